@@ -12,5 +12,7 @@ public:
     static bool CompositeImage(const std::vector<CrInt8u>& lvdata, SCRSDK::CrOSDImageDataBlock* osddata, unsigned char* outputdata, CrInt32u* outSize);
 
     static cv::Mat OverlayImage(const cv::Mat& src, const cv::Mat& overlay);
+    // Blends BGRA overlay onto BGR src into result (which may be src).
+    static void OverlayImage(const cv::Mat& src, const cv::Mat& overlay, cv::Mat& result);
     static void CreateFillImage(int width,int height, int r, int g, int b, std::vector<uchar>* imgdata);
 };
\ No newline at end of file
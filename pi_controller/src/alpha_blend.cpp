@@ -0,0 +1,120 @@
+#include "alpha_blend.hpp"
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CCU_BLEND_NEON 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CCU_BLEND_SSSE3 1
+#endif
+
+namespace ccu {
+
+// t = s * (255 - a) + o * a is at most 255 * 255; u = t + 128 and
+// (u + (u >> 8)) >> 8 is t / 255 rounded to nearest, exactly, in 16 bits.
+// The SIMD paths compute the same expression.
+static inline uint8_t blend1(uint32_t s, uint32_t o, uint32_t a) {
+  const uint32_t u = s * (255 - a) + o * a + 128;
+  return (uint8_t)((u + (u >> 8)) >> 8);
+}
+
+void blend_bgra_over_bgr_scalar(const uint8_t* src, const uint8_t* ovl, uint8_t* out, size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i, src += 3, ovl += 4, out += 3) {
+    const uint32_t a = ovl[3];
+    out[0] = blend1(src[0], ovl[0], a);
+    out[1] = blend1(src[1], ovl[1], a);
+    out[2] = blend1(src[2], ovl[2], a);
+  }
+}
+
+#if CCU_BLEND_NEON
+
+// 8 pixels per step: vld3/vld4 de-interleave, so each channel is one vector.
+static inline uint8x8_t blend8(uint8x8_t s, uint8x8_t o, uint8x8_t a, uint8x8_t ia) {
+  uint16x8_t t = vmull_u8(s, ia);
+  t = vmlal_u8(t, o, a);
+  // vrsra: t + ((t + 128) >> 8); vrshrn: (x + 128) >> 8.
+  return vrshrn_n_u16(vrsraq_n_u16(t, t, 8), 8);
+}
+
+void blend_bgra_over_bgr(const uint8_t* src, const uint8_t* ovl, uint8_t* out, size_t pixels) {
+  size_t i = 0;
+  for (; i + 8 <= pixels; i += 8) {
+    const uint8x8x4_t o = vld4_u8(ovl + i * 4);
+    uint8x8x3_t s = vld3_u8(src + i * 3);
+    const uint8x8_t ia = vmvn_u8(o.val[3]);
+    s.val[0] = blend8(s.val[0], o.val[0], o.val[3], ia);
+    s.val[1] = blend8(s.val[1], o.val[1], o.val[3], ia);
+    s.val[2] = blend8(s.val[2], o.val[2], o.val[3], ia);
+    vst3_u8(out + i * 3, s);
+  }
+  blend_bgra_over_bgr_scalar(src + i * 3, ovl + i * 4, out + i * 3, pixels - i);
+}
+
+const char* blend_kernel_name() { return "neon"; }
+
+#elif CCU_BLEND_SSSE3
+
+// 4 pixels per step: BGR is spread to BGR0 so each pixel fills one 32-bit
+// lane next to its BGRA overlay, blended in 16-bit halves, then packed back.
+__attribute__((target("ssse3")))
+static void blend_ssse3(const uint8_t* src, const uint8_t* ovl, uint8_t* out, size_t pixels) {
+  const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m128i gather = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  const __m128i alpha = _mm_setr_epi8(3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15);
+  const __m128i ones = _mm_set1_epi8((char)0xFF);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i half = _mm_set1_epi16(128);
+
+  size_t i = 0;
+  // Each step reads 16 source bytes but uses 12: stop while 6 pixels remain.
+  for (; i + 6 <= pixels; i += 4) {
+    const __m128i s = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3)), spread);
+    const __m128i o = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ovl + i * 4));
+    const __m128i a = _mm_shuffle_epi8(o, alpha);
+    const __m128i ia = _mm_xor_si128(a, ones);
+
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(ia, zero)),
+                               _mm_mullo_epi16(_mm_unpacklo_epi8(o, zero), _mm_unpacklo_epi8(a, zero)));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(ia, zero)),
+                               _mm_mullo_epi16(_mm_unpackhi_epi8(o, zero), _mm_unpackhi_epi8(a, zero)));
+    lo = _mm_add_epi16(lo, half);
+    hi = _mm_add_epi16(hi, half);
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+    const __m128i r = _mm_shuffle_epi8(_mm_packus_epi16(lo, hi), gather);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i * 3), r);
+    const int tail = _mm_cvtsi128_si32(_mm_srli_si128(r, 8));
+    std::memcpy(out + i * 3 + 8, &tail, 4);
+  }
+  blend_bgra_over_bgr_scalar(src + i * 3, ovl + i * 4, out + i * 3, pixels - i);
+}
+
+static bool have_ssse3() {
+  static const bool yes = __builtin_cpu_supports("ssse3");
+  return yes;
+}
+
+void blend_bgra_over_bgr(const uint8_t* src, const uint8_t* ovl, uint8_t* out, size_t pixels) {
+  if (have_ssse3()) {
+    blend_ssse3(src, ovl, out, pixels);
+  } else {
+    blend_bgra_over_bgr_scalar(src, ovl, out, pixels);
+  }
+}
+
+const char* blend_kernel_name() { return have_ssse3() ? "ssse3" : "scalar"; }
+
+#else
+
+void blend_bgra_over_bgr(const uint8_t* src, const uint8_t* ovl, uint8_t* out, size_t pixels) {
+  blend_bgra_over_bgr_scalar(src, ovl, out, pixels);
+}
+
+const char* blend_kernel_name() { return "scalar"; }
+
+#endif
+
+} // namespace ccu
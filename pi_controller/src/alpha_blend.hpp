@@ -0,0 +1,21 @@
+#pragma once
+// OSD alpha blend for live view: out = src * (255 - a) / 255 + ovl * a / 255
+// per channel, with src and out packed BGR and the overlay packed BGRA (alpha
+// read in place, no separate plane). Fixed point with exact rounding of the
+// /255; NEON on ARM, SSSE3 on x86 when the CPU has it, scalar otherwise. Every
+// path gives bit-identical results.
+#include <cstddef>
+#include <cstdint>
+
+namespace ccu {
+
+// Blends one row of pixels. out may alias src.
+void blend_bgra_over_bgr(const uint8_t* src, const uint8_t* ovl, uint8_t* out, size_t pixels);
+
+// Scalar version of the same kernel (reference for tests and benchmarks).
+void blend_bgra_over_bgr_scalar(const uint8_t* src, const uint8_t* ovl, uint8_t* out, size_t pixels);
+
+// Name of the kernel blend_bgra_over_bgr uses on this CPU.
+const char* blend_kernel_name();
+
+} // namespace ccu
@@ -0,0 +1,445 @@
+#include "async_log.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace ccu {
+namespace logging {
+
+namespace {
+
+// Record layout in a ring (8-byte aligned):
+//   RecordHeader, then per argument: u8 type + 8 bytes, or u8 Str + u16 len + bytes.
+struct RecordHeader {
+  uint32_t len;          // whole record incl. header and padding
+  uint8_t level;         // kPadLevel marks filler up to the ring end
+  uint8_t nargs;
+  uint16_t reserved;
+  uint64_t ts_ns;        // CLOCK_REALTIME at the call site
+  const char* fmt;
+};
+
+// Filler only writes the first 8 bytes (len + level): the gap to the ring
+// end can be shorter than a full header.
+constexpr size_t kTagSize = 8;
+static_assert(offsetof(RecordHeader, ts_ns) == kTagSize, "tag must prefix the header");
+constexpr uint8_t kPadLevel = 0xFF;
+constexpr size_t kMaxStr = 1024;
+
+// Single-producer (owning thread) / single-consumer (writer thread) byte ring.
+struct Ring {
+  static constexpr size_t kSize = 64 * 1024;
+  static constexpr size_t kMask = kSize - 1;
+
+  alignas(64) std::atomic<uint64_t> head{0};
+  alignas(64) std::atomic<uint64_t> tail{0};
+  std::atomic<uint64_t> dropped{0};
+  std::atomic<bool> retired{false};
+  uint64_t dropped_reported = 0;   // writer thread only
+  uint32_t tid = 0;
+  alignas(8) uint8_t buf[kSize];
+};
+
+struct State {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<Ring>> rings;
+  std::atomic<uint64_t> dropped{0};
+  std::atomic<bool> running{false};
+  std::atomic<bool> stopped{false};
+  std::once_flag once;
+  std::thread writer;
+};
+
+// Leaked on purpose: detached threads may still log during exit.
+State& state() {
+  static State* s = new State();
+  return *s;
+}
+
+inline size_t align8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+size_t encoded_size(const Arg* args, size_t nargs) {
+  size_t n = sizeof(RecordHeader);
+  for (size_t i = 0; i < nargs; ++i) {
+    if (args[i].type == ArgType::Str) n += 1 + 2 + std::min(std::strlen(args[i].s), kMaxStr);
+    else n += 1 + 8;
+  }
+  return align8(n);
+}
+
+void encode(uint8_t* dst, size_t len, Level level, uint64_t ts_ns, const char* fmt,
+            const Arg* args, size_t nargs) {
+  RecordHeader h{};
+  h.len = (uint32_t)len;
+  h.level = (uint8_t)level;
+  h.nargs = (uint8_t)nargs;
+  h.ts_ns = ts_ns;
+  h.fmt = fmt;
+  std::memcpy(dst, &h, sizeof(h));
+  uint8_t* p = dst + sizeof(h);
+  for (size_t i = 0; i < nargs; ++i) {
+    *p++ = (uint8_t)args[i].type;
+    if (args[i].type == ArgType::Str) {
+      const uint16_t n = (uint16_t)std::min(std::strlen(args[i].s), kMaxStr);
+      std::memcpy(p, &n, 2);
+      std::memcpy(p + 2, args[i].s, n);
+      p += 2 + n;
+    } else {
+      std::memcpy(p, &args[i].u, 8);
+      p += 8;
+    }
+  }
+}
+
+uint64_t now_ns() {
+  timespec ts{};
+  ::clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// ------------------------------------------------------------
+// Formatting (writer thread)
+// ------------------------------------------------------------
+
+struct Decoded {
+  ArgType type;
+  uint64_t bits;
+  std::string str;
+};
+
+void format_one(std::string& out, const std::string& spec, char conv, char len_mod,
+                const Decoded* a) {
+  char tmp[1100];
+  if (!a) {
+    out += "(missing)";
+    return;
+  }
+  int n = -1;
+  const bool is_str = a->type == ArgType::Str;
+  int64_t sv = 0;
+  uint64_t uv = a->bits;
+  std::memcpy(&sv, &a->bits, 8);
+  // Mimic printf argument width for int-sized conversions.
+  if (len_mod == 0) { uv = (uint32_t)uv; sv = (int32_t)sv; }
+  else if (len_mod == 'h') { uv = (uint16_t)uv; sv = (int16_t)sv; }
+  else if (len_mod == 'H') { uv = (uint8_t)uv; sv = (int8_t)sv; }
+
+  switch (conv) {
+    case 'd': case 'i':
+      if (is_str || a->type == ArgType::F64) break;
+      n = std::snprintf(tmp, sizeof(tmp), (spec + "ll" + conv).c_str(), (long long)sv);
+      break;
+    case 'u': case 'o': case 'x': case 'X':
+      if (is_str || a->type == ArgType::F64) break;
+      n = std::snprintf(tmp, sizeof(tmp), (spec + "ll" + conv).c_str(), (unsigned long long)uv);
+      break;
+    case 'c':
+      if (is_str || a->type == ArgType::F64) break;
+      n = std::snprintf(tmp, sizeof(tmp), (spec + conv).c_str(), (int)sv);
+      break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A': {
+      if (is_str) break;
+      double d = 0;
+      if (a->type == ArgType::F64) std::memcpy(&d, &a->bits, 8);
+      else if (a->type == ArgType::I64) d = (double)(int64_t)a->bits;
+      else d = (double)a->bits;
+      n = std::snprintf(tmp, sizeof(tmp), (spec + conv).c_str(), d);
+      break;
+    }
+    case 's':
+      if (!is_str) break;
+      n = std::snprintf(tmp, sizeof(tmp), (spec + 's').c_str(), a->str.c_str());
+      break;
+    case 'p':
+      if (is_str) break;
+      n = std::snprintf(tmp, sizeof(tmp), (spec + 'p').c_str(), (void*)(uintptr_t)a->bits);
+      break;
+    default:
+      break;
+  }
+  if (n < 0) {
+    out += "(?)";
+    return;
+  }
+  out.append(tmp, (size_t)std::min(n, (int)sizeof(tmp) - 1));
+}
+
+// printf-style expansion of fmt over the recorded arguments.
+void format_message(std::string& out, const char* fmt, const std::vector<Decoded>& args) {
+  size_t ai = 0;
+  auto next = [&]() -> const Decoded* { return ai < args.size() ? &args[ai++] : nullptr; };
+  for (const char* p = fmt; *p; ++p) {
+    if (*p != '%') { out += *p; continue; }
+    if (p[1] == '%') { out += '%'; ++p; continue; }
+    if (!p[1]) { out += '%'; break; }
+    std::string spec = "%";
+    ++p;
+    while (*p && std::strchr("-+ #0", *p)) spec += *p++;
+    if (*p == '*') {
+      const Decoded* w = next();
+      spec += std::to_string(w ? (int)(int64_t)w->bits : 0);
+      ++p;
+    } else {
+      while (*p >= '0' && *p <= '9') spec += *p++;
+    }
+    if (*p == '.') {
+      spec += *p++;
+      if (*p == '*') {
+        const Decoded* w = next();
+        spec += std::to_string(w ? (int)(int64_t)w->bits : 0);
+        ++p;
+      } else {
+        while (*p >= '0' && *p <= '9') spec += *p++;
+      }
+    }
+    char len_mod = 0;   // 0 = int, 'h' short, 'H' char, 'l' 64-bit
+    while (*p && std::strchr("hlLqjzt", *p)) {
+      if (*p == 'h') len_mod = (len_mod == 'h') ? 'H' : 'h';
+      else len_mod = 'l';
+      ++p;
+    }
+    if (!*p) break;
+    if (*p == 'n') { next(); continue; }
+    format_one(out, spec, *p, len_mod, next());
+  }
+}
+
+// Decodes the record at rec and appends one formatted line to out.
+void format_record(const uint8_t* rec, uint32_t tid, std::string& out) {
+  RecordHeader h;
+  std::memcpy(&h, rec, sizeof(h));
+  std::vector<Decoded> args(h.nargs);
+  const uint8_t* p = rec + sizeof(h);
+  for (uint8_t i = 0; i < h.nargs; ++i) {
+    args[i].type = (ArgType)*p++;
+    args[i].bits = 0;
+    if (args[i].type == ArgType::Str) {
+      uint16_t n = 0;
+      std::memcpy(&n, p, 2);
+      args[i].str.assign(reinterpret_cast<const char*>(p + 2), n);
+      p += 2 + n;
+    } else {
+      std::memcpy(&args[i].bits, p, 8);
+      p += 8;
+    }
+  }
+
+  const time_t secs = (time_t)(h.ts_ns / 1000000000ull);
+  tm lt{};
+  ::localtime_r(&secs, &lt);
+  char prefix[64];
+  static const char kLevels[] = "DIWE";
+  std::snprintf(prefix, sizeof(prefix), "%02d:%02d:%02d.%06u %c [%u] ",
+                lt.tm_hour, lt.tm_min, lt.tm_sec, (unsigned)((h.ts_ns / 1000ull) % 1000000ull),
+                kLevels[std::min<int>(h.level, 3)], (unsigned)tid);
+  out += prefix;
+  const size_t msg_start = out.size();
+  format_message(out, h.fmt, args);
+  while (out.size() > msg_start && out.back() == '\n') out.pop_back();
+  out += '\n';
+}
+
+void write_out(int fd, const std::string& s) {
+  size_t off = 0;
+  while (off < s.size()) {
+    const ssize_t n = ::write(fd, s.data() + off, s.size() - off);
+    if (n <= 0) return;
+    off += (size_t)n;
+  }
+}
+
+// ------------------------------------------------------------
+// Producer side
+// ------------------------------------------------------------
+
+struct ThreadRing {
+  std::shared_ptr<Ring> ring;
+  ~ThreadRing() { if (ring) ring->retired.store(true, std::memory_order_release); }
+};
+
+Ring& thread_ring() {
+  thread_local ThreadRing tr;
+  if (!tr.ring) {
+    tr.ring = std::make_shared<Ring>();
+    tr.ring->tid = (uint32_t)::syscall(SYS_gettid);
+    State& st = state();
+    std::lock_guard<std::mutex> lock(st.mutex);
+    st.rings.push_back(tr.ring);
+  }
+  return *tr.ring;
+}
+
+// After shutdown() (atexit) nothing drains the rings; format on the caller.
+void emit_sync(Level level, const char* fmt, const Arg* args, size_t nargs) {
+  const size_t len = encoded_size(args, nargs);
+  std::vector<uint8_t> rec(len);
+  encode(rec.data(), len, level, now_ns(), fmt, args, nargs);
+  std::string line;
+  format_record(rec.data(), (uint32_t)::syscall(SYS_gettid), line);
+  write_out(level >= LEVEL_WARN ? STDERR_FILENO : STDOUT_FILENO, line);
+}
+
+// ------------------------------------------------------------
+// Writer thread
+// ------------------------------------------------------------
+
+// Next real record of r (skipping filler), or nullptr when empty.
+const uint8_t* peek(Ring& r) {
+  while (true) {
+    const uint64_t tail = r.tail.load(std::memory_order_relaxed);
+    if (tail == r.head.load(std::memory_order_acquire)) return nullptr;
+    const uint8_t* rec = r.buf + (tail & Ring::kMask);
+    RecordHeader h{};
+    std::memcpy(&h, rec, kTagSize);
+    if (h.level != kPadLevel) return rec;
+    r.tail.store(tail + h.len, std::memory_order_release);
+  }
+}
+
+// Merges all rings in timestamp order; returns number of events written.
+size_t drain_once(std::string& out_stdout, std::string& out_stderr) {
+  State& st = state();
+  std::vector<std::shared_ptr<Ring>> rings;
+  {
+    std::lock_guard<std::mutex> lock(st.mutex);
+    rings = st.rings;
+  }
+
+  size_t written = 0;
+  while (true) {
+    Ring* best = nullptr;
+    const uint8_t* best_rec = nullptr;
+    uint64_t best_ts = 0;
+    for (auto& r : rings) {
+      const uint8_t* rec = peek(*r);
+      if (!rec) continue;
+      RecordHeader h;
+      std::memcpy(&h, rec, sizeof(h));
+      if (!best || h.ts_ns < best_ts) {
+        best = r.get();
+        best_rec = rec;
+        best_ts = h.ts_ns;
+      }
+    }
+    if (!best) break;
+    RecordHeader h;
+    std::memcpy(&h, best_rec, sizeof(h));
+    format_record(best_rec, best->tid, h.level >= LEVEL_WARN ? out_stderr : out_stdout);
+    best->tail.store(best->tail.load(std::memory_order_relaxed) + h.len, std::memory_order_release);
+    ++written;
+    if (out_stdout.size() > 32 * 1024) { write_out(STDOUT_FILENO, out_stdout); out_stdout.clear(); }
+    if (out_stderr.size() > 32 * 1024) { write_out(STDERR_FILENO, out_stderr); out_stderr.clear(); }
+  }
+
+  for (auto& r : rings) {
+    const uint64_t d = r->dropped.load(std::memory_order_relaxed);
+    if (d != r->dropped_reported) {
+      char line[96];
+      std::snprintf(line, sizeof(line), "log: dropped %llu events from thread %u (ring full)\n",
+                    (unsigned long long)(d - r->dropped_reported), (unsigned)r->tid);
+      out_stderr += line;
+      r->dropped_reported = d;
+    }
+  }
+
+  // Forget rings whose thread has exited once they are empty.
+  {
+    std::lock_guard<std::mutex> lock(st.mutex);
+    st.rings.erase(std::remove_if(st.rings.begin(), st.rings.end(), [](const std::shared_ptr<Ring>& r) {
+      return r->retired.load(std::memory_order_acquire) &&
+             r->tail.load(std::memory_order_relaxed) == r->head.load(std::memory_order_acquire) &&
+             r->dropped.load(std::memory_order_relaxed) == r->dropped_reported;
+    }), st.rings.end());
+  }
+  return written;
+}
+
+void writer_main() {
+  State& st = state();
+  std::string out_stdout;
+  std::string out_stderr;
+  while (true) {
+    const bool stopping = !st.running.load(std::memory_order_acquire);
+    const size_t n = drain_once(out_stdout, out_stderr);
+    if (!out_stdout.empty()) { write_out(STDOUT_FILENO, out_stdout); out_stdout.clear(); }
+    if (!out_stderr.empty()) { write_out(STDERR_FILENO, out_stderr); out_stderr.clear(); }
+    if (stopping) break;
+    if (n == 0) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+}
+
+} // namespace
+
+void emit(Level level, const char* fmt, const Arg* args, size_t nargs) {
+  State& st = state();
+  if (st.stopped.load(std::memory_order_acquire)) {
+    emit_sync(level, fmt, args, nargs);
+    return;
+  }
+  if (!st.running.load(std::memory_order_acquire)) start();
+
+  const uint64_t ts = now_ns();
+  Ring& r = thread_ring();
+  const size_t len = encoded_size(args, nargs);
+  if (len > Ring::kSize / 4) {
+    r.dropped.fetch_add(1, std::memory_order_relaxed);
+    st.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  const uint64_t head = r.head.load(std::memory_order_relaxed);
+  const uint64_t tail = r.tail.load(std::memory_order_acquire);
+  const size_t idx = (size_t)(head & Ring::kMask);
+  const size_t to_end = Ring::kSize - idx;
+  const size_t need = (len <= to_end) ? len : to_end + len;
+  if (Ring::kSize - (size_t)(head - tail) < need) {
+    r.dropped.fetch_add(1, std::memory_order_relaxed);
+    st.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  uint64_t pos = head;
+  if (len > to_end) {
+    RecordHeader pad{};
+    pad.len = (uint32_t)to_end;
+    pad.level = kPadLevel;
+    std::memcpy(r.buf + idx, &pad, kTagSize);
+    pos += to_end;
+  }
+  encode(r.buf + (pos & Ring::kMask), len, level, ts, fmt, args, nargs);
+  r.head.store(pos + len, std::memory_order_release);
+}
+
+void start() {
+  State& st = state();
+  std::call_once(st.once, [&st]() {
+    st.running.store(true, std::memory_order_release);
+    st.writer = std::thread(writer_main);
+    std::atexit(shutdown);
+  });
+}
+
+void shutdown() {
+  State& st = state();
+  if (st.stopped.exchange(true)) return;
+  st.running.store(false, std::memory_order_release);
+  if (st.writer.joinable()) st.writer.join();
+}
+
+uint64_t dropped_total() {
+  return state().dropped.load(std::memory_order_relaxed);
+}
+
+} // namespace logging
+} // namespace ccu
@@ -0,0 +1,102 @@
+#pragma once
+// Asynchronous logger for the daemon's hot paths.
+//
+// A log call copies the format pointer and its arguments (strings by value)
+// into the calling thread's SPSC ring and returns; a background thread does
+// the printf-style formatting and the blocking write. When a ring is full
+// the event is dropped and counted instead of stalling the caller.
+//
+// Format strings must be literals (only the pointer is stored). Levels below
+// CCU_LOG_MIN_LEVEL compile to nothing.
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+
+#ifndef CCU_LOG_MIN_LEVEL
+#define CCU_LOG_MIN_LEVEL 0
+#endif
+
+namespace ccu {
+namespace logging {
+
+enum Level : uint8_t {
+  LEVEL_DEBUG = 0,
+  LEVEL_INFO = 1,
+  LEVEL_WARN = 2,
+  LEVEL_ERROR = 3,
+};
+
+enum class ArgType : uint8_t { I64, U64, F64, Str, Ptr };
+
+struct Arg {
+  ArgType type;
+  union {
+    int64_t i;
+    uint64_t u;
+    double f;
+    const void* p;
+    const char* s;
+  };
+};
+
+template <typename T>
+inline Arg make_arg(T v) {
+  Arg a{};
+  using U = std::decay_t<T>;
+  if constexpr (std::is_enum_v<U>) {
+    return make_arg(static_cast<std::underlying_type_t<U>>(v));
+  } else if constexpr (std::is_same_v<U, bool>) {
+    a.type = ArgType::U64; a.u = v ? 1u : 0u;
+  } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+    a.type = ArgType::I64; a.i = (int64_t)v;
+  } else if constexpr (std::is_integral_v<U>) {
+    a.type = ArgType::U64; a.u = (uint64_t)v;
+  } else if constexpr (std::is_floating_point_v<U>) {
+    a.type = ArgType::F64; a.f = (double)v;
+  } else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>) {
+    a.type = ArgType::Str; a.s = v ? v : "(null)";
+  } else {
+    static_assert(std::is_pointer_v<U>, "unsupported log argument type");
+    a.type = ArgType::Ptr; a.p = (const void*)v;
+  }
+  return a;
+}
+
+// Copies one event into the calling thread's ring. Never blocks.
+void emit(Level level, const char* fmt, const Arg* args, size_t nargs);
+
+template <typename... Args>
+inline void log(Level level, const char* fmt, Args... args) {
+  if constexpr (sizeof...(Args) == 0) {
+    emit(level, fmt, nullptr, 0);
+  } else {
+    const Arg packed[] = { make_arg(args)... };
+    emit(level, fmt, packed, sizeof...(Args));
+  }
+}
+
+// Starts the writer thread (idempotent; also started lazily by the first
+// event) and registers an atexit drain.
+void start();
+// Drains every ring and stops the writer thread.
+void shutdown();
+
+// Events dropped because a ring was full, over the process lifetime.
+uint64_t dropped_total();
+
+} // namespace logging
+} // namespace ccu
+
+// The dead printf call only exists for -Wformat checking and is never emitted;
+// filtered levels keep it so arguments stay "used" and type-checked.
+#define CCU_LOG_AT(lvl, enabled, ...) \
+  do { \
+    if (false) std::printf(__VA_ARGS__); \
+    if (enabled) ::ccu::logging::log(lvl, __VA_ARGS__); \
+  } while (0)
+
+#define CCU_LOG_DEBUG(...) CCU_LOG_AT(::ccu::logging::LEVEL_DEBUG, CCU_LOG_MIN_LEVEL <= 0, __VA_ARGS__)
+#define CCU_LOG_INFO(...)  CCU_LOG_AT(::ccu::logging::LEVEL_INFO,  CCU_LOG_MIN_LEVEL <= 1, __VA_ARGS__)
+#define CCU_LOG_WARN(...)  CCU_LOG_AT(::ccu::logging::LEVEL_WARN,  CCU_LOG_MIN_LEVEL <= 2, __VA_ARGS__)
+#define CCU_LOG_ERROR(...) CCU_LOG_AT(::ccu::logging::LEVEL_ERROR, CCU_LOG_MIN_LEVEL <= 3, __VA_ARGS__)
@@ -0,0 +1,124 @@
+#include "avi_layout.hpp"
+#include "bytes.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace ccu {
+
+namespace {
+
+constexpr uint32_t kKeyFrame = 0x10;   // AVIIF_KEYFRAME
+constexpr uint32_t kHasIndex = 0x10;   // AVIF_HASINDEX
+
+void fourcc(uint8_t* p, const char* cc) { std::memcpy(p, cc, 4); }
+
+} // namespace
+
+bool jpeg_dimensions(const uint8_t* p, size_t n, uint16_t& w, uint16_t& h) {
+  if (n < 4 || p[0] != 0xFF || p[1] != 0xD8) return false;
+  size_t i = 2;
+  while (i + 4 <= n) {
+    if (p[i] != 0xFF) return false;
+    const uint8_t m = p[i + 1];
+    if (m == 0xFF) {  // fill byte
+      ++i;
+      continue;
+    }
+    if (m == 0xDA) return false;
+    const bool sof = m >= 0xC0 && m <= 0xCF && m != 0xC4 && m != 0xC8 && m != 0xCC;
+    if (sof) {
+      if (i + 9 > n) return false;
+      h = (uint16_t)(p[i + 5] << 8 | p[i + 6]);
+      w = (uint16_t)(p[i + 7] << 8 | p[i + 8]);
+      return w != 0 && h != 0;
+    }
+    i += 2 + ((size_t)p[i + 2] << 8 | p[i + 3]);
+  }
+  return false;
+}
+
+void avi_header(uint8_t* h, const AviInfo& info) {
+  std::memset(h, 0, kAviHeaderBytes);
+  const uint32_t us_per_frame = 1000000u / info.fps;
+  const uint32_t max_bps = (uint32_t)std::min<uint64_t>(0xFFFFFFFFu, (uint64_t)info.max_chunk * info.fps);
+  uint8_t* p = h;
+  fourcc(p, "RIFF");
+  put32(p + 4, (uint32_t)(info.file_bytes - 8));
+  fourcc(p + 8, "AVI ");
+  p += 12;
+  fourcc(p, "LIST");
+  put32(p + 4, (uint32_t)kAviHdrlBytes);
+  fourcc(p + 8, "hdrl");
+  p += 12;
+  fourcc(p, "avih");
+  put32(p + 4, 56);
+  put32(p + 8, us_per_frame);
+  put32(p + 12, max_bps);
+  put32(p + 20, info.indexed ? kHasIndex : 0);
+  put32(p + 24, info.frames);
+  put32(p + 32, 1);     // streams
+  put32(p + 36, info.max_chunk);
+  put32(p + 40, info.width);
+  put32(p + 44, info.height);
+  p += 64;
+  fourcc(p, "LIST");
+  put32(p + 4, 4 + (8 + 56) + (8 + 40));
+  fourcc(p + 8, "strl");
+  p += 12;
+  fourcc(p, "strh");
+  put32(p + 4, 56);
+  fourcc(p + 8, "vids");
+  fourcc(p + 12, "MJPG");
+  put32(p + 28, 1);             // scale
+  put32(p + 32, info.fps);      // rate
+  put32(p + 40, info.frames);   // length
+  put32(p + 44, info.max_chunk);
+  put32(p + 48, 0xFFFFFFFFu);   // quality: default
+  put16(p + 60, info.width);    // rcFrame right, bottom
+  put16(p + 62, info.height);
+  p += 64;
+  fourcc(p, "strf");
+  put32(p + 4, 40);
+  put32(p + 8, 40);
+  put32(p + 12, info.width);
+  put32(p + 16, info.height);
+  put16(p + 20, 1);
+  put16(p + 22, 24);
+  fourcc(p + 24, "MJPG");
+  put32(p + 28, (uint32_t)info.width * info.height * 3);
+  p += 48;
+  // Recording date, in the ctime() form readers expect.
+  fourcc(p, "IDIT");
+  put32(p + 4, 26);
+  tm lt{};
+  ::localtime_r(&info.take_start, &lt);
+  char date[32];
+  const size_t dn = std::strftime(date, sizeof(date), "%a %b %d %H:%M:%S %Y\n", &lt);
+  std::memcpy(p + 8, date, std::min<size_t>(dn, 25));
+  p += 8 + 26;
+  fourcc(p, "JUNK");
+  put32(p + 4, (uint32_t)(kAviMoviOffset - kAviJunkOffset - 8));
+  p = h + kAviMoviOffset;
+  fourcc(p, "LIST");
+  put32(p + 4, (uint32_t)(info.movi_end - kAviMoviFourcc));
+  fourcc(p + 8, "movi");
+}
+
+void avi_chunk_header(uint8_t* out, uint32_t size) {
+  fourcc(out, "00dc");
+  put32(out + 4, size);
+}
+
+void avi_index_entry(uint8_t* out, uint64_t pos, uint32_t size) {
+  fourcc(out, "00dc");
+  put32(out + 4, kKeyFrame);
+  put32(out + 8, (uint32_t)(pos - kAviMoviFourcc));
+  put32(out + 12, size);
+}
+
+void avi_index_header(uint8_t* out, uint32_t bytes) {
+  fourcc(out, "idx1");
+  put32(out + 4, bytes);
+}
+
+} // namespace ccu
@@ -0,0 +1,57 @@
+#pragma once
+// MJPEG AVI 1.0 layout written by the proxy recorder (proxy_recorder.hpp):
+//
+//   0                  RIFF <size> "AVI "
+//   12                 LIST <size> "hdrl" avih, LIST strl (strh, strf), IDIT
+//   kAviJunkOffset     JUNK padding up to the movi list
+//   kAviMoviOffset     LIST <size> "movi", then one "00dc" chunk per frame
+//                      (size 0 for a period that repeats the last picture,
+//                      odd sizes padded to even)
+//   after movi         idx1: one 16-byte entry per chunk, offsets counted
+//                      from the "movi" fourcc at kAviMoviFourcc
+//
+// Everything before the first chunk fills exactly kAviHeaderBytes, so the
+// header can be written as a placeholder and rewritten in place with the
+// final counts.
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+namespace ccu {
+
+constexpr size_t kAviHeaderBytes = 4096;
+constexpr size_t kAviHdrlBytes = 4 + (8 + 56) + (12 + (8 + 56) + (8 + 40)) + (8 + 26);
+constexpr size_t kAviJunkOffset = 12 + 8 + kAviHdrlBytes;
+constexpr size_t kAviMoviOffset = kAviHeaderBytes - 12;  // "LIST" <size> "movi"
+constexpr size_t kAviMoviFourcc = kAviMoviOffset + 8;    // idx1 offsets count from here
+constexpr size_t kAviIndexEntry = 16;
+static_assert(kAviJunkOffset + 8 <= kAviMoviOffset, "AVI header must fit one block");
+
+struct AviInfo {
+  uint32_t fps = 1;
+  uint32_t frames = 0;       // chunks in movi, empty ones included
+  uint32_t max_chunk = 0;    // largest padded chunk
+  uint16_t width = 0, height = 0;
+  bool indexed = false;      // idx1 follows movi
+  uint64_t movi_end = 0;     // file offset just past the last chunk
+  uint64_t file_bytes = 0;
+  time_t take_start = 0;     // IDIT, local time
+};
+
+// Width and height from the first SOFn marker; false if there is none
+// before the scan.
+bool jpeg_dimensions(const uint8_t* p, size_t n, uint16_t& w, uint16_t& h);
+
+// Fills h[0, kAviHeaderBytes) for info.
+void avi_header(uint8_t* h, const AviInfo& info);
+
+// "00dc" <size> for a chunk of size bytes (before padding).
+void avi_chunk_header(uint8_t* out, uint32_t size);
+
+// The idx1 entry for a chunk of size bytes whose header is at file offset pos.
+void avi_index_entry(uint8_t* out, uint64_t pos, uint32_t size);
+
+// "idx1" <bytes> ahead of the entries.
+void avi_index_header(uint8_t* out, uint32_t bytes);
+
+} // namespace ccu
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+
+namespace ccu {
+
+// Little-endian stores into a raw buffer (wire payloads, RIFF/AVI headers).
+inline void put16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)(v & 0xFF);
+  p[1] = (uint8_t)(v >> 8);
+}
+
+inline void put32(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; ++i) p[i] = (uint8_t)((v >> (8 * i)) & 0xFF);
+}
+
+inline void put64(uint8_t* p, uint64_t v) {
+  put32(p, (uint32_t)v);
+  put32(p + 4, (uint32_t)(v >> 32));
+}
+
+} // namespace ccu
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+
+namespace ccu {
+
+// Nanoseconds on the given POSIX clock.
+inline uint64_t clock_ns(clockid_t id) {
+  timespec ts{};
+  ::clock_gettime(id, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// CLOCK_MONOTONIC in nanoseconds: the timebase for frame stamps, trace spans,
+// flight records, fire times and ClockSync.
+inline uint64_t monotonic_ns() { return clock_ns(CLOCK_MONOTONIC); }
+
+} // namespace ccu
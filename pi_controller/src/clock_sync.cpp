@@ -0,0 +1,43 @@
+#include "clock_sync.hpp"
+
+namespace ccu {
+
+void ClockSync::note_exchange(uint64_t t1, uint64_t t2, uint64_t t3) {
+  m_pending[m_pending_next] = Pending{t1, t2, t3};
+  m_pending_next = (m_pending_next + 1) % m_pending.size();
+}
+
+bool ClockSync::complete(uint64_t t1, uint64_t t4) {
+  for (Pending& p : m_pending) {
+    if (p.t1 != t1 || p.t2 == 0) continue;
+    // A t4 before t1, or an ACK the daemon held longer than the round trip,
+    // means the CCU reported garbage.
+    if (t4 < t1 || p.t3 < p.t2 || (t4 - t1) < (p.t3 - p.t2)) return false;
+    Sample s;
+    s.at_us = p.t2;
+    s.offset_us = (((int64_t)p.t2 - (int64_t)t1) + ((int64_t)p.t3 - (int64_t)t4)) / 2;
+    s.delay_us = (t4 - t1) - (p.t3 - p.t2);
+    m_samples[m_sample_next] = s;
+    m_sample_next = (m_sample_next + 1) % m_samples.size();
+    p = Pending{};
+    return true;
+  }
+  return false;
+}
+
+ClockSync::Estimate ClockSync::estimate(uint64_t now_us) const {
+  Estimate e;
+  const Sample* best = nullptr;
+  for (const Sample& s : m_samples) {
+    if (s.at_us == 0 || now_us - s.at_us > kMaxAgeUs) continue;
+    e.samples++;
+    if (!best || s.delay_us < best->delay_us) best = &s;
+  }
+  if (!best) return e;
+  e.valid = true;
+  e.offset_us = best->offset_us;
+  e.uncertainty_us = (uint32_t)((best->delay_us + 1) / 2);
+  return e;
+}
+
+} // namespace ccu
@@ -0,0 +1,46 @@
+#pragma once
+// Offset between the CCU's clock and the daemon's CLOCK_MONOTONIC, estimated
+// from CMD_TIME_SYNC request/ACK exchanges (NTP-style, four timestamps):
+//
+//   t1 CCU sends request   t2 daemon receives   t3 daemon sends ACK   t4 CCU receives ACK
+//
+// The daemon only sees t4 when the CCU's next TIME_SYNC reports it together
+// with that exchange's t1. The estimate is the sample with the smallest
+// round-trip delay among recent ones; its half-delay bounds the error.
+// Used from the request loop only (not thread-safe).
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace ccu {
+
+class ClockSync {
+public:
+  static constexpr size_t kSamples = 16;
+  static constexpr uint64_t kMaxAgeUs = 60ull * 1000000ull;  // drift makes older samples useless
+
+  struct Estimate {
+    bool valid = false;
+    int64_t offset_us = 0;        // daemon clock - CCU clock
+    uint32_t uncertainty_us = 0;  // half the best sample's round-trip delay
+    uint8_t samples = 0;
+  };
+
+  // Daemon side of the exchange the CCU stamped t1.
+  void note_exchange(uint64_t t1, uint64_t t2, uint64_t t3);
+  // The CCU received the ACK for exchange t1 at t4. False if t1 is unknown.
+  bool complete(uint64_t t1, uint64_t t4);
+
+  Estimate estimate(uint64_t now_us) const;
+
+private:
+  struct Pending { uint64_t t1 = 0, t2 = 0, t3 = 0; };
+  struct Sample { uint64_t at_us = 0; int64_t offset_us = 0; uint64_t delay_us = 0; };
+
+  std::array<Pending, 8> m_pending{};
+  size_t m_pending_next = 0;
+  std::array<Sample, kSamples> m_samples{};
+  size_t m_sample_next = 0;
+};
+
+} // namespace ccu
@@ -0,0 +1,249 @@
+// extern "C" SCRSDK entry points of the stub libCr_Core. Only the surface
+// used by this repository is modelled; the rest of the vendor API reports
+// CrError_Api_Insufficient like a camera that lacks the feature.
+#include "stub_camera.hpp"
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstring>
+
+#define CRSTUB_TRACE(...) \
+  do { if (crstub::World::get().verbose()) std::fprintf(stderr, "[crstub] " __VA_ARGS__); } while (0)
+
+namespace SCRSDK {
+
+namespace {
+
+crstub::World& world() { return crstub::World::get(); }
+
+} // namespace
+
+bool Init(CrInt32u logtype) {
+  (void)logtype;
+  return world().init();
+}
+
+bool Release() {
+  world().shutdown();
+  return true;
+}
+
+CrError EnumCameraObjects(ICrEnumCameraObjectInfo** ppEnumCameraObjectInfo, CrInt8u timeInSec) {
+  (void)timeInSec;
+  if (!ppEnumCameraObjectInfo) return CrError_Generic_InvalidParameter;
+  *ppEnumCameraObjectInfo = nullptr;
+  if (!world().inited()) return CrError_Init;
+
+  const CrError sim = world().simulate(crstub::Op::Enum);
+  if (CR_FAILED(sim)) return sim;
+
+  auto* list = world().enumerate();
+  CRSTUB_TRACE("EnumCameraObjects -> %u\n", list->GetCount());
+  if (list->GetCount() == 0) {
+    list->Release();
+    return CrError_Adaptor_EnumDevice;
+  }
+  *ppEnumCameraObjectInfo = list;
+  return CrError_None;
+}
+
+ICrCameraObjectInfo* CreateCameraObjectInfo(CrChar* name, CrChar* model, CrInt16 usbPid, CrInt32u idType,
+                                            CrInt32u idSize, CrInt8u* id, CrChar* connectTypeName,
+                                            CrChar* adaptorName, CrChar* pairingNecessity, CrInt32u sshSupport) {
+  (void)name; (void)usbPid; (void)idType; (void)adaptorName; (void)pairingNecessity; (void)sshSupport;
+  crstub::CameraModel m;
+  if (model) m.model = model;
+  if (connectTypeName) m.conn = connectTypeName;
+  std::string serial = (id && idSize) ? std::string(reinterpret_cast<const char*>(id), idSize) : std::string();
+  int camera = world().find_camera_by_serial(serial.c_str());
+  return new crstub::CameraObjectInfo(camera < 0 ? 0 : camera, m);
+}
+
+CrError CreateCameraObjectInfoUSBConnection(ICrCameraObjectInfo** pCameraObjectInfo, CrCameraDeviceModelList model,
+                                            CrInt8u* usbSerialNumber) {
+  (void)model;
+  if (!pCameraObjectInfo) return CrError_Generic_InvalidParameter;
+  *pCameraObjectInfo = nullptr;
+  int camera = world().find_camera_by_serial(reinterpret_cast<const char*>(usbSerialNumber));
+  if (camera < 0) camera = 0;
+
+  crstub::CameraModel m;
+  m.conn = "USB";
+  *pCameraObjectInfo = new crstub::CameraObjectInfo(camera, m);
+  return CrError_None;
+}
+
+CrError CreateCameraObjectInfoEthernetConnection(ICrCameraObjectInfo** pCameraObjectInfo, CrCameraDeviceModelList model,
+                                                 CrInt32u ipAddress, CrInt8u* macAddress, CrInt32u sshSupport) {
+  (void)model; (void)sshSupport;
+  if (!pCameraObjectInfo) return CrError_Generic_InvalidParameter;
+  *pCameraObjectInfo = nullptr;
+
+  // Callers disagree on byte order (see SonyBackend's fallbacks), so accept
+  // the address both as host order and with the first octet in the low byte.
+  CrInt32u host_order = ipAddress;
+  int camera = world().find_camera_by_ip(host_order);
+  if (camera < 0) {
+    host_order = ((ipAddress & 0xFFu) << 24) | ((ipAddress & 0xFF00u) << 8) |
+                 ((ipAddress >> 8) & 0xFF00u) | ((ipAddress >> 24) & 0xFFu);
+    camera = world().find_camera_by_ip(host_order);
+  }
+  CRSTUB_TRACE("CreateCameraObjectInfoEthernetConnection ip=0x%08X -> camera %d\n", ipAddress, camera);
+  if (camera < 0) return CrError_Connect_TimeOut;
+
+  crstub::CameraModel m;
+  m.conn = "Ethernet";
+  in_addr ina{};
+  ina.s_addr = htonl(host_order);
+  char ip[INET_ADDRSTRLEN] = {0};
+  inet_ntop(AF_INET, &ina, ip, sizeof(ip));
+  m.ip = ip;
+  if (macAddress) {
+    char mac[32];
+    std::snprintf(mac, sizeof(mac), "%02x:%02x:%02x:%02x:%02x:%02x",
+                  macAddress[0], macAddress[1], macAddress[2], macAddress[3], macAddress[4], macAddress[5]);
+    m.mac = mac;
+  }
+  *pCameraObjectInfo = new crstub::CameraObjectInfo(camera, m);
+  return CrError_None;
+}
+
+CrError EditSDKInfo(CrInt16u infotype) {
+  (void)infotype;
+  return CrError_None;
+}
+
+CrError GetFingerprint(ICrCameraObjectInfo* pCameraObjectInfo, char* fingerprint, CrInt32u* fingerprintSize) {
+  auto* info = dynamic_cast<crstub::CameraObjectInfo*>(pCameraObjectInfo);
+  if (!info || !fingerprint || !fingerprintSize) return CrError_Generic_InvalidParameter;
+  const std::string fp = world().fingerprint(info->camera());
+  // *fingerprintSize is the caller's buffer size on the way in.
+  if (fp.size() + 1 > *fingerprintSize) return CrError_Generic_InvalidParameter;
+  std::memcpy(fingerprint, fp.c_str(), fp.size() + 1);
+  *fingerprintSize = (CrInt32u)fp.size();
+  return CrError_None;
+}
+
+CrError Connect(ICrCameraObjectInfo* pCameraObjectInfo, IDeviceCallback* callback, CrDeviceHandle* deviceHandle,
+                CrSdkControlMode openMode, CrReconnectingSet reconnect, const char* userId,
+                const char* userPassword, const char* fingerprint, CrInt32u fingerprintSize) {
+  (void)openMode; (void)reconnect; (void)userId; (void)userPassword; (void)fingerprint; (void)fingerprintSize;
+  auto* info = dynamic_cast<const crstub::CameraObjectInfo*>(pCameraObjectInfo);
+  if (!info || !deviceHandle) return CrError_Generic_InvalidParameter;
+  if (!world().inited()) return CrError_Init;
+  const CrError err = world().connect(info->camera(), callback, deviceHandle);
+  CRSTUB_TRACE("Connect camera=%d -> 0x%04X handle=%lld\n", info->camera(), (unsigned)err,
+               (long long)(CR_SUCCEEDED(err) ? *deviceHandle : 0));
+  return err;
+}
+
+CrError Disconnect(CrDeviceHandle deviceHandle) {
+  CRSTUB_TRACE("Disconnect handle=%lld\n", (long long)deviceHandle);
+  return world().disconnect(deviceHandle);
+}
+
+CrError ReleaseDevice(CrDeviceHandle deviceHandle) {
+  CRSTUB_TRACE("ReleaseDevice handle=%lld\n", (long long)deviceHandle);
+  return world().release_device(deviceHandle);
+}
+
+CrError GetDeviceProperties(CrDeviceHandle deviceHandle, CrDeviceProperty** properties, CrInt32* numOfProperties) {
+  return world().get_properties(deviceHandle, nullptr, 0, properties, numOfProperties);
+}
+
+CrError GetSelectDeviceProperties(CrDeviceHandle deviceHandle, CrInt32u numOfCodes, CrInt32u* codes,
+                                  CrDeviceProperty** properties, CrInt32* numOfProperties) {
+  if (!codes || numOfCodes == 0) return CrError_Generic_InvalidParameter;
+  return world().get_properties(deviceHandle, codes, numOfCodes, properties, numOfProperties);
+}
+
+CrError ReleaseDeviceProperties(CrDeviceHandle deviceHandle, CrDeviceProperty* properties) {
+  (void)deviceHandle;
+  delete[] properties;
+  return CrError_None;
+}
+
+CrError SetDeviceProperty(CrDeviceHandle deviceHandle, CrDeviceProperty* pProperty) {
+  if (!pProperty) return CrError_Generic_InvalidParameter;
+  const CrError err = world().set_property(deviceHandle, *pProperty);
+  CRSTUB_TRACE("SetDeviceProperty code=0x%04X value=%llu -> 0x%04X\n", pProperty->GetCode(),
+               (unsigned long long)pProperty->GetCurrentValue(), (unsigned)err);
+  return err;
+}
+
+CrError SendCommand(CrDeviceHandle deviceHandle, CrInt32u commandId, CrCommandParam commandParam) {
+  const CrError err = world().send_command(deviceHandle, commandId, commandParam);
+  CRSTUB_TRACE("SendCommand id=%u param=%u -> 0x%04X\n", commandId, (unsigned)commandParam, (unsigned)err);
+  return err;
+}
+
+CrError GetLiveViewImage(CrDeviceHandle deviceHandle, CrImageDataBlock* imageData) {
+  if (!imageData) return CrError_Generic_InvalidParameter;
+  CrInt32u frame_no = 0;
+  CrInt32u image_size = 0;
+  const CrError err = world().live_view_image(deviceHandle, imageData->GetImageData(), imageData->GetSize(),
+                                              frame_no, image_size);
+  if (err == CrError_None) crstub::fill_image_block(imageData, frame_no, image_size);
+  return err;
+}
+
+CrError GetLiveViewImageInfo(CrDeviceHandle deviceHandle, CrImageInfo* info) {
+  if (!info) return CrError_Generic_InvalidParameter;
+  CrInt32u buf_size = 0, w = 0, h = 0;
+  const CrError err = world().live_view_info(deviceHandle, buf_size, w, h);
+  if (err == CrError_None) crstub::fill_image_info(info, w, h, buf_size);
+  return err;
+}
+
+CrError GetLiveViewProperties(CrDeviceHandle deviceHandle, CrLiveViewProperty** properties, CrInt32* numOfProperties) {
+  return world().live_view_properties(deviceHandle, nullptr, 0, properties, numOfProperties);
+}
+
+CrError GetSelectLiveViewProperties(CrDeviceHandle deviceHandle, CrInt32u numOfCodes, CrInt32u* codes,
+                                    CrLiveViewProperty** properties, CrInt32* numOfProperties) {
+  if (!codes || numOfCodes == 0) return CrError_Generic_InvalidParameter;
+  return world().live_view_properties(deviceHandle, codes, numOfCodes, properties, numOfProperties);
+}
+
+CrError ReleaseLiveViewProperties(CrDeviceHandle deviceHandle, CrLiveViewProperty* properties) {
+  (void)deviceHandle;
+  delete[] properties;
+  return CrError_None;
+}
+
+CrError GetDeviceSetting(CrDeviceHandle deviceHandle, CrInt32u key, CrInt32u* value) {
+  return world().get_setting(deviceHandle, key, value);
+}
+
+CrError SetDeviceSetting(CrDeviceHandle deviceHandle, CrInt32u key, CrInt32u value) {
+  return world().set_setting(deviceHandle, key, value);
+}
+
+CrError SetSaveInfo(CrDeviceHandle deviceHandle, CrChar* path, CrChar* prefix, CrInt32 no) {
+  (void)deviceHandle; (void)path; (void)prefix; (void)no;
+  return CrError_None;
+}
+
+CrInt32u GetSDKVersion() {
+  return 0x01090000;   // reports as 1.09.00, the version bundled in src/CRSDK
+}
+
+CrInt32u GetSDKSerial() {
+  return 0;
+}
+
+CrError GetOSDImage(CrDeviceHandle deviceHandle, CrOSDImageDataBlock* imageData) {
+  (void)deviceHandle; (void)imageData;
+  return CrError_Api_Insufficient;
+}
+
+CrError Set2byte_CharBuffer(CrInt8u** dp, const char* src) {
+  if (!dp) return CrError_Generic_InvalidParameter;
+  const size_t n = src ? std::strlen(src) : 0;
+  auto* p = new CrInt8u[n + 3]();
+  *(CrInt16u*)p = (CrInt16u)n;
+  if (n) std::memcpy(p + 2, src, n);
+  *dp = p;
+  return CrError_None;
+}
+
+} // namespace SCRSDK
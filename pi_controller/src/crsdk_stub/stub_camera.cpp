@@ -0,0 +1,845 @@
+#include "stub_camera.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <arpa/inet.h>
+
+#if defined(CRSTUB_HAVE_JPEG)
+#include <jpeglib.h>
+#endif
+
+namespace crstub {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 16x16 mid-grey baseline JPEG, served when libjpeg is not available.
+const uint8_t kGreyJpeg[] = {
+  0xFF, 0xD8, 0xFF, 0xDB, 0x00, 0x43, 0x00, 0x10, 0x0B, 0x0C, 0x0E, 0x0C, 0x0A, 0x10, 0x0E, 0x0D,
+  0x0E, 0x12, 0x11, 0x10, 0x13, 0x18, 0x28, 0x1A, 0x18, 0x16, 0x16, 0x18, 0x31, 0x23, 0x25, 0x1D,
+  0x28, 0x3A, 0x33, 0x3D, 0x3C, 0x39, 0x33, 0x38, 0x37, 0x40, 0x48, 0x5C, 0x4E, 0x40, 0x44, 0x57,
+  0x45, 0x37, 0x38, 0x50, 0x6D, 0x51, 0x57, 0x5F, 0x62, 0x67, 0x68, 0x67, 0x3E, 0x4D, 0x71, 0x79,
+  0x70, 0x64, 0x78, 0x5C, 0x65, 0x67, 0x63, 0xFF, 0xC0, 0x00, 0x0B, 0x08, 0x00, 0x10, 0x00, 0x10,
+  0x01, 0x01, 0x11, 0x00, 0xFF, 0xC4, 0x00, 0x1F, 0x00, 0x00, 0x01, 0x05, 0x01, 0x01, 0x01, 0x01,
+  0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+  0x07, 0x08, 0x09, 0x0A, 0x0B, 0xFF, 0xC4, 0x00, 0xB5, 0x10, 0x00, 0x02, 0x01, 0x03, 0x03, 0x02,
+  0x04, 0x03, 0x05, 0x05, 0x04, 0x04, 0x00, 0x00, 0x01, 0x7D, 0x01, 0x02, 0x03, 0x00, 0x04, 0x11,
+  0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91,
+  0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09,
+  0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x34, 0x35, 0x36, 0x37,
+  0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57,
+  0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77,
+  0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96,
+  0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4,
+  0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2,
+  0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8,
+  0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFF, 0xDA, 0x00, 0x08,
+  0x01, 0x01, 0x00, 0x00, 0x3F, 0x00, 0x28, 0xA2, 0x8A, 0xFF, 0xD9,
+};
+
+constexpr uint32_t kFramesPerCamera = 8;
+
+bool parse_op(const std::string& name, Op& out) {
+  for (int i = 0; i < (int)Op::Count; ++i) {
+    if (name == op_name((Op)i)) {
+      out = (Op)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+void put_values(PropModel& p, std::initializer_list<uint64_t> vals) {
+  p.values.assign(vals.begin(), vals.end());
+}
+
+size_t element_size(SCRSDK::CrDataType type) {
+  switch (type & 0x0FFFu) {
+    case SCRSDK::CrDataType_UInt8: return 1;
+    case SCRSDK::CrDataType_UInt16: return 2;
+    case SCRSDK::CrDataType_UInt32: return 4;
+    case SCRSDK::CrDataType_UInt64: return 8;
+    default: return 4;
+  }
+}
+
+void default_props(CameraModel& cam) {
+  using namespace SCRSDK;
+  auto& p = cam.props;
+
+  auto ro = [&](CrInt32u code, CrDataType type, uint64_t v) {
+    PropModel m;
+    m.type = type;
+    m.current = v;
+    m.settable = false;
+    p[code] = m;
+  };
+  auto rw = [&](CrInt32u code, CrDataType type, uint64_t v, std::initializer_list<uint64_t> vals) {
+    PropModel m;
+    m.type = type;
+    m.current = v;
+    put_values(m, vals);
+    p[code] = m;
+  };
+
+  ro(CrDeviceProperty_BatteryLevel, CrDataType_UInt16, CrBatteryLevel_3_4);
+  ro(CrDeviceProperty_BatteryRemain, CrDataType_UInt16, 78);
+  ro(CrDeviceProperty_BatteryRemainDisplayUnit, CrDataType_UInt8, 1);
+  ro(CrDeviceProperty_RecordingMedia, CrDataType_UInt16, 1);
+  ro(CrDeviceProperty_Movie_RecordingMedia, CrDataType_UInt16, 1);
+  ro(CrDeviceProperty_MediaSLOT1_Status, CrDataType_UInt16, 1);
+  ro(CrDeviceProperty_MediaSLOT1_RemainingNumber, CrDataType_UInt32, 2400);
+  ro(CrDeviceProperty_MediaSLOT1_RemainingTime, CrDataType_UInt32, 5400);
+  ro(CrDeviceProperty_MediaSLOT2_Status, CrDataType_UInt16, 0);
+  ro(CrDeviceProperty_MediaSLOT2_RemainingNumber, CrDataType_UInt32, 0);
+  ro(CrDeviceProperty_MediaSLOT2_RemainingTime, CrDataType_UInt32, 0);
+  ro(CrDeviceProperty_RecordingState, CrDataType_UInt8, 0);
+  ro(CrDeviceProperty_RecorderMainStatus, CrDataType_UInt8, 0);
+  ro(CrDeviceProperty_FocusIndication, CrDataType_UInt32, CrFocusIndicator_Unlocked);
+
+  rw(CrDeviceProperty_IsoSensitivity, CrDataType_UInt32Array, 800,
+     {100, 125, 160, 200, 250, 320, 400, 500, 640, 800, 1000, 1250, 1600, 2000, 2500, 3200, 6400, 12800});
+  rw(CrDeviceProperty_WhiteBalance, CrDataType_UInt16Array, 0x0000,
+     {0x0000, 0x0011, 0x0012, 0x0013, 0x0014, 0x0020, 0x0021, 0x0030, 0x0100});
+  rw(CrDeviceProperty_ShutterSpeed, CrDataType_UInt32Array, 0x00010032,
+     {0x0001001E, 0x00010032, 0x0001003C, 0x00010064, 0x0001007D, 0x000100C8, 0x000101F4, 0x000103E8});
+  rw(CrDeviceProperty_Movie_Recording_FrameRateSetting, CrDataType_UInt8Array, 3,
+     {1, 2, 3, 4, 5, 6, 7});
+  rw(CrDeviceProperty_PriorityKeySettings, CrDataType_UInt32Array, CrPriorityKey_CameraPosition,
+     {CrPriorityKey_CameraPosition, CrPriorityKey_PCRemote});
+  rw(CrDeviceProperty_ExposureProgramMode, CrDataType_UInt32Array, CrExposure_Movie_P,
+     {CrExposure_Movie_P, CrExposure_Movie_A, CrExposure_Movie_S, CrExposure_Movie_M});
+  rw(CrDeviceProperty_MovieRecButtonToggleEnableStatus, CrDataType_UInt8Array, CrMovieRecButtonToggle_Enable,
+     {CrMovieRecButtonToggle_Disable, CrMovieRecButtonToggle_Enable});
+  rw(CrDeviceProperty_S1, CrDataType_UInt16Array, CrLockIndicator_Unlocked,
+     {CrLockIndicator_Unlocked, CrLockIndicator_Locked});
+}
+
+std::string default_fingerprint(int camera) {
+  char buf[64];
+  std::snprintf(buf, sizeof(buf), "U1RVQi1DQU1FUkEt%02d-c3R1Yg", camera);
+  return std::string(buf);
+}
+
+} // namespace
+
+const char* op_name(Op op) {
+  switch (op) {
+    case Op::Enum: return "enum";
+    case Op::Connect: return "connect";
+    case Op::GetProps: return "get_props";
+    case Op::SetProp: return "set_prop";
+    case Op::SendCommand: return "send_command";
+    case Op::LiveView: return "live_view";
+    default: return "?";
+  }
+}
+
+// ------------------------------------------------------------
+// Camera object info
+// ------------------------------------------------------------
+
+CameraObjectInfo::CameraObjectInfo(int camera, const CameraModel& m)
+  : m_camera(camera),
+    m_usb(m.conn == "USB"),
+    m_model(m.model),
+    m_conn(m.conn),
+    m_ip(m.ip),
+    m_mac(m.mac) {
+  m_name = m.model;
+  m_adaptor = m_usb ? "PTP-USB" : "PTP-IP";
+  char id[32];
+  std::snprintf(id, sizeof(id), "STUB%08d", camera);
+  m_id = id;
+  in_addr ina{};
+  if (!m_ip.empty() && inet_pton(AF_INET, m_ip.c_str(), &ina) == 1) {
+    m_ip_num = (CrInt32u)ntohl(ina.s_addr);
+  }
+  unsigned int ma[6] = {0};
+  if (std::sscanf(m_mac.c_str(), "%x:%x:%x:%x:%x:%x", &ma[0], &ma[1], &ma[2], &ma[3], &ma[4], &ma[5]) == 6) {
+    for (int i = 0; i < 6; ++i) m_mac_raw[i] = (CrInt8u)(ma[i] & 0xFF);
+  }
+}
+
+EnumCameraObjectInfo::~EnumCameraObjectInfo() {
+  for (auto* info : m_infos) delete info;
+}
+
+// ------------------------------------------------------------
+// World
+// ------------------------------------------------------------
+
+World& World::get() {
+  static World w;
+  return w;
+}
+
+bool World::init() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_inited) return true;
+
+  const char* verbose = std::getenv("CRSTUB_VERBOSE");
+  m_verbose = (verbose && verbose[0] == '1');
+  const char* scale = std::getenv("CRSTUB_LATENCY_SCALE");
+  m_latency_scale = (scale && scale[0]) ? std::max(0.0, std::atof(scale)) : 1.0;
+  const char* seed = std::getenv("CRSTUB_SEED");
+  m_rng.seed((seed && seed[0]) ? (uint32_t)std::strtoul(seed, nullptr, 0) : 0x5EEDu);
+
+  m_ops[(size_t)Op::Enum] = {300, 50, 0.0, SCRSDK::CrError_Adaptor_Unknown};
+  m_ops[(size_t)Op::Connect] = {800, 200, 0.0, SCRSDK::CrError_Connect_TimeOut};
+  m_ops[(size_t)Op::GetProps] = {15, 5, 0.0, SCRSDK::CrError_Connect_GetProperty};
+  m_ops[(size_t)Op::SetProp] = {20, 5, 0.0, SCRSDK::CrError_Api_InvalidCalled};
+  m_ops[(size_t)Op::SendCommand] = {30, 10, 0.0, SCRSDK::CrError_Api_InvalidCalled};
+  m_ops[(size_t)Op::LiveView] = {4, 2, 0.0, SCRSDK::CrError_Connect_GetProperty};
+
+  const char* count_env = std::getenv("CRSTUB_CAMERAS");
+  int count = (count_env && count_env[0]) ? std::atoi(count_env) : 1;
+  count = std::max(0, std::min(count, 8));
+  load_defaults(count);
+
+  const char* script = std::getenv("CRSTUB_CONFIG");
+  if (script && script[0]) load_script(script);
+
+  for (size_t i = 0; i < m_cameras.size(); ++i) {
+    generate_frames(m_cameras[i], (int)i);
+  }
+
+  std::sort(m_events.begin(), m_events.end(),
+            [](const ScriptEvent& a, const ScriptEvent& b) { return a.at_ms < b.at_ms; });
+  m_next_event = 0;
+  m_t0 = Clock::now();
+
+  m_cb_stop = false;
+  m_cb_thread = std::thread([this]() { callback_loop(); });
+  m_inited = true;
+
+  std::fprintf(stderr, "[crstub] Init: %zu camera(s), latency scale %.2f\n",
+               m_cameras.size(), m_latency_scale);
+  return true;
+}
+
+void World::shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_inited) return;
+    m_inited = false;
+    m_devices.clear();
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_cb_mutex);
+    m_cb_stop = true;
+  }
+  m_cb_cv.notify_all();
+  if (m_cb_thread.joinable()) m_cb_thread.join();
+  m_cb_queue.clear();
+}
+
+void World::load_defaults(int count) {
+  m_cameras.clear();
+  for (int i = 0; i < count; ++i) {
+    CameraModel cam;
+    if (i == 0) {
+      cam.model = "ILCE-7M4";
+      cam.conn = "USB";
+    } else {
+      char ip[32];
+      char mac[32];
+      std::snprintf(ip, sizeof(ip), "192.168.33.%d", 100 + i);
+      std::snprintf(mac, sizeof(mac), "02:00:5e:00:00:%02x", i);
+      cam.model = "ILME-FX6";
+      cam.conn = "Ethernet";
+      cam.ip = ip;
+      cam.mac = mac;
+    }
+    cam.fingerprint = default_fingerprint(i);
+    default_props(cam);
+    m_cameras.push_back(cam);
+  }
+}
+
+// Script format mirrors ccu_slots.conf: whitespace separated key=value
+// tokens, '#' comments. The first key selects the line kind:
+//   camera=<n> model=<m> conn=USB|Ethernet ip=<a> mac=<m> lv_fps=<n> lv_size=<w>x<h> prop.<code>=<v>
+//   op=<name> latency_ms=<n> jitter_ms=<n> fail_rate=<0..1> fail_err=<hex>
+//   event=disconnect|rec_stop camera=<n> at_ms=<n> offline_ms=<n>
+void World::load_script(const std::string& path) {
+  std::ifstream in(path);
+  if (!in.is_open()) {
+    std::fprintf(stderr, "[crstub] cannot open CRSTUB_CONFIG=%s\n", path.c_str());
+    return;
+  }
+
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') continue;
+
+    std::istringstream iss(line);
+    std::string tok;
+    std::vector<std::pair<std::string, std::string>> kvs;
+    while (iss >> tok) {
+      auto pos = tok.find('=');
+      if (pos == std::string::npos) continue;
+      kvs.emplace_back(tok.substr(0, pos), tok.substr(pos + 1));
+    }
+    if (kvs.empty()) continue;
+
+    const std::string& kind = kvs[0].first;
+    if (kind == "camera") {
+      const int idx = std::atoi(kvs[0].second.c_str());
+      if (idx < 0 || idx >= 8) continue;
+      while ((int)m_cameras.size() <= idx) {
+        CameraModel cam;
+        cam.fingerprint = default_fingerprint((int)m_cameras.size());
+        default_props(cam);
+        m_cameras.push_back(cam);
+      }
+      CameraModel& cam = m_cameras[(size_t)idx];
+      for (size_t i = 1; i < kvs.size(); ++i) {
+        const auto& k = kvs[i].first;
+        const auto& v = kvs[i].second;
+        if (k == "model") cam.model = v;
+        else if (k == "conn") cam.conn = v;
+        else if (k == "ip") cam.ip = v;
+        else if (k == "mac") cam.mac = v;
+        else if (k == "fingerprint") cam.fingerprint = v;
+        else if (k == "lv_fps") cam.lv_fps = (uint32_t)std::max(1, std::atoi(v.c_str()));
+        else if (k == "lv_size") std::sscanf(v.c_str(), "%ux%u", &cam.lv_width, &cam.lv_height);
+        else if (k == "online") cam.online = (v != "0");
+        else if (k.compare(0, 5, "prop.") == 0) {
+          const CrInt32u code = (CrInt32u)std::strtoul(k.c_str() + 5, nullptr, 0);
+          cam.props[code].current = std::strtoull(v.c_str(), nullptr, 0);
+        }
+      }
+    } else if (kind == "op") {
+      Op op;
+      if (!parse_op(kvs[0].second, op)) continue;
+      OpProfile& prof = m_ops[(size_t)op];
+      for (size_t i = 1; i < kvs.size(); ++i) {
+        const auto& k = kvs[i].first;
+        const auto& v = kvs[i].second;
+        if (k == "latency_ms") prof.latency_ms = (uint32_t)std::strtoul(v.c_str(), nullptr, 0);
+        else if (k == "jitter_ms") prof.jitter_ms = (uint32_t)std::strtoul(v.c_str(), nullptr, 0);
+        else if (k == "fail_rate") prof.fail_rate = std::atof(v.c_str());
+        else if (k == "fail_err") prof.fail_err = (SCRSDK::CrError)std::strtoul(v.c_str(), nullptr, 16);
+      }
+    } else if (kind == "event") {
+      ScriptEvent ev;
+      ev.kind = kvs[0].second;
+      for (size_t i = 1; i < kvs.size(); ++i) {
+        const auto& k = kvs[i].first;
+        const auto& v = kvs[i].second;
+        if (k == "camera") ev.camera = std::atoi(v.c_str());
+        else if (k == "at_ms") ev.at_ms = (uint32_t)std::strtoul(v.c_str(), nullptr, 0);
+        else if (k == "offline_ms") ev.offline_ms = (uint32_t)std::strtoul(v.c_str(), nullptr, 0);
+      }
+      m_events.push_back(ev);
+    }
+  }
+}
+
+void World::generate_frames(CameraModel& cam, int camera) {
+  cam.lv_frames.clear();
+#if defined(CRSTUB_HAVE_JPEG)
+  const uint32_t w = std::max(16u, cam.lv_width);
+  const uint32_t h = std::max(16u, cam.lv_height);
+  std::vector<uint8_t> rgb((size_t)w * h * 3);
+  for (uint32_t f = 0; f < kFramesPerCamera; ++f) {
+    // Luma ramp + moving bar, tinted per camera so mosaics are tellable apart.
+    const uint32_t bar_x = (w * f) / kFramesPerCamera;
+    for (uint32_t y = 0; y < h; ++y) {
+      uint8_t* row = rgb.data() + (size_t)y * w * 3;
+      for (uint32_t x = 0; x < w; ++x) {
+        uint8_t v = (uint8_t)((x * 255u) / (w - 1));
+        if (x >= bar_x && x < bar_x + w / 16) v = 255;
+        row[x * 3 + 0] = (uint8_t)std::min(255, v + ((camera & 1) ? 24 : 0));
+        row[x * 3 + 1] = (uint8_t)std::min(255, v + ((camera & 2) ? 24 : 0));
+        row[x * 3 + 2] = (uint8_t)std::min(255, v + ((camera & 4) ? 24 : 0));
+      }
+    }
+
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    unsigned char* out = nullptr;
+    unsigned long out_size = 0;
+    jpeg_mem_dest(&cinfo, &out, &out_size);
+    cinfo.image_width = w;
+    cinfo.image_height = h;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 80, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < cinfo.image_height) {
+      JSAMPROW r = rgb.data() + (size_t)cinfo.next_scanline * w * 3;
+      jpeg_write_scanlines(&cinfo, &r, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    cam.lv_frames.emplace_back(out, out + out_size);
+    jpeg_destroy_compress(&cinfo);
+    std::free(out);
+  }
+#else
+  (void)camera;
+  cam.lv_width = 16;
+  cam.lv_height = 16;
+  cam.lv_frames.emplace_back(kGreyJpeg, kGreyJpeg + sizeof(kGreyJpeg));
+#endif
+}
+
+SCRSDK::CrError World::simulate(Op op) {
+  OpProfile prof;
+  double u = 0.0;
+  uint32_t jitter = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    prof = m_ops[(size_t)op];
+    if (prof.jitter_ms) jitter = std::uniform_int_distribution<uint32_t>(0, prof.jitter_ms)(m_rng);
+    u = std::uniform_real_distribution<double>(0.0, 1.0)(m_rng);
+  }
+  const double ms = (double)(prof.latency_ms + jitter) * m_latency_scale;
+  if (ms > 0.0) {
+    std::this_thread::sleep_for(std::chrono::microseconds((int64_t)(ms * 1000.0)));
+  }
+  if (prof.fail_rate > 0.0 && u < prof.fail_rate) {
+    if (m_verbose) std::fprintf(stderr, "[crstub] injected failure op=%s err=0x%04X\n", op_name(op), (unsigned)prof.fail_err);
+    return prof.fail_err;
+  }
+  return SCRSDK::CrError_None;
+}
+
+bool World::camera_online(int camera) {
+  if (camera < 0 || camera >= (int)m_cameras.size()) return false;
+  CameraModel& cam = m_cameras[(size_t)camera];
+  if (!cam.online && cam.offline_until != Clock::time_point{} && Clock::now() >= cam.offline_until) {
+    cam.online = true;
+    cam.offline_until = Clock::time_point{};
+  }
+  return cam.online;
+}
+
+EnumCameraObjectInfo* World::enumerate() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto* list = new EnumCameraObjectInfo();
+  for (size_t i = 0; i < m_cameras.size(); ++i) {
+    if (!camera_online((int)i)) continue;
+    list->add(new CameraObjectInfo((int)i, m_cameras[i]));
+  }
+  return list;
+}
+
+int World::find_camera_by_ip(CrInt32u ip_host_order) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (size_t i = 0; i < m_cameras.size(); ++i) {
+    in_addr ina{};
+    if (m_cameras[i].ip.empty() || inet_pton(AF_INET, m_cameras[i].ip.c_str(), &ina) != 1) continue;
+    if ((CrInt32u)ntohl(ina.s_addr) == ip_host_order) return (int)i;
+  }
+  return -1;
+}
+
+int World::find_camera_by_serial(const char* serial) {
+  if (!serial) return -1;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (size_t i = 0; i < m_cameras.size(); ++i) {
+    char id[32];
+    std::snprintf(id, sizeof(id), "STUB%08d", (int)i);
+    if (std::strcmp(id, serial) == 0) return (int)i;
+  }
+  return -1;
+}
+
+std::string World::fingerprint(int camera) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (camera < 0 || camera >= (int)m_cameras.size()) return std::string();
+  return m_cameras[(size_t)camera].fingerprint;
+}
+
+World::Device* World::device(SCRSDK::CrDeviceHandle h) {
+  auto it = m_devices.find(h);
+  if (it == m_devices.end()) return nullptr;
+  return &it->second;
+}
+
+SCRSDK::CrError World::connect(int camera, SCRSDK::IDeviceCallback* cb, SCRSDK::CrDeviceHandle* out) {
+  const auto sim = simulate(Op::Connect);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!camera_online(camera)) return SCRSDK::CrError_Connect_TimeOut;
+  if (CR_FAILED(sim)) return sim;
+
+  for (auto& kv : m_devices) {
+    if (kv.second.camera == camera && kv.second.connected) return SCRSDK::CrError_Connect_SessionAlreadyOpened;
+  }
+
+  const SCRSDK::CrDeviceHandle h = m_next_handle++;
+  Device d;
+  d.camera = camera;
+  d.cb = cb;
+  d.connected = true;
+  m_devices[h] = d;
+  *out = h;
+
+  if (cb) {
+    post([cb]() { cb->OnConnected(SCRSDK::DEVICE_CONNECTION_VERSION_RCP3); });
+  }
+  return SCRSDK::CrError_None;
+}
+
+SCRSDK::CrError World::disconnect(SCRSDK::CrDeviceHandle h) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Device* d = device(h);
+  if (!d) return SCRSDK::CrError_Generic_InvalidHandle;
+  if (!d->connected) return SCRSDK::CrError_None;
+  d->connected = false;
+  auto* cb = d->cb;
+  if (cb) post([cb]() { cb->OnDisconnected(SCRSDK::CrError_None); });
+  return SCRSDK::CrError_None;
+}
+
+SCRSDK::CrError World::release_device(SCRSDK::CrDeviceHandle h) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_devices.erase(h) == 0) return SCRSDK::CrError_Generic_InvalidHandle;
+  }
+  // Like the SDK, no callback reaches the device's callback object once
+  // ReleaseDevice has returned, so the caller may free it.
+  flush_callbacks();
+  return SCRSDK::CrError_None;
+}
+
+SCRSDK::CrError World::get_properties(SCRSDK::CrDeviceHandle h, const CrInt32u* codes, CrInt32u num_codes,
+                                      SCRSDK::CrDeviceProperty** out, CrInt32* out_num) {
+  if (!out || !out_num) return SCRSDK::CrError_Generic_InvalidParameter;
+  *out = nullptr;
+  *out_num = 0;
+
+  const auto sim = simulate(Op::GetProps);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Device* d = device(h);
+  if (!d) return SCRSDK::CrError_Generic_InvalidHandle;
+  if (!d->connected) return SCRSDK::CrError_Connect_Disconnected;
+  if (CR_FAILED(sim)) return sim;
+
+  const CameraModel& cam = m_cameras[(size_t)d->camera];
+  std::vector<CrInt32u> want;
+  if (codes && num_codes > 0) {
+    for (CrInt32u i = 0; i < num_codes; ++i) {
+      if (cam.props.count(codes[i])) want.push_back(codes[i]);
+    }
+  } else {
+    for (const auto& kv : cam.props) want.push_back(kv.first);
+  }
+  if (want.empty()) return SCRSDK::CrError_None;
+
+  auto* props = new SCRSDK::CrDeviceProperty[want.size()];
+  for (size_t i = 0; i < want.size(); ++i) {
+    const PropModel& m = cam.props.at(want[i]);
+    SCRSDK::CrDeviceProperty& p = props[i];
+    p.SetCode(want[i]);
+    p.SetValueType(m.type);
+    p.SetCurrentValue(m.current);
+    p.SetPropertyEnableFlag(m.settable ? SCRSDK::CrEnableValue_True : SCRSDK::CrEnableValue_DisplayOnly);
+    p.SetPropertyVariableFlag(SCRSDK::CrEnableValue_Invariable);
+
+    const size_t es = element_size(m.type);
+    std::vector<CrInt8u> raw(m.values.size() * es);
+    for (size_t j = 0; j < m.values.size(); ++j) {
+      std::memcpy(raw.data() + j * es, &m.values[j], es);   // little-endian truncation
+    }
+    p.SetValueSize((CrInt32u)raw.size());
+    p.SetValues(raw.empty() ? nullptr : raw.data());
+    p.SetSetValueSize((CrInt32u)raw.size());
+    p.SetSetValues(raw.empty() ? nullptr : raw.data());
+  }
+  *out = props;
+  *out_num = (CrInt32)want.size();
+  return SCRSDK::CrError_None;
+}
+
+SCRSDK::CrError World::set_property(SCRSDK::CrDeviceHandle h, const SCRSDK::CrDeviceProperty& prop) {
+  const auto sim = simulate(Op::SetProp);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  Device* d = device(h);
+  if (!d) return SCRSDK::CrError_Generic_InvalidHandle;
+  if (!d->connected) return SCRSDK::CrError_Connect_Disconnected;
+  if (CR_FAILED(sim)) return sim;
+
+  const int camera = d->camera;
+  CameraModel& cam = m_cameras[(size_t)camera];
+  auto it = cam.props.find(prop.GetCode());
+  if (it == cam.props.end()) return SCRSDK::CrError_Api_InvalidCalled;
+  if (!it->second.settable) return SCRSDK::CrError_Api_InvalidCalled;
+  it->second.current = prop.GetCurrentValue();
+
+  std::vector<CrInt32u> changed{prop.GetCode()};
+  if (prop.GetCode() == SCRSDK::CrDeviceProperty_S1) {
+    auto& fi = cam.props[SCRSDK::CrDeviceProperty_FocusIndication];
+    fi.current = (prop.GetCurrentValue() == SCRSDK::CrLockIndicator_Locked)
+        ? SCRSDK::CrFocusIndicator_Focused_AF_S
+        : SCRSDK::CrFocusIndicator_Unlocked;
+    changed.push_back(SCRSDK::CrDeviceProperty_FocusIndication);
+  }
+  lock.unlock();
+  notify_props(camera, changed);
+  return SCRSDK::CrError_None;
+}
+
+SCRSDK::CrError World::send_command(SCRSDK::CrDeviceHandle h, CrInt32u cmd, SCRSDK::CrCommandParam param) {
+  const auto sim = simulate(Op::SendCommand);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  Device* d = device(h);
+  if (!d) return SCRSDK::CrError_Generic_InvalidHandle;
+  if (!d->connected) return SCRSDK::CrError_Connect_Disconnected;
+  if (CR_FAILED(sim)) return sim;
+
+  const int camera = d->camera;
+  auto* cb = d->cb;
+  CameraModel& cam = m_cameras[(size_t)camera];
+  auto& rec = cam.props[SCRSDK::CrDeviceProperty_RecordingState];
+  auto& rec_main = cam.props[SCRSDK::CrDeviceProperty_RecorderMainStatus];
+  bool rec_changed = false;
+
+  switch (cmd) {
+    case SCRSDK::CrCommandId_MovieRecord: {
+      const uint64_t want = (param == SCRSDK::CrCommandParam_Down) ? 1u : 0u;
+      rec_changed = (rec.current != want);
+      rec.current = want;
+      rec_main.current = want;
+      break;
+    }
+    case SCRSDK::CrCommandId_MovieRecButtonToggle:
+    case SCRSDK::CrCommandId_MovieRecButtonToggle2:
+      if (param == SCRSDK::CrCommandParam_Down) {
+        rec.current = rec.current ? 0u : 1u;
+        rec_main.current = rec.current;
+        rec_changed = true;
+      }
+      break;
+    case SCRSDK::CrCommandId_Release:
+    case SCRSDK::CrCommandId_S1andRelease:
+      if (param == SCRSDK::CrCommandParam_Up) {
+        auto& remain = cam.props[SCRSDK::CrDeviceProperty_MediaSLOT1_RemainingNumber];
+        if (remain.current > 0) remain.current--;
+        if (cb) post([cb]() { cb->OnWarning(SCRSDK::CrNotify_Captured_Event); });
+      }
+      break;
+    default:
+      break;
+  }
+  lock.unlock();
+
+  if (rec_changed) {
+    if (cb) post([cb]() { cb->OnWarning(SCRSDK::CrWarning_MovieRecordingOperation_Result_OK); });
+    notify_props(camera, {SCRSDK::CrDeviceProperty_RecordingState, SCRSDK::CrDeviceProperty_RecorderMainStatus});
+  }
+  return SCRSDK::CrError_None;
+}
+
+SCRSDK::CrError World::live_view_info(SCRSDK::CrDeviceHandle h, CrInt32u& buf_size, CrInt32u& w, CrInt32u& hgt) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Device* d = device(h);
+  if (!d) return SCRSDK::CrError_Generic_InvalidHandle;
+  if (!d->connected) return SCRSDK::CrError_Connect_Disconnected;
+  const CameraModel& cam = m_cameras[(size_t)d->camera];
+  size_t largest = 0;
+  for (const auto& f : cam.lv_frames) largest = std::max(largest, f.size());
+  // Like the vendor SDK, report generous headroom over the current frame size.
+  buf_size = (CrInt32u)(largest + largest / 2 + 4096);
+  w = cam.lv_width;
+  hgt = cam.lv_height;
+  return SCRSDK::CrError_None;
+}
+
+SCRSDK::CrError World::live_view_image(SCRSDK::CrDeviceHandle h, CrInt8u* buf, CrInt32u buf_size,
+                                       CrInt32u& frame_no, CrInt32u& image_size) {
+  const auto sim = simulate(Op::LiveView);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Device* d = device(h);
+  if (!d) return SCRSDK::CrError_Generic_InvalidHandle;
+  if (!d->connected) return SCRSDK::CrError_Connect_Disconnected;
+  if (CR_FAILED(sim)) return sim;
+  if (!d->lv_enabled) return SCRSDK::CrError_Api_InvalidCalled;
+
+  const CameraModel& cam = m_cameras[(size_t)d->camera];
+  if (cam.lv_frames.empty()) return SCRSDK::CrError_Api_NoApplicableInformation;
+
+  const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - m_t0).count();
+  const CrInt32u seq = (CrInt32u)(((uint64_t)elapsed * cam.lv_fps) / 1000000ull);
+  if (seq == d->last_lv_frame) return SCRSDK::CrWarning_Frame_NotUpdated;
+
+  const auto& frame = cam.lv_frames[seq % cam.lv_frames.size()];
+  if (!buf || frame.size() > buf_size) return SCRSDK::CrError_Memory_Insufficient;
+
+  std::memcpy(buf, frame.data(), frame.size());
+  d->last_lv_frame = seq;
+  frame_no = seq;
+  image_size = (CrInt32u)frame.size();
+  return SCRSDK::CrError_None;
+}
+
+SCRSDK::CrError World::live_view_properties(SCRSDK::CrDeviceHandle h, const CrInt32u* codes, CrInt32u num_codes,
+                                            SCRSDK::CrLiveViewProperty** out, CrInt32* out_num) {
+  if (!out || !out_num) return SCRSDK::CrError_Generic_InvalidParameter;
+  *out = nullptr;
+  *out_num = 0;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Device* d = device(h);
+  if (!d) return SCRSDK::CrError_Generic_InvalidHandle;
+  if (!d->connected) return SCRSDK::CrError_Connect_Disconnected;
+
+  bool want_af = (codes == nullptr || num_codes == 0);
+  for (CrInt32u i = 0; i < num_codes && codes; ++i) {
+    if (codes[i] == SCRSDK::CrLiveViewProperty_AF_Area_Position) want_af = true;
+  }
+  if (!want_af) return SCRSDK::CrError_None;
+
+  // Single centred focus frame, expressed like the SDK as fractions of the frame.
+  SCRSDK::CrFocusFrameInfo ffi;
+  ffi.type = SCRSDK::CrFocusFrameType_PhaseDetection_ImageSensor;
+  ffi.state = SCRSDK::CrFocusFrameState_NotFocused;
+  ffi.priority = 1;
+  ffi.xNumerator = 320;
+  ffi.xDenominator = 640;
+  ffi.yNumerator = 240;
+  ffi.yDenominator = 480;
+  ffi.width = 64;
+  ffi.height = 64;
+
+  auto* props = new SCRSDK::CrLiveViewProperty[1];
+  props[0].SetCode(SCRSDK::CrLiveViewProperty_AF_Area_Position);
+  props[0].SetPropertyEnableFlag(SCRSDK::CrEnableValue_True);
+  props[0].SetFrameInfoType(SCRSDK::CrFrameInfoType_FocusFrameInfo);
+  props[0].SetValueSize((CrInt32u)sizeof(ffi));
+  props[0].SetValue(reinterpret_cast<CrInt8u*>(&ffi));
+  *out = props;
+  *out_num = 1;
+  return SCRSDK::CrError_None;
+}
+
+SCRSDK::CrError World::get_setting(SCRSDK::CrDeviceHandle h, CrInt32u key, CrInt32u* value) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Device* d = device(h);
+  if (!d || !value) return SCRSDK::CrError_Generic_InvalidHandle;
+  if (key == SCRSDK::Setting_Key_EnableLiveView) {
+    *value = d->lv_enabled;
+    return SCRSDK::CrError_None;
+  }
+  *value = 0;
+  return SCRSDK::CrError_None;
+}
+
+SCRSDK::CrError World::set_setting(SCRSDK::CrDeviceHandle h, CrInt32u key, CrInt32u value) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Device* d = device(h);
+  if (!d) return SCRSDK::CrError_Generic_InvalidHandle;
+  if (key == SCRSDK::Setting_Key_EnableLiveView) d->lv_enabled = value;
+  return SCRSDK::CrError_None;
+}
+
+void World::notify_props(int camera, std::vector<CrInt32u> codes) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto& kv : m_devices) {
+    if (kv.second.camera != camera || !kv.second.connected || !kv.second.cb) continue;
+    auto* cb = kv.second.cb;
+    post([cb, codes]() mutable {
+      cb->OnPropertyChanged();
+      cb->OnPropertyChangedCodes((CrInt32u)codes.size(), codes.data());
+    });
+  }
+}
+
+void World::drop_camera(int camera, uint32_t offline_ms) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (camera < 0 || camera >= (int)m_cameras.size()) return;
+  CameraModel& cam = m_cameras[(size_t)camera];
+  cam.online = false;
+  cam.offline_until = offline_ms ? Clock::now() + std::chrono::milliseconds(offline_ms) : Clock::time_point{};
+  for (auto& kv : m_devices) {
+    if (kv.second.camera != camera || !kv.second.connected) continue;
+    kv.second.connected = false;
+    auto* cb = kv.second.cb;
+    if (cb) post([cb]() { cb->OnDisconnected(SCRSDK::CrError_Connect_Disconnected); });
+  }
+}
+
+void World::fire_event(const ScriptEvent& ev) {
+  std::fprintf(stderr, "[crstub] event %s camera=%d at_ms=%u\n", ev.kind.c_str(), ev.camera, ev.at_ms);
+  if (ev.kind == "disconnect") {
+    drop_camera(ev.camera, ev.offline_ms);
+  } else if (ev.kind == "rec_stop") {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (ev.camera < 0 || ev.camera >= (int)m_cameras.size()) return;
+      auto& cam = m_cameras[(size_t)ev.camera];
+      cam.props[SCRSDK::CrDeviceProperty_RecordingState].current = 0;
+      cam.props[SCRSDK::CrDeviceProperty_RecorderMainStatus].current = 0;
+    }
+    notify_props(ev.camera, {SCRSDK::CrDeviceProperty_RecordingState, SCRSDK::CrDeviceProperty_RecorderMainStatus});
+  }
+}
+
+void World::post(std::function<void()> fn) {
+  {
+    std::lock_guard<std::mutex> lock(m_cb_mutex);
+    m_cb_queue.push_back(std::move(fn));
+  }
+  m_cb_cv.notify_one();
+}
+
+// Waits until every callback queued so far has been delivered (no-op on the
+// callback thread itself, or once it has stopped).
+void World::flush_callbacks() {
+  if (std::this_thread::get_id() == m_cb_thread.get_id()) return;
+  auto done = std::make_shared<std::promise<void>>();
+  std::future<void> flushed = done->get_future();
+  {
+    std::lock_guard<std::mutex> lock(m_cb_mutex);
+    if (m_cb_stop || !m_cb_thread.joinable()) return;
+    m_cb_queue.push_back([done]() { done->set_value(); });
+  }
+  m_cb_cv.notify_one();
+  flushed.wait();
+}
+
+void World::callback_loop() {
+  std::unique_lock<std::mutex> lock(m_cb_mutex);
+  while (!m_cb_stop) {
+    if (!m_cb_queue.empty()) {
+      auto fn = std::move(m_cb_queue.front());
+      m_cb_queue.pop_front();
+      lock.unlock();
+      fn();
+      lock.lock();
+      continue;
+    }
+
+    if (m_next_event < m_events.size()) {
+      const auto due = m_t0 + std::chrono::milliseconds(m_events[m_next_event].at_ms);
+      if (Clock::now() >= due) {
+        const ScriptEvent ev = m_events[m_next_event++];
+        lock.unlock();
+        fire_event(ev);
+        lock.lock();
+        continue;
+      }
+      m_cb_cv.wait_until(lock, due);
+    } else {
+      m_cb_cv.wait(lock);
+    }
+  }
+}
+
+} // namespace crstub
@@ -0,0 +1,221 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CRSDK/CameraRemote_SDK.h"
+#include "CRSDK/IDeviceCallback.h"
+
+// Scriptable camera model behind the stub libCr_Core.
+//
+// Configuration (all optional):
+//   CRSTUB_CONFIG=<path>        script file, see docs/crsdk_stub.md
+//   CRSTUB_CAMERAS=<n>          number of default cameras (0..8)
+//   CRSTUB_LATENCY_SCALE=<f>    multiply every injected latency (0 = instant)
+//   CRSTUB_SEED=<n>             seed for jitter/failure injection
+//   CRSTUB_VERBOSE=1            log every SDK entry point to stderr
+namespace crstub {
+
+enum class Op : int {
+  Enum = 0,
+  Connect,
+  GetProps,
+  SetProp,
+  SendCommand,
+  LiveView,
+  Count
+};
+
+const char* op_name(Op op);
+
+struct OpProfile {
+  uint32_t latency_ms = 0;
+  uint32_t jitter_ms = 0;
+  double fail_rate = 0.0;
+  SCRSDK::CrError fail_err = SCRSDK::CrError_Generic_Unknown;
+};
+
+struct PropModel {
+  SCRSDK::CrDataType type = SCRSDK::CrDataType_UInt32;
+  uint64_t current = 0;
+  std::vector<uint64_t> values;
+  bool settable = true;
+};
+
+struct CameraModel {
+  std::string model = "ILCE-7M4";
+  std::string conn = "USB";           // "USB" or "Ethernet"
+  std::string ip;
+  std::string mac;
+  std::string fingerprint;
+  uint32_t lv_width = 640;
+  uint32_t lv_height = 360;
+  uint32_t lv_fps = 30;
+  bool online = true;
+  std::chrono::steady_clock::time_point offline_until{};
+  std::map<CrInt32u, PropModel> props;
+  std::vector<std::vector<uint8_t>> lv_frames;
+};
+
+struct ScriptEvent {
+  uint32_t at_ms = 0;
+  int camera = 0;
+  std::string kind;                   // "disconnect" | "rec_stop"
+  uint32_t offline_ms = 0;
+};
+
+class CameraObjectInfo final : public SCRSDK::ICrCameraObjectInfo {
+public:
+  CameraObjectInfo(int camera, const CameraModel& m);
+
+  int camera() const { return m_camera; }
+
+  void Release() override { delete this; }
+  CrChar* GetName() const override { return const_cast<CrChar*>(m_name.c_str()); }
+  CrInt32u GetNameSize() const override { return (CrInt32u)m_name.size(); }
+  CrChar* GetModel() const override { return const_cast<CrChar*>(m_model.c_str()); }
+  CrInt32u GetModelSize() const override { return (CrInt32u)m_model.size(); }
+  CrInt16 GetUsbPid() const override { return m_usb ? (CrInt16)0x0D9F : 0; }
+  CrInt8u* GetId() const override { return reinterpret_cast<CrInt8u*>(const_cast<char*>(m_id.c_str())); }
+  CrInt32u GetIdSize() const override { return (CrInt32u)m_id.size(); }
+  CrInt32u GetIdType() const override { return m_usb ? 1u : 2u; }
+  CrInt32u GetConnectionStatus() const override { return 0; }
+  CrChar* GetConnectionTypeName() const override { return const_cast<CrChar*>(m_conn.c_str()); }
+  CrChar* GetAdaptorName() const override { return const_cast<CrChar*>(m_adaptor.c_str()); }
+  CrChar* GetGuid() const override { return const_cast<CrChar*>(m_id.c_str()); }
+  CrChar* GetPairingNecessity() const override { return const_cast<CrChar*>("NotNecessary"); }
+  CrInt16u GetAuthenticationState() const override { return 0; }
+  CrInt32u GetSSHsupport() const override { return m_usb ? 0u : 1u; }
+  CrInt32u GetIPAddress() const override { return m_ip_num; }
+  CrChar* GetIPAddressChar() const override { return const_cast<CrChar*>(m_ip.c_str()); }
+  CrInt32u GetIPAddressCharSize() const override { return (CrInt32u)m_ip.size(); }
+  CrInt8u* GetMACAddress() const override { return const_cast<CrInt8u*>(m_mac_raw.data()); }
+  CrInt32u GetMACAddressSize() const override { return (CrInt32u)m_mac_raw.size(); }
+  CrChar* GetMACAddressChar() const override { return const_cast<CrChar*>(m_mac.c_str()); }
+  CrInt32u GetMACAddressCharSize() const override { return (CrInt32u)m_mac.size(); }
+
+private:
+  int m_camera;
+  bool m_usb;
+  std::string m_name;
+  std::string m_model;
+  std::string m_conn;
+  std::string m_adaptor;
+  std::string m_id;
+  std::string m_ip;
+  std::string m_mac;
+  CrInt32u m_ip_num = 0;
+  std::array<CrInt8u, 6> m_mac_raw{};
+};
+
+class EnumCameraObjectInfo final : public SCRSDK::ICrEnumCameraObjectInfo {
+public:
+  ~EnumCameraObjectInfo();
+  void add(CameraObjectInfo* info) { m_infos.push_back(info); }
+
+  CrInt32u GetCount() const override { return (CrInt32u)m_infos.size(); }
+  const SCRSDK::ICrCameraObjectInfo* GetCameraObjectInfo(CrInt32u index) const override {
+    return index < m_infos.size() ? m_infos[index] : nullptr;
+  }
+  void Release() override { delete this; }
+
+private:
+  std::vector<CameraObjectInfo*> m_infos;
+};
+
+// Process-wide emulated camera world. All SDK entry points funnel through
+// here; callbacks are delivered on a dedicated thread like the vendor SDK.
+class World {
+public:
+  static World& get();
+
+  bool init();
+  void shutdown();
+  bool inited() const { return m_inited; }
+  bool verbose() const { return m_verbose; }
+
+  // Sleeps the configured latency (+ jitter) for an operation and returns
+  // CrError_None, or the configured error when failure injection fires.
+  SCRSDK::CrError simulate(Op op);
+
+  EnumCameraObjectInfo* enumerate();
+  int find_camera_by_ip(CrInt32u ip_host_order);
+  int find_camera_by_serial(const char* serial);
+  std::string fingerprint(int camera);
+
+  SCRSDK::CrError connect(int camera, SCRSDK::IDeviceCallback* cb, SCRSDK::CrDeviceHandle* out);
+  SCRSDK::CrError disconnect(SCRSDK::CrDeviceHandle h);
+  SCRSDK::CrError release_device(SCRSDK::CrDeviceHandle h);
+
+  SCRSDK::CrError get_properties(SCRSDK::CrDeviceHandle h, const CrInt32u* codes, CrInt32u num_codes,
+                                 SCRSDK::CrDeviceProperty** out, CrInt32* out_num);
+  SCRSDK::CrError set_property(SCRSDK::CrDeviceHandle h, const SCRSDK::CrDeviceProperty& prop);
+  SCRSDK::CrError send_command(SCRSDK::CrDeviceHandle h, CrInt32u cmd, SCRSDK::CrCommandParam param);
+
+  SCRSDK::CrError live_view_info(SCRSDK::CrDeviceHandle h, CrInt32u& buf_size, CrInt32u& w, CrInt32u& hgt);
+  SCRSDK::CrError live_view_image(SCRSDK::CrDeviceHandle h, CrInt8u* buf, CrInt32u buf_size,
+                                  CrInt32u& frame_no, CrInt32u& image_size);
+  SCRSDK::CrError live_view_properties(SCRSDK::CrDeviceHandle h, const CrInt32u* codes, CrInt32u num_codes,
+                                       SCRSDK::CrLiveViewProperty** out, CrInt32* out_num);
+
+  SCRSDK::CrError get_setting(SCRSDK::CrDeviceHandle h, CrInt32u key, CrInt32u* value);
+  SCRSDK::CrError set_setting(SCRSDK::CrDeviceHandle h, CrInt32u key, CrInt32u value);
+
+private:
+  struct Device {
+    int camera = -1;
+    SCRSDK::IDeviceCallback* cb = nullptr;
+    bool connected = false;
+    CrInt32u last_lv_frame = 0xFFFFFFFFu;
+    CrInt32u lv_enabled = 1;
+  };
+
+  World() = default;
+
+  void load_defaults(int count);
+  void load_script(const std::string& path);
+  void generate_frames(CameraModel& cam, int camera);
+  Device* device(SCRSDK::CrDeviceHandle h);
+  bool camera_online(int camera);
+  void post(std::function<void()> fn);
+  void flush_callbacks();
+  void callback_loop();
+  void fire_event(const ScriptEvent& ev);
+  void notify_props(int camera, std::vector<CrInt32u> codes);
+  void drop_camera(int camera, uint32_t offline_ms);
+
+  std::mutex m_mutex;
+  bool m_inited = false;
+  bool m_verbose = false;
+  double m_latency_scale = 1.0;
+  std::mt19937 m_rng;
+  std::array<OpProfile, (size_t)Op::Count> m_ops{};
+  std::vector<CameraModel> m_cameras;
+  std::map<SCRSDK::CrDeviceHandle, Device> m_devices;
+  SCRSDK::CrDeviceHandle m_next_handle = 1;
+
+  std::chrono::steady_clock::time_point m_t0;
+  std::vector<ScriptEvent> m_events;
+  size_t m_next_event = 0;
+
+  std::mutex m_cb_mutex;
+  std::condition_variable m_cb_cv;
+  std::deque<std::function<void()>> m_cb_queue;
+  bool m_cb_stop = false;
+  std::thread m_cb_thread;
+};
+
+// Fill the library-owned fields of the image classes (stub_types.cpp).
+void fill_image_info(SCRSDK::CrImageInfo* info, CrInt32u width, CrInt32u height, CrInt32u buffer_size);
+void fill_image_block(SCRSDK::CrImageDataBlock* block, CrInt32u frame_no, CrInt32u image_size);
+
+} // namespace crstub
@@ -0,0 +1,280 @@
+// Out-of-line members of the SDK value classes (CrDeviceProperty,
+// CrLiveViewProperty, CrImageInfo, CrImageDataBlock, CrOSDImage*), which the
+// vendor ships inside libCr_Core.
+#include "stub_camera.hpp"
+#include <cstring>
+#include <type_traits>
+
+namespace SCRSDK {
+
+namespace {
+
+CrInt8u* dup_bytes(const CrInt8u* src, CrInt32u size) {
+  if (!src || size == 0) return nullptr;
+  auto* p = new CrInt8u[size];
+  std::memcpy(p, src, size);
+  return p;
+}
+
+CrInt16u* dup_str(const CrInt16u* src) {
+  if (!src) return nullptr;
+  // SDK strings are length-prefixed: first element holds the char count.
+  const CrInt32u n = (CrInt32u)src[0] + 1;
+  auto* p = new CrInt16u[n];
+  std::memcpy(p, src, n * sizeof(CrInt16u));
+  return p;
+}
+
+} // namespace
+
+// ------------------------------------------------------------
+// CrDeviceProperty
+// ------------------------------------------------------------
+
+CrDeviceProperty::CrDeviceProperty()
+  : code(0),
+    valueType(CrDataType_Undefined),
+    enableFlag(CrEnableValue_NotSupported),
+    variableFlag(CrEnableValue_Invalid),
+    currentValue(0),
+    currentStr(nullptr),
+    valuesSize(0),
+    values(nullptr),
+    getSetValuesSize(0),
+    getSetValues(nullptr) {}
+
+CrDeviceProperty::~CrDeviceProperty() {
+  delete[] currentStr;
+  delete[] values;
+  delete[] getSetValues;
+}
+
+CrDeviceProperty::CrDeviceProperty(const CrDeviceProperty& ref)
+  : code(ref.code),
+    valueType(ref.valueType),
+    enableFlag(ref.enableFlag),
+    variableFlag(ref.variableFlag),
+    currentValue(ref.currentValue),
+    currentStr(dup_str(ref.currentStr)),
+    valuesSize(ref.valuesSize),
+    values(dup_bytes(ref.values, ref.valuesSize)),
+    getSetValuesSize(ref.getSetValuesSize),
+    getSetValues(dup_bytes(ref.getSetValues, ref.getSetValuesSize)) {}
+
+CrDeviceProperty& CrDeviceProperty::operator=(const CrDeviceProperty& ref) {
+  if (this == &ref) return *this;
+  delete[] currentStr;
+  delete[] values;
+  delete[] getSetValues;
+  code = ref.code;
+  valueType = ref.valueType;
+  enableFlag = ref.enableFlag;
+  variableFlag = ref.variableFlag;
+  currentValue = ref.currentValue;
+  currentStr = dup_str(ref.currentStr);
+  valuesSize = ref.valuesSize;
+  values = dup_bytes(ref.values, ref.valuesSize);
+  getSetValuesSize = ref.getSetValuesSize;
+  getSetValues = dup_bytes(ref.getSetValues, ref.getSetValuesSize);
+  return *this;
+}
+
+void CrDeviceProperty::Alloc(const CrInt32u size, const CrInt32u getSetSize, const CrInt16u getStrSize) {
+  delete[] values;
+  delete[] getSetValues;
+  delete[] currentStr;
+  valuesSize = size;
+  values = size ? new CrInt8u[size]() : nullptr;
+  getSetValuesSize = getSetSize;
+  getSetValues = getSetSize ? new CrInt8u[getSetSize]() : nullptr;
+  currentStr = getStrSize ? new CrInt16u[getStrSize + 1u]() : nullptr;
+}
+
+bool CrDeviceProperty::IsGetEnableCurrentValue() const {
+  return enableFlag != CrEnableValue_NotSupported && enableFlag != CrEnableValue_False;
+}
+
+bool CrDeviceProperty::IsSetEnableCurrentValue() const {
+  return enableFlag == CrEnableValue_True;
+}
+
+void CrDeviceProperty::SetCode(CrInt32u c) { code = c; }
+CrInt32u CrDeviceProperty::GetCode() const { return code; }
+void CrDeviceProperty::SetValueType(CrDataType type) { valueType = type; }
+CrDataType CrDeviceProperty::GetValueType() const { return valueType; }
+void CrDeviceProperty::SetPropertyEnableFlag(CrPropertyEnableFlag flag) { enableFlag = flag; }
+CrPropertyEnableFlag CrDeviceProperty::GetPropertyEnableFlag() const { return enableFlag; }
+void CrDeviceProperty::SetPropertyVariableFlag(CrPropertyVariableFlag flag) { variableFlag = flag; }
+CrPropertyVariableFlag CrDeviceProperty::GetPropertyVariableFlag() const { return variableFlag; }
+void CrDeviceProperty::SetCurrentValue(CrInt64u value) { currentValue = value; }
+CrInt64u CrDeviceProperty::GetCurrentValue() const { return currentValue; }
+
+void CrDeviceProperty::SetCurrentStr(CrInt16u* str) {
+  delete[] currentStr;
+  currentStr = dup_str(str);
+}
+
+CrInt16u* CrDeviceProperty::GetCurrentStr() const { return currentStr; }
+
+// The size setters must precede the matching data setter, as with the
+// vendor library: SetValues copies exactly valuesSize bytes.
+void CrDeviceProperty::SetValueSize(CrInt32u size) { valuesSize = size; }
+CrInt32u CrDeviceProperty::GetValueSize() const { return valuesSize; }
+
+void CrDeviceProperty::SetValues(CrInt8u* value) {
+  delete[] values;
+  values = dup_bytes(value, valuesSize);
+}
+
+CrInt8u* CrDeviceProperty::GetValues() const { return values; }
+void CrDeviceProperty::SetSetValueSize(CrInt32u size) { getSetValuesSize = size; }
+CrInt32u CrDeviceProperty::GetSetValueSize() const { return getSetValuesSize; }
+
+void CrDeviceProperty::SetSetValues(CrInt8u* value) {
+  delete[] getSetValues;
+  getSetValues = dup_bytes(value, getSetValuesSize);
+}
+
+CrInt8u* CrDeviceProperty::GetSetValues() const { return getSetValues; }
+CrInt32u CrDeviceProperty::GetDisplayValueSize() const { return valuesSize; }
+CrInt8u* CrDeviceProperty::GetDisplayValues() const { return values; }
+
+// ------------------------------------------------------------
+// CrLiveViewProperty
+// ------------------------------------------------------------
+
+CrLiveViewProperty::CrLiveViewProperty()
+  : code(0),
+    enableFlag(CrEnableValue_NotSupported),
+    valueType(CrFrameInfoType_Unknown),
+    valueSize(0),
+    value(nullptr),
+    timeCode(0) {}
+
+CrLiveViewProperty::~CrLiveViewProperty() { delete[] value; }
+
+CrLiveViewProperty::CrLiveViewProperty(const CrLiveViewProperty& ref)
+  : code(ref.code),
+    enableFlag(ref.enableFlag),
+    valueType(ref.valueType),
+    valueSize(ref.valueSize),
+    value(dup_bytes(ref.value, ref.valueSize)),
+    timeCode(ref.timeCode) {}
+
+CrLiveViewProperty& CrLiveViewProperty::operator=(const CrLiveViewProperty& ref) {
+  if (this == &ref) return *this;
+  delete[] value;
+  code = ref.code;
+  enableFlag = ref.enableFlag;
+  valueType = ref.valueType;
+  valueSize = ref.valueSize;
+  value = dup_bytes(ref.value, ref.valueSize);
+  timeCode = ref.timeCode;
+  return *this;
+}
+
+void CrLiveViewProperty::Alloc(const CrInt32u size) {
+  delete[] value;
+  valueSize = size;
+  value = size ? new CrInt8u[size]() : nullptr;
+}
+
+bool CrLiveViewProperty::IsGetEnableCurrentValue() const {
+  return enableFlag != CrEnableValue_NotSupported && enableFlag != CrEnableValue_False;
+}
+
+void CrLiveViewProperty::SetCode(CrInt32u c) { code = c; }
+CrInt32u CrLiveViewProperty::GetCode() const { return code; }
+void CrLiveViewProperty::SetPropertyEnableFlag(CrPropertyEnableFlag flag) { enableFlag = flag; }
+CrPropertyEnableFlag CrLiveViewProperty::GetPropertyEnableFlag() const { return enableFlag; }
+void CrLiveViewProperty::SetFrameInfoType(CrFrameInfoType type) { valueType = type; }
+CrFrameInfoType CrLiveViewProperty::GetFrameInfoType() const { return valueType; }
+void CrLiveViewProperty::SetValueSize(CrInt32u size) { valueSize = size; }
+CrInt32u CrLiveViewProperty::GetValueSize() const { return valueSize; }
+
+void CrLiveViewProperty::SetValue(CrInt8u* v) {
+  delete[] value;
+  value = dup_bytes(v, valueSize);
+}
+
+CrInt8u* CrLiveViewProperty::GetValue() const { return value; }
+CrInt32u CrLiveViewProperty::GetTimeCode() const { return timeCode; }
+
+// ------------------------------------------------------------
+// Image blocks
+// ------------------------------------------------------------
+
+CrImageInfo::CrImageInfo() : width(0), height(0), bufferSize(0) {}
+CrImageInfo::~CrImageInfo() {}
+CrInt32u CrImageInfo::GetBufferSize() const { return bufferSize; }
+
+CrImageDataBlock::CrImageDataBlock() : frameNo(0), size(0), pData(nullptr), imageSize(0), timeCode(0) {}
+CrImageDataBlock::~CrImageDataBlock() {}   // pData is owned by the caller
+CrInt32u CrImageDataBlock::GetFrameNo() const { return frameNo; }
+void CrImageDataBlock::SetSize(CrInt32u s) { size = s; }
+CrInt32u CrImageDataBlock::GetSize() const { return size; }
+void CrImageDataBlock::SetData(CrInt8u* data) { pData = data; }
+CrInt32u CrImageDataBlock::GetImageSize() const { return imageSize; }
+CrInt8u* CrImageDataBlock::GetImageData() const { return pData; }
+CrInt32u CrImageDataBlock::GetTimeCode() const { return timeCode; }
+
+CrOSDImageMetaInfo::CrOSDImageMetaInfo()
+  : isLvPosExist(CrIsLvPosExist_Disable),
+    osdWidth(0),
+    osdHeight(0),
+    lvPosX(0),
+    lvPosY(0),
+    lvWidth(0),
+    lvHeight(0),
+    degree(0) {}
+CrOSDImageMetaInfo::~CrOSDImageMetaInfo() {}
+
+CrOSDImageDataBlock::CrOSDImageDataBlock() : frameNo(0), pData(nullptr), imageSize(0) {}
+CrOSDImageDataBlock::~CrOSDImageDataBlock() {}
+CrInt32u CrOSDImageDataBlock::GetFrameNo() const { return frameNo; }
+CrInt32u CrOSDImageDataBlock::GetImageSize() const { return imageSize; }
+CrInt8u* CrOSDImageDataBlock::GetImageData() const { return pData; }
+void CrOSDImageDataBlock::SetData(CrInt8u* data) { pData = data; }
+CrOSDImageMetaInfo CrOSDImageDataBlock::GetMetaInfo() const { return metaInfo; }
+
+} // namespace SCRSDK
+
+namespace crstub {
+
+// The image classes expose no setters for what the library fills in, so the
+// stub writes through a layout mirror of the private members.
+namespace {
+
+struct ImageInfoLayout {
+  CrInt32u width;
+  CrInt32u height;
+  CrInt32u bufferSize;
+};
+
+struct ImageDataBlockLayout {
+  CrInt32u frameNo;
+  CrInt32u size;
+  CrInt8u* pData;
+  CrInt32u imageSize;
+  CrInt32u timeCode;
+};
+
+static_assert(sizeof(ImageInfoLayout) == sizeof(SCRSDK::CrImageInfo), "CrImageInfo layout changed");
+static_assert(sizeof(ImageDataBlockLayout) == sizeof(SCRSDK::CrImageDataBlock), "CrImageDataBlock layout changed");
+
+} // namespace
+
+void fill_image_info(SCRSDK::CrImageInfo* info, CrInt32u width, CrInt32u height, CrInt32u buffer_size) {
+  ImageInfoLayout l{width, height, buffer_size};
+  std::memcpy(static_cast<void*>(info), &l, sizeof(l));
+}
+
+void fill_image_block(SCRSDK::CrImageDataBlock* block, CrInt32u frame_no, CrInt32u image_size) {
+  ImageDataBlockLayout l;
+  std::memcpy(&l, static_cast<const void*>(block), sizeof(l));
+  l.frameNo = frame_no;
+  l.imageSize = image_size;
+  std::memcpy(static_cast<void*>(block), &l, sizeof(l));
+}
+
+} // namespace crstub
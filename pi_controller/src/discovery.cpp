@@ -0,0 +1,93 @@
+#include "discovery.hpp"
+#include "async_log.hpp"
+#include "clock.hpp"
+#include "sony_backend.hpp"
+#include "trace.hpp"
+#include <chrono>
+#include <thread>
+
+namespace ccu {
+
+void Discovery::start() {
+  std::thread([this] { loop(); }).detach();
+}
+
+void Discovery::kick() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_kicked = true;
+  }
+  m_cv.notify_one();
+}
+
+std::shared_ptr<const Discovery::Snapshot> Discovery::snapshot() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_snapshot;
+}
+
+bool Discovery::scan(std::vector<Camera>& out) {
+  trace::Span span("discovery", "scan");
+  if (!ensure_sdk_init()) return false;
+  SCRSDK::ICrEnumCameraObjectInfo* enumInfo = nullptr;
+  const SCRSDK::CrError st = CCU_TRACE_SDK(EnumCameraObjects, ccu::trace::kNone, &enumInfo);
+  if (st == SCRSDK::CrError_Adaptor_EnumDevice) return true;  // what "no cameras" looks like
+  if (CR_FAILED(st) || !enumInfo) return false;
+
+  const CrInt32u count = enumInfo->GetCount();
+  for (CrInt32u i = 0; i < count; ++i) {
+    const auto* info = enumInfo->GetCameraObjectInfo(i);
+    if (!info) continue;
+    Camera c;
+    if (const char* s = info->GetModel()) c.model = s;
+    if (const char* s = info->GetConnectionTypeName()) c.conn = s;
+    if (const char* s = info->GetIPAddressChar()) c.ip = s;
+    if (const char* s = info->GetMACAddressChar()) c.mac = s;
+    if (c.conn != "USB") {
+      char fp[4096];
+      CrInt32u fp_size = (CrInt32u)sizeof(fp);
+      auto* mutable_info = const_cast<SCRSDK::ICrCameraObjectInfo*>(info);
+      const SCRSDK::CrError fst = CCU_TRACE_SDK(GetFingerprint, ccu::trace::kNone, mutable_info, fp, &fp_size);
+      c.fingerprint = !CR_FAILED(fst) && fp_size > 0;
+    }
+    out.push_back(std::move(c));
+  }
+  enumInfo->Release();
+  return true;
+}
+
+void Discovery::loop() {
+  trace::set_thread_name("discovery");
+  while (true) {
+    std::vector<Camera> cams;
+    const auto t0 = std::chrono::steady_clock::now();
+    const bool ok = scan(cams);
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+    if (ok) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto next = std::make_shared<Snapshot>();
+      next->scanned_us = monotonic_ns() / 1000;
+      next->version = m_snapshot->version;
+      if (next->version == 0 || cams != m_snapshot->cameras) {
+        next->version++;
+        CCU_LOG_INFO("discovery: %zu camera(s), list version %u (%lld ms)", cams.size(), (unsigned)next->version,
+                     (long long)ms);
+      }
+      next->cameras = std::move(cams);
+      m_snapshot = std::move(next);
+    } else {
+      CCU_LOG_DEBUG("discovery: scan failed (%lld ms), keeping list version %u", (long long)ms,
+                    (unsigned)snapshot()->version);
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait_for(lock, std::chrono::milliseconds(kIntervalMs), [this] { return m_kicked; });
+    m_kicked = false;
+  }
+}
+
+Discovery& discovery() {
+  static Discovery d;
+  return d;
+}
+
+} // namespace ccu
@@ -0,0 +1,54 @@
+#pragma once
+// Background camera discovery. EnumCameraObjects can take seconds (it scans
+// USB and probes the network), so it never runs on the request path: a
+// thread re-enumerates every kIntervalMs and whenever kick()ed (USB hotplug,
+// network link-up, CMD_DISCOVER), and CMD_LIST_CAMERAS serializes the last
+// result. The list's version changes only when its content does.
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ccu {
+
+class Discovery {
+public:
+  static constexpr uint32_t kIntervalMs = 10000;
+
+  struct Camera {
+    std::string model;
+    std::string conn;       // SDK connection type name ("USB", "IP", ...)
+    std::string ip;
+    std::string mac;
+    bool fingerprint = false;  // GetFingerprint answered (network cameras)
+
+    bool operator==(const Camera& o) const {
+      return model == o.model && conn == o.conn && ip == o.ip && mac == o.mac && fingerprint == o.fingerprint;
+    }
+  };
+
+  struct Snapshot {
+    uint32_t version = 0;     // 0 = no scan has succeeded yet
+    uint64_t scanned_us = 0;  // CLOCK_MONOTONIC of the last successful scan
+    std::vector<Camera> cameras;
+  };
+
+  void start();
+  void kick();
+  std::shared_ptr<const Snapshot> snapshot() const;
+
+private:
+  void loop();
+  bool scan(std::vector<Camera>& out);
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_kicked = false;
+  std::shared_ptr<const Snapshot> m_snapshot = std::make_shared<Snapshot>();
+};
+
+Discovery& discovery();
+
+} // namespace ccu
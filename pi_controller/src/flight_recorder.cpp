@@ -0,0 +1,178 @@
+#include "flight_recorder.hpp"
+#include "clock.hpp"
+#include "trace.hpp"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ccu {
+namespace flight {
+
+namespace {
+
+FileHeader* g_hdr = nullptr;
+uint8_t* g_slots = nullptr;
+uint64_t g_slot_count = 0;
+
+bool header_valid(const FileHeader& h) {
+  return std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 && h.version == kVersion &&
+         h.slot_bytes == kSlotBytes && h.slot_count > 0;
+}
+
+// Keeps the previous session's capture unless it never recorded anything.
+void rotate_previous(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return;
+  FileHeader h{};
+  const bool used = ::pread(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h) && header_valid(h) && h.head > 0;
+  ::close(fd);
+  if (used) std::rename(path.c_str(), (path + ".prev").c_str());
+}
+
+} // namespace
+
+bool open(const std::string& path, size_t bytes) {
+  if (g_hdr || bytes < kHeaderBytes + 64 * kSlotBytes) return false;
+  rotate_previous(path);
+
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) return false;
+  const uint64_t slot_count = (bytes - kHeaderBytes) / kSlotBytes;
+  const size_t map_bytes = kHeaderBytes + (size_t)slot_count * kSlotBytes;
+  if (::ftruncate(fd, (off_t)map_bytes) != 0) {
+    ::close(fd);
+    return false;
+  }
+  void* p = ::mmap(nullptr, map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) return false;
+
+  auto* hdr = static_cast<FileHeader*>(p);
+  std::memcpy(hdr->magic, kMagic, sizeof(kMagic));
+  hdr->version = kVersion;
+  hdr->slot_bytes = kSlotBytes;
+  hdr->slot_count = slot_count;
+  hdr->head = 0;
+  hdr->start_mono_ns = clock_ns(CLOCK_MONOTONIC);
+  hdr->start_wall_ns = clock_ns(CLOCK_REALTIME);
+  hdr->pid = (uint32_t)::getpid();
+
+  g_slots = static_cast<uint8_t*>(p) + kHeaderBytes;
+  g_slot_count = slot_count;
+  __atomic_store_n(&g_hdr, hdr, __ATOMIC_RELEASE);
+  return true;
+}
+
+bool enabled() {
+  return __atomic_load_n(&g_hdr, __ATOMIC_ACQUIRE) != nullptr;
+}
+
+void record(Kind kind, uint8_t source, uint32_t code, uint32_t result, const void* data, size_t len,
+            uint32_t aux) {
+  FileHeader* hdr = __atomic_load_n(&g_hdr, __ATOMIC_ACQUIRE);
+  if (!hdr) return;
+  if (len > kMaxPayload) len = kMaxPayload;
+  const uint64_t nslots = 1 + (len + kSlotBytes - 1) / kSlotBytes;
+  if (nslots > g_slot_count) return;
+  const uint64_t idx = __atomic_fetch_add(&hdr->head, nslots, __ATOMIC_RELAXED);
+
+  // Payload first (it may wrap past the end of the ring), header index last.
+  const auto* src = static_cast<const uint8_t*>(data);
+  for (uint64_t s = 1; s < nslots; ++s) {
+    const size_t off = (size_t)(s - 1) * kSlotBytes;
+    const size_t n = len - off < kSlotBytes ? len - off : kSlotBytes;
+    std::memcpy(g_slots + ((idx + s) % g_slot_count) * kSlotBytes, src + off, n);
+  }
+
+  auto* rh = reinterpret_cast<RecordHeader*>(g_slots + (idx % g_slot_count) * kSlotBytes);
+  __atomic_store_n(&rh->index, (uint64_t)0, __ATOMIC_RELAXED);
+  rh->ts_ns = clock_ns(CLOCK_MONOTONIC);
+  rh->code = code;
+  rh->result = result;
+  rh->len = (uint16_t)len;
+  rh->kind = kind;
+  rh->source = source;
+  rh->aux = aux;
+  __atomic_store_n(&rh->index, idx + 1, __ATOMIC_RELEASE);
+}
+
+void record_sdk_call(const char* fn, uint32_t code, uint32_t result, uint64_t start_ns) {
+  if (!enabled()) return;
+  const int slot = trace::current_slot();
+  const uint64_t dur_us = (clock_ns(CLOCK_MONOTONIC) - start_ns) / 1000;
+  record(KIND_SDK_CALL, slot >= 0 ? (uint8_t)slot : kNoSlot, code, result, fn, std::strlen(fn),
+         dur_us > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)dur_us);
+}
+
+void record_callback(int slot, const char* name, uint32_t code) {
+  if (!enabled()) return;
+  record(KIND_SDK_CALLBACK, slot >= 0 ? (uint8_t)slot : kNoSlot, code, 0, name, std::strlen(name));
+}
+
+bool read_file(const std::string& path, FileHeader& hdr, std::vector<Record>& out, std::string& err) {
+  out.clear();
+  FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) { err = "cannot open " + path; return false; }
+  std::vector<uint8_t> buf;
+  uint8_t chunk[65536];
+  size_t n = 0;
+  while ((n = std::fread(chunk, 1, sizeof(chunk), f)) > 0) buf.insert(buf.end(), chunk, chunk + n);
+  std::fclose(f);
+
+  if (buf.size() < kHeaderBytes) { err = "file too short"; return false; }
+  std::memcpy(&hdr, buf.data(), sizeof(hdr));
+  if (!header_valid(hdr)) { err = "not a ccu flight recording"; return false; }
+  const uint64_t count = hdr.slot_count;
+  if (buf.size() < kHeaderBytes + count * kSlotBytes) { err = "truncated recording"; return false; }
+  const uint8_t* slots = buf.data() + kHeaderBytes;
+
+  // Everything before head - count has been overwritten; records whose
+  // header no longer carries their own index were lapped or never committed.
+  // A record is only decoded if every slot it spans, payload included, lies
+  // in [head - count, head): outside that window the slots hold another
+  // lap's data, which would decode as garbage behind an intact header.
+  const uint64_t head = hdr.head;
+  const uint64_t oldest = head > count ? head - count : 0;
+  uint64_t i = oldest;
+  while (i < head) {
+    RecordHeader rh;
+    std::memcpy(&rh, slots + (i % count) * kSlotBytes, sizeof(rh));
+    const uint64_t nslots = 1 + ((uint64_t)rh.len + kSlotBytes - 1) / kSlotBytes;
+    const uint64_t last = i + nslots - 1;
+    if (rh.index != i + 1 || rh.len > kMaxPayload || nslots > count || i < oldest || last < i ||
+        last >= head) {
+      ++i;
+      continue;
+    }
+
+    Record r;
+    r.h = rh;
+    r.data.resize(rh.len);
+    for (uint64_t s = 1; s < nslots; ++s) {
+      const size_t off = (size_t)(s - 1) * kSlotBytes;
+      const size_t m = rh.len - off < kSlotBytes ? rh.len - off : kSlotBytes;
+      std::memcpy(r.data.data() + off, slots + ((i + s) % count) * kSlotBytes, m);
+    }
+    out.push_back(std::move(r));
+    i += nslots;
+  }
+  return true;
+}
+
+const char* kind_name(uint8_t kind) {
+  switch (kind) {
+    case KIND_FRAME_RX: return "rx";
+    case KIND_FRAME_TX: return "tx";
+    case KIND_SDK_CALL: return "sdk";
+    case KIND_SDK_CALLBACK: return "callback";
+    case KIND_START: return "start";
+    default: return "?";
+  }
+}
+
+} // namespace flight
+} // namespace ccu
@@ -0,0 +1,90 @@
+#pragma once
+// Always-on flight recorder: every CCU1 frame in and out, plus SDK call
+// results and callbacks, appended to a fixed-size ring in a memory-mapped
+// file. The file outlives a crash or a hung daemon, so a field session can
+// be copied off the Pi and re-run with tools/ccu_replay.
+//
+// Ring layout: a 4 KiB FileHeader, then slot_count 32-byte slots. A record
+// is one RecordHeader slot followed by ceil(len/32) payload slots; its
+// header carries its own slot index (+1), which is how a reader tells live
+// records from ones the ring has already lapped.
+#include "protocol.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ccu {
+namespace flight {
+
+static constexpr char kMagic[8] = {'C', 'C', 'U', 'F', 'L', 'T', '1', '\0'};
+static constexpr uint32_t kVersion = 1;
+static constexpr size_t kHeaderBytes = 4096;
+static constexpr size_t kSlotBytes = 32;
+static constexpr size_t kMaxPayload = MAX_FRAME_LEN;   // a whole CCU1 frame, never truncated
+
+enum Kind : uint8_t {
+  KIND_FRAME_RX = 1,      // code = peer IPv4 (UDP), result = peer port
+  KIND_FRAME_TX = 2,      // code = 1 if the send failed
+  KIND_SDK_CALL = 3,      // payload = function name, code = property/command, result = CrError
+  KIND_SDK_CALLBACK = 4,  // payload = callback name, code = its error/warning argument
+  KIND_START = 5,         // daemon start; payload = transport description
+};
+
+// Frame sources; SDK records use the slot (0..7) or kNoSlot.
+enum Source : uint8_t {
+  SRC_UDP = 0,
+  SRC_UART = 1,
+};
+static constexpr uint8_t kNoSlot = 0xFF;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t slot_bytes;
+  uint64_t slot_count;
+  uint64_t head;            // slots reserved so far (monotonic)
+  uint64_t start_mono_ns;   // CLOCK_MONOTONIC at open, for wall-clock mapping
+  uint64_t start_wall_ns;   // CLOCK_REALTIME at open
+  uint32_t pid;
+  uint32_t reserved;
+};
+
+struct RecordHeader {
+  uint64_t index;   // slot index + 1; stored last, 0 = never written
+  uint64_t ts_ns;   // CLOCK_MONOTONIC
+  uint32_t code;
+  uint32_t result;
+  uint16_t len;     // payload bytes
+  uint8_t kind;
+  uint8_t source;
+  uint32_t aux;     // SDK calls: duration in microseconds
+};
+static_assert(sizeof(RecordHeader) == kSlotBytes, "record header must fill one slot");
+
+// Maps (creating or resizing) the ring file. An existing capture is kept as
+// "<path>.prev" so a crash-restart does not overwrite the evidence.
+bool open(const std::string& path, size_t bytes);
+bool enabled();
+
+// Appends one record; lock-free and safe from any thread. No-op when closed.
+void record(Kind kind, uint8_t source, uint32_t code, uint32_t result, const void* data, size_t len,
+            uint32_t aux = 0);
+
+// start_ns is the call's CLOCK_MONOTONIC start (trace::Span::start_ns()).
+void record_sdk_call(const char* fn, uint32_t code, uint32_t result, uint64_t start_ns);
+void record_callback(int slot, const char* name, uint32_t code);
+
+// ---- Offline reader (ccu_replay) ----
+struct Record {
+  RecordHeader h;
+  std::vector<uint8_t> data;
+};
+
+// Reads every intact record of a capture, oldest first.
+bool read_file(const std::string& path, FileHeader& hdr, std::vector<Record>& out, std::string& err);
+
+const char* kind_name(uint8_t kind);
+
+} // namespace flight
+} // namespace ccu
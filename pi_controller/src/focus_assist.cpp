@@ -0,0 +1,318 @@
+#include "focus_assist.hpp"
+#include "async_log.hpp"
+#include "bytes.hpp"
+#include "clock.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+#ifdef CCU_HAVE_JPEG
+#include "jpeg_decoder.hpp"
+#include "jpeg_encoder.hpp"
+#endif
+
+namespace ccu {
+
+#ifdef CCU_HAVE_JPEG
+
+namespace {
+
+// The Laplacian's -4 centre tap needs signed 16-bit intermediates, so one
+// 128-bit register holds eight pixels; squares are summed in 32-bit lanes.
+typedef uint8_t V8u8 __attribute__((vector_size(8)));
+typedef int16_t V8s16 __attribute__((vector_size(16)));
+typedef int32_t V8s32 __attribute__((vector_size(32)));
+constexpr uint32_t kLanes = 8;
+
+// The region is the focus frame (or the centre), grown to at least a
+// quarter and capped at half of the image each way: a spot AF frame alone
+// is too small to judge, a wide one too costly.
+constexpr uint32_t kMinRoiDiv = 4;
+constexpr uint32_t kMaxRoiDiv = 2;
+
+V8s16 load8(const uint8_t* p) {
+  V8u8 v;
+  std::memcpy(&v, p, kLanes);
+  return __builtin_convertvector(v, V8s16);
+}
+
+// 4-neighbour Laplacian of row mid for x in [x0, x1) (x0 >= 1, x1 < row
+// width). Adds the sum and sum of squares; mag (optional) receives |L|
+// clamped to 255 at the same x.
+void laplacian_row(const uint8_t* up, const uint8_t* mid, const uint8_t* down, uint32_t x0, uint32_t x1,
+                   int64_t& sum, uint64_t& sq, uint8_t* mag) {
+  V8s32 vsum = {}, vsq = {};
+  const V8s16 k255 = V8s16{} + 255;
+  uint32_t x = x0;
+  // Per-lane int32 totals stay exact for rows up to 2048 pixels (|L| <= 1020).
+  for (; x + kLanes <= x1; x += kLanes) {
+    const V8s16 l = load8(mid + x) * 4 - load8(mid + x - 1) - load8(mid + x + 1) - load8(up + x) - load8(down + x);
+    const V8s32 l32 = __builtin_convertvector(l, V8s32);
+    vsum += l32;
+    vsq += l32 * l32;
+    if (mag) {
+      V8s16 m = l < 0 ? -l : l;
+      m = m > k255 ? k255 : m;
+      const V8u8 m8 = __builtin_convertvector(m, V8u8);
+      std::memcpy(mag + x, &m8, kLanes);
+    }
+  }
+  int64_t s = 0;
+  uint64_t q = 0;
+  for (uint32_t i = 0; i < kLanes; ++i) {
+    s += vsum[i];
+    q += (uint32_t)vsq[i];
+  }
+  for (; x < x1; ++x) {
+    const int l = 4 * mid[x] - mid[x - 1] - mid[x + 1] - up[x] - down[x];
+    s += l;
+    q += (uint64_t)(l * l);
+    if (mag) mag[x] = (uint8_t)std::min(l < 0 ? -l : l, 255);
+  }
+  sum += s;
+  sq += q;
+}
+
+} // namespace
+
+struct FocusAssist::State {
+  struct Source {
+    int slot = -1;
+    std::unique_ptr<FrameReader> reader;
+    double peak = 0;
+    uint64_t peak_ns = 0;
+    uint64_t decode_errors = 0;
+  };
+
+  std::vector<Source> sources;
+  JpegDecoder decoder;
+  JpegEncoder encoder;
+  std::vector<uint8_t> rows[3];    // rolling window of decoded rows
+  std::vector<uint8_t> mag;        // |Laplacian| of the middle row
+  std::vector<uint8_t> canvas;     // peaking picture, RGB
+
+  // Decodes the region of f and scores it; draws the peaking picture into
+  // canvas (roi_w x roi_h) when threshold is non-zero.
+  bool analyze(const LiveFrame& f, uint32_t threshold, Result& r, uint32_t& roi_w, uint32_t& roi_h) {
+    if (!decoder.begin(f.jpeg, f.size, UINT32_MAX, UINT32_MAX, true)) return false;
+    const uint32_t iw = decoder.width(), ih = decoder.height();
+    if (iw < 32 || ih < 32) return false;
+
+    const bool have_af = f.af.w != 0 && f.af.h != 0;
+    const uint32_t cx = have_af ? (uint32_t)(((uint64_t)f.af.x * iw) >> 16) : iw / 2;
+    const uint32_t cy = have_af ? (uint32_t)(((uint64_t)f.af.y * ih) >> 16) : ih / 2;
+    const uint32_t aw = have_af ? (uint32_t)(((uint64_t)f.af.w * iw) >> 16) : 0;
+    const uint32_t ah = have_af ? (uint32_t)(((uint64_t)f.af.h * ih) >> 16) : 0;
+    const uint32_t rw = std::min(std::max(aw, iw / kMinRoiDiv), iw / kMaxRoiDiv);
+    const uint32_t rh = std::min(std::max(ah, ih / kMinRoiDiv), ih / kMaxRoiDiv);
+    const uint32_t rx = std::min(cx > rw / 2 ? cx - rw / 2 : 0, iw - rw);
+    const uint32_t ry = std::min(cy > rh / 2 ? cy - rh / 2 : 0, ih - rh);
+
+    // Columns outside the region are not decoded; rows above it are
+    // skipped and rows below it never read.
+    uint32_t dx = rx, dw = rw;
+    if (!decoder.crop(dx, dw)) return false;
+    const uint32_t off = rx - dx;
+    if (ry && !decoder.skip_rows(ry)) return false;
+    for (auto& row : rows)
+      if (row.size() < dw) row.resize(dw);
+    if (threshold) {
+      if (mag.size() < dw) mag.resize(dw);
+      canvas.resize((size_t)rw * rh * 3);
+    }
+
+    int64_t sum = 0;
+    uint64_t sq = 0;
+    for (uint32_t y = 0; y < rh; ++y) {
+      if (!decoder.read_row(rows[y % 3].data())) return false;
+      // Border rows have no full neighbourhood: plain image.
+      if (threshold && (y == 0 || y == rh - 1)) draw_row(rows[y % 3].data() + off, nullptr, rw, threshold, y);
+      if (y < 2) continue;
+      const uint8_t* up = rows[(y - 2) % 3].data();
+      const uint8_t* mid = rows[(y - 1) % 3].data();
+      const uint8_t* down = rows[y % 3].data();
+      laplacian_row(up, mid, down, off + 1, off + rw - 1, sum, sq, threshold ? mag.data() : nullptr);
+      if (threshold) draw_row(mid + off, mag.data() + off, rw, threshold, y - 1);
+    }
+
+    const uint64_t n = (uint64_t)(rw - 2) * (rh - 2);
+    const double mean = (double)sum / (double)n;
+    const double var = (double)sq / (double)n - mean * mean;
+    r.score = (uint32_t)std::min(std::max(var, 0.0) + 0.5, 4294967295.0);
+    r.af_from_camera = have_af;
+    r.focused = have_af && f.af.focused;
+    r.roi[0] = (uint8_t)((uint64_t)rx * 256 / iw);
+    r.roi[1] = (uint8_t)((uint64_t)ry * 256 / ih);
+    r.roi[2] = (uint8_t)std::min<uint64_t>((uint64_t)rw * 256 / iw, 255);
+    r.roi[3] = (uint8_t)std::min<uint64_t>((uint64_t)rh * 256 / ih, 255);
+    r.frame_seq = (uint32_t)f.seq;
+    r.captured_ns = f.captured_ns;
+    r.valid = true;
+    roi_w = rw;
+    roi_h = rh;
+    return true;
+  }
+
+  // One peaking row: the image dimmed to make room for the marks, edges
+  // (|L| >= threshold) in red. The first and last column have no |L|.
+  void draw_row(const uint8_t* luma, const uint8_t* m, uint32_t w, uint32_t threshold, uint32_t y) {
+    uint8_t* out = canvas.data() + (size_t)y * w * 3;
+    for (uint32_t x = 0; x < w; ++x, out += 3) {
+      const bool edge = m && x > 0 && x + 1 < w && m[x] >= threshold;
+      const uint8_t g = (uint8_t)(luma[x] / 2 + 32);
+      out[0] = edge ? 255 : g;
+      out[1] = edge ? 32 : g;
+      out[2] = edge ? 32 : g;
+    }
+  }
+};
+
+FocusAssist::FocusAssist() = default;
+FocusAssist::~FocusAssist() = default;
+
+bool FocusAssist::start(uint32_t hz, uint32_t peak_threshold) {
+  if (m_hz != 0 || hz == 0) return false;
+  auto st = std::make_unique<State>();
+  for (int i = 0; i < MetricsRegistry::kSlots; ++i) {
+    if (!live_view(i).running()) continue;
+    live_view(i).track_focus_area(true);
+    State::Source s;
+    s.slot = i;
+    s.reader = std::make_unique<FrameReader>(live_view(i));
+    st->sources.push_back(std::move(s));
+  }
+  if (st->sources.empty()) return false;
+
+  CCU_LOG_INFO("focus assist: %u camera(s) at %u Hz, peaking %s", (unsigned)st->sources.size(), (unsigned)hz,
+               peak_threshold ? "on" : "off");
+  m_state = std::move(st);
+  m_peak_threshold = peak_threshold;
+  m_hz = hz;
+  std::thread([this] { loop(); }).detach();
+  return true;
+}
+
+void FocusAssist::loop() {
+  trace::set_thread_name("focus");
+  State& st = *m_state;
+  const auto period = std::chrono::microseconds(1000000 / m_hz);
+  auto next = std::chrono::steady_clock::now();
+
+  while (true) {
+    std::this_thread::sleep_until(next);
+    next = std::max(next + period, std::chrono::steady_clock::now());
+    for (State::Source& s : st.sources) {
+      const FrameRef f = s.reader->next();
+      if (!f) continue;
+      Result r;
+      uint32_t w = 0, h = 0;
+      if (!st.analyze(*f, m_peak_threshold, r, w, h)) {
+        if (s.decode_errors++ == 0) CCU_LOG_WARN("focus assist: slot %d: undecodable live-view frame", s.slot);
+        continue;
+      }
+
+      // Reference peak: the best score lately, decaying so that a scene
+      // change does not pin the relative reading low forever.
+      const uint64_t now = monotonic_ns();
+      if (s.peak_ns) s.peak -= s.peak * std::min(1.0, (double)(now - s.peak_ns) / (kPeakDecayMs * 1e6));
+      s.peak = std::max(s.peak, (double)r.score);
+      s.peak_ns = now;
+      r.rel_permille = s.peak > 0 ? (uint16_t)std::min(1000.0, r.score * 1000.0 / s.peak + 0.5) : 0;
+      {
+        std::lock_guard<std::mutex> lk(m_mu);
+        m_results[(size_t)s.slot] = r;
+      }
+
+      if (!m_peak_threshold) continue;
+      PeakingView& view = m_views[(size_t)s.slot];
+      if (!view.pool()) view.add_pool(kPeakingFrames, (size_t)w * h);
+      FramePool& p = *view.pool();
+      const int idx = p.acquire_for_write();
+      if (idx < 0) continue;  // viewers hold every buffer; next frame
+      const size_t size =
+        st.encoder.encode(st.canvas.data(), w, h, (size_t)w * 3, false, kPeakingQuality, p.data(idx), p.buffer_bytes());
+      if (size == 0) {
+        p.abandon_write(idx);
+        view.add_pool(kPeakingFrames, p.buffer_bytes() * 2);
+        continue;
+      }
+      LiveFrame& out = p.frame(idx);
+      out.jpeg = p.data(idx);
+      out.size = size;
+      out.frame_no = f->frame_no;
+      out.captured_ns = f->captured_ns;
+      out.af = f->af;
+      view.publish(idx);
+    }
+  }
+}
+
+#else  // !CCU_HAVE_JPEG
+
+struct FocusAssist::State {};
+
+FocusAssist::FocusAssist() = default;
+FocusAssist::~FocusAssist() = default;
+
+bool FocusAssist::start(uint32_t, uint32_t) {
+  CCU_LOG_WARN("focus assist: ccu_daemon was built without libjpeg");
+  return false;
+}
+
+void FocusAssist::loop() {}
+
+#endif
+
+size_t FocusAssist::build_payload(uint8_t mask, uint8_t* out, size_t out_max) const {
+  std::array<Result, 8> results;
+  {
+    std::lock_guard<std::mutex> lk(m_mu);
+    results = m_results;
+  }
+  const uint64_t now = monotonic_ns();
+  uint8_t* p = out;
+  if (out_max < 2) return 0;
+  *p++ = kVersion;
+  uint8_t* count = p++;
+  *count = 0;
+  for (int slot = 0; slot < 8; ++slot) {
+    if (!((mask >> slot) & 1u)) continue;
+    if ((size_t)(p - out) + kRecordBytes > out_max) return 0;
+    const Result& r = results[(size_t)slot];
+    uint64_t age_ms = 0xFFFF;
+    uint8_t flags = 0;
+    if (r.valid) {
+      age_ms = now > r.captured_ns ? (now - r.captured_ns) / 1000000ull : 0;
+      flags |= 0x01;
+      if (age_ms > kStaleMs) flags |= 0x02;
+      if (r.af_from_camera) flags |= 0x04;
+      if (r.focused) flags |= 0x08;
+    }
+    *p++ = (uint8_t)slot;
+    *p++ = flags;
+    put32(p, r.frame_seq);
+    p += 4;
+    put16(p, (uint16_t)std::min<uint64_t>(age_ms, 0xFFFF));
+    p += 2;
+    put32(p, r.score);
+    p += 4;
+    put16(p, r.rel_permille);
+    p += 2;
+    std::memcpy(p, r.roi, sizeof(r.roi));
+    p += sizeof(r.roi);
+    ++*count;
+  }
+  return (size_t)(p - out);
+}
+
+FocusAssist& focus_assist() {
+  static FocusAssist f;
+  return f;
+}
+
+} // namespace ccu
@@ -0,0 +1,78 @@
+#pragma once
+// Focus assist: a sharpness score for every live-view slot, so focus pulls
+// on remote-controlled cameras can be judged from the CCU.
+//
+// The score is the variance of the 4-neighbour Laplacian over a region
+// around the camera's focus frame (AF_Area_Position, see
+// LiveViewEngine::track_focus_area), or the centre of the image when the
+// camera reports none. Only that region is decoded, at full resolution: a
+// scaled decode would throw away exactly the detail being measured. The
+// absolute score depends on the scene, so each slot also reports it
+// relative to a slowly decaying peak, which is what a focus pull watches.
+//
+// Optionally the region is also published as a peaking picture (edges
+// above a threshold painted red on a dimmed image) at /focus/<n>.
+#include "live_view.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace ccu {
+
+// One slot's peaking picture; FocusAssist publishes into it.
+class PeakingView : public FrameChannel {
+  friend class FocusAssist;
+};
+
+class FocusAssist {
+public:
+  static constexpr uint8_t kVersion = 1;
+  static constexpr size_t kRecordBytes = 18;
+  static constexpr uint32_t kStaleMs = 2000;       // no new frame for this long: flagged stale
+  static constexpr uint32_t kPeakDecayMs = 20000;  // reference peak falls to 0 over this time
+  static constexpr uint32_t kPeakingFrames = 4;
+  static constexpr int kPeakingQuality = 80;
+
+  FocusAssist();
+  ~FocusAssist();
+
+  // Scores the slots whose live view is running, at most hz frames per
+  // second each; call after starting them. peak_threshold > 0 also renders
+  // peaking pictures, marking pixels whose |Laplacian| reaches it. False if
+  // there are no slots or the daemon was built without libjpeg.
+  bool start(uint32_t hz, uint32_t peak_threshold);
+  bool running() const { return m_hz != 0; }
+  bool peaking() const { return m_peak_threshold != 0; }
+  const PeakingView& peaking_view(int slot) const { return m_views[(size_t)(slot & 7)]; }
+
+  // u8 version, u8 count, then one record per slot in mask (bit per slot).
+  // Returns the bytes written, 0 if out is too small.
+  size_t build_payload(uint8_t mask, uint8_t* out, size_t out_max) const;
+
+private:
+  struct Result {
+    bool valid = false;
+    bool af_from_camera = false;
+    bool focused = false;
+    uint32_t frame_seq = 0;
+    uint64_t captured_ns = 0;
+    uint32_t score = 0;
+    uint16_t rel_permille = 0;
+    uint8_t roi[4] = {};   // x, y, w, h in 1/256 of the frame
+  };
+  struct State;
+  void loop();
+
+  uint32_t m_hz = 0;
+  uint32_t m_peak_threshold = 0;
+  std::unique_ptr<State> m_state;
+  std::array<PeakingView, 8> m_views;
+  mutable std::mutex m_mu;
+  std::array<Result, 8> m_results;
+};
+
+FocusAssist& focus_assist();
+
+} // namespace ccu
@@ -0,0 +1,114 @@
+#include "frame_channel.hpp"
+#include <algorithm>
+#include <climits>
+#include <linux/futex.h>
+#include <new>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace ccu {
+
+static constexpr size_t kBufferAlign = 64;
+
+FramePool::FramePool(uint32_t frames, size_t buffer_bytes)
+    : m_frames(frames), m_buffers(new Buffer[frames]), m_buffer_bytes(buffer_bytes) {
+  m_stride = (buffer_bytes + kBufferAlign - 1) & ~(kBufferAlign - 1);
+  m_storage = static_cast<uint8_t*>(::operator new(m_stride * frames, std::align_val_t(kBufferAlign)));
+}
+
+FramePool::~FramePool() {
+  ::operator delete(m_storage, std::align_val_t(kBufferAlign));
+}
+
+int FramePool::acquire_for_write() {
+  for (uint32_t i = 0; i < m_frames; ++i) {
+    uint32_t expected = 0;
+    if (m_buffers[i].refs.compare_exchange_strong(expected, kWriting, std::memory_order_acquire,
+                                                  std::memory_order_relaxed))
+      return (int)i;
+  }
+  return -1;
+}
+
+bool FramePool::try_ref(int idx) {
+  std::atomic<uint32_t>& refs = m_buffers[(size_t)idx].refs;
+  uint32_t r = refs.load(std::memory_order_relaxed);
+  while (r != 0 && !(r & kWriting)) {
+    if (refs.compare_exchange_weak(r, r + 1, std::memory_order_acquire, std::memory_order_relaxed)) return true;
+  }
+  return false;
+}
+
+FrameRef FrameChannel::latest() const {
+  // The published buffer can be recycled between reading m_latest and
+  // taking the reference; the seq check catches that and we look again.
+  for (int attempt = 0; attempt < 8; ++attempt) {
+    const uint64_t packed = m_latest.load(std::memory_order_acquire);
+    if (packed == 0) return {};
+    FramePool* pool = m_pools[(packed >> 8) & 0xFF].get();
+    const int idx = (int)(packed & 0xFF);
+    if (!pool->try_ref(idx)) continue;
+    if (pool->frame(idx).seq == (packed >> 16)) return FrameRef(pool, idx);
+    pool->unref(idx);
+  }
+  return {};
+}
+
+bool FrameChannel::wait_newer(uint64_t seq, std::chrono::milliseconds timeout) const {
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (latest_seq() <= seq) {
+    const auto left = deadline - std::chrono::steady_clock::now();
+    if (left <= std::chrono::steady_clock::duration::zero()) return false;
+    const uint32_t word = m_notify.load(std::memory_order_acquire);
+    if (latest_seq() > seq) break;
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+    timespec ts{(time_t)(ns / 1000000000), (long)(ns % 1000000000)};
+    m_waiters.fetch_add(1, std::memory_order_acq_rel);
+    // Pairs with the fence in publish: either it sees this waiter, or the
+    // futex compare below sees its new word.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_notify), FUTEX_WAIT_PRIVATE, word, &ts, nullptr, 0);
+    m_waiters.fetch_sub(1, std::memory_order_acq_rel);
+  }
+  return true;
+}
+
+bool FrameChannel::add_pool(uint32_t frames, size_t buffer_bytes) {
+  const size_t current = pool() ? pool()->buffer_bytes() : 0;
+  buffer_bytes = std::min(std::max(buffer_bytes, current * 2), kMaxBufferBytes);
+  if (m_pool_count >= kMaxPools || buffer_bytes <= current) return false;
+  m_pools[m_pool_count] = std::make_unique<FramePool>(frames, buffer_bytes);
+  ++m_pool_count;
+  return true;
+}
+
+void FrameChannel::publish(int idx) {
+  const uint64_t seq = ++m_seq;
+  const uint64_t gen = m_pool_count - 1;
+  FramePool* p = m_pools[gen].get();
+  p->frame(idx).seq = seq;
+  p->finish_write(idx);
+  const uint64_t packed = (seq << 16) | (gen << 8) | (uint64_t)idx;
+  const uint64_t prev = m_latest.exchange(packed, std::memory_order_acq_rel);
+  // Drop the old frame's published reference; consumers may still hold it.
+  if (prev != 0) m_pools[(prev >> 8) & 0xFF]->unref((int)(prev & 0xFF));
+  m_notify.store((uint32_t)seq, std::memory_order_release);
+  // The store must be ordered before the waiters load, or a reader that has
+  // just registered could sleep on the old word and miss this frame.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_waiters.load(std::memory_order_acquire) != 0)
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_notify), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+FrameRef FrameReader::next(uint32_t* skipped) {
+  FrameRef f = m_channel->latest();
+  if (!f || f->seq <= m_last_seq) return {};
+  const uint64_t missed = m_last_seq == 0 ? 0 : f->seq - m_last_seq - 1;
+  m_skipped_total += missed;
+  m_last_seq = f->seq;
+  if (skipped) *skipped = (uint32_t)std::min<uint64_t>(missed, UINT32_MAX);
+  return f;
+}
+
+} // namespace ccu
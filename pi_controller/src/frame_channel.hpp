@@ -0,0 +1,176 @@
+#pragma once
+// Latest-wins frame publication between one writer thread and any number
+// of readers, used by the live-view engine (live_view.hpp). Frames live in
+// fixed pools of buffers and are handed out by reference: a reader holds a
+// FrameRef to the pooled JPEG instead of copying it.
+//
+// Publishing is lock-free on both sides. The newest frame is one atomic
+// word (sequence, pool, buffer); a consumer takes a reference to whatever
+// is newest when it asks, and a FrameReader tells it how many frames it
+// skipped since its previous read. The writer never waits for a consumer:
+// it fills any buffer nobody references, and if slow consumers hold them
+// all it skips that frame.
+//
+// Memory: a writer that needs larger buffers gets a new pool with at least
+// twice the buffer size; old pools are kept because a consumer may still
+// hold one of their frames. Buffers are capped at
+// FrameChannel::kMaxBufferBytes, so all pools of a channel add up to less
+// than frames x 3 x kMaxBufferBytes (144 MiB for a live-view slot in the
+// worst case).
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace ccu {
+
+// The camera's main focus frame (AF_Area_Position live-view property):
+// centre and size as fractions of the image in 1/65536 units. w == 0 when
+// unknown or not tracked.
+struct FocusArea {
+  uint16_t x = 0, y = 0, w = 0, h = 0;
+  bool focused = false;      // the camera reports the frame in focus
+};
+
+struct LiveFrame {
+  const uint8_t* jpeg = nullptr;
+  size_t size = 0;
+  uint32_t frame_no = 0;     // SDK frame counter
+  uint64_t seq = 0;          // engine publish sequence, from 1
+  uint64_t captured_ns = 0;  // CLOCK_MONOTONIC when the fetch returned
+  FocusArea af;              // as of the last refresh (track_focus_area)
+};
+
+// Fixed set of equally sized frame buffers in one allocation. A buffer's
+// reference count is 0 when free, kWriting while the fetch thread fills it,
+// and otherwise counts the published slot plus consumer handles.
+class FramePool {
+public:
+  static constexpr uint32_t kWriting = 0x80000000u;
+
+  FramePool(uint32_t frames, size_t buffer_bytes);
+  ~FramePool();
+  FramePool(const FramePool&) = delete;
+  FramePool& operator=(const FramePool&) = delete;
+
+  size_t buffer_bytes() const { return m_buffer_bytes; }
+  uint32_t frames() const { return m_frames; }
+
+  // Fetch thread: claims a free buffer for writing, or -1 if every buffer
+  // is referenced.
+  int acquire_for_write();
+  // Fetch thread: the buffer is filled; it now holds one reference.
+  void finish_write(int idx) { m_buffers[(size_t)idx].refs.store(1, std::memory_order_release); }
+  // Fetch thread: nothing was written; the buffer is free again.
+  void abandon_write(int idx) { m_buffers[(size_t)idx].refs.store(0, std::memory_order_release); }
+  uint8_t* data(int idx) { return m_storage + (size_t)idx * m_stride; }
+  LiveFrame& frame(int idx) { return m_buffers[(size_t)idx].frame; }
+  const LiveFrame& frame(int idx) const { return m_buffers[(size_t)idx].frame; }
+
+  // Adds a reference unless the buffer is free or being written.
+  bool try_ref(int idx);
+  void ref(int idx) { m_buffers[(size_t)idx].refs.fetch_add(1, std::memory_order_relaxed); }
+  void unref(int idx) { m_buffers[(size_t)idx].refs.fetch_sub(1, std::memory_order_acq_rel); }
+
+private:
+  struct Buffer {
+    LiveFrame frame;
+    std::atomic<uint32_t> refs{0};
+  };
+
+  const uint32_t m_frames;
+  std::unique_ptr<Buffer[]> m_buffers;
+  uint8_t* m_storage = nullptr;
+  size_t m_stride = 0;
+  size_t m_buffer_bytes = 0;
+};
+
+// Shared, read-only handle to a pooled frame. The buffer becomes reusable
+// when the last handle is dropped.
+class FrameRef {
+public:
+  FrameRef() = default;
+  FrameRef(FramePool* pool, int idx) : m_pool(pool), m_idx(idx) {}  // adopts a reference
+  FrameRef(const FrameRef& o) : m_pool(o.m_pool), m_idx(o.m_idx) { if (m_pool) m_pool->ref(m_idx); }
+  FrameRef(FrameRef&& o) noexcept : m_pool(o.m_pool), m_idx(o.m_idx) { o.m_pool = nullptr; }
+  FrameRef& operator=(FrameRef o) noexcept {
+    std::swap(m_pool, o.m_pool);
+    std::swap(m_idx, o.m_idx);
+    return *this;
+  }
+  ~FrameRef() { if (m_pool) m_pool->unref(m_idx); }
+
+  explicit operator bool() const { return m_pool != nullptr; }
+  const LiveFrame& operator*() const { return m_pool->frame(m_idx); }
+  const LiveFrame* operator->() const { return &m_pool->frame(m_idx); }
+
+private:
+  FramePool* m_pool = nullptr;
+  int m_idx = -1;
+};
+
+// Latest-wins publication of frames from one writer thread. The writer
+// fills buffers from its newest pool and publishes them; readers take
+// references without locks (see FrameReader).
+class FrameChannel {
+public:
+  // Pools are never freed (a consumer may still hold a frame from an old
+  // one), so growth is bounded: each new pool at least doubles the buffer
+  // size, up to kMaxBufferBytes.
+  static constexpr uint32_t kMaxPools = 16;
+  static constexpr size_t kMaxBufferBytes = 8u << 20;
+
+  // Newest published frame (empty before the first one).
+  FrameRef latest() const;
+  uint64_t latest_seq() const { return m_latest.load(std::memory_order_acquire) >> 16; }
+  // Blocks until a frame newer than seq is published or timeout passes;
+  // true if there is one.
+  bool wait_newer(uint64_t seq, std::chrono::milliseconds timeout) const;
+
+protected:
+  // Writer side. pool() is the newest pool (nullptr before the first).
+  FramePool* pool() const { return m_pool_count ? m_pools[m_pool_count - 1].get() : nullptr; }
+  // Adds a pool that replaces the current one for writing. Its buffers are
+  // at least twice the current ones and at most kMaxBufferBytes; false if
+  // they are already that large or kMaxPools have been made.
+  bool add_pool(uint32_t frames, size_t buffer_bytes);
+  // Stamps the frame's seq and makes buffer idx of pool() the newest frame.
+  void publish(int idx);
+
+private:
+  std::array<std::unique_ptr<FramePool>, kMaxPools> m_pools;
+  uint32_t m_pool_count = 0;  // writer only
+  uint64_t m_seq = 0;         // writer only
+
+  // seq << 16 | pool << 8 | buffer; 0 = nothing published yet.
+  std::atomic<uint64_t> m_latest{0};
+  // Low 32 bits of the newest seq, as a futex word for wait_newer.
+  mutable std::atomic<uint32_t> m_notify{0};
+  mutable std::atomic<uint32_t> m_waiters{0};
+};
+
+// One consumer's view of a slot's frames: returns each newest frame once
+// and counts the ones it never saw.
+class FrameReader {
+public:
+  explicit FrameReader(const FrameChannel& channel) : m_channel(&channel) {}
+
+  // The newest frame if it is newer than the last one returned, else empty.
+  // skipped (optional) receives how many frames were published in between.
+  FrameRef next(uint32_t* skipped = nullptr);
+  // Waits up to timeout for next() to have something.
+  bool wait(std::chrono::milliseconds timeout) const { return m_channel->wait_newer(m_last_seq, timeout); }
+
+  uint64_t skipped_total() const { return m_skipped_total; }
+  uint64_t last_seq() const { return m_last_seq; }
+
+private:
+  const FrameChannel* m_channel;
+  uint64_t m_last_seq = 0;
+  uint64_t m_skipped_total = 0;
+};
+
+} // namespace ccu
@@ -0,0 +1,111 @@
+#include "jpeg_decoder.hpp"
+#include "jpeg_error.hpp"
+#include <vector>
+
+namespace ccu {
+
+struct JpegDecoder::Impl {
+  jpeg_decompress_struct info;
+  JpegError err;
+  bool active = false;
+  std::vector<uint8_t> scratch;   // rows read to be dropped (no skip support)
+
+  Impl() {
+    info.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = on_jpeg_error;
+    jpeg_create_decompress(&info);
+  }
+  ~Impl() { jpeg_destroy_decompress(&info); }
+};
+
+JpegDecoder::JpegDecoder() : m_impl(new Impl) {}
+JpegDecoder::~JpegDecoder() = default;
+
+// Each entry point sets its own jump target: libjpeg errors unwind only
+// libjpeg frames, back to the call that raised them.
+bool JpegDecoder::begin(const uint8_t* jpeg, size_t size, uint32_t min_w, uint32_t min_h, bool gray) {
+  Impl& d = *m_impl;
+  if (d.active) jpeg_abort_decompress(&d.info);
+  d.active = false;
+  if (setjmp(d.err.jb)) {
+    jpeg_abort_decompress(&d.info);
+    return false;
+  }
+  jpeg_mem_src(&d.info, const_cast<uint8_t*>(jpeg), (unsigned long)size);
+  jpeg_read_header(&d.info, TRUE);
+  unsigned denom = 8;
+  while (denom > 1 && (d.info.image_width / denom < min_w || d.info.image_height / denom < min_h)) denom /= 2;
+  d.info.scale_num = 1;
+  d.info.scale_denom = denom;
+  d.info.out_color_space = gray ? JCS_GRAYSCALE : JCS_RGB;
+  d.info.dct_method = JDCT_IFAST;
+  d.info.do_fancy_upsampling = FALSE;
+  jpeg_start_decompress(&d.info);
+  d.active = true;
+  return true;
+}
+
+uint32_t JpegDecoder::width() const { return m_impl->info.output_width; }
+uint32_t JpegDecoder::height() const { return m_impl->info.output_height; }
+
+bool JpegDecoder::crop(uint32_t& x, uint32_t& w) {
+  Impl& d = *m_impl;
+  if (setjmp(d.err.jb)) {
+    jpeg_abort_decompress(&d.info);
+    d.active = false;
+    return false;
+  }
+#ifdef LIBJPEG_TURBO_VERSION
+  JDIMENSION xoff = x, cw = w;
+  jpeg_crop_scanline(&d.info, &xoff, &cw);
+  x = xoff;
+  w = cw;
+#else
+  x = 0;
+  w = d.info.output_width;
+#endif
+  return true;
+}
+
+bool JpegDecoder::skip_rows(uint32_t n) {
+  Impl& d = *m_impl;
+  if (setjmp(d.err.jb)) {
+    jpeg_abort_decompress(&d.info);
+    d.active = false;
+    return false;
+  }
+#ifdef LIBJPEG_TURBO_VERSION
+  jpeg_skip_scanlines(&d.info, n);
+#else
+  d.scratch.resize((size_t)d.info.output_width * (size_t)d.info.output_components);
+  JSAMPROW r = d.scratch.data();
+  for (uint32_t i = 0; i < n; ++i) jpeg_read_scanlines(&d.info, &r, 1);
+#endif
+  return true;
+}
+
+bool JpegDecoder::read_row(uint8_t* row) {
+  Impl& d = *m_impl;
+  if (setjmp(d.err.jb)) {
+    jpeg_abort_decompress(&d.info);
+    d.active = false;
+    return false;
+  }
+  JSAMPROW r = row;
+  jpeg_read_scanlines(&d.info, &r, 1);
+  return true;
+}
+
+bool JpegDecoder::finish() {
+  Impl& d = *m_impl;
+  if (setjmp(d.err.jb)) {
+    jpeg_abort_decompress(&d.info);
+    d.active = false;
+    return false;
+  }
+  jpeg_finish_decompress(&d.info);
+  d.active = false;
+  return true;
+}
+
+} // namespace ccu
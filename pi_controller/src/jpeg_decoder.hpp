@@ -0,0 +1,46 @@
+#pragma once
+// Reusable libjpeg decoder for live-view analysis. Frames are decoded at the
+// largest DCT reduction (1/8, 1/4, 1/2) that still covers the size the
+// caller needs, which skips most of the IDCT work. Grayscale output decodes
+// only the Y component. A region can be cropped out (focus assist) so rows
+// and columns outside it are not decoded. Corrupt data fails the call
+// instead of exiting (the libjpeg default). Only built with CCU_HAVE_JPEG.
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace ccu {
+
+class JpegDecoder {
+public:
+  JpegDecoder();
+  ~JpegDecoder();
+  JpegDecoder(const JpegDecoder&) = delete;
+  JpegDecoder& operator=(const JpegDecoder&) = delete;
+
+  // Reads the header and starts decoding at the smallest size that is still
+  // at least min_w x min_h (or full size). gray: 1 byte per pixel (Y), else
+  // RGB. False if the data is not a usable JPEG.
+  bool begin(const uint8_t* jpeg, size_t size, uint32_t min_w, uint32_t min_h, bool gray);
+  uint32_t width() const;
+  uint32_t height() const;
+  // Before the first read_row: decode only columns [x, x + w). Both are
+  // widened to the codec's block grid and updated, after which width() is
+  // the cropped width. Without libjpeg-turbo whole rows are decoded and x
+  // becomes 0.
+  bool crop(uint32_t& x, uint32_t& w);
+  // Drops the next n rows, skipping their decode where the library can.
+  bool skip_rows(uint32_t n);
+  // Next output row into row (width() * components bytes). False on corrupt
+  // data; the decode is then abandoned.
+  bool read_row(uint8_t* row);
+  // Completes the image once all rows are read. Optional: begin() abandons
+  // an image whose remaining rows are not needed.
+  bool finish();
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> m_impl;
+};
+
+} // namespace ccu
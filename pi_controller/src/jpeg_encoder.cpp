@@ -0,0 +1,81 @@
+#include "jpeg_encoder.hpp"
+#include "jpeg_error.hpp"
+
+namespace ccu {
+
+namespace {
+
+// Output that does not fit is discarded into a spill area and reported.
+struct BufferDest {
+  jpeg_destination_mgr mgr;
+  uint8_t* buf = nullptr;
+  size_t cap = 0;
+  bool overflow = false;
+  uint8_t spill[4096];
+};
+
+void dest_init(j_compress_ptr c) {
+  auto* d = reinterpret_cast<BufferDest*>(c->dest);
+  d->mgr.next_output_byte = d->buf;
+  d->mgr.free_in_buffer = d->cap;
+  d->overflow = false;
+}
+
+boolean dest_empty(j_compress_ptr c) {
+  auto* d = reinterpret_cast<BufferDest*>(c->dest);
+  d->overflow = true;
+  d->mgr.next_output_byte = d->spill;
+  d->mgr.free_in_buffer = sizeof(d->spill);
+  return TRUE;
+}
+
+void dest_term(j_compress_ptr) {}
+
+} // namespace
+
+struct JpegEncoder::Impl {
+  jpeg_compress_struct info;
+  JpegError err;
+  BufferDest dest;
+
+  Impl() {
+    info.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = on_jpeg_error;
+    jpeg_create_compress(&info);
+    dest.mgr.init_destination = dest_init;
+    dest.mgr.empty_output_buffer = dest_empty;
+    dest.mgr.term_destination = dest_term;
+    info.dest = &dest.mgr;
+  }
+  ~Impl() { jpeg_destroy_compress(&info); }
+};
+
+JpegEncoder::JpegEncoder() : m_impl(new Impl) {}
+JpegEncoder::~JpegEncoder() = default;
+
+size_t JpegEncoder::encode(const uint8_t* pixels, uint32_t width, uint32_t height, size_t stride, bool gray,
+                           int quality, uint8_t* out, size_t cap) {
+  Impl& e = *m_impl;
+  if (setjmp(e.err.jb)) {
+    jpeg_abort_compress(&e.info);
+    return 0;
+  }
+  e.dest.buf = out;
+  e.dest.cap = cap;
+  e.info.image_width = width;
+  e.info.image_height = height;
+  e.info.input_components = gray ? 1 : 3;
+  e.info.in_color_space = gray ? JCS_GRAYSCALE : JCS_RGB;
+  jpeg_set_defaults(&e.info);
+  jpeg_set_quality(&e.info, quality, TRUE);
+  e.info.dct_method = JDCT_IFAST;
+  jpeg_start_compress(&e.info, TRUE);
+  while (e.info.next_scanline < height) {
+    JSAMPROW r = const_cast<uint8_t*>(pixels + (size_t)e.info.next_scanline * stride);
+    jpeg_write_scanlines(&e.info, &r, 1);
+  }
+  jpeg_finish_compress(&e.info);
+  return e.dest.overflow ? 0 : e.dest.cap - e.dest.mgr.free_in_buffer;
+}
+
+} // namespace ccu
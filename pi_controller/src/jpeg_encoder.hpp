@@ -0,0 +1,30 @@
+#pragma once
+// Reusable libjpeg encoder that writes straight into a caller's buffer (a
+// pooled frame), so encoding allocates nothing per frame. Corrupt input or
+// output that does not fit fails the call instead of exiting (the libjpeg
+// default). Only built with CCU_HAVE_JPEG.
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace ccu {
+
+class JpegEncoder {
+public:
+  JpegEncoder();
+  ~JpegEncoder();
+  JpegEncoder(const JpegEncoder&) = delete;
+  JpegEncoder& operator=(const JpegEncoder&) = delete;
+
+  // Encodes width x height pixels, rows stride bytes apart, 3 bytes per
+  // pixel (RGB) or 1 (gray), into out. Returns the JPEG size, or 0 if it
+  // did not fit in cap.
+  size_t encode(const uint8_t* pixels, uint32_t width, uint32_t height, size_t stride, bool gray, int quality,
+                uint8_t* out, size_t cap);
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> m_impl;
+};
+
+} // namespace ccu
@@ -0,0 +1,21 @@
+#pragma once
+// libjpeg error handling shared by JpegDecoder and JpegEncoder (internal;
+// include only from translation units built with CCU_HAVE_JPEG).
+// libjpeg's default error handler exits the process; this one jumps back to
+// the setjmp in the failing entry point instead.
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+
+namespace ccu {
+
+struct JpegError {
+  jpeg_error_mgr mgr;
+  std::jmp_buf jb;
+};
+
+inline void on_jpeg_error(j_common_ptr c) {
+  std::longjmp(reinterpret_cast<JpegError*>(c->err)->jb, 1);
+}
+
+} // namespace ccu
@@ -0,0 +1,161 @@
+#include "live_view.hpp"
+#include "async_log.hpp"
+#include "clock.hpp"
+#include "metrics.hpp"
+#include "sdk_executor.hpp"
+#include "slot_health.hpp"
+#include "sony_backend.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace ccu {
+
+void LiveViewEngine::start(SonyBackend* cam, uint32_t fps) {
+  if (m_fps != 0 || fps == 0 || !cam) return;
+  m_cam = cam;
+  m_fps = fps;
+  std::thread([this] { loop(); }).detach();
+}
+
+namespace {
+
+// Results of one live-view SDK call, shared with its executor task, which
+// may outlive the loop iteration if it misses its deadline.
+struct LiveViewCall {
+  bool ok = false;
+  SCRSDK::CrError st = SCRSDK::CrError_None;
+  uint32_t need = 0, off = 0, size = 0, frame_no = 0;
+  FocusArea af;
+};
+
+} // namespace
+
+bool LiveViewEngine::sdk_call(const char* op, std::function<void()> task, std::function<void()> late_done) {
+  SdkExecutor& ex = sdk_executor();
+  const uint64_t budget = ex.budget_us(op);
+  auto timed = [op, task = std::move(task)]() {
+    const uint64_t t0 = monotonic_ns();
+    task();
+    sdk_executor().record(op, (monotonic_ns() - t0) / 1000);
+  };
+  if (ex.run(m_slot, std::move(timed), monotonic_ns() / 1000 + budget, std::move(late_done),
+             SdkExecutor::LIVE_VIEW) == SdkExecutor::DONE)
+    return true;
+  // Live view holds no in-flight call on the breaker, so only trip it; the
+  // loop idles until the connect thread has recovered the camera.
+  metrics().slot(m_slot).sdk_timeouts.fetch_add(1, std::memory_order_relaxed);
+  slot_health(m_slot).on_timeout(monotonic_ns() / 1000);
+  CCU_LOG_WARN("slot %d: %s exceeded its %llu ms deadline; live view paused", m_slot, op,
+               (unsigned long long)(budget / 1000));
+  return false;
+}
+
+void LiveViewEngine::loop() {
+  const std::string name = "liveview-" + std::to_string(m_slot);
+  trace::set_thread_name(name.c_str());
+  SlotMetrics& sm = metrics().slot(m_slot);
+  const auto period = std::chrono::microseconds(1000000 / m_fps);
+  auto next = std::chrono::steady_clock::now();
+  FocusArea af;
+  auto af_next = next;
+
+  while (true) {
+    std::this_thread::sleep_until(next);
+    const auto now = std::chrono::steady_clock::now();
+    next = std::max(next + period, now);
+
+    // Leave an offline or tripped camera to the connect thread.
+    if (!m_cam->is_connected() || slot_health(m_slot).state() == SlotHealth::OPEN) {
+      next = now + std::chrono::milliseconds(250);
+      continue;
+    }
+
+    SonyBackend* cam = m_cam;
+    auto call = std::make_shared<LiveViewCall>();
+    if (!pool()) {
+      if (!sdk_call("live_view_info", [cam, call] { call->ok = cam->live_view_info(call->need); }) || !call->ok) {
+        sm.lv_errors.fetch_add(1, std::memory_order_relaxed);
+        next = now + std::chrono::seconds(1);
+        continue;
+      }
+      add_pool(kPoolFrames, call->need);
+      CCU_LOG_INFO("slot %d: live view at %u fps, %u x %zu byte buffers", m_slot, (unsigned)m_fps,
+                   (unsigned)kPoolFrames, pool()->buffer_bytes());
+    }
+    FramePool& pool = *this->pool();
+
+    // Every buffer held by slow consumers: skip this fetch rather than wait
+    // or allocate. The camera just delivers a newer frame next period.
+    const int idx = pool.acquire_for_write();
+    if (idx < 0) {
+      sm.lv_no_buffer.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+
+    // An abandoned fetch may still write into the buffer, so it is only
+    // released once the call returns. Pools live as long as the channel.
+    uint8_t* const buf = pool.data(idx);
+    const uint32_t cap = (uint32_t)pool.buffer_bytes();
+    FramePool* const owner = &pool;
+    if (!sdk_call("fetch_live_view",
+                  [cam, call, buf, cap] { call->st = cam->fetch_live_view(buf, cap, call->off, call->size, call->frame_no); },
+                  [owner, idx] { owner->abandon_write(idx); })) {
+      sm.lv_errors.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    const SCRSDK::CrError st = call->st;
+    const uint32_t off = call->off, size = call->size, frame_no = call->frame_no;
+    if (CR_FAILED(st) || st == SCRSDK::CrWarning_Frame_NotUpdated) pool.abandon_write(idx);
+    if (st == SCRSDK::CrWarning_Frame_NotUpdated) {
+      // Same buffer is tried again shortly; nothing to reallocate.
+      sm.lv_not_updated.fetch_add(1, std::memory_order_relaxed);
+      next = now + period / 4;
+      continue;
+    }
+    if (st == SCRSDK::CrError_Memory_Insufficient) {
+      // The camera's frames outgrew the buffers (e.g. a resolution change).
+      // The old pool stays allocated for consumers still holding its frames.
+      if (add_pool(kPoolFrames, pool.buffer_bytes() * 2)) {
+        CCU_LOG_INFO("slot %d: live view buffers grown to %zu bytes", m_slot, this->pool()->buffer_bytes());
+      }
+      sm.lv_errors.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    if (CR_FAILED(st)) {
+      sm.lv_errors.fetch_add(1, std::memory_order_relaxed);
+      next = now + std::chrono::milliseconds(500);
+      continue;
+    }
+
+    if (m_track_af.load(std::memory_order_relaxed) && now >= af_next) {
+      if (sdk_call("live_view_focus_area", [cam, call] { call->ok = cam->live_view_focus_area(call->af); }) && call->ok)
+        af = call->af;
+      else
+        af = FocusArea{};
+      af_next = now + std::chrono::milliseconds(kFocusAreaRefreshMs);
+    }
+
+    LiveFrame& f = pool.frame(idx);
+    f.jpeg = pool.data(idx) + off;
+    f.size = size;
+    f.frame_no = frame_no;
+    f.captured_ns = monotonic_ns();
+    f.af = af;
+    sm.lv_frames.fetch_add(1, std::memory_order_relaxed);
+    publish(idx);
+  }
+}
+
+LiveViewEngine& live_view(int slot) {
+  static std::array<LiveViewEngine, MetricsRegistry::kSlots> engines = {
+    LiveViewEngine(0), LiveViewEngine(1), LiveViewEngine(2), LiveViewEngine(3),
+    LiveViewEngine(4), LiveViewEngine(5), LiveViewEngine(6), LiveViewEngine(7),
+  };
+  return engines[(size_t)(slot & (MetricsRegistry::kSlots - 1))];
+}
+
+} // namespace ccu
@@ -0,0 +1,58 @@
+#pragma once
+// Per-slot live view. One thread per enabled slot fetches GetLiveViewImage
+// at the configured rate straight into a fixed pool of buffers sized from
+// GetLiveViewImageInfo, and publishes each frame on its FrameChannel
+// (frame_channel.hpp). No frame buffer is allocated per frame; the pool is
+// only rebuilt if the camera asks for a larger buffer than it has.
+//
+// The SDK calls themselves run on the slot's live-view SdkExecutor lane
+// under a deadline, so a hung fetch trips the slot's breaker instead of
+// stalling the thread, and the backend's session lock keeps a reconnect
+// from releasing the device handle under a call in progress.
+//
+// Memory: normally one pool of kPoolFrames buffers per camera, plus the
+// FrameChannel's bounded growth when a camera asks for larger buffers.
+#include "frame_channel.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+namespace ccu {
+
+class SonyBackend;
+
+class LiveViewEngine : public FrameChannel {
+public:
+  // One being fetched, one published, the rest for consumers still sending
+  // or decoding older frames.
+  static constexpr uint32_t kPoolFrames = 6;
+  static constexpr uint32_t kFocusAreaRefreshMs = 250;
+
+  explicit LiveViewEngine(int slot) : m_slot(slot) {}
+
+  // Starts the fetch thread (once). It idles while the camera is offline.
+  void start(SonyBackend* cam, uint32_t fps);
+  bool running() const { return m_fps != 0; }
+  uint32_t fps() const { return m_fps; }
+
+  // Stamps frames with the camera's focus frame, read from the live-view
+  // properties every kFocusAreaRefreshMs (one extra SDK call, so only on
+  // request).
+  void track_focus_area(bool on) { m_track_af.store(on, std::memory_order_relaxed); }
+
+private:
+  void loop();
+  // Runs one SDK call on the slot's live-view lane. False if it missed its
+  // deadline; the breaker is then tripped and late_done runs once the call
+  // returns.
+  bool sdk_call(const char* op, std::function<void()> task, std::function<void()> late_done = nullptr);
+
+  const int m_slot;
+  SonyBackend* m_cam = nullptr;
+  uint32_t m_fps = 0;
+  std::atomic<bool> m_track_af{false};
+};
+
+LiveViewEngine& live_view(int slot);
+
+} // namespace ccu
@@ -0,0 +1,203 @@
+#include "lut3d.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace ccu {
+
+namespace {
+
+// One lattice entry (R, G, B, pad as 8.8 fixed point) widened to four 32-bit
+// lanes, so each trilinear corner is weighted with a single multiply.
+typedef int32_t V4s32 __attribute__((vector_size(16)));
+typedef uint16_t V4u16 __attribute__((vector_size(8)));
+
+constexpr int kFracBits = 12;
+constexpr int32_t kFracOne = 1 << kFracBits;
+// Lattice values are 8.8 fixed point (255.0 = 65280), so a fully weighted
+// corner rounds to 255 and never to 256.
+constexpr float kLatticeScale = 255.0f * 256.0f;
+constexpr int kOutShift = kFracBits + 8;
+
+inline V4s32 entry(const uint16_t* lattice, uint32_t idx) {
+  V4u16 v;
+  std::memcpy(&v, lattice + (size_t)idx * 4, sizeof(v));
+  return __builtin_convertvector(v, V4s32);
+}
+
+bool fail(std::string* err, const std::string& why) {
+  if (err) *err = why;
+  return false;
+}
+
+// Trilinear sample of an n^3 RGB float lattice at fractional grid position.
+void sample(const std::vector<float>& src, uint32_t n, float x, float y, float z, float* rgb) {
+  const uint32_t x0 = std::min((uint32_t)x, n - 2), y0 = std::min((uint32_t)y, n - 2), z0 = std::min((uint32_t)z, n - 2);
+  const float fx = x - (float)x0, fy = y - (float)y0, fz = z - (float)z0;
+  for (int c = 0; c < 3; ++c) {
+    auto at = [&](uint32_t i, uint32_t j, uint32_t k) { return src[(((size_t)k * n + j) * n + i) * 3 + (size_t)c]; };
+    const float c00 = at(x0, y0, z0) + (at(x0 + 1, y0, z0) - at(x0, y0, z0)) * fx;
+    const float c10 = at(x0, y0 + 1, z0) + (at(x0 + 1, y0 + 1, z0) - at(x0, y0 + 1, z0)) * fx;
+    const float c01 = at(x0, y0, z0 + 1) + (at(x0 + 1, y0, z0 + 1) - at(x0, y0, z0 + 1)) * fx;
+    const float c11 = at(x0, y0 + 1, z0 + 1) + (at(x0 + 1, y0 + 1, z0 + 1) - at(x0, y0 + 1, z0 + 1)) * fx;
+    const float c0 = c00 + (c10 - c00) * fy, c1 = c01 + (c11 - c01) * fy;
+    rgb[c] = c0 + (c1 - c0) * fz;
+  }
+}
+
+} // namespace
+
+bool Lut3d::load_cube(const std::string& path, std::string* err) {
+  std::ifstream in(path);
+  if (!in) return fail(err, "cannot open " + path);
+
+  uint32_t size = 0;
+  float dmin[3] = {0, 0, 0}, dmax[3] = {1, 1, 1};
+  std::string title;
+  std::vector<float> values;
+  std::string line;
+  int line_no = 0;
+  while (std::getline(in, line)) {
+    ++line_no;
+    const size_t hash = line.find('#');
+    if (hash != std::string::npos) line.resize(hash);
+    std::istringstream ls(line);
+    std::string key;
+    if (!(ls >> key)) continue;
+    if (std::isalpha((unsigned char)key[0])) {
+      if (key == "TITLE") {
+        std::getline(ls, title);
+        title.erase(0, title.find_first_not_of(" \t\""));
+        title.erase(title.find_last_not_of(" \t\"\r") + 1);
+      } else if (key == "LUT_3D_SIZE") {
+        if (!(ls >> size) || size < 2 || size > 256) return fail(err, path + ": bad LUT_3D_SIZE");
+        values.reserve((size_t)size * size * size * 3);
+      } else if (key == "LUT_1D_SIZE") {
+        return fail(err, path + ": 1D LUTs are not supported");
+      } else if (key == "DOMAIN_MIN") {
+        if (!(ls >> dmin[0] >> dmin[1] >> dmin[2])) return fail(err, path + ": bad DOMAIN_MIN");
+      } else if (key == "DOMAIN_MAX") {
+        if (!(ls >> dmax[0] >> dmax[1] >> dmax[2])) return fail(err, path + ": bad DOMAIN_MAX");
+      } else if (key == "LUT_3D_INPUT_RANGE") {
+        float lo = 0, hi = 1;
+        if (!(ls >> lo >> hi)) return fail(err, path + ": bad LUT_3D_INPUT_RANGE");
+        std::fill(dmin, dmin + 3, lo);
+        std::fill(dmax, dmax + 3, hi);
+      }
+      continue;  // other keywords (e.g. LUT_1D_INPUT_RANGE) do not apply
+    }
+    float rgb[3];
+    char* end = nullptr;
+    rgb[0] = std::strtof(key.c_str(), &end);
+    if (*end || !(ls >> rgb[1] >> rgb[2])) return fail(err, path + ":" + std::to_string(line_no) + ": bad data line");
+    values.insert(values.end(), rgb, rgb + 3);
+  }
+  if (size == 0) return fail(err, path + ": no LUT_3D_SIZE");
+  if (values.size() != (size_t)size * size * size * 3)
+    return fail(err, path + ": expected " + std::to_string((size_t)size * size * size) + " entries");
+  for (int c = 0; c < 3; ++c) {
+    if (!(dmax[c] > dmin[c])) return fail(err, path + ": empty domain");
+  }
+
+  // Resample large lattices: a 65^3 one would not fit in cache.
+  if (size > kMaxSize) {
+    std::vector<float> small((size_t)kMaxSize * kMaxSize * kMaxSize * 3);
+    const float step = (float)(size - 1) / (float)(kMaxSize - 1);
+    for (uint32_t k = 0; k < kMaxSize; ++k)
+      for (uint32_t j = 0; j < kMaxSize; ++j)
+        for (uint32_t i = 0; i < kMaxSize; ++i)
+          sample(values, size, i * step, j * step, k * step, &small[(((size_t)k * kMaxSize + j) * kMaxSize + i) * 3]);
+    values.swap(small);
+    size = kMaxSize;
+  }
+
+  if (!load_values(size, values, err)) return false;
+  m_title = title;
+  // The domain only changes where input codes land in the lattice.
+  for (int c = 0; c < 3; ++c) {
+    const uint32_t stride = c == 0 ? 1 : (c == 1 ? size : size * size);
+    for (int v = 0; v < 256; ++v) {
+      const float t = std::min(std::max((v / 255.0f - dmin[c]) / (dmax[c] - dmin[c]), 0.0f), 1.0f);
+      const float pos = t * (float)(size - 1);
+      const uint32_t idx = std::min((uint32_t)pos, size - 2);
+      m_offset[c][v] = idx * stride;
+      m_frac[c][v] = (uint16_t)std::min<long>(std::lround((pos - (float)idx) * kFracOne), kFracOne);
+    }
+  }
+  return true;
+}
+
+bool Lut3d::load_values(uint32_t size, const std::vector<float>& rgb, std::string* err) {
+  if (size < 2 || size > kMaxSize) return fail(err, "LUT size must be 2.." + std::to_string(kMaxSize));
+  if (rgb.size() != (size_t)size * size * size * 3) return fail(err, "wrong number of LUT entries");
+  m_lattice.assign((size_t)size * size * size * 4, 0);
+  for (size_t i = 0, n = (size_t)size * size * size; i < n; ++i) {
+    for (int c = 0; c < 3; ++c) {
+      const float v = std::min(std::max(rgb[i * 3 + (size_t)c], 0.0f), 1.0f);
+      m_lattice[i * 4 + (size_t)c] = (uint16_t)std::lround(v * kLatticeScale);
+    }
+  }
+  for (int c = 0; c < 3; ++c) {
+    const uint32_t stride = c == 0 ? 1 : (c == 1 ? size : size * size);
+    for (int v = 0; v < 256; ++v) {
+      const uint32_t scaled = (uint32_t)v * (size - 1) * kFracOne / 255;
+      const uint32_t idx = std::min(scaled >> kFracBits, size - 2);
+      m_offset[c][v] = idx * stride;
+      m_frac[c][v] = (uint16_t)(scaled - (idx << kFracBits));
+    }
+  }
+  m_size = size;
+  m_title.clear();
+  return true;
+}
+
+void Lut3d::apply(const uint8_t* in, uint8_t* out, size_t pixels) const {
+  if (m_size == 0) {
+    if (out != in) std::memmove(out, in, pixels * 3);
+    return;
+  }
+  const uint16_t* lat = m_lattice.data();
+  const uint32_t sr = 1, sg = m_size, sb = m_size * m_size;
+  const V4s32 round = V4s32{} + (1 << (kOutShift - 1));
+  for (size_t i = 0; i < pixels; ++i, in += 3, out += 3) {
+    const uint8_t r = in[0], g = in[1], b = in[2];
+    const uint32_t base = m_offset[0][r] + m_offset[1][g] + m_offset[2][b];
+    const int32_t fr = m_frac[0][r], fg = m_frac[1][g], fb = m_frac[2][b];
+
+    // The cell splits into six tetrahedra along its main diagonal; the
+    // order of the three fractions picks the one holding the point, and
+    // the result weights its four corners.
+    const V4s32 c000 = entry(lat, base);
+    const V4s32 c111 = entry(lat, base + sr + sg + sb);
+    V4s32 v1, v2;
+    int32_t f1, f2, f3;
+    if (fr >= fg) {
+      if (fg >= fb) {
+        v1 = entry(lat, base + sr), v2 = entry(lat, base + sr + sg), f1 = fr, f2 = fg, f3 = fb;
+      } else if (fr >= fb) {
+        v1 = entry(lat, base + sr), v2 = entry(lat, base + sr + sb), f1 = fr, f2 = fb, f3 = fg;
+      } else {
+        v1 = entry(lat, base + sb), v2 = entry(lat, base + sr + sb), f1 = fb, f2 = fr, f3 = fg;
+      }
+    } else {
+      if (fb >= fg) {
+        v1 = entry(lat, base + sb), v2 = entry(lat, base + sg + sb), f1 = fb, f2 = fg, f3 = fr;
+      } else if (fb >= fr) {
+        v1 = entry(lat, base + sg), v2 = entry(lat, base + sg + sb), f1 = fg, f2 = fb, f3 = fr;
+      } else {
+        v1 = entry(lat, base + sg), v2 = entry(lat, base + sr + sg), f1 = fg, f2 = fr, f3 = fb;
+      }
+    }
+    const V4s32 acc = c000 * kFracOne + (v1 - c000) * f1 + (v2 - v1) * f2 + (c111 - v2) * f3 + round;
+    out[0] = (uint8_t)(acc[0] >> kOutShift);
+    out[1] = (uint8_t)(acc[1] >> kOutShift);
+    out[2] = (uint8_t)(acc[2] >> kOutShift);
+  }
+}
+
+} // namespace ccu
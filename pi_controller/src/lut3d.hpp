@@ -0,0 +1,46 @@
+#pragma once
+// 3D colour LUT for monitoring (e.g. S-Log3 to Rec.709), loaded from an
+// Adobe/Resolve .cube file and applied to 8-bit RGB.
+//
+// The lattice is stored as 4 x u16 per entry (RGB + pad, 8.8 fixed point),
+// so one entry is one 8-byte load and a 33^3 lattice (287 KB) stays in a
+// Pi's L2 cache. Larger .cube files are resampled to 33^3 on load. Input
+// codes map to a lattice cell and a 12-bit fraction through per-channel
+// tables, and each pixel is interpolated tetrahedrally (4 lattice entries)
+// with the three channels in one 4-lane integer vector.
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ccu {
+
+class Lut3d {
+public:
+  static constexpr uint32_t kMaxSize = 33;  // larger files are resampled to this
+
+  // Parses a .cube file (LUT_3D_SIZE 2..256, optional DOMAIN_MIN/MAX).
+  // False with a reason in err on any problem.
+  bool load_cube(const std::string& path, std::string* err);
+  // Lattice straight from values (size^3 RGB triplets in 0..1, red
+  // fastest), as in a .cube file body.
+  bool load_values(uint32_t size, const std::vector<float>& rgb, std::string* err);
+
+  bool empty() const { return m_size == 0; }
+  uint32_t size() const { return m_size; }
+  const std::string& title() const { return m_title; }
+
+  // RGB in, RGB out (3 bytes per pixel); out may alias in.
+  void apply(const uint8_t* in, uint8_t* out, size_t pixels) const;
+
+private:
+  uint32_t m_size = 0;
+  std::string m_title;
+  std::vector<uint16_t> m_lattice;   // m_size^3 x {r, g, b, 0}
+  // Per input code and channel: entry offset of the cell's low corner
+  // (already multiplied by the channel's stride) and the 12-bit fraction.
+  uint32_t m_offset[3][256] = {};
+  uint16_t m_frac[3][256] = {};
+};
+
+} // namespace ccu
@@ -0,0 +1,114 @@
+#include "lut_view.hpp"
+#include "async_log.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#ifdef CCU_HAVE_JPEG
+#include "jpeg_decoder.hpp"
+#include "jpeg_encoder.hpp"
+#endif
+
+namespace ccu {
+
+#ifdef CCU_HAVE_JPEG
+
+bool LutView::start(const std::string& cube_path) {
+  if (m_running || !live_view(m_slot).running()) return false;
+  std::string err;
+  if (!m_lut.load_cube(cube_path, &err)) {
+    CCU_LOG_WARN("slot %d: LUT not loaded: %s", m_slot, err.c_str());
+    return false;
+  }
+  CCU_LOG_INFO("slot %d: monitoring LUT %s (%u^3%s%s)", m_slot, cube_path.c_str(), (unsigned)m_lut.size(),
+               m_lut.title().empty() ? "" : ", ", m_lut.title().c_str());
+  m_running = true;
+  std::thread([this] { loop(); }).detach();
+  return true;
+}
+
+void LutView::loop() {
+  const std::string name = "lut-" + std::to_string(m_slot);
+  trace::set_thread_name(name.c_str());
+  SlotMetrics& sm = metrics().slot(m_slot);
+  FrameReader reader(live_view(m_slot));
+  JpegDecoder decoder;
+  JpegEncoder encoder;
+  std::vector<uint8_t> image;   // decoded and mapped, RGB
+
+  while (true) {
+    if (!reader.wait(std::chrono::seconds(1))) continue;
+    uint32_t skipped = 0;
+    const FrameRef f = reader.next(&skipped);
+    if (!f) continue;
+    sm.lv_lut_skipped.fetch_add(skipped, std::memory_order_relaxed);
+    const auto t0 = std::chrono::steady_clock::now();
+
+    // Full size: this is what viewers watch.
+    if (!decoder.begin(f->jpeg, f->size, UINT32_MAX, UINT32_MAX, false)) continue;
+    const uint32_t w = decoder.width(), h = decoder.height();
+    const size_t stride = (size_t)w * 3;
+    if (image.size() < stride * h) image.resize(stride * h);
+    bool ok = true;
+    for (uint32_t y = 0; y < h && ok; ++y) {
+      uint8_t* row = image.data() + y * stride;
+      ok = decoder.read_row(row);
+      if (ok) m_lut.apply(row, row, w);   // while the row is still in cache
+    }
+    if (!ok || !decoder.finish()) continue;
+
+    if (!pool()) add_pool(kPoolFrames, std::max<size_t>(f->size * 2, 64 * 1024));
+    FramePool& p = *pool();
+    const int idx = p.acquire_for_write();
+    if (idx < 0) continue;  // viewers hold every buffer; next frame
+    const size_t size = encoder.encode(image.data(), w, h, stride, false, kQuality, p.data(idx), p.buffer_bytes());
+    if (size == 0) {
+      p.abandon_write(idx);
+      if (add_pool(kPoolFrames, p.buffer_bytes() * 2))
+        CCU_LOG_INFO("slot %d: LUT buffers grown to %zu bytes", m_slot, pool()->buffer_bytes());
+      continue;
+    }
+    LiveFrame& out = p.frame(idx);
+    out.jpeg = p.data(idx);
+    out.size = size;
+    out.frame_no = f->frame_no;
+    out.captured_ns = f->captured_ns;
+    out.af = f->af;
+    publish(idx);
+    sm.lv_lut_frames.fetch_add(1, std::memory_order_relaxed);
+    sm.lv_lut_busy_us.fetch_add((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                                  std::chrono::steady_clock::now() - t0).count(),
+                                std::memory_order_relaxed);
+  }
+}
+
+#else  // !CCU_HAVE_JPEG
+
+bool LutView::start(const std::string&) {
+  CCU_LOG_WARN("slot %d: monitoring LUT needs libjpeg; ccu_daemon was built without it", m_slot);
+  return false;
+}
+
+void LutView::loop() {}
+
+#endif
+
+LutView& lut_view(int slot) {
+  static std::array<LutView, MetricsRegistry::kSlots> views = {
+    LutView(0), LutView(1), LutView(2), LutView(3),
+    LutView(4), LutView(5), LutView(6), LutView(7),
+  };
+  return views[(size_t)(slot & (MetricsRegistry::kSlots - 1))];
+}
+
+const FrameChannel& monitor_view(int slot) {
+  const LutView& lut = lut_view(slot);
+  if (lut.running()) return lut;
+  return live_view(slot);
+}
+
+} // namespace ccu
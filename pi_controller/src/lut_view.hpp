@@ -0,0 +1,45 @@
+#pragma once
+// Monitoring LUT stage: a slot's live view with a 3D LUT applied (e.g.
+// S-Log3 to Rec.709, so flat log pictures can be judged). Each slot with a
+// LUT gets its own thread, woken by every new camera frame, that decodes
+// it, maps it through the LUT and re-encodes it into pooled buffers. The
+// threads spread over the cores; one that falls behind skips to the newest
+// frame rather than adding latency.
+//
+// The HTTP stream and the mosaic show monitor_view(slot), which is the LUT
+// stage when one runs. Scopes and focus assist keep reading the camera's
+// own frames.
+#include "live_view.hpp"
+#include "lut3d.hpp"
+#include <cstdint>
+#include <string>
+
+namespace ccu {
+
+class LutView : public FrameChannel {
+public:
+  static constexpr uint32_t kPoolFrames = 4;
+  static constexpr int kQuality = 85;
+
+  explicit LutView(int slot) : m_slot(slot) {}
+
+  // Loads the .cube file and starts the stage on the slot's live view,
+  // which must be running. False (and logged) on a bad file or without
+  // libjpeg.
+  bool start(const std::string& cube_path);
+  bool running() const { return m_running; }
+
+private:
+  void loop();
+
+  const int m_slot;
+  Lut3d m_lut;
+  bool m_running = false;
+};
+
+LutView& lut_view(int slot);
+
+// What monitors show for a slot: the LUT stage if it runs, else the live view.
+const FrameChannel& monitor_view(int slot);
+
+} // namespace ccu
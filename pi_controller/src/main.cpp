@@ -5,6 +5,7 @@
 #include <thread>
 #include <chrono>
 #include <array>
+#include <memory>
 #include <mutex>
 #include <vector>
 #include <string>
@@ -17,6 +18,24 @@
 #include <ctime>
 #include "sony_backend.hpp"
 #include "uart_transport.hpp"
+#include "metrics.hpp"
+#include "async_log.hpp"
+#include "trace.hpp"
+#include "flight_recorder.hpp"
+#include "clock_sync.hpp"
+#include "slot_health.hpp"
+#include "reconnect.hpp"
+#include "discovery.hpp"
+#include "live_view.hpp"
+#include "mjpeg_server.hpp"
+#include "mosaic.hpp"
+#include "scopes.hpp"
+#include "focus_assist.hpp"
+#include "lut_view.hpp"
+#include "shm_export.hpp"
+#include "proxy_recorder.hpp"
+#include "bytes.hpp"
+#include "sdk_executor.hpp"
 
 // CRSDK header included so we know headers + linkage still ok
 #include "CRSDK/CameraRemote_SDK.h"
@@ -24,6 +43,11 @@
 using namespace ccu;
 
 static std::array<bool, 8> g_run_state = {}; // reported state per target
+// Camera RecordingState from the last CMD_GET_STATUS (-1 = none since the
+// last accepted RUNSTOP), so REC started on the camera body counts too.
+static std::array<int8_t, 8> g_status_rec = {-1, -1, -1, -1, -1, -1, -1, -1};
+// Guards the two above and publish_rec_state (request loop and deferred handlers).
+static std::mutex g_rec_mutex;
 static std::array<ccu::SonyBackend, 8> g_sony;
 
 struct SlotConfig {
@@ -37,9 +61,13 @@ struct SlotConfig {
 };
 
 static std::array<SlotConfig, 8> g_slots;
-static std::mutex g_env_mutex;
-static std::mutex g_sdk_mutex;
-static bool g_crsdk_inited = false;
+// Whether each slot's connected camera is on USB, and its serial, for
+// matching unplug events; written by connect_slot.
+static std::mutex g_usb_mutex;
+static std::array<bool, 8> g_usb_camera = {};
+static std::array<std::string, 8> g_usb_serials;
+static std::timed_mutex g_env_mutex;
+static ClockSync g_clock_sync;
 
 static bool env_is_true(const char* v) {
   return v && v[0] && v[0] == '1';
@@ -216,6 +244,17 @@ static bool slot_selected(uint8_t mask, int idx) {
   return (mask & (1u << idx)) != 0;
 }
 
+// Every slot's REC state, for the mosaic borders and the proxy recorder.
+static void publish_rec_state() {
+  uint8_t mask = 0;
+  for (int i = 0; i < 8; ++i) {
+    const bool rec = g_status_rec[i] >= 0 ? g_status_rec[i] != 0 : g_run_state[i];
+    if (rec) mask |= (uint8_t)(1u << i);
+  }
+  mosaic().set_rec_mask(mask);
+  proxy_recorder().set_rec_mask(mask);
+}
+
 static int pick_slot(uint8_t mask) {
   for (int i = 0; i < 8; ++i) {
     if (slot_selected(mask, i)) return i;
@@ -223,11 +262,299 @@ static int pick_slot(uint8_t mask) {
   return -1;
 }
 
+// steady_clock is CLOCK_MONOTONIC: the timebase of ClockSync and set_runstop(fire_at_ns).
+static uint64_t mono_us(std::chrono::steady_clock::time_point t) {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(t.time_since_epoch()).count();
+}
+
+static uint64_t elapsed_us(std::chrono::steady_clock::time_point t0) {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - t0).count();
+}
+
+// Per-slot camera time and result of a request, for the ACK timing extension
+// (FLAG_TIMING). Each request has its own; t_req_sdk points at it on the
+// thread handling the request.
+struct RequestSdkTiming {
+  std::array<uint32_t, 8> us{};
+  std::array<uint32_t, 8> result{};
+};
+static thread_local RequestSdkTiming* t_req_sdk = nullptr;
+
+static void note_request_sdk(int slot, uint64_t us, bool ok, uint32_t sdk_error) {
+  RequestSdkTiming* req = t_req_sdk;
+  if (!req || slot < 0 || slot >= 8) return;
+  const uint64_t total = (uint64_t)req->us[slot] + us;
+  req->us[slot] = total > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)total;
+  if (!ok && req->result[slot] == 0) req->result[slot] = sdk_error ? sdk_error : TIMING_FAILED_NO_SDK;
+}
+
+// What an ACK needs from the request it answers. Deferred handlers take a
+// copy to their own thread.
+struct RequestCtx {
+  Header h{};
+  sockaddr_in from{};
+  uint64_t rx_ns = 0;   // kernel arrival time (0 = unknown)
+  std::chrono::steady_clock::time_point t_rx{};
+  RequestSdkTiming sdk;
+};
+
+struct DeadlineCall {
+  bool timed_out = false;
+  bool ok = false;
+  uint32_t sdk_error = 0;   // first failing CrError inside the operation
+  uint64_t us = 0;          // operation time, excluding extra_us
+};
+
+// Absolute deadline (CLOCK_MONOTONIC us) for operation name started now:
+// its adaptive budget plus extra_us.
+static uint64_t sdk_deadline_us(const char* name, uint64_t extra_us = 0) {
+  return mono_us(std::chrono::steady_clock::now()) + sdk_executor().budget_us(name) + extra_us;
+}
+
+// Runs one backend operation, fn(slot), on the SDK worker of every slot in
+// slots at once, all until deadline_us (0 = sdk_deadline_us(name, extra_us);
+// extra_us is e.g. the wait for a scheduled start): an ALL-target command
+// waits once, for its slowest camera. The trace span tags the SDK calls
+// inside it with the slot. The caller holds a call on each slot's breaker; a
+// timed-out call trips it and stays in flight until the SDK returns, then
+// runs on_late(slot) (if any) on the same worker. fn may outlive this call:
+// capture by value only. Slots outside slots are left default.
+static std::array<DeadlineCall, 8> run_each_with_deadline(uint8_t slots, const char* name,
+                                                          std::function<bool(int)> fn, uint64_t extra_us = 0,
+                                                          std::function<void(int)> on_late = nullptr,
+                                                          uint64_t deadline_us = 0) {
+  auto res = std::make_shared<std::array<DeadlineCall, 8>>();
+  SdkExecutor& ex = sdk_executor();
+  const uint64_t start = mono_us(std::chrono::steady_clock::now());
+  const uint64_t deadline = deadline_us ? deadline_us : start + ex.budget_us(name) + extra_us;
+  const uint64_t budget = deadline > start ? deadline - start : 0;
+  auto task = [name, extra_us, res, fn = std::move(fn)](int slot) {
+    trace::Span span("backend", name, slot);
+    const auto t0 = std::chrono::steady_clock::now();
+    trace::take_sdk_error();
+    const bool ok = fn(slot);
+    const uint64_t us = elapsed_us(t0);
+    DeadlineCall& r = (*res)[(size_t)slot];
+    r.ok = ok;
+    r.sdk_error = trace::take_sdk_error();
+    r.us = us > extra_us ? us - extra_us : 0;
+    span.set_result(ok ? 0 : 1);
+    sdk_executor().record(name, r.us);
+  };
+  auto late_done = [on_late = std::move(on_late)](int slot) {
+    if (on_late) on_late(slot);
+    slot_health(slot).finish(SlotHealth::OUTCOME_HARD, mono_us(std::chrono::steady_clock::now()));
+  };
+  const auto status = ex.run_each(slots, std::move(task), deadline, std::move(late_done));
+
+  // Only completed entries are read: an abandoned task may still write its own.
+  std::array<DeadlineCall, 8> out{};
+  for (int i = 0; i < 8; ++i) {
+    if (!(slots & (1u << i))) continue;
+    if (status[(size_t)i] == SdkExecutor::DONE) {
+      out[(size_t)i] = (*res)[(size_t)i];
+      continue;
+    }
+    metrics().slot(i).sdk_timeouts.fetch_add(1, std::memory_order_relaxed);
+    slot_health(i).on_timeout(mono_us(std::chrono::steady_clock::now()));
+    CCU_LOG_WARN("slot %d: %s exceeded its %llu ms deadline; worker abandoned", i, name,
+                 (unsigned long long)(budget / 1000));
+    out[(size_t)i].timed_out = true;
+    out[(size_t)i].us = budget;
+  }
+  return out;
+}
+
+// run_each_with_deadline for one slot.
+static DeadlineCall run_with_deadline(int slot, const char* name, std::function<bool()> fn, uint64_t extra_us = 0,
+                                      std::function<void()> on_late = nullptr, uint64_t deadline_us = 0) {
+  std::function<void(int)> late;
+  if (on_late) late = [on_late = std::move(on_late)](int) { on_late(); };
+  return run_each_with_deadline((uint8_t)(1u << slot), name, [fn = std::move(fn)](int) { return fn(); }, extra_us,
+                                std::move(late), deadline_us)[(size_t)slot];
+}
+
+enum class SlotResult { OK, FAILED, BUSY, TIMEOUT };
+
+// Records a finished call of an admitted slot (admit_slot) against the
+// slot's SDK metrics and the request's timing extension; finishes the call.
+static SlotResult record_sdk_call(int slot, const DeadlineCall& c) {
+  SlotMetrics& sm = metrics().slot(slot);
+  sm.sdk_calls.fetch_add(1, std::memory_order_relaxed);
+  if (c.timed_out) {
+    sm.sdk_errors.fetch_add(1, std::memory_order_relaxed);
+    note_request_sdk(slot, c.us, false, TIMING_TIMED_OUT);
+    return SlotResult::TIMEOUT;
+  }
+  sm.sdk_latency.record(c.us);
+  if (!c.ok) sm.sdk_errors.fetch_add(1, std::memory_order_relaxed);
+  note_request_sdk(slot, c.us, c.ok, c.sdk_error);
+  slot_health(slot).finish(SlotHealth::classify(c.ok, c.sdk_error, c.us), mono_us(std::chrono::steady_clock::now()));
+  return c.ok ? SlotResult::OK : SlotResult::FAILED;
+}
+
+// run_with_deadline + record_sdk_call.
+static SlotResult timed_sdk_call(int slot, const char* name, std::function<bool()> fn, uint64_t extra_us = 0) {
+  return record_sdk_call(slot, run_with_deadline(slot, name, std::move(fn), extra_us));
+}
+
+// Circuit breaker gate for one slot of a request. Rejected slots are answered
+// at once: open -> fail mask, call in flight elsewhere -> busy mask.
+static SlotResult admit_slot(int slot) {
+  SlotMetrics& sm = metrics().slot(slot);
+  switch (slot_health(slot).admit(mono_us(std::chrono::steady_clock::now()))) {
+    case SlotHealth::REJECT_OPEN:
+      sm.rejected_open.fetch_add(1, std::memory_order_relaxed);
+      note_request_sdk(slot, 0, false, 0);
+      return SlotResult::FAILED;
+    case SlotHealth::REJECT_BUSY:
+      sm.rejected_busy.fetch_add(1, std::memory_order_relaxed);
+      return SlotResult::BUSY;
+    default:
+      return SlotResult::OK;
+  }
+}
+
+// admit_slot + timed_sdk_call.
+static SlotResult guarded_sdk_call(int slot, const char* name, std::function<bool()> fn, uint64_t extra_us = 0) {
+  const SlotResult gate = admit_slot(slot);
+  if (gate != SlotResult::OK) return gate;
+  return timed_sdk_call(slot, name, std::move(fn), extra_us);
+}
+
+// The slots of target_mask as a bit mask (0xFF = every enabled slot).
+static uint8_t selected_slots(uint8_t target_mask) {
+  uint8_t slots = 0;
+  for (int i = 0; i < 8; ++i) {
+    if (slot_selected(target_mask, i)) slots |= (uint8_t)(1u << i);
+  }
+  return slots;
+}
+
+// guarded_sdk_call for every slot in slots in parallel, each on its own SDK
+// worker, under one deadline taken before the first call: an ALL-target
+// command is as slow as its slowest camera, not the sum of them. admitted
+// (optional) receives the slots the breaker let through; on_late is passed
+// to run_each_with_deadline. Slots outside slots are left OK.
+static std::array<SlotResult, 8> fan_out(uint8_t slots, const char* name, std::function<bool(int)> fn,
+                                          uint64_t extra_us = 0, std::function<void(int)> on_late = nullptr,
+                                          uint8_t* admitted = nullptr) {
+  std::array<SlotResult, 8> result{};
+  const uint64_t deadline = sdk_deadline_us(name, extra_us);
+  uint8_t run = 0;
+  for (int i = 0; i < 8; ++i) {
+    if (!(slots & (1u << i))) continue;
+    result[i] = admit_slot(i);
+    if (result[i] == SlotResult::OK) run |= (uint8_t)(1u << i);
+  }
+  if (admitted) *admitted = run;
+  if (run == 0) return result;
+  const auto calls = run_each_with_deadline(run, name, std::move(fn), extra_us, std::move(on_late), deadline);
+  for (int i = 0; i < 8; ++i) {
+    if (run & (1u << i)) result[i] = record_sdk_call(i, calls[(size_t)i]);
+  }
+  return result;
+}
+
+// ok/fail/busy masks of a multi-slot ACK plus the timeout mask (byte 5, a
+// subset of fail): the CCU's E_TIMEOUT per slot.
+struct AckMasks {
+  uint8_t ok = 0;
+  uint8_t fail = 0;
+  uint8_t busy = 0;
+  uint8_t timeout = 0;
+
+  void mark(SlotResult r, int slot) {
+    const uint8_t bit = (uint8_t)(1u << slot);
+    switch (r) {
+      case SlotResult::OK: ok |= bit; break;
+      case SlotResult::FAILED: fail |= bit; break;
+      case SlotResult::BUSY: busy |= bit; break;
+      case SlotResult::TIMEOUT: fail |= bit; timeout |= bit; break;
+    }
+  }
+
+  void mark_all(const std::array<SlotResult, 8>& result, uint8_t slots) {
+    for (int i = 0; i < 8; ++i) {
+      if (slots & (1u << i)) mark(result[i], i);
+    }
+  }
+};
+
+// Resp code for a single-slot command that did not succeed.
+static uint8_t failure_code(SlotResult r) {
+  return r == SlotResult::TIMEOUT ? RESP_TIMEOUT : RESP_UNKNOWN;
+}
+
+// Runs on the slot's SDK worker (run_with_deadline). The env lock is only
+// waited on briefly: the holder may be a connect that is itself stuck.
 static bool connect_slot(int idx) {
   if (!g_slots[idx].enabled) return false;
-  std::lock_guard<std::mutex> lock(g_env_mutex);
+  std::unique_lock<std::timed_mutex> lock(g_env_mutex, std::chrono::seconds(2));
+  if (!lock.owns_lock()) return false;
   EnvOverride env(g_slots[idx]);
-  return g_sony[idx].connect_first_camera();
+  if (g_sony[idx].is_connected()) return g_sony[idx].connect_first_camera();
+
+  SlotMetrics& sm = metrics().slot(idx);
+  sm.connect_attempts.fetch_add(1, std::memory_order_relaxed);
+  const auto t0 = std::chrono::steady_clock::now();
+  const bool ok = g_sony[idx].connect_first_camera();
+  const uint64_t us = elapsed_us(t0);
+  sm.connect_latency.record(us);
+  if (ok) {
+    if (sm.connects.fetch_add(1, std::memory_order_relaxed) > 0) sm.reconnects.fetch_add(1, std::memory_order_relaxed);
+    sm.last_connect_us.store(us, std::memory_order_relaxed);
+    slot_health(idx).on_connected(mono_us(std::chrono::steady_clock::now()));
+    std::lock_guard<std::mutex> usb_lock(g_usb_mutex);
+    g_usb_camera[idx] = g_sony[idx].connection_type() == "USB";
+    g_usb_serials[idx] = g_sony[idx].camera_id();
+  } else {
+    sm.connect_failures.fetch_add(1, std::memory_order_relaxed);
+  }
+  return ok;
+}
+
+// Sony USB hotplug (uevent thread). Slots without SONY_CAMERA_IP are USB
+// slots. An attach kicks the disconnected ones; a detach takes the slot
+// whose camera has that serial (or the only connected USB slot) offline at
+// once instead of waiting for the SDK to notice.
+static void on_sony_usb_event(const UsbEvent& ev) {
+  uint8_t usb_slots = 0;
+  for (int i = 0; i < 8; ++i) {
+    if (g_slots[i].enabled && g_slots[i].camera_ip.empty()) usb_slots |= (uint8_t)(1u << i);
+  }
+  discovery().kick();
+  if (ev.attached) {
+    uint8_t kick = 0;
+    for (int i = 0; i < 8; ++i) {
+      if ((usb_slots & (1u << i)) && !g_sony[i].is_connected()) kick |= (uint8_t)(1u << i);
+    }
+    reconnect_signal().kick(kick);
+    return;
+  }
+
+  int slot = -1;
+  int usb_connected = 0;
+  int last_usb = -1;
+  {
+    std::lock_guard<std::mutex> lock(g_usb_mutex);
+    for (int i = 0; i < 8; ++i) {
+      if (!(usb_slots & (1u << i)) || !g_sony[i].is_connected() || !g_usb_camera[i]) continue;
+      usb_connected++;
+      last_usb = i;
+      if (!ev.serial.empty() && g_usb_serials[i] == ev.serial) slot = i;
+    }
+  }
+  if (slot < 0 && usb_connected == 1) slot = last_usb;
+  if (slot < 0) {
+    CCU_LOG_WARN("usb monitor: cannot tell which slot lost %s; waiting for the SDK", ev.devpath.c_str());
+    return;
+  }
+  CCU_LOG_WARN("slot %d: USB camera unplugged", slot);
+  g_sony[slot].mark_disconnected();
+  slot_health(slot).on_disconnected(mono_us(std::chrono::steady_clock::now()));
+  reconnect_signal().kick((uint8_t)(1u << slot));
 }
 
 static uint32_t read_env_u32(const char* name) {
@@ -277,6 +604,10 @@ static uint32_t rd_u32_le(const uint8_t* p) {
   return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
 }
 
+static uint64_t rd_u64_le(const uint8_t* p) {
+  return (uint64_t)rd_u32_le(p) | ((uint64_t)rd_u32_le(p + 4) << 32);
+}
+
 static bool opt_to_property(uint8_t opt_id, CrInt32u& prop_code) {
   switch (opt_id) {
     case OPT_ISO:
@@ -306,69 +637,55 @@ static uint8_t conn_type_from_name(const char* conn) {
   return 0;
 }
 
-static bool build_camera_list_payload(uint8_t* out, size_t out_max, size_t& out_len) {
-  out_len = 0;
-  if (out_max < 1) return false;
-
-  if (!g_crsdk_inited) {
-    g_crsdk_inited = SCRSDK::Init();
-  }
-
-  SCRSDK::ICrEnumCameraObjectInfo* enumInfo = nullptr;
-  {
-    std::lock_guard<std::mutex> lock(g_sdk_mutex);
-    auto st = SCRSDK::EnumCameraObjects(&enumInfo);
-    if (CR_FAILED(st) || !enumInfo) return false;
-  }
-
-  const CrInt32u count = enumInfo->GetCount();
+// docs/ccu_camera_list.md. Serializes the discovery snapshot; never touches
+// the SDK.
+static size_t build_camera_list_payload(uint8_t* out, size_t out_max) {
+  const auto snap = discovery().snapshot();
+  size_t out_len = 0;
   out[out_len++] = 0;
 
+  // Records stop early if the trailer (10 bytes + one flag per record) would not fit.
   uint8_t added = 0;
-  for (CrInt32u i = 0; i < count; ++i) {
-    const auto* info = enumInfo->GetCameraObjectInfo(i);
-    if (!info) continue;
-
-    const char* model = info->GetModel();
-    const char* conn = info->GetConnectionTypeName();
-    const char* ip = info->GetIPAddressChar();
-    const char* mac = info->GetMACAddressChar();
-
-    const uint8_t conn_type = conn_type_from_name(conn);
-    const uint8_t model_len = (uint8_t)std::min<size_t>(model ? std::strlen(model) : 0, 32);
-    const uint8_t ip_len = (uint8_t)std::min<size_t>(ip ? std::strlen(ip) : 0, 32);
-    const uint8_t mac_len = (uint8_t)std::min<size_t>(mac ? std::strlen(mac) : 0, 32);
+  for (size_t i = 0; i < snap->cameras.size() && i < 255; ++i) {
+    const Discovery::Camera& c = snap->cameras[i];
+    const uint8_t model_len = (uint8_t)std::min<size_t>(c.model.size(), 32);
+    const uint8_t ip_len = (uint8_t)std::min<size_t>(c.ip.size(), 32);
+    const uint8_t mac_len = (uint8_t)std::min<size_t>(c.mac.size(), 32);
 
     const size_t need = 1 + 1 + 1 + model_len + 1 + ip_len + 1 + mac_len;
-    if (out_len + need > out_max) break;
+    if (out_len + need + 10 + (size_t)added + 1 > out_max) break;
 
     out[out_len++] = (uint8_t)i;
-    out[out_len++] = conn_type;
+    out[out_len++] = conn_type_from_name(c.conn.c_str());
     out[out_len++] = model_len;
-    if (model_len && model) {
-      std::memcpy(out + out_len, model, model_len);
-      out_len += model_len;
-    }
+    std::memcpy(out + out_len, c.model.data(), model_len);
+    out_len += model_len;
     out[out_len++] = ip_len;
-    if (ip_len && ip) {
-      std::memcpy(out + out_len, ip, ip_len);
-      out_len += ip_len;
-    }
+    std::memcpy(out + out_len, c.ip.data(), ip_len);
+    out_len += ip_len;
     out[out_len++] = mac_len;
-    if (mac_len && mac) {
-      std::memcpy(out + out_len, mac, mac_len);
-      out_len += mac_len;
-    }
+    std::memcpy(out + out_len, c.mac.data(), mac_len);
+    out_len += mac_len;
 
     added++;
   }
-
   out[0] = added;
-  enumInfo->Release();
-  return true;
+
+  const uint64_t now = mono_us(std::chrono::steady_clock::now());
+  const uint64_t age_ms = snap->version ? (now - snap->scanned_us) / 1000 : 0xFFFFFFFFull;
+  out[out_len++] = 1;  // trailer version
+  put32(out + out_len, snap->version);
+  out_len += 4;
+  put32(out + out_len, (uint32_t)std::min<uint64_t>(age_ms, 0xFFFFFFFFull));
+  out_len += 4;
+  out[out_len++] = added;
+  for (uint8_t i = 0; i < added; ++i) out[out_len++] = snap->cameras[i].fingerprint ? 0x01 : 0x00;
+  return out_len;
 }
 
 int main(int argc, char** argv) {
+  logging::start();
+  trace::set_thread_name("main");
   const uint16_t port = (argc >= 2) ? (uint16_t)std::atoi(argv[1]) : 5555;
 
   const char* transport_env = std::getenv("CCU_TRANSPORT");
@@ -389,127 +706,461 @@ int main(int argc, char** argv) {
   if (!any_enabled) {
     g_slots[0].enabled = true;
   }
+  for (int i = 0; i < 8; ++i) g_sony[i].set_slot(i);
+
+  // Flight recorder: on by default in tmpfs (no SD wear); CCU_FLIGHT_MB=0 disables.
+  const char* flight_mb_env = std::getenv("CCU_FLIGHT_MB");
+  const uint32_t flight_mb = (flight_mb_env && flight_mb_env[0]) ? read_env_u32("CCU_FLIGHT_MB") : 16u;
+  if (flight_mb > 0) {
+    const char* flight_env = std::getenv("CCU_FLIGHT_FILE");
+    const std::string flight_path = (flight_env && flight_env[0]) ? flight_env : "/dev/shm/ccu_flight.bin";
+    if (flight::open(flight_path, (size_t)flight_mb << 20)) {
+      CCU_LOG_INFO("ccu_daemon flight recorder -> %s (%u MB)", flight_path.c_str(), (unsigned)flight_mb);
+    } else {
+      CCU_LOG_WARN("Failed to open flight recorder %s", flight_path.c_str());
+    }
+  }
 
   UdpServer udp;
   UartTransport uart;
 
   if (use_uart) {
     if (!uart.open(uart_dev, uart_baud)) {
-      std::fprintf(stderr, "Failed to open UART %s @ %u\n", uart_dev.c_str(), (unsigned)uart_baud);
+      CCU_LOG_ERROR("Failed to open UART %s @ %u", uart_dev.c_str(), (unsigned)uart_baud);
       return 1;
     }
-    std::printf("ccu_daemon listening UART %s @ %u\n", uart_dev.c_str(), (unsigned)uart_baud);
+    CCU_LOG_INFO("ccu_daemon listening UART %s @ %u", uart_dev.c_str(), (unsigned)uart_baud);
   } else {
     if (!udp.open(port)) {
-      std::fprintf(stderr, "Failed to open UDP port %u\n", port);
+      CCU_LOG_ERROR("Failed to open UDP port %u", port);
       return 1;
     }
-    std::printf("ccu_daemon listening UDP :%u\n", port);
+    CCU_LOG_INFO("ccu_daemon listening UDP :%u", port);
+  }
+  {
+    const std::string desc = use_uart ? ("uart " + uart_dev + "@" + std::to_string(uart_baud))
+                                      : ("udp :" + std::to_string(port));
+    flight::record(flight::KIND_START, use_uart ? flight::SRC_UART : flight::SRC_UDP, 0, 0, desc.data(), desc.size());
   }
 
-  // Background connect loop (non-blocking for UDP)
+  // Background connect loop (non-blocking for UDP). Polls every 2 s, and is
+  // woken early by OnDisconnected and network link-up events. After a failed
+  // connect a slot waits out the poll interval, or kKickRetryUs if kicked (a
+  // failed attempt can itself raise OnDisconnected, so kicks cannot spin it).
+  discovery().start();
+  if (!start_link_monitor([] { discovery().kick(); })) {
+    CCU_LOG_WARN("rtnetlink unavailable; reconnects wait for the 2 s poll");
+  }
+  if (!start_usb_monitor(on_sony_usb_event)) CCU_LOG_WARN("uevent socket unavailable; USB cameras are found by the 2 s poll");
   std::thread connect_thread([]() {
+    trace::set_thread_name("connect");
+    static constexpr uint64_t kRetryUs = 2000000ull;
+    static constexpr uint64_t kKickRetryUs = 250000ull;
+    std::array<bool, 8> was_connected = {};
+    std::array<uint64_t, 8> failed_at_us = {};
+    uint8_t kicked = 0;
     while (true) {
       for (int i = 0; i < 8; ++i) {
         if (!g_slots[i].enabled) continue;
+        SlotHealth& hl = slot_health(i);
+        const uint64_t now = mono_us(std::chrono::steady_clock::now());
         if (!g_sony[i].is_connected()) {
-          connect_slot(i);
+          if (was_connected[i]) {
+            metrics().slot(i).disconnects.fetch_add(1, std::memory_order_relaxed);
+            failed_at_us[i] = 0;
+          }
+          const uint64_t wait_us = (kicked & (1u << i)) ? kKickRetryUs : kRetryUs;
+          // Marks the slot busy so requests do not queue behind the connect.
+          if (now - failed_at_us[i] >= wait_us && hl.begin(now)) {
+            const DeadlineCall c = run_with_deadline(i, "connect", [i] { return connect_slot(i); });
+            const uint64_t done = mono_us(std::chrono::steady_clock::now());
+            if (!c.timed_out) hl.finish(c.ok ? SlotHealth::OUTCOME_OK : SlotHealth::OUTCOME_FAILED, done);
+            failed_at_us[i] = c.ok ? 0 : done;
+          }
+        } else if (hl.probe_due(now) && hl.admit(now) == SlotHealth::ADMIT) {
+          // Half-open probe: one cheap status read decides whether the
+          // camera is back before real commands are let through again.
+          const DeadlineCall c = run_with_deadline(i, "probe", [i] {
+            ccu::SonyBackend::Status st{};
+            return g_sony[i].get_status(st);
+          });
+          if (!c.timed_out) hl.finish(SlotHealth::classify(c.ok, c.sdk_error, c.us), mono_us(std::chrono::steady_clock::now()));
         }
+        was_connected[i] = g_sony[i].is_connected();
       }
-      std::this_thread::sleep_for(std::chrono::seconds(2));
+      kicked = reconnect_signal().wait(std::chrono::milliseconds(kRetryUs / 1000));
+      if (kicked) CCU_LOG_DEBUG("connect: woken for slots 0x%02X", (unsigned)kicked);
     }
   });
   connect_thread.detach();
 
+  // Live view: CCU_LIVEVIEW_FPS_<n> (or CCU_LIVEVIEW_FPS for every slot);
+  // unset or 0 = off.
+  for (int i = 0; i < 8; ++i) {
+    if (!g_slots[i].enabled) continue;
+    const char* fps_env = env_slot("CCU_LIVEVIEW_FPS", i);
+    const uint32_t fps = fps_env ? (uint32_t)std::strtoul(fps_env, nullptr, 10) : 0u;
+    if (fps > 0) live_view(i).start(&g_sony[i], std::min<uint32_t>(fps, 60));
+  }
+  // Monitoring LUT for the HTTP stream and the mosaic: CCU_LUT_<n> (or
+  // CCU_LUT for every slot) = path of a .cube file.
+  for (int i = 0; i < 8; ++i) {
+    const char* cube = env_slot("CCU_LUT", i);
+    if (cube && *cube && live_view(i).running() && !lut_view(i).start(cube)) {
+      CCU_LOG_ERROR("slot %d: monitoring LUT not started; streaming camera frames unchanged", i);
+    }
+  }
+  // All of them on one picture: CCU_MOSAIC_FPS, unset or 0 = off.
+  const uint32_t mosaic_fps = read_env_u32("CCU_MOSAIC_FPS");
+  if (mosaic_fps > 0) {
+    const uint32_t tile_w = read_env_u32("CCU_MOSAIC_TILE_W");
+    if (!mosaic().start(std::min<uint32_t>(mosaic_fps, 30), tile_w ? tile_w : 320)) {
+      CCU_LOG_WARN("mosaic not started (needs CCU_LIVEVIEW_FPS)");
+    }
+  }
+  // Exposure scopes for CMD_GET_SCOPES: CCU_SCOPES_HZ, unset or 0 = off.
+  const uint32_t scopes_hz = read_env_u32("CCU_SCOPES_HZ");
+  if (scopes_hz > 0 && !scopes().start(std::min<uint32_t>(scopes_hz, 15))) {
+    CCU_LOG_WARN("scopes not started (needs CCU_LIVEVIEW_FPS)");
+  }
+  // Focus assist for CMD_GET_FOCUS: CCU_FOCUS_HZ, unset or 0 = off.
+  // CCU_FOCUS_PEAKING=1 adds /focus/<n> peaking pictures; edges are pixels
+  // whose |Laplacian| reaches CCU_FOCUS_PEAK_THRESHOLD (default 48).
+  const uint32_t focus_hz = read_env_u32("CCU_FOCUS_HZ");
+  if (focus_hz > 0) {
+    const uint32_t threshold = read_env_u32("CCU_FOCUS_PEAK_THRESHOLD");
+    const uint32_t peaking = read_env_u32("CCU_FOCUS_PEAKING") ? (threshold ? threshold : 48) : 0;
+    if (!focus_assist().start(std::min<uint32_t>(focus_hz, 30), peaking)) {
+      CCU_LOG_WARN("focus assist not started (needs CCU_LIVEVIEW_FPS)");
+    }
+  }
+  // Shared-memory rings for local readers: CCU_SHM_SOCKET = unix socket
+  // path, unset = off. CCU_SHM_FRAMES entries (default 8) of
+  // CCU_SHM_FRAME_KB each (default 1024) per slot.
+  const char* shm_socket = std::getenv("CCU_SHM_SOCKET");
+  if (shm_socket && shm_socket[0]) {
+    const uint32_t frames = read_env_u32("CCU_SHM_FRAMES");
+    const uint32_t frame_kb = read_env_u32("CCU_SHM_FRAME_KB");
+    if (!shm_export().start(shm_socket, frames ? frames : 8, (size_t)(frame_kb ? frame_kb : 1024) * 1024)) {
+      CCU_LOG_WARN("shared-memory live view not started (needs CCU_LIVEVIEW_FPS)");
+    }
+  }
+  // Proxy files of each take: CCU_PROXY_DIR, unset = off; CCU_PROXY_BUFFER_MB
+  // per slot (default 16) rides out storage stalls.
+  const char* proxy_dir = std::getenv("CCU_PROXY_DIR");
+  if (proxy_dir && proxy_dir[0]) {
+    const uint32_t buffer_mb = read_env_u32("CCU_PROXY_BUFFER_MB");
+    if (!proxy_recorder().start(proxy_dir, buffer_mb ? buffer_mb : 16)) {
+      CCU_LOG_WARN("proxy recorder not started (needs CCU_LIVEVIEW_FPS and a writable CCU_PROXY_DIR)");
+    }
+  }
+  // MJPEG over HTTP for the slots above: CCU_HTTP_PORT, unset or 0 = off.
+  const uint32_t http_port = read_env_u32("CCU_HTTP_PORT");
+  if (http_port > 0 && http_port <= 0xFFFF) {
+    if (mjpeg_server().start((uint16_t)http_port)) {
+      CCU_LOG_INFO("ccu_daemon live view http://:%u/", (unsigned)http_port);
+    } else {
+      CCU_LOG_WARN("Failed to open HTTP port %u", (unsigned)http_port);
+    }
+  }
+
+  // Prometheus textfile export (node_exporter textfile collector or any file scraper).
+  const char* metrics_file_env = std::getenv("CCU_METRICS_FILE");
+  if (metrics_file_env && metrics_file_env[0]) {
+    const std::string metrics_path = metrics_file_env;
+    uint32_t interval_ms = read_env_u32("CCU_METRICS_INTERVAL_MS");
+    if (interval_ms == 0) interval_ms = 5000;
+    CCU_LOG_INFO("ccu_daemon metrics -> %s every %u ms", metrics_path.c_str(), (unsigned)interval_ms);
+    std::thread([metrics_path, interval_ms]() {
+      trace::set_thread_name("metrics");
+      bool warned = false;
+      while (true) {
+        if (!metrics().write_prometheus_file(metrics_path) && !warned) {
+          CCU_LOG_WARN("Failed to write metrics file %s", metrics_path.c_str());
+          warned = true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+      }
+    }).detach();
+  }
+
+  MetricsRegistry& mx = metrics();
+  TransportMetrics& tm = mx.transport();
+  uint64_t uart_resyncs_seen = 0;
+  uint64_t uart_bad_crc_seen = 0;
+
   uint8_t rxbuf[512];
-  uint8_t txbuf[512];
+  static constexpr size_t kTxFrameMax = 512;
+  static constexpr size_t kMaxAckPayload = kTxFrameMax - sizeof(Header) - 4;
+  const uint8_t flight_src = use_uart ? flight::SRC_UART : flight::SRC_UDP;
+
+  // The request loop and deferred handlers both send; one frame at a time.
+  std::mutex tx_mutex;
+  auto send_out = [&](const uint8_t* frame, size_t outn, const sockaddr_in& to) {
+    std::lock_guard<std::mutex> lock(tx_mutex);
+    const bool sent = outn > 0 && (use_uart ? uart.send_frame(frame, outn) : udp.sendto(frame, outn, to));
+    flight::record(flight::KIND_FRAME_TX, flight_src, sent ? 0 : 1, 0, frame, outn);
+    (sent ? tm.tx_frames : tm.tx_errors).fetch_add(1, std::memory_order_relaxed);
+  };
+  // Single exit for every ACK: sends on the active transport and records
+  // receive-to-ACK latency against the request's command. FLAG_TIMING
+  // requests get the TimingExt appended when it fits.
+  auto send_ack = [&](const RequestCtx& rq, uint8_t code, const uint8_t* payload, size_t payload_len) {
+    const Header& h = rq.h;
+    uint8_t frame[kTxFrameMax];
+    if ((h.flags & FLAG_TIMING) && payload_len + sizeof(TimingExt) <= kMaxAckPayload) {
+      uint8_t ext_payload[kMaxAckPayload];
+      if (payload_len) std::memcpy(ext_payload, payload, payload_len);
+      TimingExt ext{};
+      const uint64_t pickup_us = mono_us(rq.t_rx);
+      ext.rx_mono_us = rq.rx_ns ? rq.rx_ns / 1000 : pickup_us;
+      ext.queue_us = (uint32_t)std::min<uint64_t>(pickup_us > ext.rx_mono_us ? pickup_us - ext.rx_mono_us : 0, 0xFFFFFFFFu);
+      ext.handler_us = (uint32_t)std::min<uint64_t>(elapsed_us(rq.t_rx), 0xFFFFFFFFu);
+      for (int i = 0; i < 8; ++i) {
+        ext.sdk_us[i] = rq.sdk.us[i];
+        ext.sdk_result[i] = rq.sdk.result[i];
+      }
+      ext.version = TIMING_EXT_VER;
+      ext.ext_len = (uint8_t)sizeof(TimingExt);
+      std::memcpy(ext_payload + payload_len, &ext, sizeof(ext));
+      send_out(frame, build_resp_ack(frame, sizeof(frame), h.seq, h.target_mask, code, ext_payload,
+                                     payload_len + sizeof(ext), FLAG_TIMING), rq.from);
+    } else {
+      send_out(frame, build_resp_ack(frame, sizeof(frame), h.seq, h.target_mask, code, payload, payload_len), rq.from);
+    }
+    CommandMetrics& cm = mx.command(h.cmd_or_code);
+    (code == RESP_OK ? cm.ok : cm.nak).fetch_add(1, std::memory_order_relaxed);
+    cm.latency.record(elapsed_us(rq.t_rx));
+  };
+  // Finishes a handler that waits for a start time (up to 10 s) on its own
+  // thread, so the loop keeps serving TIME_SYNC, GET_STATUS, RUNSTOP and the
+  // rest meanwhile; slots it holds answer busy until it is done. handler
+  // sends its ACK with send_ack and returns the resp code for the trace.
+  auto run_deferred = [&](const RequestCtx& rq, std::function<uint8_t(const RequestCtx&)> handler) {
+    std::thread([ctx = rq, handler = std::move(handler)]() mutable {
+      trace::set_thread_name("deferred");
+      trace::Span span("request", command_name(ctx.h.cmd_or_code), trace::kInheritSlot, ctx.h.seq);
+      t_req_sdk = &ctx.sdk;
+      span.set_result(handler(ctx));
+    }).detach();
+  };
 
   while (true) {
     sockaddr_in from{};
     int n = 0;
+    uint64_t rx_ns = 0;
     if (use_uart) {
       n = uart.recv_frame(rxbuf, sizeof(rxbuf));
+      rx_ns = uart.last_frame_rx_ns();
+      // Frames the UART layer drops never reach parse_packet; fold them in here.
+      if (uart.resyncs() != uart_resyncs_seen) {
+        tm.resyncs.fetch_add(uart.resyncs() - uart_resyncs_seen, std::memory_order_relaxed);
+        uart_resyncs_seen = uart.resyncs();
+      }
+      if (uart.bad_crc() != uart_bad_crc_seen) {
+        tm.bad_crc.fetch_add(uart.bad_crc() - uart_bad_crc_seen, std::memory_order_relaxed);
+        uart_bad_crc_seen = uart.bad_crc();
+      }
     } else {
-      n = udp.recv(rxbuf, sizeof(rxbuf), from);
+      n = udp.recv(rxbuf, sizeof(rxbuf), from, &rx_ns);
     }
     if (n <= 0) { usleep(1000); continue; }
 
+    const auto t_rx = std::chrono::steady_clock::now();
+    trace::Span req_span("request", "rx");
+    tm.rx_frames.fetch_add(1, std::memory_order_relaxed);
+    flight::record(flight::KIND_FRAME_RX, flight_src, ntohl(from.sin_addr.s_addr), ntohs(from.sin_port), rxbuf, (size_t)n);
+
     Header h{};
     const uint8_t* pl = nullptr;
     size_t pl_len = 0;
     uint8_t err = RESP_OK;
 
     if (!parse_packet(rxbuf, (size_t)n, h, pl, pl_len, err)) {
+      (err == RESP_BAD_CRC ? tm.bad_crc : tm.bad_format).fetch_add(1, std::memory_order_relaxed);
       uint8_t ap[8] = {0};
-      const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), 0, 0, err, ap, sizeof(ap));
-      if (use_uart) uart.send_frame(txbuf, outn);
-      else udp.sendto(txbuf, outn, from);
+      uint8_t frame[kTxFrameMax];
+      send_out(frame, build_resp_ack(frame, sizeof(frame), 0, 0, err, ap, sizeof(ap)), from);
       continue;
     }
+    tm.rx_ok.fetch_add(1, std::memory_order_relaxed);
+    mx.command(h.cmd_or_code).rx.fetch_add(1, std::memory_order_relaxed);
+    req_span.set_name(command_name(h.cmd_or_code));
+    req_span.set_code(h.seq);
+    RequestCtx rq;
+    rq.h = h;
+    rq.from = from;
+    rq.rx_ns = rx_ns;
+    rq.t_rx = t_rx;
+    t_req_sdk = &rq.sdk;
+    auto reply = [&](uint8_t code, const uint8_t* payload, size_t payload_len) {
+      send_ack(rq, code, payload, payload_len);
+      req_span.set_result(code);
+    };
 
     if (h.msg_type != MSG_REQ_CMD) {
       uint8_t ap[8] = {0};
-      const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_BAD_FORMAT, ap, sizeof(ap));
-      if (use_uart) uart.send_frame(txbuf, outn);
-      else udp.sendto(txbuf, outn, from);
+      reply(RESP_BAD_FORMAT, ap, sizeof(ap));
       continue;
     }
 
     if (h.cmd_or_code == CMD_RUNSTOP) {
       if (pl_len < 1) {
         uint8_t ap[8] = {0};
-        const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_BAD_FORMAT, ap, sizeof(ap));
-        if (use_uart) uart.send_frame(txbuf, outn);
-        else udp.sendto(txbuf, outn, from);
+        reply(RESP_BAD_FORMAT, ap, sizeof(ap));
         continue;
       }
 
       const bool run = (pl[0] != 0);
 
-      std::printf("RUNSTOP requested: %d (seq=%u target=0x%02X)\n",
+      CCU_LOG_INFO("RUNSTOP requested: %d (seq=%u target=0x%02X)",
                   run ? 1 : 0, h.seq, h.target_mask);
 
-      uint8_t ok_mask = 0;
-      uint8_t fail_mask = 0;
-      uint8_t busy_mask = 0;
+      AckMasks m;
       uint8_t state_run_mask = 0;
       uint8_t state_known_mask = 0;
 
-      for (int i = 0; i < 8; ++i) {
-        if (!slot_selected(h.target_mask, i)) continue;
-        const bool ok = g_sony[i].set_runstop(run);
-        if (ok) {
-          ok_mask |= (1u << i);
-          g_run_state[i] = run;
-          state_known_mask |= (1u << i);
-        } else {
-          fail_mask |= (1u << i);
+      const uint8_t slots = selected_slots(h.target_mask);
+      const auto result = fan_out(slots, "set_runstop", [run](int i) { return g_sony[i].set_runstop(run); });
+      {
+        std::lock_guard<std::mutex> lock(g_rec_mutex);
+        for (int i = 0; i < 8; ++i) {
+          if (!(slots & (1u << i))) continue;
+          const SlotResult r = result[i];
+          m.mark(r, i);
+          if (r == SlotResult::OK) {
+            g_run_state[i] = run;
+            g_status_rec[i] = -1;
+            state_known_mask |= (1u << i);
+          }
+          if (g_run_state[i]) state_run_mask |= (1u << i);
         }
-        if (g_run_state[i]) state_run_mask |= (1u << i);
+        publish_rec_state();
       }
 
-      uint8_t ap[8] = { ok_mask, fail_mask, busy_mask, state_run_mask, state_known_mask, 0,0,0 };
-      const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_OK, ap, sizeof(ap));
-      if (use_uart) uart.send_frame(txbuf, outn);
-      else udp.sendto(txbuf, outn, from);
+      uint8_t ap[8] = { m.ok, m.fail, m.busy, state_run_mask, state_known_mask, m.timeout, 0, 0 };
+      reply(RESP_OK, ap, sizeof(ap));
+      continue;
+    }
+
+    if (h.cmd_or_code == CMD_RUNSTOP_AT) {
+      // run u8, target u64 (CCU clock, us). Needs a CMD_TIME_SYNC estimate.
+      if (pl_len < 9) {
+        uint8_t ap[8] = {0};
+        reply(RESP_BAD_FORMAT, ap, sizeof(ap));
+        continue;
+      }
+      const bool run = (pl[0] != 0);
+      const uint64_t target_ccu_us = rd_u64_le(pl + 1);
+      const uint64_t now_us = mono_us(std::chrono::steady_clock::now());
+      const ClockSync::Estimate est = g_clock_sync.estimate(now_us);
+      if (!est.valid) {
+        CCU_LOG_WARN("RUNSTOP_AT seq=%u rejected: no clock sync", h.seq);
+        uint8_t ap[8] = {0};
+        reply(RESP_UNKNOWN, ap, sizeof(ap));
+        continue;
+      }
+      const int64_t target_us = (int64_t)target_ccu_us + est.offset_us;
+      if (target_us <= 0 || target_us > (int64_t)now_us + 10 * 1000000) {
+        uint8_t ap[8] = {0};
+        reply(RESP_BAD_FORMAT, ap, sizeof(ap));
+        continue;
+      }
+      CCU_LOG_INFO("RUNSTOP_AT requested: %d in %lld us (seq=%u target=0x%02X +/-%u us)",
+                   run ? 1 : 0, (long long)(target_us - (int64_t)now_us), h.seq, h.target_mask,
+                   (unsigned)est.uncertainty_us);
+
+      // Every slot pre-arms and waits for the target on its own thread so a
+      // slow camera cannot delay the others. The wait runs off this loop.
+      const uint64_t fire_ns = (uint64_t)target_us * 1000ull;
+      const uint8_t slots = selected_slots(h.target_mask);
+      const uint32_t uncertainty_us = est.uncertainty_us;
+      run_deferred(rq, [&send_ack, run, fire_ns, slots, uncertainty_us](const RequestCtx& drq) -> uint8_t {
+        // The deadline covers the wait for the start time as well.
+        const uint64_t now_ns = mono_us(std::chrono::steady_clock::now()) * 1000ull;
+        const uint64_t lead_us = fire_ns > now_ns ? (fire_ns - now_ns) / 1000 : 0;
+        auto issued_ns = std::make_shared<std::array<uint64_t, 8>>();
+        const auto result = fan_out(slots, "set_runstop_at", [run, fire_ns, issued_ns](int i) {
+          return g_sony[i].set_runstop(run, fire_ns, &(*issued_ns)[i]);
+        }, lead_us);
+
+        // masks[8], then per slot the accept time minus the target in us
+        // (INT32_MIN = not accepted), then the sync uncertainty.
+        uint8_t payload[8 + 8 * 4 + 4] = {0};
+        AckMasks m;
+        std::lock_guard<std::mutex> lock(g_rec_mutex);
+        for (int i = 0; i < 8; ++i) {
+          int32_t skew = INT32_MIN;
+          if (slots & (1u << i)) {
+            m.mark(result[i], i);
+            if (result[i] == SlotResult::OK) {
+              g_run_state[i] = run;
+              g_status_rec[i] = -1;
+              payload[4] |= (uint8_t)(1u << i);
+            }
+            // Only read back for calls that finished; a timed-out one may still write.
+            const uint64_t issued = result[i] == SlotResult::TIMEOUT ? 0 : (*issued_ns)[i];
+            if (issued) {
+              const int64_t d = ((int64_t)issued - (int64_t)fire_ns) / 1000;
+              skew = (int32_t)std::max<int64_t>(INT32_MIN + 1, std::min<int64_t>(INT32_MAX, d));
+            }
+          }
+          if (g_run_state[i]) payload[3] |= (uint8_t)(1u << i);
+          put32(payload + 8 + i * 4, (uint32_t)skew);
+        }
+        payload[0] = m.ok;
+        payload[1] = m.fail;
+        payload[2] = m.busy;
+        payload[5] = m.timeout;
+        publish_rec_state();
+        put32(payload + 40, uncertainty_us);
+        send_ack(drq, RESP_OK, payload, sizeof(payload));
+        return RESP_OK;
+      });
+      continue;
+    }
+
+    if (h.cmd_or_code == CMD_TIME_SYNC) {
+      // t1 u64 [, prev_t1 u64, prev_t4 u64]: see clock_sync.hpp.
+      if (pl_len < 8) {
+        uint8_t ap[8] = {0};
+        reply(RESP_BAD_FORMAT, ap, sizeof(ap));
+        continue;
+      }
+      const uint64_t t1 = rd_u64_le(pl);
+      if (pl_len >= 24) {
+        const uint64_t prev_t1 = rd_u64_le(pl + 8);
+        if (prev_t1) g_clock_sync.complete(prev_t1, rd_u64_le(pl + 16));
+      }
+      // Kernel arrival time when there is one: pickup trails it by up to the
+      // poll interval, which would skew the offset and inflate the delay.
+      const uint64_t t2 = rq.rx_ns ? rq.rx_ns / 1000 : mono_us(t_rx);
+      const uint64_t t3 = mono_us(std::chrono::steady_clock::now());
+      g_clock_sync.note_exchange(t1, t2, t3);
+      const ClockSync::Estimate est = g_clock_sync.estimate(t3);
+
+      uint8_t payload[37] = {0};
+      put64(payload + 0, t1);
+      put64(payload + 8, t2);
+      put64(payload + 16, t3);
+      put64(payload + 24, (uint64_t)est.offset_us);
+      put32(payload + 32, est.valid ? est.uncertainty_us : 0xFFFFFFFFu);
+      payload[36] = est.samples;
+      reply(RESP_OK, payload, sizeof(payload));
       continue;
     }
 
     if (h.cmd_or_code == CMD_GET_OPTIONS) {
       if (pl_len < 1) {
         uint8_t ap[8] = {0};
-        const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_BAD_FORMAT, ap, sizeof(ap));
-        if (use_uart) uart.send_frame(txbuf, outn);
-        else udp.sendto(txbuf, outn, from);
+        reply(RESP_BAD_FORMAT, ap, sizeof(ap));
         continue;
       }
 
       const int slot = pick_slot(h.target_mask);
       if (slot < 0) {
         uint8_t ap[8] = {0};
-        const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_UNKNOWN, ap, sizeof(ap));
-        if (use_uart) uart.send_frame(txbuf, outn);
-        else udp.sendto(txbuf, outn, from);
+        reply(RESP_UNKNOWN, ap, sizeof(ap));
         continue;
       }
 
@@ -540,20 +1191,21 @@ int main(int argc, char** argv) {
         default:
           {
             uint8_t ap[8] = {0};
-            const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_BAD_FORMAT, ap, sizeof(ap));
-            udp.sendto(txbuf, outn, from);
+            reply(RESP_BAD_FORMAT, ap, sizeof(ap));
             continue;
           }
       }
 
-      ccu::SonyBackend::PropertyOptions opts;
-      const bool ok = g_sony[slot].get_property_options(prop_code, opts);
-      if (!ok) {
+      auto opts_box = std::make_shared<ccu::SonyBackend::PropertyOptions>();
+      const SlotResult r = guarded_sdk_call(slot, "get_property_options", [slot, prop_code, opts_box] {
+        return g_sony[slot].get_property_options(prop_code, *opts_box);
+      });
+      if (r != SlotResult::OK) {
         uint8_t ap[8] = {0};
-        const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_UNKNOWN, ap, sizeof(ap));
-        udp.sendto(txbuf, outn, from);
+        reply(failure_code(r), ap, sizeof(ap));
         continue;
       }
+      const ccu::SonyBackend::PropertyOptions& opts = *opts_box;
 
       auto wr16 = [&](uint8_t* p, uint16_t v) {
         p[0] = (uint8_t)(v & 0xFF);
@@ -568,10 +1220,9 @@ int main(int argc, char** argv) {
 
       const uint16_t count = (uint16_t)opts.values.size();
       const size_t payload_len = 1 + 2 + 2 + 4 + (size_t)count * 4;
-      if (payload_len > sizeof(txbuf) - sizeof(Header) - 4) {
+      if (payload_len > kMaxAckPayload) {
         uint8_t ap[8] = {0};
-        const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_BAD_FORMAT, ap, sizeof(ap));
-        udp.sendto(txbuf, outn, from);
+        reply(RESP_BAD_FORMAT, ap, sizeof(ap));
         continue;
       }
 
@@ -586,10 +1237,8 @@ int main(int argc, char** argv) {
         off += 4;
       }
 
-      std::printf("OPTIONS %s count=%u current=0x%08X\n", label, (unsigned)count, (unsigned)opts.current_value);
-      const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_OK, payload, off);
-      if (use_uart) uart.send_frame(txbuf, outn);
-      else udp.sendto(txbuf, outn, from);
+      CCU_LOG_DEBUG("OPTIONS %s count=%u current=0x%08X", label, (unsigned)count, (unsigned)opts.current_value);
+      reply(RESP_OK, payload, off);
       continue;
     }
 
@@ -598,20 +1247,18 @@ int main(int argc, char** argv) {
       const int slot = pick_slot(h.target_mask);
       if (slot < 0) {
         uint8_t ap[8] = {0};
-        const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_UNKNOWN, ap, sizeof(ap));
-        if (use_uart) uart.send_frame(txbuf, outn);
-        else udp.sendto(txbuf, outn, from);
+        reply(RESP_UNKNOWN, ap, sizeof(ap));
         continue;
       }
 
-      const bool ok = g_sony[slot].get_status(st);
-      if (!ok) {
+      auto st_box = std::make_shared<ccu::SonyBackend::Status>();
+      const SlotResult r = guarded_sdk_call(slot, "get_status", [slot, st_box] { return g_sony[slot].get_status(*st_box); });
+      if (r != SlotResult::OK) {
         uint8_t ap[8] = {0};
-        const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_UNKNOWN, ap, sizeof(ap));
-        if (use_uart) uart.send_frame(txbuf, outn);
-        else udp.sendto(txbuf, outn, from);
+        reply(failure_code(r), ap, sizeof(ap));
         continue;
       }
+      st = *st_box;
 
       const uint32_t battery_pct = battery_percent_from_status(st);
         const uint32_t media1_time = media_time_value(st.media_slot1_remaining_time);
@@ -623,10 +1270,16 @@ int main(int argc, char** argv) {
       st.battery_remain_unit = 1; // percent
       st.media_slot1_remaining_time = media1_time;
       st.media_slot2_remaining_time = media2_time;
-      if (st.recording_state == 0xFFFFFFFFu) {
-        // Freeze baseline (2026-02-08): when camera recording_state is
-        // unavailable, keep CCU UI aligned to the last accepted RUNSTOP state.
-        st.recording_state = g_run_state[slot] ? 1u : 0u;
+      {
+        std::lock_guard<std::mutex> lock(g_rec_mutex);
+        if (st.recording_state == 0xFFFFFFFFu) {
+          // Freeze baseline (2026-02-08): when camera recording_state is
+          // unavailable, keep CCU UI aligned to the last accepted RUNSTOP state.
+          st.recording_state = g_run_state[slot] ? 1u : 0u;
+        } else if (g_status_rec[slot] != (st.recording_state != 0u ? 1 : 0)) {
+          g_status_rec[slot] = st.recording_state != 0u ? 1 : 0;
+          publish_rec_state();
+        }
       }
 
       auto wr32 = [&](uint8_t* p, uint32_t v) {
@@ -667,7 +1320,7 @@ int main(int argc, char** argv) {
         off += model_len;
       }
 
-      std::printf("[ccu_daemon] STATUS tx seq=%u slot=%d target=0x%02X rec=0x%08X rec_media=0x%08X conn=%u model=%s\n",
+      CCU_LOG_DEBUG("[ccu_daemon] STATUS tx seq=%u slot=%d target=0x%02X rec=0x%08X rec_media=0x%08X conn=%u model=%s",
                   h.seq,
                   slot,
                   h.target_mask,
@@ -676,18 +1329,14 @@ int main(int argc, char** argv) {
                   (unsigned)conn_type,
                   model.c_str());
 
-      const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_OK, payload, off);
-      if (use_uart) uart.send_frame(txbuf, outn);
-      else udp.sendto(txbuf, outn, from);
+      reply(RESP_OK, payload, off);
       continue;
     }
 
     if (h.cmd_or_code == CMD_SET_VALUE) {
       if (pl_len < 5) {
         uint8_t ap[8] = {0};
-        const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_BAD_FORMAT, ap, sizeof(ap));
-        if (use_uart) uart.send_frame(txbuf, outn);
-        else udp.sendto(txbuf, outn, from);
+        reply(RESP_BAD_FORMAT, ap, sizeof(ap));
         continue;
       }
 
@@ -697,36 +1346,26 @@ int main(int argc, char** argv) {
       CrInt32u prop_code = 0;
       if (!opt_to_property(opt_id, prop_code)) {
         uint8_t ap[8] = {0};
-        const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_BAD_FORMAT, ap, sizeof(ap));
-        if (use_uart) uart.send_frame(txbuf, outn);
-        else udp.sendto(txbuf, outn, from);
+        reply(RESP_BAD_FORMAT, ap, sizeof(ap));
         continue;
       }
 
-      uint8_t ok_mask = 0;
-      uint8_t fail_mask = 0;
-      uint8_t busy_mask = 0;
+      const uint8_t slots = selected_slots(h.target_mask);
+      const auto result = fan_out(slots, "set_property_value", [prop_code, value](int i) {
+        return g_sony[i].set_property_value(prop_code, value);
+      });
+      AckMasks m;
+      m.mark_all(result, slots);
 
-      for (int i = 0; i < 8; ++i) {
-        if (!slot_selected(h.target_mask, i)) continue;
-        const bool ok = g_sony[i].set_property_value(prop_code, value);
-        if (ok) ok_mask |= (1u << i);
-        else fail_mask |= (1u << i);
-      }
-
-      uint8_t ap[8] = { ok_mask, fail_mask, busy_mask, 0, 0, 0, 0, 0 };
-      const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_OK, ap, sizeof(ap));
-      if (use_uart) uart.send_frame(txbuf, outn);
-      else udp.sendto(txbuf, outn, from);
+      uint8_t ap[8] = { m.ok, m.fail, m.busy, 0, 0, m.timeout, 0, 0 };
+      reply(RESP_OK, ap, sizeof(ap));
       continue;
     }
 
     if (h.cmd_or_code == CMD_PARAM_STEP) {
       if (pl_len < 2) {
         uint8_t ap[8] = {0};
-        const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_BAD_FORMAT, ap, sizeof(ap));
-        if (use_uart) uart.send_frame(txbuf, outn);
-        else udp.sendto(txbuf, outn, from);
+        reply(RESP_BAD_FORMAT, ap, sizeof(ap));
         continue;
       }
 
@@ -736,94 +1375,277 @@ int main(int argc, char** argv) {
       CrInt32u prop_code = 0;
       if (!opt_to_property(opt_id, prop_code)) {
         uint8_t ap[8] = {0};
-        const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_BAD_FORMAT, ap, sizeof(ap));
-        udp.sendto(txbuf, outn, from);
+        reply(RESP_BAD_FORMAT, ap, sizeof(ap));
         continue;
       }
 
-      uint8_t ok_mask = 0;
-      uint8_t fail_mask = 0;
-      uint8_t busy_mask = 0;
+      const uint8_t slots = selected_slots(h.target_mask);
+      const auto result = fan_out(slots, "step_property_value", [prop_code, step](int i) {
+        return g_sony[i].step_property_value(prop_code, step);
+      });
+      AckMasks m;
+      m.mark_all(result, slots);
 
-      for (int i = 0; i < 8; ++i) {
-        if (!slot_selected(h.target_mask, i)) continue;
-        const bool ok = g_sony[i].step_property_value(prop_code, step);
-        if (ok) ok_mask |= (1u << i);
-        else fail_mask |= (1u << i);
-      }
-
-      uint8_t ap[8] = { ok_mask, fail_mask, busy_mask, 0, 0, 0, 0, 0 };
-      const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_OK, ap, sizeof(ap));
-      if (use_uart) uart.send_frame(txbuf, outn);
-      else udp.sendto(txbuf, outn, from);
+      uint8_t ap[8] = { m.ok, m.fail, m.busy, 0, 0, m.timeout, 0, 0 };
+      reply(RESP_OK, ap, sizeof(ap));
       continue;
     }
 
     if (h.cmd_or_code == CMD_CAPTURE_STILL) {
       if (pl_len < 1) {
         uint8_t ap[8] = {0};
-        const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_BAD_FORMAT, ap, sizeof(ap));
-        if (use_uart) uart.send_frame(txbuf, outn);
-        else udp.sendto(txbuf, outn, from);
+        reply(RESP_BAD_FORMAT, ap, sizeof(ap));
         continue;
       }
 
       const bool with_af = (pl[0] != 0);
 
-      uint8_t ok_mask = 0;
-      uint8_t fail_mask = 0;
-      uint8_t busy_mask = 0;
-      for (int i = 0; i < 8; ++i) {
-        if (!slot_selected(h.target_mask, i)) continue;
-        const bool ok = g_sony[i].capture_still(with_af);
-        if (ok) ok_mask |= (1u << i);
-        else fail_mask |= (1u << i);
-      }
-      uint8_t ap[8] = { ok_mask, fail_mask, busy_mask, 0, 0, 0, 0, 0 };
-      const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_OK, ap, sizeof(ap));
-      udp.sendto(txbuf, outn, from);
+      const uint8_t slots = selected_slots(h.target_mask);
+      const auto result = fan_out(slots, "capture_still", [with_af](int i) { return g_sony[i].capture_still(with_af); });
+      AckMasks m;
+      m.mark_all(result, slots);
+      uint8_t ap[8] = { m.ok, m.fail, m.busy, 0, 0, m.timeout, 0, 0 };
+      reply(RESP_OK, ap, sizeof(ap));
+      continue;
+    }
+
+    if (h.cmd_or_code == CMD_CAPTURE_SYNC) {
+      // af u8 [, target u64 (CCU clock, us; 0 = as soon as every slot is armed)].
+      if (pl_len < 1) {
+        uint8_t ap[8] = {0};
+        reply(RESP_BAD_FORMAT, ap, sizeof(ap));
+        continue;
+      }
+      const bool af = (pl[0] != 0);
+      const uint64_t target_ccu_us = pl_len >= 9 ? rd_u64_le(pl + 1) : 0;
+      uint64_t now_us = mono_us(std::chrono::steady_clock::now());
+      ClockSync::Estimate est{};
+      int64_t target_us = 0;
+      if (target_ccu_us) {
+        est = g_clock_sync.estimate(now_us);
+        if (!est.valid) {
+          CCU_LOG_WARN("CAPTURE_SYNC seq=%u rejected: no clock sync", h.seq);
+          uint8_t ap[8] = {0};
+          reply(RESP_UNKNOWN, ap, sizeof(ap));
+          continue;
+        }
+        target_us = (int64_t)target_ccu_us + est.offset_us;
+        if (target_us <= (int64_t)now_us || target_us > (int64_t)now_us + 10 * 1000000) {
+          uint8_t ap[8] = {0};
+          reply(RESP_BAD_FORMAT, ap, sizeof(ap));
+          continue;
+        }
+      }
+      // Each SDK worker needs a moment to pick up its release and set its
+      // timer; without a target the release is this far after the last arm.
+      static constexpr uint64_t kReleaseLeadUs = 20000;
+      static constexpr uint32_t kAfTimeoutMs = 1500;
+      uint32_t af_ms = kAfTimeoutMs;
+      if (target_us) {
+        const int64_t room_ms = (target_us - (int64_t)now_us - (int64_t)kReleaseLeadUs) / 1000;
+        af_ms = (uint32_t)std::max<int64_t>(0, std::min<int64_t>(af_ms, room_ms));
+      }
+      CCU_LOG_INFO("CAPTURE_SYNC requested: af=%d %s (seq=%u target=0x%02X)", af ? 1 : 0,
+                   target_us ? "scheduled" : "on arm", h.seq, h.target_mask);
+
+      // Both phases run off this loop (a scheduled release can be 10 s away).
+      const uint8_t slots = selected_slots(h.target_mask);
+      const uint32_t uncertainty_us = target_us ? est.uncertainty_us : 0;
+      run_deferred(rq, [&send_ack, af, af_ms, target_us, slots, uncertainty_us](const RequestCtx& drq) -> uint8_t {
+        // Phase one: half-press every slot in parallel so AF runs on all
+        // cameras at once instead of at each release.
+        const auto t_arm = std::chrono::steady_clock::now();
+        // An arm abandoned at its deadline lets go of S1 once it returns.
+        auto focused = std::make_shared<std::array<bool, 8>>();
+        uint8_t admitted = 0;
+        const std::array<SlotResult, 8> armed = fan_out(slots, "still_arm",
+            [af, af_ms, focused](int i) { return g_sony[i].still_arm(af, af_ms, &(*focused)[i]); },
+            0, [](int i) { g_sony[i].still_cancel(); }, &admitted);
+        const uint64_t arm_us = elapsed_us(t_arm);
+
+        // Phase two: every slot that answered sleeps on a timerfd to the same
+        // instant. A slot whose S1 was refused still fires (a plain release).
+        const uint64_t now_us = mono_us(std::chrono::steady_clock::now());
+        const uint64_t fire_us = target_us ? (uint64_t)target_us : now_us + kReleaseLeadUs;
+        const uint64_t fire_ns = fire_us * 1000ull;
+        const uint64_t lead_us = fire_us > now_us ? fire_us - now_us : 0;
+        uint8_t fire = 0;
+        for (int i = 0; i < 8; ++i) {
+          if (!(admitted & (1u << i)) || armed[i] == SlotResult::TIMEOUT) continue;
+          if (armed[i] != SlotResult::FAILED || g_sony[i].is_connected()) fire |= (uint8_t)(1u << i);
+        }
+        auto issued_ns = std::make_shared<std::array<uint64_t, 8>>();
+        uint8_t released = 0;
+        std::array<SlotResult, 8> result = fan_out(fire, "still_release", [fire_ns, issued_ns](int i) {
+          return g_sony[i].still_release(fire_ns, &(*issued_ns)[i]);
+        }, lead_us, nullptr, &released);
+        for (int i = 0; i < 8; ++i) {
+          if (!(fire & (1u << i))) result[i] = armed[i];
+          if (!(admitted & (1u << i)) || armed[i] == SlotResult::TIMEOUT || (released & (1u << i))) continue;
+          // Not released (still_release lets go of S1 itself): undo a
+          // half-press that may have taken, behind any call in flight.
+          sdk_executor().post(i, [i] {
+            trace::Span span("backend", "still_cancel", i);
+            g_sony[i].still_cancel();
+          });
+        }
+
+        // As CMD_RUNSTOP_AT: masks[8] (byte 3 = AF locked, byte 4 = armed),
+        // per slot the release accept time minus the release instant in us
+        // (INT32_MIN = not released), the sync uncertainty, then the arm time.
+        uint8_t payload[8 + 8 * 4 + 4 + 4] = {0};
+        AckMasks m;
+        for (int i = 0; i < 8; ++i) {
+          int32_t skew = INT32_MIN;
+          if (slots & (1u << i)) {
+            m.mark(result[i], i);
+            if (armed[i] == SlotResult::OK) {
+              payload[4] |= (uint8_t)(1u << i);
+              if ((*focused)[i]) payload[3] |= (uint8_t)(1u << i);
+            }
+            // Only read back for calls that finished; a timed-out one may still write.
+            const uint64_t issued = result[i] == SlotResult::TIMEOUT ? 0 : (*issued_ns)[i];
+            if (issued) {
+              const int64_t d = ((int64_t)issued - (int64_t)fire_ns) / 1000;
+              skew = (int32_t)std::max<int64_t>(INT32_MIN + 1, std::min<int64_t>(INT32_MAX, d));
+            }
+          }
+          put32(payload + 8 + i * 4, (uint32_t)skew);
+        }
+        payload[0] = m.ok;
+        payload[1] = m.fail;
+        payload[2] = m.busy;
+        payload[5] = m.timeout;
+        put32(payload + 40, uncertainty_us);
+        put32(payload + 44, (uint32_t)std::min<uint64_t>(arm_us, 0xFFFFFFFFull));
+        send_ack(drq, RESP_OK, payload, sizeof(payload));
+        return RESP_OK;
+      });
       continue;
     }
 
     if (h.cmd_or_code == CMD_DISCOVER) {
-      uint8_t ok_mask = 0;
-      uint8_t fail_mask = 0;
-      uint8_t busy_mask = 0;
+      discovery().kick();
+      // Every selected slot reconnects at once under one deadline. A slot
+      // whose breaker is open (or that is connecting in the background) is
+      // rejected like any other request and left to the connect thread, which
+      // is woken for it; that keeps a dead camera from costing a 20 s connect
+      // per DISCOVER.
+      const uint8_t slots = selected_slots(h.target_mask);
+      const uint64_t deadline = sdk_deadline_us("connect");
+      std::array<SlotResult, 8> result{};
+      uint8_t admitted = 0;
+      for (int i = 0; i < 8; ++i) {
+        if (!(slots & (1u << i))) continue;
+        result[i] = admit_slot(i);
+        if (result[i] == SlotResult::OK) admitted |= (uint8_t)(1u << i);
+      }
+      // Not timed_sdk_call: connect time is in the connect metrics, not the
+      // per-slot SDK latency.
+      const auto calls = run_each_with_deadline(admitted, "connect", [](int i) { return connect_slot(i); }, 0,
+                                                nullptr, deadline);
       for (int i = 0; i < 8; ++i) {
-        if (!slot_selected(h.target_mask, i)) continue;
-        const bool ok = connect_slot(i);
-        if (ok) ok_mask |= (1u << i);
-        else fail_mask |= (1u << i);
-      }
-      uint8_t ap[8] = { ok_mask, fail_mask, busy_mask, 0, 0, 0, 0, 0 };
-      const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_OK, ap, sizeof(ap));
-      udp.sendto(txbuf, outn, from);
+        if (!(admitted & (1u << i))) continue;
+        const DeadlineCall& c = calls[(size_t)i];
+        if (c.timed_out) {
+          note_request_sdk(i, c.us, false, TIMING_TIMED_OUT);
+          result[i] = SlotResult::TIMEOUT;
+          continue;
+        }
+        note_request_sdk(i, c.us, c.ok, c.sdk_error);
+        slot_health(i).finish(SlotHealth::classify(c.ok, c.sdk_error, c.us), mono_us(std::chrono::steady_clock::now()));
+        result[i] = c.ok ? SlotResult::OK : SlotResult::FAILED;
+      }
+      reconnect_signal().kick((uint8_t)(slots & ~admitted));
+      AckMasks m;
+      m.mark_all(result, slots);
+      uint8_t ap[8] = { m.ok, m.fail, m.busy, 0, 0, m.timeout, 0, 0 };
+      reply(RESP_OK, ap, sizeof(ap));
+      continue;
+    }
+
+    if (h.cmd_or_code == CMD_GET_STATS) {
+      // Leave room for the timing extension so it is not dropped.
+      uint8_t payload[kMaxAckPayload] = {0};
+      const size_t room = (h.flags & FLAG_TIMING) ? sizeof(payload) - sizeof(TimingExt) : sizeof(payload);
+      const size_t payload_len = mx.build_stats_payload(payload, room);
+      if (payload_len == 0) {
+        uint8_t ap[8] = {0};
+        reply(RESP_UNKNOWN, ap, sizeof(ap));
+        continue;
+      }
+      reply(RESP_OK, payload, payload_len);
+      continue;
+    }
+
+    if (h.cmd_or_code == CMD_TRACE_DUMP) {
+      // Optional u16 window in seconds (default 10). The spans are copied
+      // here; JSON formatting and the file write happen off the request path.
+      uint32_t window_s = 10;
+      if (pl_len >= 2) window_s = (uint32_t)pl[0] | ((uint32_t)pl[1] << 8);
+      window_s = std::min<uint32_t>(std::max<uint32_t>(window_s, 1), 600);
+
+      auto snap = std::make_shared<std::vector<trace::ThreadEvents>>(trace::snapshot(window_s * 1000));
+      const char* dir_env = std::getenv("CCU_TRACE_DIR");
+      const std::string dir = (dir_env && dir_env[0]) ? dir_env : "/tmp";
+      const std::string path = dir + "/ccu_trace_" + std::to_string((long long)std::time(nullptr)) +
+                               "_" + std::to_string(h.seq) + ".json";
+      std::thread([snap, path]() {
+        if (!trace::write_chrome_json(path, *snap)) CCU_LOG_WARN("Failed to write trace %s", path.c_str());
+        else CCU_LOG_INFO("Trace written: %s (%u spans)", path.c_str(), (unsigned)trace::event_count(*snap));
+      }).detach();
+
+      uint8_t payload[256] = {0};
+      const uint32_t count = (uint32_t)trace::event_count(*snap);
+      const size_t path_len = std::min(path.size(), sizeof(payload) - 5);
+      payload[0] = (uint8_t)(count & 0xFF);
+      payload[1] = (uint8_t)((count >> 8) & 0xFF);
+      payload[2] = (uint8_t)((count >> 16) & 0xFF);
+      payload[3] = (uint8_t)((count >> 24) & 0xFF);
+      payload[4] = (uint8_t)path_len;
+      std::memcpy(payload + 5, path.data(), path_len);
+      reply(RESP_OK, payload, 5 + path_len);
       continue;
     }
 
     if (h.cmd_or_code == CMD_LIST_CAMERAS) {
-      uint8_t payload[512] = {0};
-      size_t payload_len = 0;
-      if (!build_camera_list_payload(payload, sizeof(payload), payload_len)) {
+      uint8_t payload[kMaxAckPayload] = {0};
+      const size_t room = (h.flags & FLAG_TIMING) ? sizeof(payload) - sizeof(TimingExt) : sizeof(payload);
+      reply(RESP_OK, payload, build_camera_list_payload(payload, room));
+      continue;
+    }
+
+    if (h.cmd_or_code == CMD_GET_SCOPES) {
+      // The record is precomputed by the scopes thread; this only copies it.
+      // Slots without scopes answer with the valid flag clear.
+      static_assert(Scopes::kPayloadBytes + sizeof(TimingExt) <= kMaxAckPayload, "scopes ACK too large");
+      const int slot = pick_slot(h.target_mask);
+      if (slot < 0) {
         uint8_t ap[8] = {0};
-        const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_UNKNOWN, ap, sizeof(ap));
-        if (use_uart) uart.send_frame(txbuf, outn);
-        else udp.sendto(txbuf, outn, from);
+        reply(RESP_UNKNOWN, ap, sizeof(ap));
         continue;
       }
+      uint8_t payload[Scopes::kPayloadBytes];
+      reply(RESP_OK, payload, scopes().build_payload(slot, payload, sizeof(payload)));
+      continue;
+    }
 
-      const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_OK, payload, payload_len);
-      if (use_uart) uart.send_frame(txbuf, outn);
-      else udp.sendto(txbuf, outn, from);
+    if (h.cmd_or_code == CMD_GET_FOCUS) {
+      // One record per selected slot, so the CCU can watch every camera with
+      // one request. Slots without focus assist have the valid flag clear.
+      uint8_t mask = 0;
+      for (int i = 0; i < 8; ++i) {
+        if (slot_selected(h.target_mask, i)) mask |= (uint8_t)(1u << i);
+      }
+      uint8_t payload[2 + 8 * FocusAssist::kRecordBytes];
+      reply(RESP_OK, payload, focus_assist().build_payload(mask, payload, sizeof(payload)));
       continue;
     }
 
     if (h.cmd_or_code == CMD_SET_SLOT_CONFIG) {
       if (pl_len < 2) {
         uint8_t ap[8] = {0};
-        const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_BAD_FORMAT, ap, sizeof(ap));
-        if (use_uart) uart.send_frame(txbuf, outn);
-        else udp.sendto(txbuf, outn, from);
+        reply(RESP_BAD_FORMAT, ap, sizeof(ap));
         continue;
       }
 
@@ -846,9 +1668,7 @@ int main(int argc, char** argv) {
 
       if (slot >= 8) {
         uint8_t ap[8] = {0};
-        const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_BAD_FORMAT, ap, sizeof(ap));
-        if (use_uart) uart.send_frame(txbuf, outn);
-        else udp.sendto(txbuf, outn, from);
+        reply(RESP_BAD_FORMAT, ap, sizeof(ap));
         continue;
       }
 
@@ -862,8 +1682,7 @@ int main(int argc, char** argv) {
           !read_str(cfg.pass) ||
           !read_str(cfg.fingerprint)) {
         uint8_t ap[8] = {0};
-        const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_BAD_FORMAT, ap, sizeof(ap));
-        udp.sendto(txbuf, outn, from);
+        reply(RESP_BAD_FORMAT, ap, sizeof(ap));
         continue;
       }
 
@@ -876,18 +1695,14 @@ int main(int argc, char** argv) {
       else fail_mask |= (1u << slot);
 
       uint8_t ap[8] = { ok_mask, fail_mask, 0, 0, 0, 0, 0, 0 };
-      const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, saved ? RESP_OK : RESP_UNKNOWN, ap, sizeof(ap));
-      if (use_uart) uart.send_frame(txbuf, outn);
-      else udp.sendto(txbuf, outn, from);
+      reply(saved ? RESP_OK : RESP_UNKNOWN, ap, sizeof(ap));
       continue;
     }
 
     // Unknown command
     {
       uint8_t ap[8] = {0};
-      const size_t outn = build_resp_ack(txbuf, sizeof(txbuf), h.seq, h.target_mask, RESP_UNKNOWN, ap, sizeof(ap));
-      if (use_uart) uart.send_frame(txbuf, outn);
-      else udp.sendto(txbuf, outn, from);
+      reply(RESP_UNKNOWN, ap, sizeof(ap));
     }
   }
 
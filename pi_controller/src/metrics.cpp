@@ -0,0 +1,342 @@
+#include "metrics.hpp"
+#include "protocol.hpp"
+#include "async_log.hpp"
+#include <cstdarg>
+#include <cstdio>
+#include <algorithm>
+
+namespace ccu {
+
+static constexpr auto kRelaxed = std::memory_order_relaxed;
+
+// ------------------------------------------------------------
+// LatencyHistogram
+// ------------------------------------------------------------
+
+int LatencyHistogram::bucket_of(uint64_t us) {
+  if (us < (uint64_t)kSub) return (int)us;
+  const uint64_t cap = (2ull << kMaxExp) - 1;
+  if (us > cap) us = cap;
+  const int e = 63 - __builtin_clzll(us);
+  const int shift = e - kSubBits;
+  const int mant = (int)((us >> shift) & (uint64_t)(kSub - 1));
+  return (shift + 1) * kSub + mant;
+}
+
+uint64_t LatencyHistogram::bucket_upper(int idx) {
+  if (idx < kSub) return (uint64_t)idx;
+  const int shift = idx / kSub - 1;
+  const uint64_t mant = (uint64_t)(idx % kSub);
+  const uint64_t lower = ((uint64_t)kSub + mant) << shift;
+  return lower + (1ull << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t us) {
+  m_buckets[(size_t)bucket_of(us)].fetch_add(1, kRelaxed);
+  m_count.fetch_add(1, kRelaxed);
+  m_sum.fetch_add(us, kRelaxed);
+  uint64_t prev = m_max.load(kRelaxed);
+  while (us > prev && !m_max.compare_exchange_weak(prev, us, kRelaxed)) {}
+}
+
+uint64_t LatencyHistogram::percentile_us(double q) const {
+  const uint64_t n = count();
+  if (n == 0) return 0;
+  q = std::min(1.0, std::max(0.0, q));
+  uint64_t target = (uint64_t)(q * (double)n + 0.5);
+  if (target == 0) target = 1;
+  uint64_t seen = 0;
+  for (int i = 0; i < kBuckets; ++i) {
+    seen += m_buckets[(size_t)i].load(kRelaxed);
+    if (seen >= target) return std::min(bucket_upper(i), max_us());
+  }
+  return max_us();
+}
+
+uint64_t LatencyHistogram::count_le(uint64_t us) const {
+  uint64_t seen = 0;
+  for (int i = 0; i < kBuckets && bucket_upper(i) <= us; ++i) {
+    seen += m_buckets[(size_t)i].load(kRelaxed);
+  }
+  return seen;
+}
+
+// ------------------------------------------------------------
+// MetricsRegistry
+// ------------------------------------------------------------
+
+// Order defines the registry index; the last entry catches unknown opcodes.
+static const uint8_t kCommandIds[MetricsRegistry::kCommands] = {
+  CMD_RUNSTOP, CMD_RUNSTOP_AT, CMD_GET_OPTIONS, CMD_GET_STATUS, CMD_CAPTURE_STILL,
+  CMD_DISCOVER, CMD_LIST_CAMERAS, CMD_GET_STATS, CMD_TRACE_DUMP, CMD_TIME_SYNC,
+  CMD_GET_SCOPES, CMD_GET_FOCUS, CMD_CAPTURE_SYNC, CMD_SET_VALUE, CMD_PARAM_STEP, CMD_SET_SLOT_CONFIG,
+  0x00,
+};
+
+static const char* command_label(size_t idx) {
+  return idx + 1 < MetricsRegistry::kCommands ? command_name(kCommandIds[idx]) : "other";
+}
+
+MetricsRegistry::MetricsRegistry() : m_start(std::chrono::steady_clock::now()) {}
+
+size_t MetricsRegistry::command_index(uint8_t cmd) {
+  for (size_t i = 0; i + 1 < kCommands; ++i) {
+    if (kCommandIds[i] == cmd) return i;
+  }
+  return kCommands - 1;
+}
+
+CommandMetrics& MetricsRegistry::command(uint8_t cmd) {
+  return m_commands[command_index(cmd)];
+}
+
+uint64_t MetricsRegistry::uptime_s() const {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::seconds>(
+    std::chrono::steady_clock::now() - m_start).count();
+}
+
+static uint32_t sat32(uint64_t v) { return v > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)v; }
+static uint16_t sat16(uint64_t v) { return v > 0xFFFFull ? (uint16_t)0xFFFF : (uint16_t)v; }
+
+namespace {
+struct Writer {
+  uint8_t* p;
+  size_t left;
+  bool ok = true;
+  void u8(uint8_t v) { if (left < 1) { ok = false; return; } *p++ = v; left -= 1; }
+  void u16(uint16_t v) { u8((uint8_t)(v & 0xFF)); u8((uint8_t)(v >> 8)); }
+  void u32(uint32_t v) { u16((uint16_t)(v & 0xFFFF)); u16((uint16_t)(v >> 16)); }
+};
+} // namespace
+
+size_t MetricsRegistry::build_stats_payload(uint8_t* out, size_t out_max) const {
+  Writer w{out, out_max};
+  w.u8(1); // payload version
+  w.u32(sat32(uptime_s()));
+
+  const TransportMetrics& t = m_transport;
+  w.u32(sat32(t.rx_frames.load(kRelaxed)));
+  w.u32(sat32(t.rx_ok.load(kRelaxed)));
+  w.u32(sat32(t.bad_crc.load(kRelaxed)));
+  w.u32(sat32(t.bad_format.load(kRelaxed)));
+  w.u32(sat32(t.resyncs.load(kRelaxed)));
+  w.u32(sat32(t.tx_frames.load(kRelaxed)));
+  w.u32(sat32(t.tx_errors.load(kRelaxed)));
+
+  // Only commands seen so far, and only as many as leave room for the slot
+  // records, to keep the ACK inside one UART frame.
+  static constexpr size_t kCmdRecord = 21;
+  static constexpr size_t kSlotSection = 1 + kSlots * 22;
+  const size_t cmd_room = w.left > 1 + kSlotSection ? (w.left - 1 - kSlotSection) / kCmdRecord : 0;
+  size_t n_cmd = 0;
+  for (size_t i = 0; i < kCommands; ++i) {
+    if (m_commands[i].rx.load(kRelaxed) != 0) ++n_cmd;
+  }
+  n_cmd = std::min(n_cmd, cmd_room);
+  w.u8((uint8_t)n_cmd);
+  for (size_t i = 0, written = 0; i < kCommands && written < n_cmd; ++i) {
+    const CommandMetrics& c = m_commands[i];
+    if (c.rx.load(kRelaxed) == 0) continue;
+    ++written;
+    w.u8(kCommandIds[i]);
+    w.u32(sat32(c.rx.load(kRelaxed)));
+    w.u32(sat32(c.nak.load(kRelaxed)));
+    w.u32(sat32(c.latency.percentile_us(0.50)));
+    w.u32(sat32(c.latency.percentile_us(0.99)));
+    w.u32(sat32(c.latency.max_us()));
+  }
+
+  w.u8((uint8_t)kSlots);
+  for (int i = 0; i < kSlots; ++i) {
+    const SlotMetrics& s = m_slots[(size_t)i];
+    w.u32(sat32(s.sdk_calls.load(kRelaxed)));
+    w.u32(sat32(s.sdk_errors.load(kRelaxed)));
+    w.u32(sat32(s.sdk_latency.percentile_us(0.99)));
+    w.u16(sat16(s.connects.load(kRelaxed)));
+    w.u16(sat16(s.reconnects.load(kRelaxed)));
+    w.u16(sat16(s.connect_failures.load(kRelaxed)));
+    w.u32(sat32(s.last_connect_us.load(kRelaxed) / 1000));
+  }
+
+  return w.ok ? (size_t)(w.p - out) : 0;
+}
+
+static void append(std::string& s, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+static void append(std::string& s, const char* fmt, ...) {
+  char line[256];
+  va_list ap;
+  va_start(ap, fmt);
+  const int n = std::vsnprintf(line, sizeof(line), fmt, ap);
+  va_end(ap);
+  if (n > 0) s.append(line, (size_t)std::min(n, (int)sizeof(line) - 1));
+}
+
+// Fixed Prometheus bucket bounds (seconds); resolved against the log-linear buckets.
+static const double kPromBounds[] = {
+  0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0
+};
+
+static void append_histogram(std::string& s, const char* name, const char* labels,
+                             const LatencyHistogram& h) {
+  const char* sep = labels[0] ? "," : "";
+  for (double le : kPromBounds) {
+    append(s, "%s_bucket{%s%sle=\"%g\"} %llu\n", name, labels, sep, le,
+           (unsigned long long)h.count_le((uint64_t)(le * 1e6)));
+  }
+  append(s, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, labels, sep, (unsigned long long)h.count());
+  append(s, "%s_sum{%s} %.6f\n", name, labels, (double)h.sum_us() / 1e6);
+  append(s, "%s_count{%s} %llu\n", name, labels, (unsigned long long)h.count());
+}
+
+std::string MetricsRegistry::prometheus_text() const {
+  std::string s;
+  s.reserve(16 * 1024);
+  auto ull = [](const Counter& c) { return (unsigned long long)c.load(kRelaxed); };
+
+  append(s, "# HELP ccu_uptime_seconds Daemon uptime.\n# TYPE ccu_uptime_seconds gauge\n");
+  append(s, "ccu_uptime_seconds %llu\n", (unsigned long long)uptime_s());
+
+  append(s, "# HELP ccu_log_dropped_total Log events dropped because a ring was full.\n# TYPE ccu_log_dropped_total counter\n");
+  append(s, "ccu_log_dropped_total %llu\n", (unsigned long long)logging::dropped_total());
+
+  const TransportMetrics& t = m_transport;
+  append(s, "# HELP ccu_transport_frames_total CCU link frame counters.\n# TYPE ccu_transport_frames_total counter\n");
+  append(s, "ccu_transport_frames_total{result=\"rx\"} %llu\n", ull(t.rx_frames));
+  append(s, "ccu_transport_frames_total{result=\"rx_ok\"} %llu\n", ull(t.rx_ok));
+  append(s, "ccu_transport_frames_total{result=\"bad_crc\"} %llu\n", ull(t.bad_crc));
+  append(s, "ccu_transport_frames_total{result=\"bad_format\"} %llu\n", ull(t.bad_format));
+  append(s, "ccu_transport_frames_total{result=\"tx\"} %llu\n", ull(t.tx_frames));
+  append(s, "ccu_transport_frames_total{result=\"tx_error\"} %llu\n", ull(t.tx_errors));
+  append(s, "# HELP ccu_transport_resyncs_total UART resynchronisations.\n# TYPE ccu_transport_resyncs_total counter\n");
+  append(s, "ccu_transport_resyncs_total %llu\n", ull(t.resyncs));
+
+  append(s, "# HELP ccu_requests_total Requests received per command.\n# TYPE ccu_requests_total counter\n");
+  for (size_t i = 0; i < kCommands; ++i) {
+    append(s, "ccu_requests_total{cmd=\"%s\"} %llu\n", command_label(i), ull(m_commands[i].rx));
+  }
+  append(s, "# HELP ccu_request_naks_total Requests answered with a non-OK code.\n# TYPE ccu_request_naks_total counter\n");
+  for (size_t i = 0; i < kCommands; ++i) {
+    append(s, "ccu_request_naks_total{cmd=\"%s\"} %llu\n", command_label(i), ull(m_commands[i].nak));
+  }
+  append(s, "# HELP ccu_request_latency_seconds Receive-to-ACK latency.\n# TYPE ccu_request_latency_seconds histogram\n");
+  for (size_t i = 0; i < kCommands; ++i) {
+    char labels[64];
+    std::snprintf(labels, sizeof(labels), "cmd=\"%s\"", command_label(i));
+    append_histogram(s, "ccu_request_latency_seconds", labels, m_commands[i].latency);
+  }
+
+  append(s, "# HELP ccu_slot_sdk_calls_total Backend operations per slot.\n# TYPE ccu_slot_sdk_calls_total counter\n");
+  for (int i = 0; i < kSlots; ++i) {
+    append(s, "ccu_slot_sdk_calls_total{slot=\"%d\"} %llu\n", i, ull(m_slots[(size_t)i].sdk_calls));
+  }
+  append(s, "# HELP ccu_slot_sdk_errors_total Failed backend operations per slot.\n# TYPE ccu_slot_sdk_errors_total counter\n");
+  for (int i = 0; i < kSlots; ++i) {
+    append(s, "ccu_slot_sdk_errors_total{slot=\"%d\"} %llu\n", i, ull(m_slots[(size_t)i].sdk_errors));
+  }
+  append(s, "# HELP ccu_slot_sdk_latency_seconds Backend operation latency.\n# TYPE ccu_slot_sdk_latency_seconds histogram\n");
+  for (int i = 0; i < kSlots; ++i) {
+    char labels[32];
+    std::snprintf(labels, sizeof(labels), "slot=\"%d\"", i);
+    append_histogram(s, "ccu_slot_sdk_latency_seconds", labels, m_slots[(size_t)i].sdk_latency);
+  }
+  append(s, "# HELP ccu_slot_connects_total Camera connection events per slot.\n# TYPE ccu_slot_connects_total counter\n");
+  for (int i = 0; i < kSlots; ++i) {
+    const SlotMetrics& sm = m_slots[(size_t)i];
+    append(s, "ccu_slot_connects_total{slot=\"%d\",result=\"attempt\"} %llu\n", i, ull(sm.connect_attempts));
+    append(s, "ccu_slot_connects_total{slot=\"%d\",result=\"ok\"} %llu\n", i, ull(sm.connects));
+    append(s, "ccu_slot_connects_total{slot=\"%d\",result=\"failed\"} %llu\n", i, ull(sm.connect_failures));
+    append(s, "ccu_slot_connects_total{slot=\"%d\",result=\"reconnect\"} %llu\n", i, ull(sm.reconnects));
+    append(s, "ccu_slot_connects_total{slot=\"%d\",result=\"disconnect\"} %llu\n", i, ull(sm.disconnects));
+  }
+  append(s, "# HELP ccu_slot_breaker_state Circuit breaker: 0 closed, 1 open, 2 half-open.\n# TYPE ccu_slot_breaker_state gauge\n");
+  for (int i = 0; i < kSlots; ++i) {
+    append(s, "ccu_slot_breaker_state{slot=\"%d\"} %llu\n", i, ull(m_slots[(size_t)i].breaker_state));
+  }
+  append(s, "# HELP ccu_slot_breaker_events_total Circuit breaker trips and fast-failed calls.\n# TYPE ccu_slot_breaker_events_total counter\n");
+  for (int i = 0; i < kSlots; ++i) {
+    const SlotMetrics& sm = m_slots[(size_t)i];
+    append(s, "ccu_slot_breaker_events_total{slot=\"%d\",event=\"trip\"} %llu\n", i, ull(sm.breaker_trips));
+    append(s, "ccu_slot_breaker_events_total{slot=\"%d\",event=\"rejected_open\"} %llu\n", i, ull(sm.rejected_open));
+    append(s, "ccu_slot_breaker_events_total{slot=\"%d\",event=\"rejected_busy\"} %llu\n", i, ull(sm.rejected_busy));
+    append(s, "ccu_slot_breaker_events_total{slot=\"%d\",event=\"timeout\"} %llu\n", i, ull(sm.sdk_timeouts));
+  }
+  append(s, "# HELP ccu_liveview_fetches_total Live-view fetches by result.\n# TYPE ccu_liveview_fetches_total counter\n");
+  for (int i = 0; i < kSlots; ++i) {
+    const SlotMetrics& sm = m_slots[(size_t)i];
+    append(s, "ccu_liveview_fetches_total{slot=\"%d\",result=\"frame\"} %llu\n", i, ull(sm.lv_frames));
+    append(s, "ccu_liveview_fetches_total{slot=\"%d\",result=\"not_updated\"} %llu\n", i, ull(sm.lv_not_updated));
+    append(s, "ccu_liveview_fetches_total{slot=\"%d\",result=\"error\"} %llu\n", i, ull(sm.lv_errors));
+    append(s, "ccu_liveview_fetches_total{slot=\"%d\",result=\"no_buffer\"} %llu\n", i, ull(sm.lv_no_buffer));
+  }
+  append(s, "# HELP ccu_liveview_http_clients MJPEG viewers streaming.\n# TYPE ccu_liveview_http_clients gauge\n");
+  for (int i = 0; i < kSlots; ++i) {
+    append(s, "ccu_liveview_http_clients{slot=\"%d\"} %llu\n", i, ull(m_slots[(size_t)i].lv_http_clients));
+  }
+  append(s, "# HELP ccu_liveview_http_frames_total Frames sent to MJPEG viewers, and frames they skipped.\n# TYPE ccu_liveview_http_frames_total counter\n");
+  for (int i = 0; i < kSlots; ++i) {
+    const SlotMetrics& sm = m_slots[(size_t)i];
+    append(s, "ccu_liveview_http_frames_total{slot=\"%d\",result=\"sent\"} %llu\n", i, ull(sm.lv_http_frames));
+    append(s, "ccu_liveview_http_frames_total{slot=\"%d\",result=\"skipped\"} %llu\n", i, ull(sm.lv_http_skipped));
+  }
+  append(s, "# HELP ccu_liveview_lut_frames_total Frames through the monitoring LUT, and frames it skipped.\n# TYPE ccu_liveview_lut_frames_total counter\n");
+  for (int i = 0; i < kSlots; ++i) {
+    const SlotMetrics& sm = m_slots[(size_t)i];
+    append(s, "ccu_liveview_lut_frames_total{slot=\"%d\",result=\"done\"} %llu\n", i, ull(sm.lv_lut_frames));
+    append(s, "ccu_liveview_lut_frames_total{slot=\"%d\",result=\"skipped\"} %llu\n", i, ull(sm.lv_lut_skipped));
+  }
+  append(s, "# HELP ccu_liveview_lut_busy_seconds_total Time the monitoring LUT stage spent working.\n# TYPE ccu_liveview_lut_busy_seconds_total counter\n");
+  for (int i = 0; i < kSlots; ++i) {
+    append(s, "ccu_liveview_lut_busy_seconds_total{slot=\"%d\"} %.6f\n", i, (double)m_slots[(size_t)i].lv_lut_busy_us.load(kRelaxed) / 1e6);
+  }
+  append(s, "# HELP ccu_liveview_shm_clients Local processes reading the shared-memory ring.\n# TYPE ccu_liveview_shm_clients gauge\n");
+  for (int i = 0; i < kSlots; ++i) {
+    append(s, "ccu_liveview_shm_clients{slot=\"%d\"} %llu\n", i, ull(m_slots[(size_t)i].lv_shm_clients));
+  }
+  append(s, "# HELP ccu_liveview_shm_frames_total Frames written to the shared-memory ring, and frames too large for it.\n# TYPE ccu_liveview_shm_frames_total counter\n");
+  for (int i = 0; i < kSlots; ++i) {
+    const SlotMetrics& sm = m_slots[(size_t)i];
+    append(s, "ccu_liveview_shm_frames_total{slot=\"%d\",result=\"written\"} %llu\n", i, ull(sm.lv_shm_frames));
+    append(s, "ccu_liveview_shm_frames_total{slot=\"%d\",result=\"oversize\"} %llu\n", i, ull(sm.lv_shm_oversize));
+  }
+  append(s, "# HELP ccu_proxy_recording Proxy recorder writing a file for the slot.\n# TYPE ccu_proxy_recording gauge\n");
+  for (int i = 0; i < kSlots; ++i) {
+    append(s, "ccu_proxy_recording{slot=\"%d\"} %llu\n", i, ull(m_slots[(size_t)i].proxy_recording));
+  }
+  append(s, "# HELP ccu_proxy_frames_total Live-view frames written to proxy files, and frames dropped behind slow storage.\n# TYPE ccu_proxy_frames_total counter\n");
+  for (int i = 0; i < kSlots; ++i) {
+    const SlotMetrics& sm = m_slots[(size_t)i];
+    append(s, "ccu_proxy_frames_total{slot=\"%d\",result=\"written\"} %llu\n", i, ull(sm.proxy_frames));
+    append(s, "ccu_proxy_frames_total{slot=\"%d\",result=\"dropped\"} %llu\n", i, ull(sm.proxy_dropped));
+  }
+  append(s, "# HELP ccu_proxy_bytes_total Bytes written to proxy files.\n# TYPE ccu_proxy_bytes_total counter\n");
+  for (int i = 0; i < kSlots; ++i) {
+    append(s, "ccu_proxy_bytes_total{slot=\"%d\"} %llu\n", i, ull(m_slots[(size_t)i].proxy_bytes));
+  }
+  append(s, "# HELP ccu_slot_connect_seconds Camera connect duration.\n# TYPE ccu_slot_connect_seconds histogram\n");
+  for (int i = 0; i < kSlots; ++i) {
+    char labels[32];
+    std::snprintf(labels, sizeof(labels), "slot=\"%d\"", i);
+    append_histogram(s, "ccu_slot_connect_seconds", labels, m_slots[(size_t)i].connect_latency);
+  }
+  return s;
+}
+
+bool MetricsRegistry::write_prometheus_file(const std::string& path) const {
+  const std::string text = prometheus_text();
+  const std::string tmp = path + ".tmp";
+  FILE* f = std::fopen(tmp.c_str(), "w");
+  if (!f) return false;
+  const bool ok = std::fwrite(text.data(), 1, text.size(), f) == text.size();
+  if (std::fclose(f) != 0 || !ok) {
+    std::remove(tmp.c_str());
+    return false;
+  }
+  return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+MetricsRegistry& metrics() {
+  static MetricsRegistry reg;
+  return reg;
+}
+
+} // namespace ccu
@@ -0,0 +1,131 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ccu {
+
+// Log-linear (HDR-style) latency histogram in microseconds: values below 8
+// are exact, above that each power of two is split into 8 sub-buckets
+// (<= 12.5% relative error). Covers up to ~2^36 us (19 h); larger values
+// land in the last bucket. Recording is a few relaxed atomic adds.
+class LatencyHistogram {
+public:
+  static constexpr int kSubBits = 3;
+  static constexpr int kSub = 1 << kSubBits;
+  static constexpr int kMaxExp = 36;
+  static constexpr int kBuckets = (kMaxExp - kSubBits + 2) * kSub;
+
+  void record(uint64_t us);
+
+  uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+  uint64_t sum_us() const { return m_sum.load(std::memory_order_relaxed); }
+  uint64_t max_us() const { return m_max.load(std::memory_order_relaxed); }
+
+  // Upper bound of the bucket holding the q-quantile (0 when empty).
+  uint64_t percentile_us(double q) const;
+  // Number of samples <= us (bucket resolution).
+  uint64_t count_le(uint64_t us) const;
+
+  static int bucket_of(uint64_t us);
+  static uint64_t bucket_upper(int idx);
+
+private:
+  std::array<std::atomic<uint64_t>, kBuckets> m_buckets{};
+  std::atomic<uint64_t> m_count{0};
+  std::atomic<uint64_t> m_sum{0};
+  std::atomic<uint64_t> m_max{0};
+};
+
+using Counter = std::atomic<uint64_t>;
+
+struct CommandMetrics {
+  Counter rx{0};
+  Counter ok{0};
+  Counter nak{0};                    // ACK with resp code != RESP_OK
+  LatencyHistogram latency;          // frame received -> ACK sent
+};
+
+struct SlotMetrics {
+  Counter sdk_calls{0};
+  Counter sdk_errors{0};
+  LatencyHistogram sdk_latency;      // one backend operation (may span several SDK calls)
+  Counter connect_attempts{0};
+  Counter connects{0};
+  Counter connect_failures{0};
+  Counter reconnects{0};             // successful connects after the first
+  Counter disconnects{0};
+  Counter last_connect_us{0};
+  LatencyHistogram connect_latency;
+  Counter breaker_state{0};          // SlotHealth::State (gauge)
+  Counter breaker_trips{0};
+  Counter rejected_open{0};          // calls refused while the breaker was open
+  Counter rejected_busy{0};          // calls refused while another was in flight
+  Counter sdk_timeouts{0};           // operations abandoned at their deadline
+  Counter lv_frames{0};              // live-view frames published
+  Counter lv_not_updated{0};         // fetches answered CrWarning_Frame_NotUpdated
+  Counter lv_errors{0};
+  Counter lv_no_buffer{0};           // fetches skipped: every pooled buffer held by consumers
+  Counter lv_http_clients{0};        // MJPEG viewers streaming (gauge)
+  Counter lv_http_frames{0};         // frames sent to MJPEG viewers
+  Counter lv_http_skipped{0};        // frames MJPEG viewers were too slow to receive
+  Counter lv_lut_frames{0};          // frames through the monitoring LUT
+  Counter lv_lut_skipped{0};         // frames the LUT stage was too slow to take
+  Counter lv_lut_busy_us{0};         // LUT stage time spent decoding, mapping, encoding
+  Counter lv_shm_clients{0};         // local processes reading the shared-memory ring (gauge)
+  Counter lv_shm_frames{0};          // frames written to the shared-memory ring
+  Counter lv_shm_oversize{0};        // frames too large for a ring entry
+  Counter proxy_recording{0};        // proxy recorder has a file open (gauge)
+  Counter proxy_frames{0};           // live-view frames written to proxy files
+  Counter proxy_dropped{0};          // frames dropped: proxy buffer full behind slow storage
+  Counter proxy_bytes{0};
+};
+
+struct TransportMetrics {
+  Counter rx_frames{0};
+  Counter rx_ok{0};
+  Counter bad_crc{0};
+  Counter bad_format{0};
+  Counter resyncs{0};                // UART: bytes skipped hunting for a frame
+  Counter tx_frames{0};
+  Counter tx_errors{0};
+};
+
+// Process-wide fixed-layout registry: every metric exists up front, so
+// recording never allocates or locks. Readers see relaxed snapshots.
+class MetricsRegistry {
+public:
+  static constexpr int kSlots = 8;
+  static constexpr size_t kCommands = 17;   // known CCU1 commands + "other"
+
+  MetricsRegistry();
+
+  CommandMetrics& command(uint8_t cmd);
+  SlotMetrics& slot(int idx) { return m_slots[(size_t)(idx & (kSlots - 1))]; }
+  TransportMetrics& transport() { return m_transport; }
+
+  uint64_t uptime_s() const;
+
+  // CMD_GET_STATS response payload (docs/ccu_stats_payload.md). Returns length.
+  size_t build_stats_payload(uint8_t* out, size_t out_max) const;
+
+  // Prometheus text exposition format.
+  std::string prometheus_text() const;
+  // Atomically replaces path (write tmp + rename), for node_exporter's textfile collector.
+  bool write_prometheus_file(const std::string& path) const;
+
+private:
+  static size_t command_index(uint8_t cmd);
+
+  std::array<CommandMetrics, kCommands> m_commands;
+  std::array<SlotMetrics, kSlots> m_slots;
+  TransportMetrics m_transport;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+MetricsRegistry& metrics();
+
+} // namespace ccu
@@ -0,0 +1,268 @@
+#include "mjpeg_server.hpp"
+#include "async_log.hpp"
+#include "live_view.hpp"
+#include "metrics.hpp"
+#include "mosaic.hpp"
+#include "focus_assist.hpp"
+#include "lut_view.hpp"
+#include "trace.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+
+namespace ccu {
+
+static constexpr const char* kBoundary = "ccuframe";
+
+// Sends all iovecs, resuming after partial writes. MSG_NOSIGNAL: a viewer
+// closing the tab must not SIGPIPE the daemon.
+static bool send_all(int fd, iovec* iov, int iovcnt) {
+  while (iovcnt > 0) {
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = (size_t)iovcnt;
+    const ssize_t n = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;  // includes EAGAIN from SO_SNDTIMEO: the viewer stalled
+    }
+    size_t left = (size_t)n;
+    while (iovcnt > 0 && left >= iov->iov_len) {
+      left -= iov->iov_len;
+      ++iov;
+      --iovcnt;
+    }
+    if (iovcnt > 0) {
+      iov->iov_base = static_cast<uint8_t*>(iov->iov_base) + left;
+      iov->iov_len -= left;
+    }
+  }
+  return true;
+}
+
+static bool send_str(int fd, const std::string& s) {
+  iovec iov{const_cast<char*>(s.data()), s.size()};
+  return send_all(fd, &iov, 1);
+}
+
+static void send_status(int fd, const char* status, const char* body) {
+  char buf[256];
+  std::snprintf(buf, sizeof(buf),
+                "HTTP/1.0 %s\r\nContent-Type: text/plain\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n%s", status,
+                std::strlen(body), body);
+  send_str(fd, buf);
+}
+
+// Part header for one frame; the JPEG and the trailing CRLF follow it.
+static int part_header(char* out, size_t cap, const LiveFrame& f) {
+  return std::snprintf(out, cap,
+                       "--%s\r\nContent-Type: image/jpeg\r\nContent-Length: %zu\r\nX-Frame-Seq: %llu\r\n\r\n",
+                       kBoundary, f.size, (unsigned long long)f.seq);
+}
+
+static void serve_index(int fd) {
+  std::string body = "<!doctype html><title>CCU live view</title><body style=\"background:#111;color:#ccc\">";
+  for (int i = 0; i < MetricsRegistry::kSlots; ++i) {
+    if (!live_view(i).running()) continue;
+    body += "<figure style=\"display:inline-block\"><img src=\"/slot/" + std::to_string(i) +
+            "\" width=\"480\"><figcaption>slot " + std::to_string(i);
+    if (focus_assist().peaking())
+      body += " <a href=\"/focus/" + std::to_string(i) + "\" style=\"color:#ccc\">focus</a>";
+    body += "</figcaption></figure>";
+  }
+  if (mosaic().running()) body += "<p><a href=\"/mosaic\" style=\"color:#ccc\">all cameras (mosaic)</a></p>";
+  body += "</body>";
+  send_str(fd, "HTTP/1.0 200 OK\r\nContent-Type: text/html\r\nContent-Length: " + std::to_string(body.size()) +
+                   "\r\nConnection: close\r\n\r\n" + body);
+}
+
+static void serve_snapshot(int fd, const FrameChannel& lv) {
+  const FrameRef f = lv.latest();
+  if (!f) {
+    send_status(fd, "503 Service Unavailable", "no frame yet\n");
+    return;
+  }
+  char head[192];
+  const int n = std::snprintf(head, sizeof(head),
+                              "HTTP/1.0 200 OK\r\nContent-Type: image/jpeg\r\nContent-Length: %zu\r\n"
+                              "Cache-Control: no-store\r\nConnection: close\r\n\r\n",
+                              f->size);
+  iovec iov[2] = {{head, (size_t)n}, {const_cast<uint8_t*>(f->jpeg), f->size}};
+  send_all(fd, iov, 2);
+}
+
+// sm: the slot's metrics, or nullptr for derived pictures (mosaic, peaking).
+static void serve_stream(int fd, SlotMetrics* sm, const FrameChannel& lv) {
+  char head[256];
+  const int n = std::snprintf(head, sizeof(head),
+                              "HTTP/1.0 200 OK\r\nContent-Type: multipart/x-mixed-replace; boundary=%s\r\n"
+                              "Cache-Control: no-cache, no-store\r\nPragma: no-cache\r\nConnection: close\r\n\r\n",
+                              kBoundary);
+  iovec first{head, (size_t)n};
+  if (!send_all(fd, &first, 1)) return;
+
+  FrameReader reader(lv);
+  static const char kCrlf[] = "\r\n";
+  while (true) {
+    // Wake on a new frame. While the camera is offline nothing is sent, so
+    // check once a second whether the viewer has gone.
+    if (!reader.wait(std::chrono::seconds(1))) {
+      char c;
+      if (::recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 0) break;
+      continue;
+    }
+    uint32_t skipped = 0;
+    const FrameRef f = reader.next(&skipped);
+    if (!f) continue;
+    const int hn = part_header(head, sizeof(head), *f);
+    iovec iov[3] = {
+      {head, (size_t)hn},
+      {const_cast<uint8_t*>(f->jpeg), f->size},
+      {const_cast<char*>(kCrlf), 2},
+    };
+    if (!send_all(fd, iov, 3)) break;
+    if (sm) {
+      sm->lv_http_frames.fetch_add(1, std::memory_order_relaxed);
+      sm->lv_http_skipped.fetch_add(skipped, std::memory_order_relaxed);
+    }
+  }
+}
+
+bool MjpegServer::start(uint16_t port) {
+  m_listen_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (m_listen_fd < 0) return false;
+  int yes = 1;
+  ::setsockopt(m_listen_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = INADDR_ANY;
+  addr.sin_port = htons(port);
+  if (::bind(m_listen_fd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(m_listen_fd, 8) < 0) {
+    ::close(m_listen_fd);
+    m_listen_fd = -1;
+    return false;
+  }
+  std::thread([this] { accept_loop(); }).detach();
+  return true;
+}
+
+void MjpegServer::accept_loop() {
+  trace::set_thread_name("http");
+  while (true) {
+    const int fd = ::accept4(m_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno != EINTR) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      continue;
+    }
+    if (m_clients.load(std::memory_order_relaxed) >= kMaxClients) {
+      send_status(fd, "503 Service Unavailable", "too many viewers\n");
+      ::close(fd);
+      continue;
+    }
+    m_clients.fetch_add(1, std::memory_order_relaxed);
+    std::thread([this, fd] {
+      trace::set_thread_name("http-client");
+      serve(fd);
+      ::close(fd);
+      m_clients.fetch_sub(1, std::memory_order_relaxed);
+    }).detach();
+  }
+}
+
+void MjpegServer::serve(int fd) {
+  timeval tv{kSendTimeoutMs / 1000, (kSendTimeoutMs % 1000) * 1000};
+  ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  int yes = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+  // Only the request line matters; headers are read and ignored.
+  char req[2048];
+  size_t len = 0;
+  while (len < sizeof(req) - 1) {
+    const ssize_t n = ::recv(fd, req + len, sizeof(req) - 1 - len, 0);
+    if (n <= 0) return;
+    len += (size_t)n;
+    req[len] = '\0';
+    if (std::strstr(req, "\r\n\r\n") || std::strstr(req, "\n\n")) break;
+  }
+  req[len] = '\0';
+
+  char method[8] = {}, path[128] = {};
+  if (std::sscanf(req, "%7s %127s", method, path) != 2 || std::strcmp(method, "GET") != 0) {
+    send_status(fd, "405 Method Not Allowed", "GET only\n");
+    return;
+  }
+  if (std::strcmp(path, "/") == 0) {
+    serve_index(fd);
+    return;
+  }
+  if (std::strcmp(path, "/mosaic") == 0 || std::strcmp(path, "/mosaic.jpg") == 0) {
+    if (!mosaic().running()) {
+      send_status(fd, "503 Service Unavailable", "mosaic is off (CCU_MOSAIC_FPS)\n");
+    } else if (path[7] == '.') {
+      serve_snapshot(fd, mosaic());
+    } else {
+      serve_stream(fd, nullptr, mosaic());
+    }
+    return;
+  }
+  if (std::strncmp(path, "/focus/", 7) == 0) {
+    char* end = nullptr;
+    const long slot = std::strtol(path + 7, &end, 10);
+    if (end == path + 7 || slot < 0 || slot >= MetricsRegistry::kSlots || (*end && std::strcmp(end, ".jpg") != 0)) {
+      send_status(fd, "404 Not Found", "not found\n");
+    } else if (!focus_assist().peaking() || !live_view((int)slot).running()) {
+      send_status(fd, "503 Service Unavailable", "focus peaking is off (CCU_FOCUS_HZ, CCU_FOCUS_PEAKING)\n");
+    } else if (*end) {
+      serve_snapshot(fd, focus_assist().peaking_view((int)slot));
+    } else {
+      serve_stream(fd, nullptr, focus_assist().peaking_view((int)slot));
+    }
+    return;
+  }
+  if (std::strncmp(path, "/slot/", 6) != 0) {
+    send_status(fd, "404 Not Found", "not found\n");
+    return;
+  }
+  char* end = nullptr;
+  const long slot = std::strtol(path + 6, &end, 10);
+  if (end == path + 6 || slot < 0 || slot >= MetricsRegistry::kSlots || (*end && std::strcmp(end, ".jpg") != 0)) {
+    send_status(fd, "404 Not Found", "not found\n");
+    return;
+  }
+  if (!live_view((int)slot).running()) {
+    send_status(fd, "503 Service Unavailable", "live view is off for this slot (CCU_LIVEVIEW_FPS)\n");
+    return;
+  }
+  // With the slot's monitoring LUT applied, when it has one.
+  const FrameChannel& lv = monitor_view((int)slot);
+  if (*end) {
+    serve_snapshot(fd, lv);
+    return;
+  }
+
+  SlotMetrics& sm = metrics().slot((int)slot);
+  sm.lv_http_clients.fetch_add(1, std::memory_order_relaxed);
+  CCU_LOG_INFO("http: viewer joined slot %ld", slot);
+  serve_stream(fd, &sm, lv);
+  sm.lv_http_clients.fetch_sub(1, std::memory_order_relaxed);
+  CCU_LOG_INFO("http: viewer left slot %ld", slot);
+}
+
+MjpegServer& mjpeg_server() {
+  static MjpegServer s;
+  return s;
+}
+
+} // namespace ccu
@@ -0,0 +1,38 @@
+#pragma once
+// Live view over HTTP for browsers and VLC. The camera's live-view frames are
+// already JPEG, so each slot is served as multipart/x-mixed-replace with the
+// camera's bytes sent untouched: one sendmsg per frame gathers the part
+// header and the pooled JPEG buffer, with no decode, copy or re-encode.
+//
+//   GET /              index page with every streaming slot
+//   GET /slot/<n>      MJPEG stream
+//   GET /slot/<n>.jpg  newest single frame
+//   GET /mosaic        all cameras on one stream (mosaic.hpp), /mosaic.jpg
+//
+// Each viewer gets its own thread and FrameReader. A slow viewer skips
+// frames and holds at most the one it is sending; it never slows the
+// camera or other viewers.
+#include <atomic>
+#include <cstdint>
+
+namespace ccu {
+
+class MjpegServer {
+public:
+  static constexpr uint32_t kMaxClients = 16;
+  // A viewer that cannot take a frame for this long is dropped.
+  static constexpr uint32_t kSendTimeoutMs = 5000;
+
+  bool start(uint16_t port);
+
+private:
+  void accept_loop();
+  void serve(int fd);
+
+  int m_listen_fd = -1;
+  std::atomic<uint32_t> m_clients{0};
+};
+
+MjpegServer& mjpeg_server();
+
+} // namespace ccu
@@ -0,0 +1,238 @@
+#include "mosaic.hpp"
+#include "async_log.hpp"
+#include "clock.hpp"
+#include "lut_view.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+#ifdef CCU_HAVE_JPEG
+#include "jpeg_decoder.hpp"
+#include "jpeg_encoder.hpp"
+#endif
+
+namespace ccu {
+
+#ifdef CCU_HAVE_JPEG
+
+struct Mosaic::State {
+  struct Tile {
+    int slot = -1;
+    std::unique_ptr<FrameReader> reader;
+    uint32_t x0 = 0, y0 = 0;       // top-left of the tile on the canvas
+    int border = -1;               // 1 = REC, 0 = idle, -1 = not drawn yet
+    bool live = false;             // showing a camera image (not blanked)
+    uint64_t last_frame_ns = 0;
+    // Placement of the scaled image in the tile, rebuilt when the camera's
+    // decoded size changes.
+    uint32_t src_w = 0, src_h = 0;
+    uint32_t dst_x = 0, dst_y = 0, dst_w = 0, dst_h = 0;
+    std::vector<uint32_t> xmap;    // canvas column -> byte offset in a decoded row
+  };
+
+  uint32_t tile_w = 0, tile_h = 0, cols = 0, rows = 0;
+  uint32_t width = 0, height = 0;
+  std::vector<uint8_t> canvas;     // RGB
+  std::vector<uint8_t> row;        // one decoded scanline
+  std::vector<Tile> tiles;
+
+  JpegDecoder decoder;
+  JpegEncoder encoder;
+
+  uint8_t* px(uint32_t x, uint32_t y) { return canvas.data() + ((size_t)y * width + x) * 3; }
+
+  void fill(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t r, uint8_t g, uint8_t b) {
+    for (uint32_t j = 0; j < h; ++j) {
+      uint8_t* p = px(x, y + j);
+      for (uint32_t i = 0; i < w; ++i, p += 3) {
+        p[0] = r;
+        p[1] = g;
+        p[2] = b;
+      }
+    }
+  }
+
+  void draw_border(Tile& t, bool rec) {
+    const uint8_t r = rec ? 220 : 48, g = rec ? 0 : 48, b = rec ? 0 : 48;
+    fill(t.x0, t.y0, tile_w, kBorderPx, r, g, b);
+    fill(t.x0, t.y0 + tile_h - kBorderPx, tile_w, kBorderPx, r, g, b);
+    fill(t.x0, t.y0 + kBorderPx, kBorderPx, tile_h - 2 * kBorderPx, r, g, b);
+    fill(t.x0 + tile_w - kBorderPx, t.y0 + kBorderPx, kBorderPx, tile_h - 2 * kBorderPx, r, g, b);
+    t.border = rec ? 1 : 0;
+  }
+
+  void blank(Tile& t) {
+    fill(t.x0 + kBorderPx, t.y0 + kBorderPx, tile_w - 2 * kBorderPx, tile_h - 2 * kBorderPx, 16, 16, 16);
+    t.live = false;
+    t.src_w = t.src_h = 0;
+  }
+
+  // Fits a src_w x src_h image into the tile, keeping its aspect ratio.
+  void place(Tile& t, uint32_t sw, uint32_t sh) {
+    const uint32_t iw = tile_w - 2 * kBorderPx, ih = tile_h - 2 * kBorderPx;
+    t.dst_w = iw;
+    t.dst_h = (uint32_t)((uint64_t)iw * sh / sw);
+    if (t.dst_h > ih) {
+      t.dst_h = ih;
+      t.dst_w = (uint32_t)((uint64_t)ih * sw / sh);
+    }
+    t.dst_x = t.x0 + kBorderPx + (iw - t.dst_w) / 2;
+    t.dst_y = t.y0 + kBorderPx + (ih - t.dst_h) / 2;
+    t.xmap.resize(t.dst_w);
+    for (uint32_t x = 0; x < t.dst_w; ++x) t.xmap[x] = (uint32_t)((uint64_t)x * sw / t.dst_w) * 3;
+    t.src_w = sw;
+    t.src_h = sh;
+    // Clear the letterbox bars left from a previous geometry.
+    fill(t.x0 + kBorderPx, t.y0 + kBorderPx, iw, ih, 0, 0, 0);
+  }
+
+  // Decodes one frame into its tile at the smallest DCT scale that still
+  // covers it. False if the JPEG is corrupt (the tile keeps what it had).
+  bool decode(Tile& t, const LiveFrame& f) {
+    if (!decoder.begin(f.jpeg, f.size, tile_w - 2 * kBorderPx, tile_h - 2 * kBorderPx, false)) return false;
+    const uint32_t sw = decoder.width(), sh = decoder.height();
+    if (row.size() < (size_t)sw * 3) row.resize((size_t)sw * 3);
+    if (sw != t.src_w || sh != t.src_h) place(t, sw, sh);
+
+    uint32_t dy = 0;
+    for (uint32_t sy = 0; sy < sh; ++sy) {
+      if (!decoder.read_row(row.data())) return false;
+      // Emit every canvas row that maps to this source row (nearest).
+      for (; dy < t.dst_h && (uint64_t)dy * sh / t.dst_h == sy; ++dy) {
+        uint8_t* out = px(t.dst_x, t.dst_y + dy);
+        for (uint32_t x = 0; x < t.dst_w; ++x, out += 3) std::memcpy(out, row.data() + t.xmap[x], 3);
+      }
+    }
+    if (!decoder.finish()) return false;
+    t.live = true;
+    return true;
+  }
+
+  // Encodes the canvas into buffer idx of pool. Returns the JPEG size, or 0
+  // if it did not fit.
+  size_t encode(FramePool& pool, int idx) {
+    return encoder.encode(canvas.data(), width, height, (size_t)width * 3, false, kQuality, pool.data(idx),
+                          pool.buffer_bytes());
+  }
+};
+
+Mosaic::Mosaic() = default;
+Mosaic::~Mosaic() = default;
+
+bool Mosaic::start(uint32_t fps, uint32_t tile_w) {
+  if (m_fps != 0 || fps == 0) return false;
+  auto st = std::make_unique<State>();
+  for (int i = 0; i < MetricsRegistry::kSlots; ++i) {
+    if (!live_view(i).running()) continue;
+    State::Tile t;
+    t.slot = i;
+    t.reader = std::make_unique<FrameReader>(monitor_view(i));
+    st->tiles.push_back(std::move(t));
+  }
+  const uint32_t n = (uint32_t)st->tiles.size();
+  if (n == 0) return false;
+
+  // Even sizes keep libjpeg's chroma subsampling clean.
+  st->tile_w = std::max<uint32_t>(64, tile_w) & ~1u;
+  st->tile_h = (st->tile_w * 9 / 16) & ~1u;
+  st->cols = n == 1 ? 1 : (n <= 4 ? 2 : 4);
+  st->rows = (n + st->cols - 1) / st->cols;
+  st->width = st->cols * st->tile_w;
+  st->height = st->rows * st->tile_h;
+  st->canvas.assign((size_t)st->width * st->height * 3, 0);
+  for (uint32_t i = 0; i < n; ++i) {
+    State::Tile& t = st->tiles[i];
+    t.x0 = (i % st->cols) * st->tile_w;
+    t.y0 = (i / st->cols) * st->tile_h;
+    st->blank(t);
+  }
+  // About one byte per pixel is plenty at this quality; grown on overflow.
+  add_pool(kPoolFrames, (size_t)st->width * st->height);
+
+  CCU_LOG_INFO("mosaic: %u camera(s), %ux%u canvas (%ux%u tiles) at %u fps", (unsigned)n, (unsigned)st->width,
+               (unsigned)st->height, (unsigned)st->tile_w, (unsigned)st->tile_h, (unsigned)fps);
+  m_state = std::move(st);
+  m_fps = fps;
+  std::thread([this] { loop(); }).detach();
+  return true;
+}
+
+void Mosaic::loop() {
+  trace::set_thread_name("mosaic");
+  State& st = *m_state;
+  const auto period = std::chrono::microseconds(1000000 / m_fps);
+  auto next = std::chrono::steady_clock::now();
+  bool dirty = true;
+
+  while (true) {
+    std::this_thread::sleep_until(next);
+    next = std::max(next + period, std::chrono::steady_clock::now());
+    const uint64_t now_ns = monotonic_ns();
+    const uint8_t rec = m_rec_mask.load(std::memory_order_relaxed);
+
+    for (State::Tile& t : st.tiles) {
+      const bool want_rec = (rec >> t.slot) & 1u;
+      if (t.border != (want_rec ? 1 : 0)) {
+        st.draw_border(t, want_rec);
+        dirty = true;
+      }
+      if (const FrameRef f = t.reader->next()) {
+        if (st.decode(t, *f)) {
+          t.last_frame_ns = now_ns;
+          dirty = true;
+        }
+      } else if (t.live && now_ns - t.last_frame_ns > (uint64_t)kStaleMs * 1000000ull) {
+        st.blank(t);
+        dirty = true;
+      }
+    }
+    if (!dirty) continue;
+
+    FramePool& p = *pool();
+    const int idx = p.acquire_for_write();
+    if (idx < 0) continue;  // every buffer held by slow viewers; try next tick
+    const size_t size = st.encode(p, idx);
+    if (size == 0) {
+      p.abandon_write(idx);
+      if (add_pool(kPoolFrames, p.buffer_bytes() * 2))
+        CCU_LOG_INFO("mosaic: buffers grown to %zu bytes", pool()->buffer_bytes());
+      continue;
+    }
+    LiveFrame& f = p.frame(idx);
+    f.jpeg = p.data(idx);
+    f.size = size;
+    f.frame_no = 0;
+    f.captured_ns = now_ns;
+    publish(idx);
+    dirty = false;
+  }
+}
+
+#else  // !CCU_HAVE_JPEG
+
+struct Mosaic::State {};
+
+Mosaic::Mosaic() = default;
+Mosaic::~Mosaic() = default;
+
+bool Mosaic::start(uint32_t, uint32_t) {
+  CCU_LOG_WARN("mosaic: ccu_daemon was built without libjpeg");
+  return false;
+}
+
+void Mosaic::loop() {}
+
+#endif
+
+Mosaic& mosaic() {
+  static Mosaic m;
+  return m;
+}
+
+} // namespace ccu
@@ -0,0 +1,50 @@
+#pragma once
+// Multi-camera monitoring mosaic: every live-view slot on one JPEG (2x2 up to
+// four cameras, 4x2 up to eight), published like a camera's live view so the
+// HTTP server streams it at /mosaic.
+//
+// Each camera's frame is decoded straight at 1/2, 1/4 or 1/8 scale by
+// libjpeg's DCT scaling (the smallest that still covers a tile), so a Pi
+// never decodes full-size frames. Tiles are blitted into a canvas allocated
+// once. A tile is redrawn only when its camera has a new frame or its border
+// changes, and the canvas is encoded only when a tile was redrawn. Each tile
+// has a border: red while that slot records, grey otherwise. A tile whose
+// camera stopped sending frames is blanked.
+#include "live_view.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace ccu {
+
+class Mosaic : public FrameChannel {
+public:
+  static constexpr int kMaxTiles = 8;
+  static constexpr uint32_t kPoolFrames = 4;
+  static constexpr uint32_t kBorderPx = 4;
+  static constexpr uint32_t kStaleMs = 2000;  // no frame for this long: tile blanked
+  static constexpr int kQuality = 75;
+
+  Mosaic();
+  ~Mosaic();
+
+  // Tiles the slots whose live view is running; call after starting them.
+  // False if there are none or the daemon was built without libjpeg.
+  bool start(uint32_t fps, uint32_t tile_w);
+  bool running() const { return m_fps != 0; }
+
+  // Slots currently recording (bit per slot), for the REC borders.
+  void set_rec_mask(uint8_t mask) { m_rec_mask.store(mask, std::memory_order_relaxed); }
+
+private:
+  struct State;
+  void loop();
+
+  uint32_t m_fps = 0;
+  std::atomic<uint8_t> m_rec_mask{0};
+  std::unique_ptr<State> m_state;
+};
+
+Mosaic& mosaic();
+
+} // namespace ccu
@@ -42,21 +42,21 @@ bool parse_packet(const uint8_t* buf, size_t len, Header& out_h,
   return true;
 }
 
-size_t build_resp_ack(uint8_t* out, size_t out_max,
-                      uint32_t seq, uint8_t target_mask, uint8_t resp_code,
-                      const uint8_t* payload, size_t payload_len) {
+static size_t build_frame(uint8_t* out, size_t out_max, uint8_t msg_type,
+                          uint32_t seq, uint8_t target_mask, uint8_t cmd_or_code,
+                          const uint8_t* payload, size_t payload_len, uint16_t flags) {
   const size_t total = sizeof(Header) + payload_len + 4;
-  if (out_max < total) return 0;
+  if (out_max < total || payload_len > 0xFFFFu) return 0;
 
   Header h{};
   h.magic = MAGIC;
   h.version = VER;
-  h.msg_type = MSG_RESP_ACK;
+  h.msg_type = msg_type;
   h.payload_len = (uint16_t)payload_len;
   h.seq = seq;
   h.target_mask = target_mask;
-  h.cmd_or_code = resp_code;
-  h.flags = 0;
+  h.cmd_or_code = cmd_or_code;
+  h.flags = flags;
 
   std::memcpy(out, &h, sizeof(h));
   if (payload_len && payload) std::memcpy(out + sizeof(Header), payload, payload_len);
@@ -66,5 +66,40 @@ size_t build_resp_ack(uint8_t* out, size_t out_max,
   return total;
 }
 
-} // namespace ccu
+size_t build_resp_ack(uint8_t* out, size_t out_max,
+                      uint32_t seq, uint8_t target_mask, uint8_t resp_code,
+                      const uint8_t* payload, size_t payload_len,
+                      uint16_t flags) {
+  return build_frame(out, out_max, MSG_RESP_ACK, seq, target_mask, resp_code, payload, payload_len, flags);
+}
 
+size_t build_req_cmd(uint8_t* out, size_t out_max,
+                     uint32_t seq, uint8_t target_mask, uint8_t cmd,
+                     const uint8_t* payload, size_t payload_len,
+                     uint16_t flags) {
+  return build_frame(out, out_max, MSG_REQ_CMD, seq, target_mask, cmd, payload, payload_len, flags);
+}
+
+const char* command_name(uint8_t cmd) {
+  switch (cmd) {
+    case CMD_RUNSTOP: return "runstop";
+    case CMD_RUNSTOP_AT: return "runstop_at";
+    case CMD_GET_OPTIONS: return "get_options";
+    case CMD_GET_STATUS: return "get_status";
+    case CMD_CAPTURE_STILL: return "capture_still";
+    case CMD_DISCOVER: return "discover";
+    case CMD_LIST_CAMERAS: return "list_cameras";
+    case CMD_GET_STATS: return "get_stats";
+    case CMD_TRACE_DUMP: return "trace_dump";
+    case CMD_TIME_SYNC: return "time_sync";
+    case CMD_GET_SCOPES: return "get_scopes";
+    case CMD_GET_FOCUS: return "get_focus";
+    case CMD_CAPTURE_SYNC: return "capture_sync";
+    case CMD_SET_VALUE: return "set_value";
+    case CMD_PARAM_STEP: return "param_step";
+    case CMD_SET_SLOT_CONFIG: return "set_slot_config";
+    default: return "unknown";
+  }
+}
+
+} // namespace ccu
@@ -7,6 +7,7 @@ namespace ccu {
 
 static constexpr uint32_t MAGIC = 0x43435531u; // 'CCU1'
 static constexpr uint8_t  VER   = 1;
+static constexpr size_t   MAX_FRAME_LEN = 2048;   // header + payload + CRC; longer frames are dropped
 
 enum : uint8_t {
   MSG_REQ_CMD  = 0x01,
@@ -15,16 +16,30 @@ enum : uint8_t {
 
 enum : uint8_t {
   CMD_RUNSTOP = 0x10,
+  CMD_RUNSTOP_AT = 0x11,      // scheduled RUNSTOP at a CCU clock time (see CMD_TIME_SYNC)
   CMD_GET_OPTIONS = 0x20,
   CMD_GET_STATUS = 0x30,
   CMD_CAPTURE_STILL = 0x31,
   CMD_DISCOVER = 0x32,
   CMD_LIST_CAMERAS = 0x33,
+  CMD_GET_STATS = 0x34,
+  CMD_TRACE_DUMP = 0x35,
+  CMD_TIME_SYNC = 0x36,
+  CMD_GET_SCOPES = 0x37,      // live-view exposure scopes of one slot (see scopes.hpp)
+  CMD_GET_FOCUS = 0x38,       // focus-assist sharpness of the selected slots (see focus_assist.hpp)
+  CMD_CAPTURE_SYNC = 0x39,    // S1 pre-arm on all selected slots, then one simultaneous release
   CMD_SET_VALUE = 0x40,
   CMD_PARAM_STEP = 0x41,
   CMD_SET_SLOT_CONFIG = 0x50,
 };
 
+// Header.flags bits.
+enum : uint16_t {
+  // REQ: append a TimingExt to the ACK payload. ACK: the payload ends with
+  // one. Requests without it get the plain ACK, so old CCUs are unaffected.
+  FLAG_TIMING = 0x0001,
+};
+
 enum : uint8_t {
   OPT_ISO = 0x01,
   OPT_WHITE_BALANCE = 0x02,
@@ -38,6 +53,7 @@ enum : uint8_t {
   RESP_BAD_CRC    = 0x01,
   RESP_BAD_FORMAT = 0x02,
   RESP_UNKNOWN    = 0x03,
+  RESP_TIMEOUT    = 0x04,   // camera operation abandoned at its deadline (E_TIMEOUT)
 };
 
 #pragma pack(push, 1)
@@ -55,6 +71,26 @@ struct Header {
 
 static_assert(sizeof(Header) == 16, "Header must be 16 bytes");
 
+// Server-side timing breakdown, appended after the normal ACK payload when
+// the request set FLAG_TIMING (and it fits). The last two bytes let a parser
+// find it from the end of the payload.
+#pragma pack(push, 1)
+struct TimingExt {
+  uint64_t rx_mono_us;      // frame arrival, daemon CLOCK_MONOTONIC (kernel stamp / last UART byte)
+  uint32_t queue_us;        // arrival -> request loop picked it up
+  uint32_t handler_us;      // pickup -> ACK built
+  uint32_t sdk_us[8];       // per slot: time in camera/SDK calls for this request (0 = none)
+  uint32_t sdk_result[8];   // per slot: first failing CrError, 0 = ok, TIMING_FAILED_NO_SDK / TIMING_TIMED_OUT
+  uint8_t  version;         // 1
+  uint8_t  ext_len;         // sizeof(TimingExt)
+};
+#pragma pack(pop)
+
+static_assert(sizeof(TimingExt) == 82, "TimingExt must be 82 bytes");
+static constexpr uint8_t TIMING_EXT_VER = 1;
+static constexpr uint32_t TIMING_FAILED_NO_SDK = 0xFFFFFFFFu;
+static constexpr uint32_t TIMING_TIMED_OUT = 0xFFFFFFFEu;   // abandoned at its deadline
+
 uint32_t crc32_ieee(const uint8_t* data, size_t len);
 
 bool parse_packet(const uint8_t* buf, size_t len, Header& out_h,
@@ -63,6 +99,16 @@ bool parse_packet(const uint8_t* buf, size_t len, Header& out_h,
 
 size_t build_resp_ack(uint8_t* out, size_t out_max,
                       uint32_t seq, uint8_t target_mask, uint8_t resp_code,
-                      const uint8_t* payload, size_t payload_len);
+                      const uint8_t* payload, size_t payload_len,
+                      uint16_t flags = 0);
+
+// Client side: build a MSG_REQ_CMD frame. Returns frame length, 0 if out_max is too small.
+size_t build_req_cmd(uint8_t* out, size_t out_max,
+                     uint32_t seq, uint8_t target_mask, uint8_t cmd,
+                     const uint8_t* payload, size_t payload_len,
+                     uint16_t flags = 0);
+
+// Lower-case command name for logs/metrics/traces ("unknown" if not a CMD_*).
+const char* command_name(uint8_t cmd);
 
 } // namespace ccu
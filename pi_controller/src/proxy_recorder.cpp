@@ -0,0 +1,417 @@
+#include "proxy_recorder.hpp"
+#include "async_log.hpp"
+#include "avi_layout.hpp"
+#include "clock.hpp"
+#include "live_view.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace ccu {
+
+namespace {
+
+size_t round_up(size_t v, size_t to) { return (v + to - 1) / to * to; }
+
+static_assert(kAviHeaderBytes == ProxyRecorder::kAlign, "the AVI header is one O_DIRECT block");
+
+} // namespace
+
+struct ProxyRecorder::File {
+  std::string path;
+  int fd = -1;       // writer thread only
+  bool direct = false;
+  bool failed = false;
+  uint64_t synced_ns = 0;
+};
+
+struct ProxyRecorder::Slot {
+  int index = -1;
+  uint32_t fps = 1;
+  SlotMetrics* metrics = nullptr;
+
+  // Block pool; the writer thread hands blocks back through free.
+  std::mutex mu;
+  std::condition_variable cv;
+  std::vector<uint8_t*> free;
+  std::vector<uint8_t*> all;
+
+  // Slot thread only.
+  std::shared_ptr<File> file;
+  uint8_t* block = nullptr;
+  size_t fill = 0;
+  uint64_t block_offset = 0;   // file offset of block[0]
+  uint64_t pos = 0;            // logical file size
+  std::vector<uint8_t> idx1;   // index entries
+  uint32_t entries = 0;        // AVI frames, empty ones included
+  uint32_t max_chunk = 0;
+  uint16_t width = 0, height = 0;
+  uint64_t t0_ns = 0;          // captured_ns that AVI frame 0 stands for
+  time_t take_start = 0;       // wall clock, for file names and IDIT
+  int segment = 0;
+  bool warned_size = false;
+};
+
+struct ProxyRecorder::Writer {
+  struct Op {
+    enum Kind { kOpen, kWrite, kClose } kind = kWrite;
+    std::shared_ptr<File> file;
+    Slot* slot = nullptr;      // kWrite: owner of data's block
+    uint8_t* data = nullptr;   // kWrite: block; kClose: header, freed after
+    size_t bytes = 0;
+    uint64_t offset = 0;       // kWrite: where; kClose: final file size
+  };
+
+  std::mutex mu;
+  std::condition_variable cv;
+  std::deque<Op> ops;
+
+  void submit(Op op) {
+    {
+      std::lock_guard<std::mutex> lk(mu);
+      ops.push_back(std::move(op));
+    }
+    cv.notify_one();
+  }
+
+  void loop() {
+    trace::set_thread_name("proxy-writer");
+    while (true) {
+      Op op;
+      {
+        std::unique_lock<std::mutex> lk(mu);
+        cv.wait(lk, [&] { return !ops.empty(); });
+        op = std::move(ops.front());
+        ops.pop_front();
+      }
+      File& f = *op.file;
+      if (op.kind == Op::kOpen) {
+        open(f);
+      } else if (op.kind == Op::kWrite) {
+        write(f, op.data, op.bytes, op.offset);
+        {
+          std::lock_guard<std::mutex> lk(op.slot->mu);
+          op.slot->free.push_back(op.data);
+        }
+        op.slot->cv.notify_one();
+      } else {
+        write(f, op.data, kAlign, 0);
+        std::free(op.data);
+        if (f.fd >= 0) {
+          if (::ftruncate(f.fd, (off_t)op.offset) < 0 && !f.failed)
+            CCU_LOG_WARN("proxy: %s: truncate failed (%s)", f.path.c_str(), std::strerror(errno));
+          ::fdatasync(f.fd);
+          ::close(f.fd);
+          f.fd = -1;
+        }
+      }
+    }
+  }
+
+  static void open(File& f) {
+    f.fd = ::open(f.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_DIRECT, 0644);
+    f.direct = f.fd >= 0;
+    if (f.fd < 0 && errno == EINVAL) f.fd = ::open(f.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (f.fd < 0) {
+      f.failed = true;
+      CCU_LOG_WARN("proxy: cannot create %s (%s)", f.path.c_str(), std::strerror(errno));
+    }
+    f.synced_ns = monotonic_ns();
+  }
+
+  static void write(File& f, const uint8_t* data, size_t bytes, uint64_t offset) {
+    if (f.fd < 0 || f.failed) return;
+    const uint64_t t0 = monotonic_ns();
+    while (bytes > 0) {
+      const ssize_t n = ::pwrite(f.fd, data, bytes, (off_t)offset);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) {
+        f.failed = true;
+        CCU_LOG_WARN("proxy: %s: write failed (%s); rest of the take is lost", f.path.c_str(),
+                     n < 0 ? std::strerror(errno) : "short write");
+        return;
+      }
+      data += n;
+      bytes -= (size_t)n;
+      offset += (uint64_t)n;
+    }
+    const uint64_t now = monotonic_ns();
+    if (now - t0 > (uint64_t)kSlowWriteMs * 1000000ull)
+      CCU_LOG_WARN("proxy: %s: storage stalled %llu ms", f.path.c_str(), (unsigned long long)((now - t0) / 1000000ull));
+    // Buffered files would otherwise pile up dirty pages and flush them in
+    // one long stall.
+    if (!f.direct && now - f.synced_ns > (uint64_t)kSyncMs * 1000000ull) {
+      ::fdatasync(f.fd);
+      f.synced_ns = now;
+    }
+  }
+};
+
+ProxyRecorder::ProxyRecorder() = default;
+ProxyRecorder::~ProxyRecorder() = default;
+
+bool ProxyRecorder::start(const std::string& dir, uint32_t buffer_mb) {
+  if (m_running) return false;
+  struct stat st{};
+  if (::stat(dir.c_str(), &st) < 0 || !S_ISDIR(st.st_mode) || ::access(dir.c_str(), W_OK) < 0) {
+    CCU_LOG_WARN("proxy: %s is not a writable directory", dir.c_str());
+    return false;
+  }
+  const uint32_t blocks = std::max<uint32_t>(2, (uint32_t)((uint64_t)buffer_mb * (1u << 20) / kBlockBytes));
+  int count = 0;
+  for (int i = 0; i < (int)m_slots.size(); ++i) {
+    if (!live_view(i).running()) continue;
+    auto s = std::make_unique<Slot>();
+    s->index = i;
+    s->fps = std::max<uint32_t>(1, live_view(i).fps());
+    s->metrics = &metrics().slot(i);
+    for (uint32_t b = 0; b < blocks; ++b) {
+      auto* p = (uint8_t*)std::aligned_alloc(kAlign, kBlockBytes);
+      if (!p) return false;
+      s->all.push_back(p);
+      s->free.push_back(p);
+    }
+    m_slots[(size_t)i] = std::move(s);
+    ++count;
+  }
+  if (count == 0) return false;
+
+  m_dir = dir;
+  m_writer = std::make_unique<Writer>();
+  m_running = true;
+  CCU_LOG_INFO("proxy: %d slot(s) to %s, %u MB buffer each", count, dir.c_str(),
+               (unsigned)(blocks * kBlockBytes >> 20));
+  std::thread([this] { m_writer->loop(); }).detach();
+  for (auto& s : m_slots) {
+    if (!s) continue;
+    Slot* sp = s.get();
+    std::thread([this, sp] { slot_loop(*sp); }).detach();
+  }
+  return true;
+}
+
+void ProxyRecorder::slot_loop(Slot& s) {
+  const std::string name = "proxy-" + std::to_string(s.index);
+  trace::set_thread_name(name.c_str());
+  FrameReader reader(live_view(s.index));
+  const uint64_t period_ns = 1000000000ull / s.fps;
+
+  while (true) {
+    reader.wait(std::chrono::seconds(1));
+    const FrameRef f = reader.next();
+    const bool rec = (m_rec_mask.load(std::memory_order_relaxed) >> s.index) & 1u;
+    if (!rec) {
+      if (s.file) finish_file(s);
+      s.segment = 0;
+      continue;
+    }
+    if (!f) continue;
+    if (!s.file) {
+      if (!open_file(s, f->jpeg, f->size, f->captured_ns)) continue;
+    }
+
+    // AVI frame periods since the last one that got no frame; they repeat
+    // it. A frame early for its period takes the next free one.
+    auto gap = [&] {
+      if (f->captured_ns <= s.t0_ns) return (uint64_t)0;
+      const uint64_t target = (f->captured_ns - s.t0_ns + period_ns / 2) / period_ns;
+      return target > s.entries ? std::min<uint64_t>(target - s.entries, (uint64_t)s.fps * 3600) : 0;
+    };
+    const uint64_t need = s.pos + gap() * 8 + 8 + f->size + 1 + (s.entries + gap() + 2) * 16 + 8;
+    if (need > kSegmentBytes) {
+      const uint64_t t_next = s.t0_ns + (uint64_t)s.entries * period_ns;
+      finish_file(s);
+      ++s.segment;
+      if (!open_file(s, f->jpeg, f->size, f->captured_ns)) continue;
+      s.t0_ns = t_next;   // the next segment carries on the same timeline
+    }
+    for (uint64_t i = 0, n = gap(); i < n; ++i) {
+      if (!append_chunk(s, nullptr, 0)) break;
+    }
+    if (append_chunk(s, f->jpeg, f->size)) {
+      s.metrics->proxy_frames.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      s.metrics->proxy_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+bool ProxyRecorder::open_file(Slot& s, const uint8_t* jpeg, size_t size, uint64_t captured_ns) {
+  uint16_t w = 0, h = 0;
+  if (!jpeg_dimensions(jpeg, size, w, h)) {
+    if (!s.warned_size) CCU_LOG_WARN("proxy: slot %d: live-view frame has no JPEG size", s.index);
+    s.warned_size = true;
+    return false;
+  }
+  if (!reserve(s, kAlign, true)) return false;
+  if (s.segment == 0) s.take_start = std::time(nullptr);
+  tm lt{};
+  ::localtime_r(&s.take_start, &lt);
+  char stamp[32];
+  std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &lt);
+
+  auto file = std::make_shared<File>();
+  char name[64];
+  if (s.segment == 0) {
+    std::snprintf(name, sizeof(name), "/slot%d_%s.avi", s.index, stamp);
+  } else {
+    std::snprintf(name, sizeof(name), "/slot%d_%s_%02d.avi", s.index, stamp, s.segment + 1);
+  }
+  file->path = m_dir + name;
+  Writer::Op op;
+  op.kind = Writer::Op::kOpen;
+  op.file = file;
+  m_writer->submit(std::move(op));
+
+  s.file = file;
+  s.width = w;
+  s.height = h;
+  s.block_offset = 0;
+  s.fill = 0;
+  s.pos = 0;
+  s.entries = 0;
+  s.max_chunk = 0;
+  s.idx1.clear();
+  s.t0_ns = captured_ns;
+  // Placeholder header; finish_file rewrites it with the counts.
+  uint8_t header[kAlign] = {};
+  put(s, header, sizeof(header));
+  s.metrics->proxy_recording.store(1, std::memory_order_relaxed);
+  CCU_LOG_INFO("proxy: slot %d recording %ux%u to %s", s.index, (unsigned)w, (unsigned)h, file->path.c_str());
+  return true;
+}
+
+void ProxyRecorder::finish_file(Slot& s) {
+  // idx1 has to make it even if storage is behind: wait for blocks.
+  const uint64_t movi_end = s.pos;
+  uint8_t idx_head[8];
+  avi_index_header(idx_head, (uint32_t)s.idx1.size());
+  const bool indexed = reserve(s, sizeof(idx_head) + s.idx1.size(), true);
+  if (indexed) {
+    put(s, idx_head, sizeof(idx_head));
+    put(s, s.idx1.data(), s.idx1.size());
+  }
+  const uint64_t final_size = s.pos;
+
+  // The last, partial block goes out padded; the writer truncates.
+  if (s.block) {
+    const size_t bytes = round_up(s.fill, kAlign);
+    std::memset(s.block + s.fill, 0, bytes - s.fill);
+    Writer::Op op;
+    op.kind = Writer::Op::kWrite;
+    op.file = s.file;
+    op.slot = &s;
+    op.data = s.block;
+    op.bytes = bytes;
+    op.offset = s.block_offset;
+    m_writer->submit(std::move(op));
+    s.block = nullptr;
+    s.fill = 0;
+  }
+
+  auto* h = (uint8_t*)std::aligned_alloc(kAlign, kAlign);
+  if (h) {
+    AviInfo info;
+    info.fps = s.fps;
+    info.frames = s.entries;
+    info.max_chunk = s.max_chunk;
+    info.width = s.width;
+    info.height = s.height;
+    info.indexed = indexed;
+    info.movi_end = movi_end;
+    info.file_bytes = final_size;
+    info.take_start = s.take_start;
+    avi_header(h, info);
+
+    Writer::Op op;
+    op.kind = Writer::Op::kClose;
+    op.file = s.file;
+    op.data = h;
+    op.offset = final_size;
+    m_writer->submit(std::move(op));
+  }
+  CCU_LOG_INFO("proxy: slot %d stopped: %u frames, %llu KB in %s", s.index, (unsigned)s.entries,
+               (unsigned long long)(final_size >> 10), s.file->path.c_str());
+  s.metrics->proxy_recording.store(0, std::memory_order_relaxed);
+  s.file.reset();
+}
+
+bool ProxyRecorder::append_chunk(Slot& s, const uint8_t* data, size_t size) {
+  const size_t padded = size + (size & 1);
+  if (!reserve(s, 8 + padded, false)) return false;
+  uint8_t idx[kAviIndexEntry];
+  avi_index_entry(idx, s.pos, (uint32_t)size);
+  s.idx1.insert(s.idx1.end(), idx, idx + sizeof(idx));
+
+  uint8_t head[8];
+  avi_chunk_header(head, (uint32_t)size);
+  put(s, head, sizeof(head));
+  if (size) put(s, data, size);
+  if (padded != size) put(s, "", 1);
+  ++s.entries;
+  s.max_chunk = std::max(s.max_chunk, (uint32_t)padded);
+  s.metrics->proxy_bytes.fetch_add(8 + padded, std::memory_order_relaxed);
+  return true;
+}
+
+bool ProxyRecorder::reserve(Slot& s, size_t bytes, bool wait) {
+  const size_t have = s.block ? kBlockBytes - s.fill : 0;
+  if (bytes <= have) return true;
+  const size_t blocks = (bytes - have + kBlockBytes - 1) / kBlockBytes;
+  if (blocks > s.all.size()) return false;
+  std::unique_lock<std::mutex> lk(s.mu);
+  if (s.free.size() >= blocks) return true;
+  if (!wait) return false;
+  // Only for headers and the index; a dead card is given 10 s.
+  return s.cv.wait_for(lk, std::chrono::seconds(10), [&] { return s.free.size() >= blocks; });
+}
+
+void ProxyRecorder::put(Slot& s, const void* data, size_t size) {
+  const uint8_t* src = (const uint8_t*)data;
+  while (size > 0) {
+    if (!s.block) {
+      std::lock_guard<std::mutex> lk(s.mu);
+      s.block = s.free.back();
+      s.free.pop_back();
+      s.fill = 0;
+    }
+    const size_t n = std::min(size, kBlockBytes - s.fill);
+    std::memcpy(s.block + s.fill, src, n);
+    s.fill += n;
+    s.pos += n;
+    src += n;
+    size -= n;
+    if (s.fill == kBlockBytes) {
+      Writer::Op op;
+      op.kind = Writer::Op::kWrite;
+      op.file = s.file;
+      op.slot = &s;
+      op.data = s.block;
+      op.bytes = kBlockBytes;
+      op.offset = s.block_offset;
+      m_writer->submit(std::move(op));
+      s.block = nullptr;
+      s.block_offset += kBlockBytes;
+    }
+  }
+}
+
+ProxyRecorder& proxy_recorder() {
+  static ProxyRecorder r;
+  return r;
+}
+
+} // namespace ccu
@@ -0,0 +1,69 @@
+#pragma once
+// Proxy recorder: while a slot records, its live-view JPEGs go to an
+// MJPEG AVI on the Pi, so every take has a small review copy per camera
+// that starts and stops with the real one (set_rec_mask, fed from the
+// same REC state as the mosaic borders).
+//
+// Frames are placed on the camera's timeline: each AVI frame period that
+// got no new live-view frame is filled with an empty chunk (players repeat
+// the previous picture), so the proxy runs in step with the take. Files are
+// named slot<n>_<start time>.avi and split before 1 GiB so AVI 1.0 readers
+// and 32-bit index offsets keep working.
+//
+// SD cards stall for hundreds of milliseconds at a time, so nothing here
+// waits on storage. Each slot's thread appends chunks to 1 MiB aligned
+// blocks from its own pool; one writer thread writes full blocks with
+// O_DIRECT (buffered writes plus periodic fdatasync where the filesystem
+// does not support it) and hands them back. If a stall outlasts the pool,
+// frames are dropped and counted; live view itself never notices.
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace ccu {
+
+class ProxyRecorder {
+public:
+  static constexpr size_t kBlockBytes = 1u << 20;
+  static constexpr size_t kAlign = 4096;                 // O_DIRECT and the AVI header
+  static constexpr uint64_t kSegmentBytes = 1ull << 30;  // split files before this
+  static constexpr uint32_t kSyncMs = 5000;              // fdatasync period for buffered files
+  static constexpr uint32_t kSlowWriteMs = 1000;         // a block write this slow is logged
+
+  ProxyRecorder();
+  ~ProxyRecorder();
+
+  // Records the slots whose live view is running into dir, buffering up
+  // to buffer_mb per slot; call after starting them. False if dir is not
+  // writable or there are no slots.
+  bool start(const std::string& dir, uint32_t buffer_mb);
+  bool running() const { return m_running; }
+
+  // Slots currently recording (bit per slot).
+  void set_rec_mask(uint8_t mask) { m_rec_mask.store(mask, std::memory_order_relaxed); }
+
+private:
+  struct File;
+  struct Slot;
+  struct Writer;
+
+  void slot_loop(Slot& s);
+  bool open_file(Slot& s, const uint8_t* jpeg, size_t size, uint64_t captured_ns);
+  void finish_file(Slot& s);
+  bool append_chunk(Slot& s, const uint8_t* data, size_t size);
+  bool reserve(Slot& s, size_t bytes, bool wait);
+  void put(Slot& s, const void* data, size_t size);
+
+  std::string m_dir;
+  bool m_running = false;
+  std::atomic<uint8_t> m_rec_mask{0};
+  std::array<std::unique_ptr<Slot>, 8> m_slots;
+  std::unique_ptr<Writer> m_writer;
+};
+
+ProxyRecorder& proxy_recorder();
+
+} // namespace ccu
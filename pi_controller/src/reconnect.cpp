@@ -0,0 +1,229 @@
+#include "reconnect.hpp"
+#include "async_log.hpp"
+#include "trace.hpp"
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <thread>
+#include <unordered_map>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace ccu {
+
+void ReconnectSignal::kick(uint8_t slot_mask) {
+  if (!slot_mask) return;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending |= slot_mask;
+  }
+  m_cv.notify_one();
+}
+
+uint8_t ReconnectSignal::wait(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_cv.wait_for(lock, timeout, [this] { return m_pending != 0; });
+  const uint8_t mask = m_pending;
+  m_pending = 0;
+  return mask;
+}
+
+ReconnectSignal& reconnect_signal() {
+  static ReconnectSignal s;
+  return s;
+}
+
+static void link_monitor_loop(int fd, std::function<void()> on_link_up) {
+  trace::set_thread_name("netlink");
+  // Last IFF_RUNNING per interface. An interface seen for the first time is
+  // only recorded: RTM_NEWLINK also fires for MTU/name/flag changes, and only
+  // a down -> running transition means the link came back.
+  std::unordered_map<int, bool> running;
+  alignas(nlmsghdr) char buf[8192];
+  while (true) {
+    const ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      if (errno == ENOBUFS) {
+        // Events were lost; assume the worst.
+        reconnect_signal().kick(ReconnectSignal::kAllSlots);
+        continue;
+      }
+      CCU_LOG_WARN("link monitor: recv failed (%s), stopping", std::strerror(errno));
+      ::close(fd);
+      return;
+    }
+    char ifname[IF_NAMESIZE] = "?";
+    int len = (int)n;
+    for (auto* nh = reinterpret_cast<nlmsghdr*>(buf); NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+      if (nh->nlmsg_type == RTM_NEWLINK) {
+        const auto* ifi = static_cast<const ifinfomsg*>(NLMSG_DATA(nh));
+        if (ifi->ifi_flags & IFF_LOOPBACK) continue;
+        const bool up = (ifi->ifi_flags & IFF_RUNNING) != 0;
+        auto it = running.find(ifi->ifi_index);
+        const bool came_up = it != running.end() && !it->second && up;
+        running[ifi->ifi_index] = up;
+        if (!came_up) continue;
+        if_indextoname((unsigned)ifi->ifi_index, ifname);
+        CCU_LOG_INFO("link monitor: %s is up, reconnecting cameras", ifname);
+        reconnect_signal().kick(ReconnectSignal::kAllSlots);
+        if (on_link_up) on_link_up();
+      } else if (nh->nlmsg_type == RTM_NEWADDR) {
+        const auto* ifa = static_cast<const ifaddrmsg*>(NLMSG_DATA(nh));
+        if (ifa->ifa_scope == RT_SCOPE_HOST) continue;
+        if_indextoname(ifa->ifa_index, ifname);
+        CCU_LOG_INFO("link monitor: new address on %s, reconnecting cameras", ifname);
+        reconnect_signal().kick(ReconnectSignal::kAllSlots);
+        if (on_link_up) on_link_up();
+      }
+    }
+  }
+}
+
+// ---- USB hotplug ----
+
+static std::string read_sysfs_line(const std::string& path) {
+  std::string out;
+  FILE* f = std::fopen(path.c_str(), "r");
+  if (!f) return out;
+  char line[128];
+  if (std::fgets(line, sizeof(line), f)) {
+    out = line;
+    while (!out.empty() && (out.back() == '\n' || out.back() == '\r')) out.pop_back();
+  }
+  std::fclose(f);
+  return out;
+}
+
+// Parses one uevent datagram. Kernel events are "ACTION@DEVPATH\0KEY=VAL\0...";
+// udev's start with a "libudev" header whose properties_off/len locate the
+// same KEY=VAL list. False unless it is a Sony USB device attach/detach.
+static bool parse_uevent(const char* buf, size_t len, UsbEvent& ev, std::string& action) {
+  size_t off = 0;
+  size_t end = len;
+  if (len >= 24 && std::memcmp(buf, "libudev", 8) == 0) {
+    uint32_t props_off = 0, props_len = 0;
+    std::memcpy(&props_off, buf + 16, 4);
+    std::memcpy(&props_len, buf + 20, 4);
+    if (props_off > len || props_len > len - props_off) return false;
+    off = props_off;
+    end = props_off + props_len;
+  } else {
+    if (!std::memchr(buf, '@', len)) return false;
+    off = std::strlen(buf) + 1;  // skip "ACTION@DEVPATH"
+  }
+
+  std::string subsystem, devtype, product;
+  action.clear();
+  ev = UsbEvent{};
+  while (off < end) {
+    const char* kv = buf + off;
+    const size_t kv_len = strnlen(kv, end - off);
+    const char* eq = static_cast<const char*>(std::memchr(kv, '=', kv_len));
+    if (eq) {
+      const std::string key(kv, (size_t)(eq - kv));
+      const std::string val(eq + 1, kv_len - (size_t)(eq - kv) - 1);
+      if (key == "ACTION") action = val;
+      else if (key == "DEVPATH") ev.devpath = val;
+      else if (key == "SUBSYSTEM") subsystem = val;
+      else if (key == "DEVTYPE") devtype = val;
+      else if (key == "PRODUCT") product = val;
+    }
+    off += kv_len + 1;
+  }
+  if (subsystem != "usb" || devtype != "usb_device" || product.empty()) return false;
+  // PRODUCT is "vid/pid/bcdDevice" in unpadded hex.
+  char* next = nullptr;
+  const unsigned long vid = std::strtoul(product.c_str(), &next, 16);
+  if (vid != kSonyUsbVendor || !next || *next != '/') return false;
+  ev.product_id = (uint16_t)std::strtoul(next + 1, nullptr, 16);
+  if (action != "add" && action != "remove") return false;
+  ev.attached = (action == "add");
+  return true;
+}
+
+static void usb_monitor_loop(int fd, std::function<void(const UsbEvent&)> on_event) {
+  trace::set_thread_name("uevent");
+  // Serials by devpath: sysfs is already gone when the remove arrives.
+  std::unordered_map<std::string, std::string> serials;
+  if (DIR* d = ::opendir("/sys/bus/usb/devices")) {
+    while (dirent* de = ::readdir(d)) {
+      if (de->d_name[0] == '.') continue;
+      const std::string dir = std::string("/sys/bus/usb/devices/") + de->d_name;
+      if (std::strtoul(read_sysfs_line(dir + "/idVendor").c_str(), nullptr, 16) != kSonyUsbVendor) continue;
+      char real[PATH_MAX];
+      if (!::realpath(dir.c_str(), real) || std::strncmp(real, "/sys", 4) != 0) continue;
+      serials[real + 4] = read_sysfs_line(dir + "/serial");
+    }
+    ::closedir(d);
+  }
+
+  char buf[8192];
+  std::string action;
+  while (true) {
+    const ssize_t n = ::recv(fd, buf, sizeof(buf) - 1, 0);
+    if (n < 0) {
+      if (errno == EINTR || errno == ENOBUFS) continue;
+      CCU_LOG_WARN("usb monitor: recv failed (%s), stopping", std::strerror(errno));
+      ::close(fd);
+      return;
+    }
+    buf[n] = '\0';
+    UsbEvent ev;
+    if (!parse_uevent(buf, (size_t)n, ev, action)) continue;
+    if (ev.attached) {
+      auto it = serials.find(ev.devpath);
+      if (it == serials.end() || it->second.empty()) {
+        serials[ev.devpath] = read_sysfs_line("/sys" + ev.devpath + "/serial");
+      }
+      ev.serial = serials[ev.devpath];
+    } else {
+      auto it = serials.find(ev.devpath);
+      if (it == serials.end()) continue;  // duplicate (kernel + udev) remove
+      ev.serial = it->second;
+      serials.erase(it);
+    }
+    CCU_LOG_INFO("usb monitor: Sony device %04x:%04x %s (%s serial=%s)", (unsigned)kSonyUsbVendor,
+                 (unsigned)ev.product_id, ev.attached ? "attached" : "detached", ev.devpath.c_str(),
+                 ev.serial.empty() ? "-" : ev.serial.c_str());
+    on_event(ev);
+  }
+}
+
+bool start_usb_monitor(std::function<void(const UsbEvent&)> on_event) {
+  const int fd = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+  if (fd < 0) return false;
+  sockaddr_nl sa{};
+  sa.nl_family = AF_NETLINK;
+  sa.nl_groups = 1u | 2u;  // kernel events | udev events
+  if (::bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0) {
+    ::close(fd);
+    return false;
+  }
+  std::thread(usb_monitor_loop, fd, std::move(on_event)).detach();
+  return true;
+}
+
+// ---- Network links ----
+
+bool start_link_monitor(std::function<void()> on_link_up) {
+  const int fd = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+  if (fd < 0) return false;
+  sockaddr_nl sa{};
+  sa.nl_family = AF_NETLINK;
+  sa.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR;
+  if (::bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0) {
+    ::close(fd);
+    return false;
+  }
+  std::thread(link_monitor_loop, fd, std::move(on_link_up)).detach();
+  return true;
+}
+
+} // namespace ccu
@@ -0,0 +1,58 @@
+#pragma once
+// Wakes the background connect loop as soon as a camera is worth retrying,
+// instead of on its next 2 s poll. Three sources kick it:
+//
+//   - the SDK's OnDisconnected callback (that slot only);
+//   - rtnetlink: a network interface coming up (RTM_NEWLINK with IFF_RUNNING
+//     newly set) or gaining an address (RTM_NEWADDR), e.g. an Ethernet cable
+//     re-plugged or Wi-Fi re-associated (all slots);
+//   - USB hotplug (start_usb_monitor): the daemon kicks its USB slots when a
+//     Sony camera is plugged in.
+//
+// Kicks coalesce into a slot mask, so a burst of events costs one pass.
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace ccu {
+
+class ReconnectSignal {
+public:
+  static constexpr uint8_t kAllSlots = 0xFF;
+
+  void kick(uint8_t slot_mask);
+  // Waits up to timeout for a kick; returns the slots kicked (0 on timeout).
+  uint8_t wait(std::chrono::milliseconds timeout);
+
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  uint8_t m_pending = 0;
+};
+
+ReconnectSignal& reconnect_signal();
+
+// Starts the rtnetlink watcher thread; on_link_up (optional) also runs on
+// it for each event that kicks. False if the socket cannot be opened
+// (reconnects then fall back to the poll).
+bool start_link_monitor(std::function<void()> on_link_up = nullptr);
+
+static constexpr uint16_t kSonyUsbVendor = 0x054C;
+
+struct UsbEvent {
+  bool attached = false;
+  std::string devpath;    // sysfs path below /sys, e.g. /devices/platform/.../usb1/1-1
+  std::string serial;     // iSerialNumber; empty if the device has none
+  uint16_t product_id = 0;
+};
+
+// Starts the NETLINK_KOBJECT_UEVENT watcher for Sony (kSonyUsbVendor) USB
+// devices; on_event runs on the watcher thread. Both the kernel's event
+// (instant, used for unplug) and udev's (sent once the device node is
+// ready) are delivered for an attach; handlers must be idempotent.
+bool start_usb_monitor(std::function<void(const UsbEvent&)> on_event);
+
+} // namespace ccu
@@ -0,0 +1,285 @@
+#include "scopes.hpp"
+#include "async_log.hpp"
+#include "bytes.hpp"
+#include "clock.hpp"
+#include "live_view.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+#ifdef CCU_HAVE_JPEG
+#include "jpeg_decoder.hpp"
+#endif
+
+namespace ccu {
+
+#ifdef CCU_HAVE_JPEG
+
+namespace {
+
+// Zone and clip tests compare raw 8-bit luma, so a 128-bit vector covers 16
+// pixels with no widening. Written with vector extensions rather than
+// intrinsics so the same code builds on the Pi and on an x86 dev host.
+typedef uint8_t V16 __attribute__((vector_size(16)));
+constexpr uint32_t kLanes = 16;
+
+// Lower edge of each false-color zone. Zone 0 is exactly "underexposed"
+// and zone 7 exactly "clipped"; the middle ones bracket shadows, mid grey
+// and skin the way a monitor's false-color does.
+constexpr uint8_t kZoneStart[8] = {0, Scopes::kUnderLuma + 1, 26, 102, 128, 153, 217, Scopes::kClipLuma};
+
+// Four interleaved sub-histograms: runs of equal pixels (sky, a capped
+// lens) would otherwise serialise on one counter's load-add-store.
+void luma_histogram(const uint8_t* p, size_t n, uint32_t (&sub)[4][256]) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    ++sub[0][p[i]];
+    ++sub[1][p[i + 1]];
+    ++sub[2][p[i + 2]];
+    ++sub[3][p[i + 3]];
+  }
+  for (; i < n; ++i) ++sub[0][p[i]];
+}
+
+// Adds one row to per-pixel band counters: cnt[b * stride + x] counts the
+// rows in which pixel x had luma >> 5 == b. stride is a multiple of kLanes
+// and the row is padded to it. The u8 counters must be flushed at least
+// every 255 rows.
+void count_bands(const uint8_t* row, uint32_t stride, uint8_t* cnt) {
+  for (uint32_t x = 0; x < stride; x += kLanes) {
+    V16 v;
+    std::memcpy(&v, row + x, kLanes);
+    const V16 band = v >> 5;
+    for (uint32_t b = 0; b < Scopes::kBands; ++b) {
+      uint8_t* c = cnt + (size_t)b * stride + x;
+      V16 acc;
+      std::memcpy(&acc, c, kLanes);
+      acc -= (V16)(band == (uint8_t)b);  // a match is all ones, i.e. -1
+      std::memcpy(c, &acc, kLanes);
+    }
+  }
+}
+
+} // namespace
+
+struct Scopes::State {
+  struct Source {
+    int slot = -1;
+    std::unique_ptr<FrameReader> reader;
+    uint64_t decode_errors = 0;
+  };
+
+  std::vector<Source> sources;
+  JpegDecoder decoder;
+  std::vector<uint8_t> row;        // one decoded scanline, padded to kLanes
+  std::vector<uint8_t> bands;      // count_bands counters
+  std::vector<uint8_t> col_of_x;   // pixel column -> waveform column
+  uint32_t col_w = 0;              // width col_of_x was built for
+
+  bool analyze(const LiveFrame& f, Result& r) {
+    if (!decoder.begin(f.jpeg, f.size, kDecodeW, kDecodeH, true)) return false;
+    const uint32_t w = decoder.width(), h = decoder.height();
+    const uint32_t stride = (w + kLanes - 1) / kLanes * kLanes;
+    // Padding pixels land in counters past w, which are never read.
+    if (row.size() < stride) row.resize(stride);
+    bands.assign((size_t)kBands * stride, 0);
+    if (col_w != w) {
+      col_of_x.resize(w);
+      for (uint32_t x = 0; x < w; ++x) col_of_x[x] = (uint8_t)(x * kColumns / w);
+      col_w = w;
+    }
+
+    uint32_t sub[4][256] = {};
+    uint32_t wave[kColumns][kBands] = {};
+    auto flush = [&] {
+      for (uint32_t b = 0; b < kBands; ++b) {
+        const uint8_t* c = bands.data() + (size_t)b * stride;
+        for (uint32_t x = 0; x < w; ++x) wave[col_of_x[x]][b] += c[x];
+      }
+      std::fill(bands.begin(), bands.end(), 0);
+    };
+    uint32_t pending = 0;
+    for (uint32_t y = 0; y < h; ++y) {
+      if (!decoder.read_row(row.data())) return false;
+      luma_histogram(row.data(), w, sub);
+      count_bands(row.data(), stride, bands.data());
+      if (++pending == 255) {
+        flush();
+        pending = 0;
+      }
+    }
+    if (pending) flush();
+    if (!decoder.finish()) return false;
+
+    summarize(sub, wave, (uint64_t)w * h, r);
+    r.frame_seq = (uint32_t)f.seq;
+    r.captured_ns = f.captured_ns;
+    r.valid = true;
+    return true;
+  }
+
+  static void summarize(const uint32_t (&sub)[4][256], const uint32_t (&wave)[kColumns][kBands], uint64_t n,
+                        Result& r) {
+    uint32_t hist[256];
+    uint32_t peak = 0;
+    uint64_t sum = 0;
+    for (uint32_t v = 0; v < 256; ++v) {
+      hist[v] = sub[0][v] + sub[1][v] + sub[2][v] + sub[3][v];
+      peak = std::max(peak, hist[v]);
+      sum += (uint64_t)v * hist[v];
+    }
+    if (n == 0 || peak == 0) return;
+    r.mean = (uint8_t)((sum + n / 2) / n);
+
+    // Smallest luma with at least permille of the pixels at or below it.
+    auto percentile = [&](uint64_t permille) {
+      const uint64_t want = std::max<uint64_t>(1, (n * permille + 999) / 1000);
+      uint64_t cum = 0;
+      for (uint32_t v = 0; v < 256; ++v) {
+        cum += hist[v];
+        if (cum >= want) return (uint8_t)v;
+      }
+      return (uint8_t)255;
+    };
+    r.p1 = percentile(10);
+    r.p50 = percentile(500);
+    r.p99 = percentile(990);
+
+    uint64_t zone[8] = {};
+    for (uint32_t v = 0, z = 0; v < 256; ++v) {
+      while (z + 1 < 8 && v >= kZoneStart[z + 1]) ++z;
+      zone[z] += hist[v];
+    }
+    for (int z = 0; z < 8; ++z) r.zones[z] = (uint8_t)((zone[z] * 200 + n / 2) / n);
+    r.under_permille = (uint16_t)((zone[0] * 1000 + n / 2) / n);
+    r.clipped_permille = (uint16_t)((zone[7] * 1000 + n / 2) / n);
+
+    // Rounded up so a bin with any pixels never reads as empty.
+    for (uint32_t v = 0; v < 256; ++v) r.hist[v] = (uint8_t)(((uint64_t)hist[v] * 255 + peak - 1) / peak);
+
+    std::memset(r.wave, 0, sizeof(r.wave));
+    for (uint32_t c = 0; c < kColumns; ++c) {
+      const uint32_t top = *std::max_element(wave[c], wave[c] + kBands);
+      if (top == 0) continue;
+      for (uint32_t b = 0; b < kBands; ++b) {
+        const uint32_t cell = (wave[c][b] * 15 + top - 1) / top;
+        r.wave[c * (kBands / 2) + b / 2] |= (uint8_t)(cell << (4 * (b & 1)));
+      }
+    }
+  }
+};
+
+Scopes::Scopes() = default;
+Scopes::~Scopes() = default;
+
+bool Scopes::start(uint32_t hz) {
+  if (m_hz != 0 || hz == 0) return false;
+  auto st = std::make_unique<State>();
+  for (int i = 0; i < MetricsRegistry::kSlots; ++i) {
+    if (!live_view(i).running()) continue;
+    State::Source s;
+    s.slot = i;
+    s.reader = std::make_unique<FrameReader>(live_view(i));
+    st->sources.push_back(std::move(s));
+  }
+  if (st->sources.empty()) return false;
+
+  CCU_LOG_INFO("scopes: %u camera(s) at %u Hz", (unsigned)st->sources.size(), (unsigned)hz);
+  m_state = std::move(st);
+  m_hz = hz;
+  std::thread([this] { loop(); }).detach();
+  return true;
+}
+
+void Scopes::loop() {
+  trace::set_thread_name("scopes");
+  State& st = *m_state;
+  const auto period = std::chrono::microseconds(1000000 / m_hz);
+  auto next = std::chrono::steady_clock::now();
+
+  while (true) {
+    std::this_thread::sleep_until(next);
+    next = std::max(next + period, std::chrono::steady_clock::now());
+    for (State::Source& s : st.sources) {
+      const FrameRef f = s.reader->next();
+      if (!f) continue;
+      Result r;
+      if (!st.analyze(*f, r)) {
+        if (s.decode_errors++ == 0) CCU_LOG_WARN("scopes: slot %d: undecodable live-view frame", s.slot);
+        continue;
+      }
+      std::lock_guard<std::mutex> lk(m_mu);
+      m_results[(size_t)s.slot] = r;
+    }
+  }
+}
+
+#else  // !CCU_HAVE_JPEG
+
+struct Scopes::State {};
+
+Scopes::Scopes() = default;
+Scopes::~Scopes() = default;
+
+bool Scopes::start(uint32_t) {
+  CCU_LOG_WARN("scopes: ccu_daemon was built without libjpeg");
+  return false;
+}
+
+void Scopes::loop() {}
+
+#endif
+
+size_t Scopes::build_payload(int slot, uint8_t* out, size_t out_max) const {
+  if (out_max < kPayloadBytes || slot < 0 || slot >= (int)m_results.size()) return 0;
+  Result r;
+  {
+    std::lock_guard<std::mutex> lk(m_mu);
+    r = m_results[(size_t)slot];
+  }
+  uint64_t age_ms = 0xFFFF;
+  uint8_t flags = 0;
+  if (r.valid) {
+    const uint64_t now = monotonic_ns();
+    age_ms = now > r.captured_ns ? (now - r.captured_ns) / 1000000ull : 0;
+    flags |= 0x01;
+    if (age_ms > kStaleMs) flags |= 0x02;
+  }
+
+  uint8_t* p = out;
+  *p++ = kVersion;
+  *p++ = (uint8_t)slot;
+  *p++ = flags;
+  *p++ = (uint8_t)kColumns;
+  put32(p, r.frame_seq);
+  p += 4;
+  put16(p, (uint16_t)std::min<uint64_t>(age_ms, 0xFFFF));
+  p += 2;
+  put16(p, r.clipped_permille);
+  p += 2;
+  put16(p, r.under_permille);
+  p += 2;
+  *p++ = r.mean;
+  *p++ = r.p1;
+  *p++ = r.p50;
+  *p++ = r.p99;
+  std::memcpy(p, r.zones, sizeof(r.zones));
+  p += sizeof(r.zones);
+  std::memcpy(p, r.hist, sizeof(r.hist));
+  p += sizeof(r.hist);
+  std::memcpy(p, r.wave, sizeof(r.wave));
+  p += sizeof(r.wave);
+  return (size_t)(p - out);
+}
+
+Scopes& scopes() {
+  static Scopes s;
+  return s;
+}
+
+} // namespace ccu
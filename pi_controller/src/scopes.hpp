@@ -0,0 +1,71 @@
+#pragma once
+// Exposure scopes for every live-view slot, computed on the Pi so the CCU
+// gets a histogram, waveform and clip/crush readings without touching an
+// image. Each new live-view frame is decoded as luma only, at the smallest
+// DCT scale that is still at least kDecodeW x kDecodeH, and summarised into
+// a fixed kPayloadBytes record that CMD_GET_SCOPES returns as is.
+//
+// Payload (little endian, see docs/ccu_scopes.md):
+//   u8 version, u8 slot, u8 flags (bit0 valid, bit1 stale), u8 columns
+//   u32 frame_seq, u16 age_ms
+//   u16 clipped_permille, u16 under_permille
+//   u8 mean, u8 p1, u8 p50, u8 p99, u8 zones[8]
+//   u8 hist[256], u8 waveform[columns * kBands / 2] (4-bit cells)
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace ccu {
+
+class Scopes {
+public:
+  static constexpr uint8_t kVersion = 1;
+  static constexpr uint32_t kColumns = 32;
+  static constexpr uint32_t kBands = 8;            // luma >> 5
+  static constexpr uint32_t kDecodeW = 160;
+  static constexpr uint32_t kDecodeH = 90;
+  static constexpr uint32_t kStaleMs = 2000;       // no new frame for this long: flagged stale
+  static constexpr uint8_t kClipLuma = 250;        // >= counts as clipped
+  static constexpr uint8_t kUnderLuma = 8;         // <= counts as underexposed
+  static constexpr size_t kPayloadBytes = 26 + 256 + kColumns * kBands / 2;
+
+  Scopes();
+  ~Scopes();
+
+  // Analyses the slots whose live view is running, at most hz frames per
+  // second each; call after starting them. False if there are none or the
+  // daemon was built without libjpeg.
+  bool start(uint32_t hz);
+  bool running() const { return m_hz != 0; }
+
+  // Latest record for slot into out (at least kPayloadBytes); flags are 0
+  // when nothing was analysed yet. Returns the bytes written, 0 if out is
+  // too small.
+  size_t build_payload(int slot, uint8_t* out, size_t out_max) const;
+
+private:
+  struct Result {
+    bool valid = false;
+    uint32_t frame_seq = 0;
+    uint64_t captured_ns = 0;
+    uint16_t clipped_permille = 0;
+    uint16_t under_permille = 0;
+    uint8_t mean = 0, p1 = 0, p50 = 0, p99 = 0;
+    uint8_t zones[8] = {};
+    uint8_t hist[256] = {};
+    uint8_t wave[kColumns * kBands / 2] = {};
+  };
+  struct State;
+  void loop();
+
+  uint32_t m_hz = 0;
+  std::unique_ptr<State> m_state;
+  mutable std::mutex m_mu;
+  std::array<Result, 8> m_results;
+};
+
+Scopes& scopes();
+
+} // namespace ccu
@@ -0,0 +1,192 @@
+#include "sdk_executor.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace ccu {
+
+struct SdkExecutor::Worker {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::function<void()>> tasks;
+  bool retired = false;
+};
+
+namespace {
+
+// Completion handshake between a caller and the workers running its tasks
+// (one per slot): for each, whoever moves its state away from RUNNING first
+// decides how that call ended.
+struct Calls {
+  enum : int { RUNNING, COMPLETED, ABANDONED };
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::array<int, MetricsRegistry::kSlots> state{};
+  int running = 0;
+};
+
+// Upper bounds before any latency has been observed. Connect covers the SDK's
+// own reconnect attempts; capture_still and still_arm include AF.
+uint64_t default_budget_us(const std::string& op) {
+  if (op == "connect") return 20000000ull;
+  if (op == "capture_still" || op == "still_arm") return 8000000ull;
+  if (op == "set_runstop" || op == "set_runstop_at") return 6000000ull;
+  return 4000000ull;
+}
+
+} // namespace
+
+void SdkExecutor::worker_loop(std::shared_ptr<Worker> w, int slot, Lane lane) {
+  char name[16];
+  std::snprintf(name, sizeof(name), lane == LIVE_VIEW ? "sdk-lv-%d" : "sdk-%d", slot);
+  trace::set_thread_name(name);
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(w->mutex);
+      w->cv.wait(lock, [&] { return w->retired || !w->tasks.empty(); });
+      if (w->tasks.empty()) return;
+      task = std::move(w->tasks.front());
+      w->tasks.pop_front();
+    }
+    task();
+    std::lock_guard<std::mutex> lock(w->mutex);
+    if (w->retired && w->tasks.empty()) return;
+  }
+}
+
+std::shared_ptr<SdkExecutor::Worker>& SdkExecutor::worker_ref(int slot, Lane lane) {
+  return m_workers[lane][(size_t)(slot & (MetricsRegistry::kSlots - 1))];
+}
+
+std::shared_ptr<SdkExecutor::Worker> SdkExecutor::worker(int slot, Lane lane) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto& w = worker_ref(slot, lane);
+  if (!w) {
+    w = std::make_shared<Worker>();
+    std::thread(worker_loop, w, slot, lane).detach();
+  }
+  return w;
+}
+
+SdkExecutor::Status SdkExecutor::run(int slot, std::function<void()> task, uint64_t deadline_us,
+                                     std::function<void()> late_done, Lane lane) {
+  slot &= MetricsRegistry::kSlots - 1;
+  std::function<void(int)> late;
+  if (late_done) late = [late_done = std::move(late_done)](int) { late_done(); };
+  return run_each((uint8_t)(1u << slot), [task = std::move(task)](int) { task(); }, deadline_us, std::move(late),
+                  lane)[(size_t)slot];
+}
+
+std::array<SdkExecutor::Status, MetricsRegistry::kSlots> SdkExecutor::run_each(uint8_t slots,
+                                                                               std::function<void(int)> task,
+                                                                               uint64_t deadline_us,
+                                                                               std::function<void(int)> late_done,
+                                                                               Lane lane) {
+  std::array<Status, MetricsRegistry::kSlots> status;
+  status.fill(DONE);
+  auto calls = std::make_shared<Calls>();
+  for (int i = 0; i < MetricsRegistry::kSlots; ++i) {
+    if (slots & (1u << i)) ++calls->running;
+  }
+  std::array<std::shared_ptr<Worker>, MetricsRegistry::kSlots> workers;
+  for (int i = 0; i < MetricsRegistry::kSlots; ++i) {
+    if (!(slots & (1u << i))) continue;
+    workers[(size_t)i] = post_to(i, [calls, i, task, late_done]() {
+      task(i);
+      bool abandoned = false;
+      {
+        std::lock_guard<std::mutex> cl(calls->mutex);
+        if (calls->state[(size_t)i] == Calls::RUNNING) {
+          calls->state[(size_t)i] = Calls::COMPLETED;
+          --calls->running;
+        } else {
+          abandoned = true;
+        }
+      }
+      calls->cv.notify_all();
+      if (abandoned && late_done) late_done(i);
+    }, lane);
+  }
+
+  const auto deadline = std::chrono::steady_clock::time_point(std::chrono::microseconds(deadline_us));
+  {
+    std::unique_lock<std::mutex> cl(calls->mutex);
+    calls->cv.wait_until(cl, deadline, [&] { return calls->running == 0; });
+    for (int i = 0; i < MetricsRegistry::kSlots; ++i) {
+      if (!workers[(size_t)i] || calls->state[(size_t)i] != Calls::RUNNING) continue;
+      calls->state[(size_t)i] = Calls::ABANDONED;
+      status[(size_t)i] = TIMED_OUT;
+    }
+  }
+  for (int i = 0; i < MetricsRegistry::kSlots; ++i) {
+    if (status[(size_t)i] == TIMED_OUT) retire(i, lane, workers[(size_t)i]);
+  }
+  return status;
+}
+
+void SdkExecutor::post(int slot, std::function<void()> task, Lane lane) {
+  post_to(slot, std::move(task), lane);
+}
+
+std::shared_ptr<SdkExecutor::Worker> SdkExecutor::post_to(int slot, std::function<void()> task, Lane lane) {
+  // A worker retired since worker() returned it may already have exited;
+  // retire() unpublishes it first, so the next lookup is fresh.
+  while (true) {
+    std::shared_ptr<Worker> w = worker(slot, lane);
+    {
+      std::lock_guard<std::mutex> lock(w->mutex);
+      if (w->retired) continue;
+      w->tasks.push_back(std::move(task));
+    }
+    w->cv.notify_one();
+    return w;
+  }
+}
+
+// Retires a stuck worker; it exits once the SDK call returns and the slot
+// gets a fresh one for later calls.
+void SdkExecutor::retire(int slot, Lane lane, const std::shared_ptr<Worker>& w) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& cur = worker_ref(slot, lane);
+    if (cur == w) cur.reset();
+  }
+  {
+    std::lock_guard<std::mutex> lock(w->mutex);
+    w->retired = true;
+  }
+  w->cv.notify_one();
+}
+
+SdkExecutor::OpStats& SdkExecutor::op_stats(const std::string& op) {
+  for (auto& e : m_ops) {
+    if (e.first == op) return *e.second;
+  }
+  auto st = std::make_unique<OpStats>();
+  st->default_us = default_budget_us(op);
+  m_ops.emplace_back(op, std::move(st));
+  return *m_ops.back().second;
+}
+
+uint64_t SdkExecutor::budget_us(const std::string& op) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  OpStats& st = op_stats(op);
+  if (st.latency.count() < kMinSamples) return st.default_us;
+  const uint64_t adaptive = 4 * st.latency.percentile_us(0.99) + kMarginUs;
+  return std::min(st.default_us, std::max(kMinDeadlineUs, adaptive));
+}
+
+void SdkExecutor::record(const std::string& op, uint64_t us) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  op_stats(op).latency.record(us);
+}
+
+SdkExecutor& sdk_executor() {
+  static SdkExecutor ex;
+  return ex;
+}
+
+} // namespace ccu
@@ -0,0 +1,78 @@
+#pragma once
+// Deadline-aware execution of blocking camera operations. Each slot has one
+// worker thread; the caller hands it a task and waits until a deadline. A
+// CRSDK call that hangs (Connect on a half-open PTP-IP session, a property
+// read during a USB reset) then costs the caller one deadline instead of
+// blocking it forever: the call is abandoned, its worker is retired (it exits
+// once the SDK returns) and the slot gets a fresh worker for later calls.
+//
+// Deadlines adapt per operation: 4 x the observed p99 plus 250 ms, clamped
+// to [1 s, the operation's default]. Until an operation has 20 samples its
+// default applies.
+//
+// Live view gets a second lane per slot with its own worker, so frame
+// fetches neither queue behind a long command (a RUNSTOP_AT wait, AF) nor
+// retire the command worker when they time out.
+#include "metrics.hpp"
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace ccu {
+
+class SdkExecutor {
+public:
+  static constexpr uint64_t kMinDeadlineUs = 1000000ull;
+  static constexpr uint64_t kMarginUs = 250000ull;
+  static constexpr uint64_t kMinSamples = 20;
+
+  enum Status : uint8_t { DONE, TIMED_OUT };
+  enum Lane : uint8_t { CONTROL, LIVE_VIEW, kLanes };
+
+  // Runs task on the slot's worker and waits until deadline_us (CLOCK_MONOTONIC).
+  // An abandoned task keeps running and calls late_done when it finally
+  // returns, so it must own (or share) everything it touches.
+  Status run(int slot, std::function<void()> task, uint64_t deadline_us,
+             std::function<void()> late_done = nullptr, Lane lane = CONTROL);
+  // run() for every slot in slots at once, task(slot) on each slot's worker,
+  // all under one deadline; late_done(slot) for each abandoned one. Slots
+  // outside slots report DONE.
+  std::array<Status, MetricsRegistry::kSlots> run_each(uint8_t slots, std::function<void(int)> task,
+                                                       uint64_t deadline_us,
+                                                       std::function<void(int)> late_done = nullptr,
+                                                       Lane lane = CONTROL);
+  // Queues task behind whatever the slot's worker is running and returns at
+  // once; for best-effort cleanup nobody waits on.
+  void post(int slot, std::function<void()> task, Lane lane = CONTROL);
+
+  // Current deadline budget for op (a backend operation name).
+  uint64_t budget_us(const std::string& op);
+  void record(const std::string& op, uint64_t us);
+
+private:
+  struct Worker;
+  struct OpStats {
+    uint64_t default_us = 0;
+    LatencyHistogram latency;
+  };
+
+  std::shared_ptr<Worker>& worker_ref(int slot, Lane lane);  // m_mutex held
+  std::shared_ptr<Worker> worker(int slot, Lane lane);
+  std::shared_ptr<Worker> post_to(int slot, std::function<void()> task, Lane lane);
+  void retire(int slot, Lane lane, const std::shared_ptr<Worker>& w);
+  static void worker_loop(std::shared_ptr<Worker> w, int slot, Lane lane);
+  OpStats& op_stats(const std::string& op);  // m_mutex held
+
+  std::mutex m_mutex;
+  std::array<std::array<std::shared_ptr<Worker>, MetricsRegistry::kSlots>, kLanes> m_workers;
+  std::deque<std::pair<std::string, std::unique_ptr<OpStats>>> m_ops;
+};
+
+SdkExecutor& sdk_executor();
+
+} // namespace ccu
@@ -0,0 +1,234 @@
+#include "shm_export.hpp"
+#include "async_log.hpp"
+#include "live_view.hpp"
+#include "metrics.hpp"
+#include "shm_layout.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace ccu {
+
+namespace {
+
+size_t round_up(size_t v, size_t to) { return (v + to - 1) / to * to; }
+
+bool send_reply(int fd, uint8_t status, uint32_t frames, int memfd, int event_fd) {
+  ShmReply reply{};
+  reply.status = status;
+  reply.version = (uint8_t)kShmVersion;
+  reply.frames = frames;
+  iovec iov{&reply, sizeof(reply)};
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+  if (status == kShmOk) {
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(2 * sizeof(int));
+    const int fds[2] = {memfd, event_fd};
+    std::memcpy(CMSG_DATA(cm), fds, sizeof(fds));
+  }
+  return ::sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT) == (ssize_t)sizeof(reply);
+}
+
+} // namespace
+
+bool ShmExport::start(const std::string& socket_path, uint32_t frames, size_t frame_bytes) {
+  if (m_listen_fd >= 0) return false;
+  const size_t page = (size_t)::sysconf(_SC_PAGESIZE);
+  m_frames = std::min(std::max<uint32_t>(frames, 2), kShmMaxFrames);
+  m_frame_bytes = round_up(std::max<size_t>(frame_bytes, page), page);
+  m_header_bytes = round_up(sizeof(ShmRingHeader) + kShmMaxFrames * sizeof(ShmEntry), page);
+
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (socket_path.empty() || socket_path.size() >= sizeof(addr.sun_path)) {
+    CCU_LOG_WARN("shm: bad socket path '%s'", socket_path.c_str());
+    return false;
+  }
+  std::memcpy(addr.sun_path, socket_path.c_str(), socket_path.size());
+
+  int rings = 0;
+  for (int i = 0; i < (int)m_rings.size(); ++i) {
+    if (!live_view(i).running()) continue;
+    if (!create_ring(i, m_rings[(size_t)i])) return false;
+    ++rings;
+  }
+  if (rings == 0) return false;
+
+  const int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (fd < 0) return false;
+  ::unlink(socket_path.c_str());  // left over from a previous run
+  if (::bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(fd, 8) < 0) {
+    CCU_LOG_WARN("shm: cannot listen on %s (%s)", socket_path.c_str(), std::strerror(errno));
+    ::close(fd);
+    return false;
+  }
+  m_listen_fd = fd;
+
+  CCU_LOG_INFO("shm: %d slot(s) on %s, %u x %zu KB per ring", rings, socket_path.c_str(), (unsigned)m_frames,
+               m_frame_bytes / 1024);
+  for (int i = 0; i < (int)m_rings.size(); ++i) {
+    if (m_rings[(size_t)i].base) std::thread([this, i] { write_loop(i); }).detach();
+  }
+  std::thread([this] { socket_loop(); }).detach();
+  return true;
+}
+
+bool ShmExport::create_ring(int slot, Ring& r) {
+  const std::string name = "ccu-liveview-" + std::to_string(slot);
+  const size_t total = m_header_bytes + (size_t)m_frames * m_frame_bytes;
+  r.memfd = ::memfd_create(name.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (r.memfd < 0 || ::ftruncate(r.memfd, (off_t)total) < 0) {
+    CCU_LOG_WARN("shm: slot %d: memfd of %zu bytes failed (%s)", slot, total, std::strerror(errno));
+    return false;
+  }
+  // Readers can rely on the size: a shrink would fault their mappings.
+  ::fcntl(r.memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+  void* p = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, r.memfd, 0);
+  if (p == MAP_FAILED) {
+    CCU_LOG_WARN("shm: slot %d: mmap failed (%s)", slot, std::strerror(errno));
+    return false;
+  }
+  // Readers get a read-only descriptor, so a buggy one cannot scribble on
+  // the ring. Without /proc they get the writable one.
+  const std::string self = "/proc/self/fd/" + std::to_string(r.memfd);
+  r.ro_fd = ::open(self.c_str(), O_RDONLY | O_CLOEXEC);
+  if (r.ro_fd < 0) r.ro_fd = r.memfd;
+
+  r.base = (uint8_t*)p;
+  shm_init_ring(r.base, (uint8_t)slot, m_frames, (uint32_t)m_header_bytes, m_frame_bytes, total);
+  return true;
+}
+
+void ShmExport::write_loop(int slot) {
+  const std::string name = "shm-" + std::to_string(slot);
+  trace::set_thread_name(name.c_str());
+  Ring& r = m_rings[(size_t)slot];
+  SlotMetrics& sm = metrics().slot(slot);
+  FrameReader reader(live_view(slot));
+  uint64_t seq = 0;
+  bool warned = false;
+
+  while (true) {
+    if (!reader.wait(std::chrono::seconds(1))) continue;
+    const FrameRef f = reader.next();
+    if (!f) continue;
+    if (f->size > m_frame_bytes) {
+      sm.lv_shm_oversize.fetch_add(1, std::memory_order_relaxed);
+      if (!warned) CCU_LOG_WARN("shm: slot %d: %zu-byte frame exceeds CCU_SHM_FRAME_KB", slot, f->size);
+      warned = true;
+      continue;
+    }
+
+    shm_write_frame(r.base, ++seq, f->jpeg, (uint32_t)f->size, f->captured_ns, f->frame_no);
+    sm.lv_shm_frames.fetch_add(1, std::memory_order_relaxed);
+
+    const uint64_t one = 1;
+    std::lock_guard<std::mutex> lk(r.mu);
+    // Cannot block: an eventfd write only fails on counter overflow.
+    for (int efd : r.event_fds) (void)!::write(efd, &one, sizeof(one));
+  }
+}
+
+void ShmExport::socket_loop() {
+  trace::set_thread_name("shm");
+  std::vector<pollfd> pfds;
+  while (true) {
+    pfds.clear();
+    pfds.push_back({m_listen_fd, POLLIN, 0});
+    for (const Client& c : m_clients) pfds.push_back({c.fd, POLLIN, 0});
+    if (::poll(pfds.data(), (nfds_t)pfds.size(), -1) < 0) {
+      if (errno != EINTR) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      continue;
+    }
+
+    // Clients first: indexes in pfds match m_clients until it changes.
+    for (size_t i = m_clients.size(); i-- > 0;) {
+      const short ev = pfds[i + 1].revents;
+      if (!ev) continue;
+      Client& c = m_clients[i];
+      uint8_t req = 0;
+      const ssize_t n = ::recv(c.fd, &req, 1, MSG_DONTWAIT);
+      if (n == 1 && c.slot < 0) {
+        subscribe(c, req);
+        if (c.slot >= 0) continue;
+      } else if (n > 0 || (n < 0 && (errno == EAGAIN || errno == EINTR))) {
+        continue;  // already subscribed: extra requests are ignored
+      }
+      drop(c);
+      m_clients.erase(m_clients.begin() + (ptrdiff_t)i);
+    }
+
+    if (pfds[0].revents & POLLIN) {
+      const int fd = ::accept4(m_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+      if (fd < 0) continue;
+      if (m_clients.size() >= kMaxClients) {
+        send_reply(fd, kShmBusy, 0, -1, -1);
+        ::close(fd);
+        continue;
+      }
+      Client c;
+      c.fd = fd;
+      m_clients.push_back(c);
+    }
+  }
+}
+
+void ShmExport::subscribe(Client& c, uint8_t slot) {
+  if (slot >= m_rings.size() || !m_rings[slot].base) {
+    send_reply(c.fd, kShmNoSlot, 0, -1, -1);
+    return;
+  }
+  Ring& r = m_rings[slot];
+  const int efd = ::eventfd(0, EFD_CLOEXEC);
+  if (efd < 0) return;
+  if (!send_reply(c.fd, kShmOk, m_frames, r.ro_fd, efd)) {
+    ::close(efd);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lk(r.mu);
+    r.event_fds.push_back(efd);
+  }
+  c.slot = slot;
+  c.event_fd = efd;
+  metrics().slot(slot).lv_shm_clients.fetch_add(1, std::memory_order_relaxed);
+  CCU_LOG_INFO("shm: reader joined slot %d", (int)slot);
+}
+
+void ShmExport::drop(Client& c) {
+  if (c.slot >= 0) {
+    Ring& r = m_rings[(size_t)c.slot];
+    {
+      std::lock_guard<std::mutex> lk(r.mu);
+      r.event_fds.erase(std::remove(r.event_fds.begin(), r.event_fds.end(), c.event_fd), r.event_fds.end());
+    }
+    ::close(c.event_fd);
+    metrics().slot(c.slot).lv_shm_clients.fetch_sub(1, std::memory_order_relaxed);
+    CCU_LOG_INFO("shm: reader left slot %d", c.slot);
+  }
+  ::close(c.fd);
+}
+
+ShmExport& shm_export() {
+  static ShmExport s;
+  return s;
+}
+
+} // namespace ccu
@@ -0,0 +1,61 @@
+#pragma once
+// Live view for local processes (ffmpeg, OBS helpers, analysis scripts)
+// without a second SDK session or a socket copy per frame. Each slot's
+// camera frames are written into a ring in a memfd (layout in
+// shm_layout.hpp); readers subscribe on a unix socket, receive the memfd
+// and their own eventfd, map the ring read-only and read frames in place.
+//
+// One thread per slot copies each new frame into the ring once and bumps
+// every subscriber's eventfd. It never waits for a reader: one that falls
+// more than a ring behind sees its frame overwritten and skips ahead.
+// Pages of the ring are only backed by memory once a frame touches them.
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ccu {
+
+class ShmExport {
+public:
+  static constexpr uint32_t kMaxClients = 32;
+
+  // Creates a ring of frames entries of frame_bytes each for every running
+  // live-view slot and listens on socket_path (replacing a stale socket).
+  // Call after starting live view.
+  bool start(const std::string& socket_path, uint32_t frames, size_t frame_bytes);
+  bool running() const { return m_listen_fd >= 0; }
+
+private:
+  struct Ring {
+    int memfd = -1;
+    int ro_fd = -1;   // read-only reopen handed to readers
+    uint8_t* base = nullptr;
+    std::mutex mu;
+    std::vector<int> event_fds;   // one per subscriber
+  };
+  struct Client {
+    int fd = -1;
+    int slot = -1;       // -1 until subscribed
+    int event_fd = -1;
+  };
+
+  bool create_ring(int slot, Ring& r);
+  void write_loop(int slot);
+  void socket_loop();
+  void subscribe(Client& c, uint8_t slot);
+  void drop(Client& c);
+
+  uint32_t m_frames = 0;
+  size_t m_frame_bytes = 0;
+  size_t m_header_bytes = 0;
+  int m_listen_fd = -1;
+  std::array<Ring, 8> m_rings;
+  std::vector<Client> m_clients;   // socket thread only
+};
+
+ShmExport& shm_export();
+
+} // namespace ccu
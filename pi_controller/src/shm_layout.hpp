@@ -0,0 +1,105 @@
+#pragma once
+// Layout of the shared-memory live-view ring (shm_export.hpp), shared by
+// ccu_daemon and local readers (tools/ccu_shm_client.hpp). One ring per
+// slot, in a sealed memfd readers map read-only:
+//
+//   offset 0              ShmRingHeader
+//   offset 64             ShmEntry[frames]
+//   offset header_bytes   frame data, entry i at header_bytes + i * frame_bytes
+//
+// Frame seq s (from 1) goes to entry (s - 1) % frames. The writer clears
+// the entry's seq, copies the JPEG, sets seq = s and then write_seq = s.
+// A reader takes write_seq, uses the entry only if its seq matches, and
+// checks it still matches once done: if not, the writer lapped the ring
+// while the frame was in use and it must be discarded. Everything is
+// little endian and the same on 32- and 64-bit Pis.
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+namespace ccu {
+
+constexpr uint32_t kShmMagic = 0x4C554343;  // "CCUL"
+constexpr uint16_t kShmVersion = 1;
+constexpr uint32_t kShmMaxFrames = 64;      // entries fit in the first page
+
+// Subscribe: send the slot number as one byte on the daemon's SOCK_SEQPACKET
+// socket. The reply is one ShmReply; with status kShmOk it carries two
+// descriptors (SCM_RIGHTS): the ring memfd (read-only) and an eventfd the
+// daemon increments after each frame. Keep the socket open while reading;
+// closing it unsubscribes.
+enum : uint8_t {
+  kShmOk = 0,
+  kShmNoSlot = 1,   // slot out of range or its live view is off
+  kShmBusy = 2,     // too many readers
+};
+
+struct ShmReply {
+  uint8_t status;
+  uint8_t version;
+  uint16_t reserved;
+  uint32_t frames;
+};
+
+struct ShmRingHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint8_t slot;
+  uint8_t reserved0;
+  uint32_t frames;                  // ring entries
+  uint32_t header_bytes;            // offset of entry 0's data (page aligned)
+  uint64_t frame_bytes;             // data capacity per entry (page aligned)
+  uint64_t total_bytes;             // memfd size
+  std::atomic<uint64_t> write_seq;  // newest complete frame, 0 = none yet
+  uint8_t reserved1[24];
+};
+
+struct ShmEntry {
+  std::atomic<uint64_t> seq;   // frame in this entry, 0 while being written
+  uint64_t captured_ns;        // CLOCK_MONOTONIC when the camera fetch returned
+  uint32_t size;               // JPEG bytes
+  uint32_t frame_no;           // SDK frame counter
+  uint64_t reserved;
+};
+
+static_assert(sizeof(ShmRingHeader) == 64, "ShmRingHeader layout");
+static_assert(sizeof(ShmEntry) == 32, "ShmEntry layout");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring counters must be lock-free across processes");
+
+inline ShmEntry* shm_entries(uint8_t* base) { return reinterpret_cast<ShmEntry*>(base + sizeof(ShmRingHeader)); }
+
+// Writer side (ccu_daemon). Lays out an empty ring at base, which must be
+// zeroed and total_bytes long.
+inline ShmRingHeader* shm_init_ring(uint8_t* base, uint8_t slot, uint32_t frames, uint32_t header_bytes,
+                                    uint64_t frame_bytes, uint64_t total_bytes) {
+  auto* h = new (base) ShmRingHeader();
+  h->magic = kShmMagic;
+  h->version = kShmVersion;
+  h->slot = slot;
+  h->frames = frames;
+  h->header_bytes = header_bytes;
+  h->frame_bytes = frame_bytes;
+  h->total_bytes = total_bytes;
+  for (uint32_t i = 0; i < frames; ++i) new (&shm_entries(base)[i]) ShmEntry();
+  return h;
+}
+
+// Writes frame seq (one more than the previous one) in the order above;
+// size must not exceed frame_bytes.
+inline void shm_write_frame(uint8_t* base, uint64_t seq, const uint8_t* jpeg, uint32_t size, uint64_t captured_ns,
+                            uint32_t frame_no) {
+  auto* h = reinterpret_cast<ShmRingHeader*>(base);
+  const uint64_t idx = (seq - 1) % h->frames;
+  ShmEntry& e = shm_entries(base)[idx];
+  e.seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);  // readers see 0 before any new byte
+  std::memcpy(base + h->header_bytes + idx * h->frame_bytes, jpeg, size);
+  e.captured_ns = captured_ns;
+  e.size = size;
+  e.frame_no = frame_no;
+  e.seq.store(seq, std::memory_order_release);
+  h->write_seq.store(seq, std::memory_order_release);
+}
+
+} // namespace ccu
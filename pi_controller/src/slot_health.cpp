@@ -0,0 +1,128 @@
+#include "slot_health.hpp"
+#include "async_log.hpp"
+#include "metrics.hpp"
+#include <array>
+
+namespace ccu {
+
+SlotHealth::Outcome SlotHealth::classify(bool ok, uint32_t sdk_error, uint64_t duration_us) {
+  if (duration_us > kSlowCallUs) return OUTCOME_HARD;
+  if (ok) return OUTCOME_OK;
+  switch (sdk_error & 0xFF00u) {
+    case 0x8200u: return OUTCOME_HARD;     // CrError_Connect
+    case 0x8400u: return OUTCOME_REFUSED;  // CrError_Api
+    default: return OUTCOME_FAILED;
+  }
+}
+
+SlotHealth::Admit SlotHealth::admit(uint64_t now_us) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_state == OPEN && now_us < m_open_until_us) return REJECT_OPEN;
+  if (m_in_flight > 0) return REJECT_BUSY;
+  if (m_state == OPEN) set_state(HALF_OPEN);
+  m_in_flight++;
+  return ADMIT;
+}
+
+bool SlotHealth::begin(uint64_t now_us) {
+  (void)now_us;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_in_flight > 0) return false;
+  m_in_flight++;
+  return true;
+}
+
+void SlotHealth::set_state(State s) {
+  m_state = s;
+  metrics().slot(m_slot).breaker_state.store(s, std::memory_order_relaxed);
+}
+
+void SlotHealth::trip(uint64_t now_us) {
+  // Back off harder each time a probe finds the camera still broken.
+  if (m_state == HALF_OPEN) m_backoff_us = m_backoff_us * 2 > kMaxBackoffUs ? kMaxBackoffUs : m_backoff_us * 2;
+  else m_backoff_us = kMinBackoffUs;
+  if (m_state == CLOSED) {
+    metrics().slot(m_slot).breaker_trips.fetch_add(1, std::memory_order_relaxed);
+    CCU_LOG_WARN("slot %d: circuit open, fast-failing for %llu ms", m_slot,
+                 (unsigned long long)(m_backoff_us / 1000));
+  }
+  set_state(OPEN);
+  m_open_until_us = now_us + m_backoff_us;
+  m_failures = 0;
+}
+
+void SlotHealth::finish(Outcome outcome, uint64_t now_us) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_in_flight > 0) m_in_flight--;
+  switch (outcome) {
+    case OUTCOME_OK:
+    case OUTCOME_REFUSED:
+      if (m_state != CLOSED) CCU_LOG_INFO("slot %d: circuit closed", m_slot);
+      set_state(CLOSED);
+      m_failures = 0;
+      m_backoff_us = kMinBackoffUs;
+      break;
+    case OUTCOME_FAILED:
+      if (m_state == HALF_OPEN || ++m_failures >= kTripFailures) trip(now_us);
+      break;
+    case OUTCOME_HARD:
+      trip(now_us);
+      break;
+  }
+}
+
+void SlotHealth::on_timeout(uint64_t now_us) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_state != OPEN) trip(now_us);
+}
+
+void SlotHealth::on_disconnected(uint64_t now_us) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  // A fresh outage starts at the minimum backoff; recovery normally comes
+  // through a reconnect (on_connected) rather than a probe.
+  if (m_state == CLOSED) {
+    trip(now_us);
+    return;
+  }
+  set_state(OPEN);
+  m_backoff_us = kMinBackoffUs;
+  m_open_until_us = now_us + kMinBackoffUs;
+}
+
+void SlotHealth::on_connected(uint64_t now_us) {
+  (void)now_us;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_state != CLOSED) CCU_LOG_INFO("slot %d: circuit closed (reconnected)", m_slot);
+  set_state(CLOSED);
+  m_failures = 0;
+  m_backoff_us = kMinBackoffUs;
+}
+
+bool SlotHealth::probe_due(uint64_t now_us) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_state == OPEN && now_us >= m_open_until_us && m_in_flight == 0;
+}
+
+SlotHealth::State SlotHealth::state() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_state;
+}
+
+SlotHealth& slot_health(int slot) {
+  static std::array<SlotHealth, MetricsRegistry::kSlots> slots = {
+    SlotHealth(0), SlotHealth(1), SlotHealth(2), SlotHealth(3),
+    SlotHealth(4), SlotHealth(5), SlotHealth(6), SlotHealth(7),
+  };
+  return slots[(size_t)(slot & (MetricsRegistry::kSlots - 1))];
+}
+
+const char* health_state_name(SlotHealth::State s) {
+  switch (s) {
+    case SlotHealth::CLOSED: return "closed";
+    case SlotHealth::OPEN: return "open";
+    case SlotHealth::HALF_OPEN: return "half_open";
+    default: return "?";
+  }
+}
+
+} // namespace ccu
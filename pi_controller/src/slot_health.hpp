@@ -0,0 +1,77 @@
+#pragma once
+// Per-slot circuit breaker. A camera that dropped off, keeps failing or
+// stops answering is taken out of the request path: commands to it are
+// rejected at once (fail mask) instead of waiting for the SDK to time out,
+// so an ALL-target ACK is only as slow as the healthy cameras.
+//
+//   CLOSED     normal; kTripFailures consecutive failures, a Connect-category
+//              CrError, a call slower than kSlowCallUs, a call abandoned at its
+//              deadline (SdkExecutor) or OnDisconnected trip it
+//   OPEN       every call rejected until the backoff (1 s doubling to 30 s) ends
+//   HALF_OPEN  exactly one call (a request or the connect thread's probe) is let
+//              through; success closes the breaker, failure re-opens it
+//
+// Independently, a slot with a call in flight on another thread (background
+// connect, a RUNSTOP_AT worker) is BUSY and rejected with the busy mask.
+#include <cstdint>
+#include <mutex>
+
+namespace ccu {
+
+class SlotHealth {
+public:
+  static constexpr uint32_t kTripFailures = 3;
+  static constexpr uint64_t kSlowCallUs = 5ull * 1000000ull;
+  static constexpr uint64_t kMinBackoffUs = 1000000ull;
+  static constexpr uint64_t kMaxBackoffUs = 30ull * 1000000ull;
+
+  enum State : uint8_t { CLOSED = 0, OPEN = 1, HALF_OPEN = 2 };
+  enum Admit : uint8_t { ADMIT, REJECT_OPEN, REJECT_BUSY };
+  enum Outcome : uint8_t {
+    OUTCOME_OK,
+    OUTCOME_REFUSED,   // camera answered with an Api-category error: alive, but said no
+    OUTCOME_FAILED,    // counts towards kTripFailures
+    OUTCOME_HARD,      // trips at once (link error, call timeout)
+  };
+
+  explicit SlotHealth(int slot) : m_slot(slot) {}
+
+  // Maps an operation's result, first failing CrError (0 = none) and duration.
+  static Outcome classify(bool ok, uint32_t sdk_error, uint64_t duration_us);
+
+  // On ADMIT the caller owns one in-flight call and must finish() it.
+  Admit admit(uint64_t now_us);
+  // Like admit() but ignores the breaker (the background connect thread);
+  // false only if another call is in flight.
+  bool begin(uint64_t now_us);
+  void finish(Outcome outcome, uint64_t now_us);
+  // The in-flight call missed its deadline: trip now; the call stays in
+  // flight (slot busy once the backoff ends) until the SDK returns and
+  // finish() is called for it. Live view, which never holds an in-flight
+  // call, uses it only to trip the breaker.
+  void on_timeout(uint64_t now_us);
+
+  void on_disconnected(uint64_t now_us);
+  void on_connected(uint64_t now_us);
+
+  // Open and past its backoff: the connect thread should send a probe.
+  bool probe_due(uint64_t now_us) const;
+  State state() const;
+
+private:
+  void trip(uint64_t now_us);
+  void set_state(State s);
+
+  const int m_slot;
+  mutable std::mutex m_mutex;
+  State m_state = CLOSED;
+  uint32_t m_in_flight = 0;
+  uint32_t m_failures = 0;
+  uint64_t m_open_until_us = 0;
+  uint64_t m_backoff_us = kMinBackoffUs;
+};
+
+SlotHealth& slot_health(int slot);
+const char* health_state_name(SlotHealth::State s);
+
+} // namespace ccu
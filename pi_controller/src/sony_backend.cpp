@@ -1,14 +1,28 @@
 #include "sony_backend.hpp"
 #include "CRSDK/IDeviceCallback.h"
 #include "CrDebugString.h"
+#include "async_log.hpp"
+#include "clock.hpp"
+#include "live_view.hpp"
+#include "reconnect.hpp"
+#include "slot_health.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
+#include <shared_mutex>
 #include <thread>
 #include <chrono>
 #include <string>
 #include <cctype>
+#include <cerrno>
 #include <arpa/inet.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
 
 #define MSEARCH_ENB  // Enable camera enumeration like RemoteCli
 
@@ -25,35 +39,70 @@ static const char* warning_name(CrInt32u warning) {
   }
 }
 
-struct DeviceCallbackImpl : public SCRSDK::IDeviceCallback {
+struct DeviceCallbackImpl final : public SCRSDK::IDeviceCallback {
+  DeviceCallbackImpl(int slot, std::atomic<bool>* connected) : slot(slot), connected(connected) {}
+  const int slot;  // daemon slot of the owning backend, -1 if unassigned
+  std::atomic<bool>* const connected;  // the owning backend's m_connected
+  // Set before the backend tears down this callback's session itself, so
+  // the OnDisconnected that follows is not taken for a drop of the next one.
+  std::atomic<bool> retired{false};
+
   // Inherited via IDeviceCallback - log events for debugging
   virtual void OnConnected(SCRSDK::DeviceConnectionVersioin version) override {
-    std::printf("[DeviceCallback] OnConnected(version=%d)\n", (int)version);
+    ccu::trace::Span span("callback", "OnConnected", slot, (int64_t)version);
+    ccu::flight::record_callback(slot, "OnConnected", (uint32_t)version);
+    if (slot >= 0) ccu::slot_health(slot).on_connected(ccu::monotonic_ns() / 1000);
+    CCU_LOG_INFO("[DeviceCallback] OnConnected(version=%d)", (int)version);
   }
   virtual void OnDisconnected(CrInt32u error) override {
-    std::printf("[DeviceCallback] OnDisconnected(error=0x%08X)\n", (unsigned)error);
+    ccu::trace::Span span("callback", "OnDisconnected", slot, error);
+    ccu::flight::record_callback(slot, "OnDisconnected", (uint32_t)error);
+    if (retired.load(std::memory_order_acquire)) {
+      CCU_LOG_DEBUG("[DeviceCallback] OnDisconnected(error=0x%08X) for a released session", (unsigned)error);
+      return;
+    }
+    connected->store(false, std::memory_order_release);
+    // Fast-fail commands to this slot from now on instead of letting them
+    // wait for the SDK to time out, and reconnect right away.
+    if (slot >= 0) {
+      ccu::slot_health(slot).on_disconnected(ccu::monotonic_ns() / 1000);
+      ccu::reconnect_signal().kick((uint8_t)(1u << slot));
+    }
+    CCU_LOG_WARN("[DeviceCallback] OnDisconnected(error=0x%08X)", (unsigned)error);
   }
-  virtual void OnPropertyChanged() override { std::printf("[DeviceCallback] OnPropertyChanged\n"); }
-  virtual void OnLvPropertyChanged() override { std::printf("[DeviceCallback] OnLvPropertyChanged\n"); }
-  virtual void OnCompleteDownload(CrChar* filename, CrInt32u type) override { std::printf("[DeviceCallback] OnCompleteDownload(filename=%s,type=%u)\n", filename ? filename : "(null)", (unsigned)type); }
+  virtual void OnPropertyChanged() override { CCU_LOG_DEBUG("[DeviceCallback] OnPropertyChanged"); }
+  virtual void OnLvPropertyChanged() override { CCU_LOG_DEBUG("[DeviceCallback] OnLvPropertyChanged"); }
+  virtual void OnCompleteDownload(CrChar* filename, CrInt32u type) override { CCU_LOG_DEBUG("[DeviceCallback] OnCompleteDownload(filename=%s,type=%u)", filename ? filename : "(null)", (unsigned)type); }
   virtual void OnWarning(CrInt32u warning) override {
-    std::printf("[DeviceCallback] OnWarning(0x%08X %s)\n", (unsigned)warning, warning_name(warning));
+    ccu::trace::Span span("callback", "OnWarning", slot, warning);
+    ccu::flight::record_callback(slot, "OnWarning", (uint32_t)warning);
+    CCU_LOG_INFO("[DeviceCallback] OnWarning(0x%08X %s)", (unsigned)warning, warning_name(warning));
   }
   virtual void OnWarningExt(CrInt32u warning, CrInt32 param1, CrInt32 param2, CrInt32 param3) override {
-    std::printf("[DeviceCallback] OnWarningExt(0x%08X %s) params=(%d,%d,%d)\n",
+    ccu::trace::Span span("callback", "OnWarningExt", slot, warning);
+    ccu::flight::record_callback(slot, "OnWarningExt", (uint32_t)warning);
+    CCU_LOG_INFO("[DeviceCallback] OnWarningExt(0x%08X %s) params=(%d,%d,%d)",
                 (unsigned)warning, warning_name(warning), (int)param1, (int)param2, (int)param3);
   }
-  virtual void OnError(CrInt32u error) override { std::printf("[DeviceCallback] OnError(0x%08X)\n", (unsigned)error); }
-  virtual void OnPropertyChangedCodes(CrInt32u num, CrInt32u* codes) override { std::printf("[DeviceCallback] OnPropertyChangedCodes(num=%u)\n", (unsigned)num); }
-  virtual void OnLvPropertyChangedCodes(CrInt32u num, CrInt32u* codes) override { std::printf("[DeviceCallback] OnLvPropertyChangedCodes(num=%u)\n", (unsigned)num); }
-  virtual void OnNotifyContentsTransfer(CrInt32u notify, SCRSDK::CrContentHandle contentHandle, CrChar* filename) override { std::printf("[DeviceCallback] OnNotifyContentsTransfer(notify=%u,filename=%s)\n", (unsigned)notify, filename ? filename : "(null)"); }
-  virtual void OnNotifyFTPTransferResult(CrInt32u notify, CrInt32u numOfSuccess, CrInt32u numOfFail) override { std::printf("[DeviceCallback] OnNotifyFTPTransferResult(%u,%u)\n", (unsigned)numOfSuccess, (unsigned)numOfFail); }
-  virtual void OnNotifyRemoteTransferResult(CrInt32u notify, CrInt32u per, CrChar* filename) override { std::printf("[DeviceCallback] OnNotifyRemoteTransferResult(notify=%u,per=%u,filename=%s)\n", (unsigned)notify, (unsigned)per, filename ? filename : "(null)"); }
-  virtual void OnNotifyRemoteTransferResult(CrInt32u notify, CrInt32u per, CrInt8u* data, CrInt64u size) override { std::printf("[DeviceCallback] OnNotifyRemoteTransferResultData(notify=%u,per=%u,size=%llu)\n", (unsigned)notify, (unsigned)per, (unsigned long long)size); }
-  virtual void OnNotifyRemoteTransferContentsListChanged(CrInt32u notify, CrInt32u slotNumber, CrInt32u addSize) override { std::printf("[DeviceCallback] OnNotifyRemoteTransferContentsListChanged(notify=%u,slot=%u,add=%u)\n", (unsigned)notify, (unsigned)slotNumber, (unsigned)addSize); }
-  virtual void OnReceivePlaybackTimeCode(CrInt32u timeCode) override { std::printf("[DeviceCallback] OnReceivePlaybackTimeCode(%u)\n", (unsigned)timeCode); }
-  virtual void OnReceivePlaybackData(CrInt8u mediaType, CrInt32 dataSize, CrInt8u* data, CrInt64 pts, CrInt64 dts, CrInt32 param1, CrInt32 param2) override { std::printf("[DeviceCallback] OnReceivePlaybackData(type=%u,size=%d)\n", (unsigned)mediaType, (int)dataSize); }
-  virtual void OnNotifyRemoteFirmwareUpdateResult(CrInt32u notify, const void* param) override { std::printf("[DeviceCallback] OnNotifyRemoteFirmwareUpdateResult(notify=%u)\n", (unsigned)notify); }
+  virtual void OnError(CrInt32u error) override {
+    ccu::trace::Span span("callback", "OnError", slot, error);
+    ccu::flight::record_callback(slot, "OnError", (uint32_t)error);
+    CCU_LOG_WARN("[DeviceCallback] OnError(0x%08X)", (unsigned)error);
+  }
+  virtual void OnPropertyChangedCodes(CrInt32u num, CrInt32u* codes) override {
+    ccu::trace::Span span("callback", "OnPropertyChangedCodes", slot, (num > 0 && codes) ? codes[0] : ccu::trace::kNone);
+    ccu::flight::record_callback(slot, "OnPropertyChangedCodes", (num > 0 && codes) ? codes[0] : 0xFFFFFFFFu);
+    CCU_LOG_DEBUG("[DeviceCallback] OnPropertyChangedCodes(num=%u)", (unsigned)num);
+  }
+  virtual void OnLvPropertyChangedCodes(CrInt32u num, CrInt32u* codes) override { CCU_LOG_DEBUG("[DeviceCallback] OnLvPropertyChangedCodes(num=%u)", (unsigned)num); }
+  virtual void OnNotifyContentsTransfer(CrInt32u notify, SCRSDK::CrContentHandle contentHandle, CrChar* filename) override { CCU_LOG_DEBUG("[DeviceCallback] OnNotifyContentsTransfer(notify=%u,filename=%s)", (unsigned)notify, filename ? filename : "(null)"); }
+  virtual void OnNotifyFTPTransferResult(CrInt32u notify, CrInt32u numOfSuccess, CrInt32u numOfFail) override { CCU_LOG_DEBUG("[DeviceCallback] OnNotifyFTPTransferResult(%u,%u)", (unsigned)numOfSuccess, (unsigned)numOfFail); }
+  virtual void OnNotifyRemoteTransferResult(CrInt32u notify, CrInt32u per, CrChar* filename) override { CCU_LOG_DEBUG("[DeviceCallback] OnNotifyRemoteTransferResult(notify=%u,per=%u,filename=%s)", (unsigned)notify, (unsigned)per, filename ? filename : "(null)"); }
+  virtual void OnNotifyRemoteTransferResult(CrInt32u notify, CrInt32u per, CrInt8u* data, CrInt64u size) override { CCU_LOG_DEBUG("[DeviceCallback] OnNotifyRemoteTransferResultData(notify=%u,per=%u,size=%llu)", (unsigned)notify, (unsigned)per, (unsigned long long)size); }
+  virtual void OnNotifyRemoteTransferContentsListChanged(CrInt32u notify, CrInt32u slotNumber, CrInt32u addSize) override { CCU_LOG_DEBUG("[DeviceCallback] OnNotifyRemoteTransferContentsListChanged(notify=%u,slot=%u,add=%u)", (unsigned)notify, (unsigned)slotNumber, (unsigned)addSize); }
+  virtual void OnReceivePlaybackTimeCode(CrInt32u timeCode) override { CCU_LOG_DEBUG("[DeviceCallback] OnReceivePlaybackTimeCode(%u)", (unsigned)timeCode); }
+  virtual void OnReceivePlaybackData(CrInt8u mediaType, CrInt32 dataSize, CrInt8u* data, CrInt64 pts, CrInt64 dts, CrInt32 param1, CrInt32 param2) override { CCU_LOG_DEBUG("[DeviceCallback] OnReceivePlaybackData(type=%u,size=%d)", (unsigned)mediaType, (int)dataSize); }
+  virtual void OnNotifyRemoteFirmwareUpdateResult(CrInt32u notify, const void* param) override { CCU_LOG_DEBUG("[DeviceCallback] OnNotifyRemoteFirmwareUpdateResult(notify=%u)", (unsigned)notify); }
 };
 } // anonymous namespace
 
@@ -80,6 +129,32 @@ static const char* crerror_category(SCRSDK::CrError err) {
 //   3) If API returns InvalidCalled (0x8402), fallback through toggle commands
 // Do not alter command ordering/semantics without re-validating on hardware.
 static constexpr const char* kA74FrozenModel = "ILCE-7M4";
+
+// Settle delays and retry backoff show up as their own spans in SDK traces.
+static void traced_sleep_ms(int ms) {
+  ccu::trace::Span span("wait", "sleep", ccu::trace::kInheritSlot, ms);
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// Sleeps until an absolute CLOCK_MONOTONIC time; returns at once if it has passed.
+static void wait_until_ns(uint64_t t_ns) {
+  ccu::trace::Span span("wait", "timer");
+  timespec ts{};
+  ts.tv_sec = (time_t)(t_ns / 1000000000ull);
+  ts.tv_nsec = (long)(t_ns % 1000000000ull);
+  const int fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+  if (fd < 0) {
+    while (::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+    return;
+  }
+  itimerspec its{};
+  its.it_value = ts;
+  if (::timerfd_settime(fd, TFD_TIMER_ABSTIME, &its, nullptr) == 0) {
+    uint64_t expirations = 0;
+    while (::read(fd, &expirations, sizeof(expirations)) < 0 && errno == EINTR) {}
+  }
+  ::close(fd);
+}
 static constexpr SCRSDK::CrError kA74InvalidCalled = SCRSDK::CrError_Api_InvalidCalled;
 
 static std::string normalize_fingerprint(const char* data, CrInt32u len) {
@@ -122,6 +197,7 @@ static bool read_recording_flags(SCRSDK::CrDeviceHandle device_handle,
                                  uint32_t& recording_state,
                                  uint32_t& recorder_main_status,
                                  bool& is_recording) {
+  ccu::trace::Span span("backend", "read_recording_flags");
   recording_state = 0xFFFFFFFFu;
   recorder_main_status = 0xFFFFFFFFu;
   is_recording = false;
@@ -133,9 +209,9 @@ static bool read_recording_flags(SCRSDK::CrDeviceHandle device_handle,
     SCRSDK::CrDeviceProperty_RecorderMainStatus
   };
 
-  const auto err = SCRSDK::GetSelectDeviceProperties(device_handle, 2, codes, &props, &num_props);
+  const auto err = CCU_TRACE_SDK(GetSelectDeviceProperties, ccu::trace::kNone, device_handle, 2, codes, &props, &num_props);
   if (CR_FAILED(err) || !props || num_props <= 0) {
-    if (props) SCRSDK::ReleaseDeviceProperties(device_handle, props);
+    if (props) CCU_TRACE_SDK(ReleaseDeviceProperties, ccu::trace::kNone, device_handle, props);
     return false;
   }
 
@@ -150,7 +226,7 @@ static bool read_recording_flags(SCRSDK::CrDeviceHandle device_handle,
     }
   }
 
-  SCRSDK::ReleaseDeviceProperties(device_handle, props);
+  CCU_TRACE_SDK(ReleaseDeviceProperties, ccu::trace::kNone, device_handle, props);
 
   const bool rec_state_known = (recording_state != 0xFFFFFFFFu);
   const bool rec_main_known = (recorder_main_status != 0xFFFFFFFFu);
@@ -161,23 +237,38 @@ static bool read_recording_flags(SCRSDK::CrDeviceHandle device_handle,
   return true;
 }
 
+// One property's current value, e.g. FocusIndication while S1 is held.
+static bool read_current_value(SCRSDK::CrDeviceHandle device_handle, CrInt32u code, uint32_t& out) {
+  SCRSDK::CrDeviceProperty* props = nullptr;
+  CrInt32 num_props = 0;
+  const auto err = CCU_TRACE_SDK(GetSelectDeviceProperties, code, device_handle, 1, &code, &props, &num_props);
+  if (CR_FAILED(err) || !props || num_props <= 0) {
+    if (props) CCU_TRACE_SDK(ReleaseDeviceProperties, ccu::trace::kNone, device_handle, props);
+    return false;
+  }
+  const bool ok = get_prop_first_value(props[0], out);
+  CCU_TRACE_SDK(ReleaseDeviceProperties, ccu::trace::kNone, device_handle, props);
+  return ok;
+}
+
 static void try_prepare_recording_mode(SCRSDK::CrDeviceHandle device_handle) {
+  ccu::trace::Span span("backend", "try_prepare_recording_mode");
   // Best-effort: some bodies reject MovieRecord until PC Remote priority/mode
   // is asserted.
   SCRSDK::CrDeviceProperty priority;
   priority.SetCode(SCRSDK::CrDevicePropertyCode::CrDeviceProperty_PriorityKeySettings);
   priority.SetCurrentValue(SCRSDK::CrPriorityKeySettings::CrPriorityKey_PCRemote);
   priority.SetValueType(SCRSDK::CrDataType::CrDataType_UInt32Array);
-  auto st_priority = SCRSDK::SetDeviceProperty(device_handle, &priority);
-  std::printf("[SonyBackend] prepare_recording: PriorityKeySettings=PCRemote st=0x%08X\n",
+  auto st_priority = CCU_TRACE_SDK(SetDeviceProperty, priority.GetCode(), device_handle, &priority);
+  CCU_LOG_INFO("[SonyBackend] prepare_recording: PriorityKeySettings=PCRemote st=0x%08X",
               (unsigned)st_priority);
 
   SCRSDK::CrDeviceProperty exp_mode;
   exp_mode.SetCode(SCRSDK::CrDevicePropertyCode::CrDeviceProperty_ExposureProgramMode);
   exp_mode.SetCurrentValue(SCRSDK::CrExposureProgram::CrExposure_Movie_P);
   exp_mode.SetValueType(SCRSDK::CrDataType::CrDataType_UInt16Array);
-  auto st_exp = SCRSDK::SetDeviceProperty(device_handle, &exp_mode);
-  std::printf("[SonyBackend] prepare_recording: ExposureProgramMode=Movie_P st=0x%08X\n",
+  auto st_exp = CCU_TRACE_SDK(SetDeviceProperty, exp_mode.GetCode(), device_handle, &exp_mode);
+  CCU_LOG_INFO("[SonyBackend] prepare_recording: ExposureProgramMode=Movie_P st=0x%08X",
               (unsigned)st_exp);
 }
 
@@ -190,15 +281,15 @@ static bool connect_camera(SCRSDK::ICrCameraObjectInfo* cam,
                            SCRSDK::CrDeviceHandle* out_handle) {
   if (!out_handle) return false;
   *out_handle = 0;
-  auto err = SCRSDK::Connect(cam, cb, out_handle,
+  auto err = CCU_TRACE_SDK(Connect, ccu::trace::kNone, cam, cb, out_handle,
                              SCRSDK::CrSdkControlMode_Remote,
                              SCRSDK::CrReconnecting_ON,
                              user, pass, fingerprint, fp_size);
   if (!CR_FAILED(err) && *out_handle != 0) {
-    std::printf("[SonyBackend] Connect succeeded (handle=%lld)\n", (long long)*out_handle);
+    CCU_LOG_INFO("[SonyBackend] Connect succeeded (handle=%lld)", (long long)*out_handle);
     return true;
   }
-  std::printf("[SonyBackend] Connect failed (0x%08X) category=%s\n",
+  CCU_LOG_WARN("[SonyBackend] Connect failed (0x%08X) category=%s",
               (unsigned)err, crerror_category(err));
   return false;
 }
@@ -223,10 +314,22 @@ static const char* select_fingerprint(const char* env_fp,
 
 namespace ccu {
 
+bool ensure_sdk_init() {
+  static std::mutex mutex;
+  static bool inited = false;
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!inited) {
+    inited = CCU_TRACE_SDK(Init, ccu::trace::kNone);
+    CCU_LOG_INFO("[SonyBackend] Init() returned: %d", inited ? 1 : 0);
+  }
+  return inited;
+}
+
 SonyBackend::~SonyBackend() {
+  std::unique_lock<std::shared_mutex> session(m_session_mutex);
   if (m_device_handle != 0) {
-    SCRSDK::Disconnect(m_device_handle);
-    SCRSDK::ReleaseDevice(m_device_handle);
+    CCU_TRACE_SDK(Disconnect, ccu::trace::kNone, m_device_handle);
+    CCU_TRACE_SDK(ReleaseDevice, ccu::trace::kNone, m_device_handle);
     m_device_handle = 0;
   }
   if (m_callback_impl) {
@@ -235,23 +338,46 @@ SonyBackend::~SonyBackend() {
   }
 }
 
+void SonyBackend::adopt_session(SCRSDK::CrDeviceHandle h) {
+  std::unique_lock<std::shared_mutex> session(m_session_mutex);
+  m_device_handle = h;
+  m_connected = true;
+}
+
+void SonyBackend::release_session() {
+  // The old session's callback object is retired first, so the
+  // OnDisconnected that Disconnect triggers is not taken for a drop, and
+  // freed once ReleaseDevice returns: the SDK delivers nothing for the
+  // device after that. The next connect gets a fresh one.
+  auto* cb = static_cast<DeviceCallbackImpl*>(m_callback_impl);
+  m_callback_impl = nullptr;
+  if (cb) cb->retired.store(true, std::memory_order_release);
+  {
+    std::unique_lock<std::shared_mutex> session(m_session_mutex);
+    CCU_TRACE_SDK(Disconnect, ccu::trace::kNone, m_device_handle);
+    CCU_TRACE_SDK(ReleaseDevice, ccu::trace::kNone, m_device_handle);
+    m_device_handle = 0;
+  }
+  delete cb;
+}
+
 bool SonyBackend::connect_first_camera() {
-  std::printf("[SonyBackend] connect_first_camera() called (is_connected=%d)\n", is_connected() ? 1 : 0);
+  CCU_LOG_INFO("[SonyBackend] connect_first_camera() called (is_connected=%d)", is_connected() ? 1 : 0);
   if (is_connected()) return true;
+  // A session the camera dropped still holds its device handle.
+  if (m_device_handle != 0) {
+    CCU_LOG_INFO("[SonyBackend] Releasing dropped session before reconnecting");
+    release_session();
+  }
 
   // 1) Init once - match RemoteCli exactly (no parameters)
-  if (!m_inited) {
-    const bool ok = SCRSDK::Init();
-    std::printf("[SonyBackend] Init() returned: %d\n", ok ? 1 : 0);
-    if (!ok) return false;
-    m_inited = true;
-  }
+  if (!ensure_sdk_init()) return false;
 
   const char* dbg_ip = std::getenv("SONY_CAMERA_IP");
   const char* dbg_accept = std::getenv("SONY_ACCEPT_FINGERPRINT");
   const char* dbg_pass = std::getenv("SONY_PASS");
   const char* dbg_user = std::getenv("SONY_USER");
-  std::printf("[SonyBackend] Env SONY_CAMERA_IP=%s SONY_ACCEPT_FINGERPRINT=%s SONY_PASS=%s SONY_USER=%s\n",
+  CCU_LOG_INFO("[SonyBackend] Env SONY_CAMERA_IP=%s SONY_ACCEPT_FINGERPRINT=%s SONY_PASS=%s SONY_USER=%s",
              dbg_ip ? dbg_ip : "(unset)",
              dbg_accept ? dbg_accept : "(unset)",
              dbg_pass ? "(set)" : "(unset)",
@@ -260,13 +386,13 @@ bool SonyBackend::connect_first_camera() {
   // If the user provided SONY_CAMERA_IP, try direct IP connection first (deterministic path)
   const char* cam_ip_env = std::getenv("SONY_CAMERA_IP");
   if (cam_ip_env && cam_ip_env[0]) {
-    std::printf("[SonyBackend] Attempting direct IP camera info via SONY_CAMERA_IP=%s\n", cam_ip_env);
+    CCU_LOG_INFO("[SonyBackend] Attempting direct IP camera info via SONY_CAMERA_IP=%s", cam_ip_env);
     // Parse IP using inet_pton and convert to CRSDK-packed value
     in_addr ina;
     if (inet_pton(AF_INET, cam_ip_env, &ina) == 1) {
       SCRSDK::ICrCameraObjectInfo* pCam = nullptr;
       CrInt32u ipAddr = (CrInt32u)ntohl(ina.s_addr); // CRSDK expects first octet in bits 7..0
-      std::printf("[SonyBackend] CreateCameraObjectInfoEthernetConnection(model=CrCameraDeviceModel_ILME_FX6 ip=%s numeric=%u)...\n", cam_ip_env, (unsigned)ipAddr);
+      CCU_LOG_INFO("[SonyBackend] CreateCameraObjectInfoEthernetConnection(model=CrCameraDeviceModel_ILME_FX6 ip=%s numeric=%u)...", cam_ip_env, (unsigned)ipAddr);
       CrInt8u macBuf[6] = {0};
       // Try to obtain MAC from env (SONY_CAMERA_MAC) or ARP table for the IP
       const char* env_mac = std::getenv("SONY_CAMERA_MAC");
@@ -274,7 +400,7 @@ bool SonyBackend::connect_first_camera() {
         unsigned int ma[6] = {0};
         if (std::sscanf(env_mac, "%x:%x:%x:%x:%x:%x", &ma[0], &ma[1], &ma[2], &ma[3], &ma[4], &ma[5]) == 6) {
           for (int i = 0; i < 6; ++i) macBuf[i] = (CrInt8u)(ma[i] & 0xFF);
-          std::printf("[SonyBackend] Using SONY_CAMERA_MAC=%s\n", env_mac);
+          CCU_LOG_INFO("[SonyBackend] Using SONY_CAMERA_MAC=%s", env_mac);
         }
       } else {
         // try to populate ARP entry then 'ip neigh show <ip>' to get MAC
@@ -291,33 +417,33 @@ bool SonyBackend::connect_first_camera() {
             // Typical output: "192.168.33.94 dev eth0 lladdr ac:80:0a:39:29:84 STALE"
             if (std::sscanf(buf, "%*s dev %*s lladdr %x:%x:%x:%x:%x:%x", &ma[0], &ma[1], &ma[2], &ma[3], &ma[4], &ma[5]) == 6) {
               for (int i = 0; i < 6; ++i) macBuf[i] = (CrInt8u)(ma[i] & 0xFF);
-              std::printf("[SonyBackend] Found MAC via 'ip neigh': %02X:%02X:%02X:%02X:%02X:%02X\n", macBuf[0], macBuf[1], macBuf[2], macBuf[3], macBuf[4], macBuf[5]);
+              CCU_LOG_INFO("[SonyBackend] Found MAC via 'ip neigh': %02X:%02X:%02X:%02X:%02X:%02X", macBuf[0], macBuf[1], macBuf[2], macBuf[3], macBuf[4], macBuf[5]);
             }
           }
           pclose(f);
         }
       }
 
-      auto err = SCRSDK::CreateCameraObjectInfoEthernetConnection(&pCam, SCRSDK::CrCameraDeviceModelList::CrCameraDeviceModel_MPC_2610, ipAddr, macBuf, 1);
+      auto err = CCU_TRACE_SDK(CreateCameraObjectInfoEthernetConnection, ccu::trace::kNone, &pCam, SCRSDK::CrCameraDeviceModelList::CrCameraDeviceModel_MPC_2610, ipAddr, macBuf, 1);
       if (!CR_FAILED(err) && pCam) {
-        std::printf("[SonyBackend] Created camera object for IP %s\n", cam_ip_env);
+        CCU_LOG_INFO("[SonyBackend] Created camera object for IP %s", cam_ip_env);
         SCRSDK::ICrCameraObjectInfo* camInfo = pCam;
 
         // Fingerprint
         char fingerprint[4096] = {0};
         CrInt32u fpSize = (CrInt32u)sizeof(fingerprint);
-        SCRSDK::CrError fpSt = SCRSDK::GetFingerprint(camInfo, fingerprint, &fpSize);
+        SCRSDK::CrError fpSt = CCU_TRACE_SDK(GetFingerprint, ccu::trace::kNone, camInfo, fingerprint, &fpSize);
         std::string fp_norm;
         if (CR_FAILED(fpSt) || fpSize == 0) {
-          std::printf("[SonyBackend] GetFingerprint failed (0x%08X)\n", (unsigned)fpSt);
+          CCU_LOG_WARN("[SonyBackend] GetFingerprint failed (0x%08X)", (unsigned)fpSt);
           fpSize = 0; // still attempt connect
         } else {
           fp_norm = normalize_fingerprint(fingerprint, fpSize);
-          std::printf("[SonyBackend] Fingerprint OK (size=%u padded=%u)\n", (unsigned)fpSize, (unsigned)fp_norm.size());
-          std::printf("[SonyBackend] fingerprint (padded):\n%s\n", fp_norm.c_str());
+          CCU_LOG_INFO("[SonyBackend] Fingerprint OK (size=%u padded=%u)", (unsigned)fpSize, (unsigned)fp_norm.size());
+          CCU_LOG_INFO("[SonyBackend] fingerprint (padded):\n%s", fp_norm.c_str());
           const char* accept_fp = std::getenv("SONY_ACCEPT_FINGERPRINT");
           if (!(accept_fp && accept_fp[0] && accept_fp[0] == '1')) {
-            std::printf("[SonyBackend] Fingerprint requires acceptance. Set SONY_ACCEPT_FINGERPRINT=1 to auto-accept and connect.\n");
+            CCU_LOG_WARN("[SonyBackend] Fingerprint requires acceptance. Set SONY_ACCEPT_FINGERPRINT=1 to auto-accept and connect.");
             pCam->Release();
             return false;
           }
@@ -326,12 +452,12 @@ bool SonyBackend::connect_first_camera() {
         // Credentials: only password is required (match RemoteCli)
         const char* pass = std::getenv("SONY_PASS");
         if (!pass || !pass[0]) {
-          std::printf("[SonyBackend] Missing SONY_PASS env var\n");
+          CCU_LOG_WARN("[SonyBackend] Missing SONY_PASS env var");
           pCam->Release();
           return false;
         }
 
-        if (!m_callback_impl) m_callback_impl = static_cast<void*>(new DeviceCallbackImpl());
+        if (!m_callback_impl) m_callback_impl = static_cast<void*>(new DeviceCallbackImpl(m_slot, &m_connected));
         auto* cb = static_cast<SCRSDK::IDeviceCallback*>(m_callback_impl);
         const char* user = std::getenv("SONY_USER");
         if (!user || !user[0]) user = nullptr;
@@ -343,9 +469,9 @@ bool SonyBackend::connect_first_camera() {
         if (accept_fp && accept_fp[0] == '1') {
           fp_ptr = select_fingerprint(env_fp, env_fp_len, fingerprint, fpSize, &fp_len);
           if (env_fp && env_fp[0]) {
-            std::printf("[SonyBackend] Using fingerprint from SONY_FINGERPRINT (len=%u)\n", (unsigned)fp_len);
+            CCU_LOG_INFO("[SonyBackend] Using fingerprint from SONY_FINGERPRINT (len=%u)", (unsigned)fp_len);
           } else if (fp_ptr && fp_len > 0) {
-            std::printf("[SonyBackend] Using fingerprint from GetFingerprint (len=%u)\n", (unsigned)fp_len);
+            CCU_LOG_INFO("[SonyBackend] Using fingerprint from GetFingerprint (len=%u)", (unsigned)fp_len);
           }
         }
 
@@ -354,54 +480,53 @@ bool SonyBackend::connect_first_camera() {
         for (int attempt = 1; attempt <= max_attempts; ++attempt) {
           SCRSDK::CrDeviceHandle h = 0;
           if (connect_camera(camInfo, cb, user, pass, fp_ptr, fp_len, &h)) {
-            m_device_handle = h;
-            m_connected = true;
-            std::printf("[SonyBackend] Connect succeeded on attempt %d\n", attempt);
+            adopt_session(h);
+            CCU_LOG_INFO("[SonyBackend] Connect succeeded on attempt %d", attempt);
             cd_connected = true;
             break;
           }
-          std::printf("[SonyBackend] Connect attempt %d/%d failed\n", attempt, max_attempts);
-          if (attempt < max_attempts) std::this_thread::sleep_for(std::chrono::seconds(1 << (attempt-1)));
+          CCU_LOG_WARN("[SonyBackend] Connect attempt %d/%d failed", attempt, max_attempts);
+          if (attempt < max_attempts) traced_sleep_ms(1000 << (attempt - 1));
         }
 
         pCam->Release();
         if (cd_connected) {
-          std::printf("[SonyBackend] Connected via direct CRSDK Connect!\n");
+          CCU_LOG_INFO("[SonyBackend] Connected via direct CRSDK Connect!");
           return true;
         } else {
-          std::printf("[SonyBackend] Connect failed after %d attempts\n", max_attempts);
+          CCU_LOG_WARN("[SonyBackend] Connect failed after %d attempts", max_attempts);
           // fallthrough to enumeration
         }
       } else {
-        std::printf("[SonyBackend] CreateCameraObjectInfoEthernetConnection failed (0x%08X) category=%s\n", (unsigned)err, crerror_category(err));
+        CCU_LOG_WARN("[SonyBackend] CreateCameraObjectInfoEthernetConnection failed (0x%08X) category=%s", (unsigned)err, crerror_category(err));
 
         // Try byte-order fallback: some SDKs expect host order for the IP integer
         CrInt32u ipHostOrder = (CrInt32u)ntohl(ina.s_addr);
         if (ipHostOrder != ipAddr) {
-          std::printf("[SonyBackend] Trying CreateCameraObjectInfoEthernetConnection with IP host-order numeric=%u\n", (unsigned)ipHostOrder);
+          CCU_LOG_INFO("[SonyBackend] Trying CreateCameraObjectInfoEthernetConnection with IP host-order numeric=%u", (unsigned)ipHostOrder);
           SCRSDK::ICrCameraObjectInfo* pCam1b = nullptr;
           // For host-order attempt, reuse macBuf if populated, else zero
           CrInt8u macBuf1b[6] = {0};
-          auto err1b = SCRSDK::CreateCameraObjectInfoEthernetConnection(&pCam1b, SCRSDK::CrCameraDeviceModelList::CrCameraDeviceModel_ILME_FX6, ipHostOrder, macBuf1b, 1);
+          auto err1b = CCU_TRACE_SDK(CreateCameraObjectInfoEthernetConnection, ccu::trace::kNone, &pCam1b, SCRSDK::CrCameraDeviceModelList::CrCameraDeviceModel_ILME_FX6, ipHostOrder, macBuf1b, 1);
           if (!CR_FAILED(err1b) && pCam1b) {
-            std::printf("[SonyBackend] Created camera object for IP %s using host-order numeric=%u\n", cam_ip_env, (unsigned)ipHostOrder);
+            CCU_LOG_INFO("[SonyBackend] Created camera object for IP %s using host-order numeric=%u", cam_ip_env, (unsigned)ipHostOrder);
             // proceed as normal (reuse the pCam path) by swapping pCam to pCam1b
             SCRSDK::ICrCameraObjectInfo* camInfo = pCam1b;
             // fingerprint
             char fingerprint[4096] = {0};
             CrInt32u fpSize = (CrInt32u)sizeof(fingerprint);
-            SCRSDK::CrError fpSt = SCRSDK::GetFingerprint(camInfo, fingerprint, &fpSize);
+            SCRSDK::CrError fpSt = CCU_TRACE_SDK(GetFingerprint, ccu::trace::kNone, camInfo, fingerprint, &fpSize);
             if (CR_FAILED(fpSt) || fpSize == 0) {
-              std::printf("[SonyBackend] GetFingerprint failed (0x%08X)\n", (unsigned)fpSt);
+              CCU_LOG_WARN("[SonyBackend] GetFingerprint failed (0x%08X)", (unsigned)fpSt);
               fpSize = 0; // still attempt connect
             } else {
               if (fpSize < sizeof(fingerprint)) fingerprint[fpSize] = '\0';
               fingerprint[sizeof(fingerprint)-1] = '\0';
-              std::printf("[SonyBackend] Fingerprint OK (size=%u)\n", (unsigned)fpSize);
-              std::printf("[SonyBackend] fingerprint:\n%s\n", fingerprint);
+              CCU_LOG_INFO("[SonyBackend] Fingerprint OK (size=%u)", (unsigned)fpSize);
+              CCU_LOG_INFO("[SonyBackend] fingerprint:\n%s", fingerprint);
               const char* accept_fp = std::getenv("SONY_ACCEPT_FINGERPRINT");
               if (!(accept_fp && accept_fp[0] && accept_fp[0] == '1')) {
-                std::printf("[SonyBackend] Fingerprint requires acceptance. Set SONY_ACCEPT_FINGERPRINT=1 to auto-accept and connect.\n");
+                CCU_LOG_WARN("[SonyBackend] Fingerprint requires acceptance. Set SONY_ACCEPT_FINGERPRINT=1 to auto-accept and connect.");
                 pCam1b->Release();
                 return false;
               }
@@ -410,13 +535,13 @@ bool SonyBackend::connect_first_camera() {
             const char* user = std::getenv("SONY_USER");
             const char* pass = std::getenv("SONY_PASS");
             if (!pass || !pass[0]) {
-              std::printf("[SonyBackend] Missing SONY_PASS env var\n");
+              CCU_LOG_WARN("[SonyBackend] Missing SONY_PASS env var");
               pCam1b->Release();
               return false;
             }
             if (!user || !user[0]) user = nullptr; // match RemoteCli: no username, only password
 
-            if (!m_callback_impl) m_callback_impl = static_cast<void*>(new DeviceCallbackImpl());
+            if (!m_callback_impl) m_callback_impl = static_cast<void*>(new DeviceCallbackImpl(m_slot, &m_connected));
             auto* cb = static_cast<SCRSDK::IDeviceCallback*>(m_callback_impl);
             const char* accept_fp_env = std::getenv("SONY_ACCEPT_FINGERPRINT");
             const char* env_fp = std::getenv("SONY_FINGERPRINT");
@@ -426,9 +551,9 @@ bool SonyBackend::connect_first_camera() {
             if (accept_fp_env && accept_fp_env[0] == '1') {
               fp_ptr = select_fingerprint(env_fp, env_fp_len, fingerprint, fpSize, &fp_len);
               if (env_fp && env_fp[0]) {
-                std::printf("[SonyBackend] Using fingerprint from SONY_FINGERPRINT (len=%u)\n", (unsigned)fp_len);
+                CCU_LOG_INFO("[SonyBackend] Using fingerprint from SONY_FINGERPRINT (len=%u)", (unsigned)fp_len);
               } else if (fp_ptr && fp_len > 0) {
-                std::printf("[SonyBackend] Using fingerprint from GetFingerprint (len=%u)\n", (unsigned)fp_len);
+                CCU_LOG_INFO("[SonyBackend] Using fingerprint from GetFingerprint (len=%u)", (unsigned)fp_len);
               }
             }
 
@@ -437,51 +562,50 @@ bool SonyBackend::connect_first_camera() {
             for (int attempt = 1; attempt <= max_attempts_host; ++attempt) {
               SCRSDK::CrDeviceHandle h = 0;
               if (connect_camera(camInfo, cb, user, pass, fp_ptr, fp_len, &h)) {
-                m_device_handle = h;
-                m_connected = true;
-                std::printf("[SonyBackend] Connect succeeded on attempt %d\n", attempt);
+                adopt_session(h);
+                CCU_LOG_INFO("[SonyBackend] Connect succeeded on attempt %d", attempt);
                 cd_connected_host = true;
                 break;
               }
-              std::printf("[SonyBackend] Connect attempt %d/%d failed\n", attempt, max_attempts_host);
-              if (attempt < max_attempts_host) std::this_thread::sleep_for(std::chrono::seconds(1 << (attempt-1)));
+              CCU_LOG_WARN("[SonyBackend] Connect attempt %d/%d failed", attempt, max_attempts_host);
+              if (attempt < max_attempts_host) traced_sleep_ms(1000 << (attempt - 1));
             }
 
             pCam1b->Release();
             if (cd_connected_host) {
-              std::printf("[SonyBackend] Connected via direct CRSDK Connect (host-order IP)!\n");
+              CCU_LOG_INFO("[SonyBackend] Connected via direct CRSDK Connect (host-order IP)!");
               return true;
             } else {
-              std::printf("[SonyBackend] Connect (host-order IP) failed after %d attempts\n", max_attempts_host);
+              CCU_LOG_WARN("[SonyBackend] Connect (host-order IP) failed after %d attempts", max_attempts_host);
               // fallthrough to earlier fallbacks
             }
           } else {
-            std::printf("[SonyBackend] CreateCameraObjectInfoEthernetConnection with host-order IP failed (0x%08X) category=%s\n", (unsigned)err1b, crerror_category(err1b));
+            CCU_LOG_WARN("[SonyBackend] CreateCameraObjectInfoEthernetConnection with host-order IP failed (0x%08X) category=%s", (unsigned)err1b, crerror_category(err1b));
           }
         }
 
-        std::printf("[SonyBackend] Trying fallback CreateCameraObjectInfoEthernetConnection with model=0 (unknown)...\n");
+        CCU_LOG_INFO("[SonyBackend] Trying fallback CreateCameraObjectInfoEthernetConnection with model=0 (unknown)...");
         SCRSDK::ICrCameraObjectInfo* pCam2 = nullptr;
         CrInt8u macBuf2[6] = {0};
-        auto err2 = SCRSDK::CreateCameraObjectInfoEthernetConnection(&pCam2, (SCRSDK::CrCameraDeviceModelList)0, ipAddr, macBuf2, 1);
+        auto err2 = CCU_TRACE_SDK(CreateCameraObjectInfoEthernetConnection, ccu::trace::kNone, &pCam2, (SCRSDK::CrCameraDeviceModelList)0, ipAddr, macBuf2, 1);
         if (!CR_FAILED(err2) && pCam2) {
-          std::printf("[SonyBackend] Fallback created camera object for IP %s (model=0)\n", cam_ip_env);
+          CCU_LOG_INFO("[SonyBackend] Fallback created camera object for IP %s (model=0)", cam_ip_env);
 
           // fingerprint (fallback)
           char fingerprint2[4096] = {0};
           CrInt32u fpSize2 = (CrInt32u)sizeof(fingerprint2);
-          SCRSDK::CrError fpSt2 = SCRSDK::GetFingerprint(pCam2, fingerprint2, &fpSize2);
+          SCRSDK::CrError fpSt2 = CCU_TRACE_SDK(GetFingerprint, ccu::trace::kNone, pCam2, fingerprint2, &fpSize2);
           if (CR_FAILED(fpSt2) || fpSize2 == 0) {
-            std::printf("[SonyBackend] GetFingerprint(fallback) failed (0x%08X)\n", (unsigned)fpSt2);
+            CCU_LOG_WARN("[SonyBackend] GetFingerprint(fallback) failed (0x%08X)", (unsigned)fpSt2);
             fpSize2 = 0;
           } else {
             if (fpSize2 < sizeof(fingerprint2)) fingerprint2[fpSize2] = '\0';
             fingerprint2[sizeof(fingerprint2)-1] = '\0';
-            std::printf("[SonyBackend] Fingerprint OK (size=%u)\n", (unsigned)fpSize2);
-            std::printf("[SonyBackend] fingerprint:\n%s\n", fingerprint2);
+            CCU_LOG_INFO("[SonyBackend] Fingerprint OK (size=%u)", (unsigned)fpSize2);
+            CCU_LOG_INFO("[SonyBackend] fingerprint:\n%s", fingerprint2);
             const char* accept_fp2 = std::getenv("SONY_ACCEPT_FINGERPRINT");
             if (!(accept_fp2 && accept_fp2[0] && accept_fp2[0] == '1')) {
-              std::printf("[SonyBackend] Fingerprint requires acceptance. Set SONY_ACCEPT_FINGERPRINT=1 to auto-accept and connect.\n");
+              CCU_LOG_WARN("[SonyBackend] Fingerprint requires acceptance. Set SONY_ACCEPT_FINGERPRINT=1 to auto-accept and connect.");
               pCam2->Release();
               return false;
             }
@@ -490,13 +614,13 @@ bool SonyBackend::connect_first_camera() {
           const char* user2 = std::getenv("SONY_USER");
           const char* pass2 = std::getenv("SONY_PASS");
           if (!pass2 || !pass2[0]) {
-            std::printf("[SonyBackend] Missing SONY_PASS env var\n");
+            CCU_LOG_WARN("[SonyBackend] Missing SONY_PASS env var");
             pCam2->Release();
             return false;
           }
           if (!user2 || !user2[0]) user2 = nullptr;
 
-          if (!m_callback_impl) m_callback_impl = static_cast<void*>(new DeviceCallbackImpl());
+          if (!m_callback_impl) m_callback_impl = static_cast<void*>(new DeviceCallbackImpl(m_slot, &m_connected));
           auto* cb = static_cast<SCRSDK::IDeviceCallback*>(m_callback_impl);
           const char* user2_env = std::getenv("SONY_USER");
           if (!user2_env || !user2_env[0]) user2_env = nullptr;
@@ -508,9 +632,9 @@ bool SonyBackend::connect_first_camera() {
           if (accept_fp2 && accept_fp2[0] == '1') {
             fp_ptr2 = select_fingerprint(env_fp, env_fp_len, fingerprint2, fpSize2, &fp_len2);
             if (env_fp && env_fp[0]) {
-              std::printf("[SonyBackend] Using fingerprint from SONY_FINGERPRINT (len=%u)\n", (unsigned)fp_len2);
+              CCU_LOG_INFO("[SonyBackend] Using fingerprint from SONY_FINGERPRINT (len=%u)", (unsigned)fp_len2);
             } else if (fp_ptr2 && fp_len2 > 0) {
-              std::printf("[SonyBackend] Using fingerprint from GetFingerprint (len=%u)\n", (unsigned)fp_len2);
+              CCU_LOG_INFO("[SonyBackend] Using fingerprint from GetFingerprint (len=%u)", (unsigned)fp_len2);
             }
           }
 
@@ -519,58 +643,57 @@ bool SonyBackend::connect_first_camera() {
           for (int attempt2 = 1; attempt2 <= max_connect_attempts_ip2; ++attempt2) {
             SCRSDK::CrDeviceHandle h = 0;
             if (connect_camera(pCam2, cb, user2_env, pass2, fp_ptr2, fp_len2, &h)) {
-              m_device_handle = h;
-              m_connected = true;
-              std::printf("[SonyBackend] Connect (fallback) succeeded on attempt %d\n", attempt2);
+              adopt_session(h);
+              CCU_LOG_INFO("[SonyBackend] Connect (fallback) succeeded on attempt %d", attempt2);
               cd_connected_fb = true;
               break;
             }
-            std::printf("[SonyBackend] Connect (fallback) attempt %d/%d failed\n", attempt2, max_connect_attempts_ip2);
-            if (attempt2 < max_connect_attempts_ip2) std::this_thread::sleep_for(std::chrono::seconds(1 << (attempt2-1)));
+            CCU_LOG_WARN("[SonyBackend] Connect (fallback) attempt %d/%d failed", attempt2, max_connect_attempts_ip2);
+            if (attempt2 < max_connect_attempts_ip2) traced_sleep_ms(1000 << (attempt2 - 1));
           }
 
           pCam2->Release();
           if (cd_connected_fb) {
-            std::printf("[SonyBackend] Connected via direct CRSDK Connect (fallback)!\n");
+            CCU_LOG_INFO("[SonyBackend] Connected via direct CRSDK Connect (fallback)!");
             return true;
           } else {
-            std::printf("[SonyBackend] Connect (fallback) failed after %d attempts\n", max_connect_attempts_ip2);
+            CCU_LOG_WARN("[SonyBackend] Connect (fallback) failed after %d attempts", max_connect_attempts_ip2);
             // fallthrough to enumeration
           }
         } else {
-          std::printf("[SonyBackend] Fallback CreateCameraObjectInfoEthernetConnection failed (0x%08X) category=%s\n", (unsigned)err2, crerror_category(err2));
+          CCU_LOG_WARN("[SonyBackend] Fallback CreateCameraObjectInfoEthernetConnection failed (0x%08X) category=%s", (unsigned)err2, crerror_category(err2));
 
-          std::printf("[SonyBackend] Scanning model enum values for CreateCameraObjectInfoEthernetConnection successes...\n");
+          CCU_LOG_INFO("[SonyBackend] Scanning model enum values for CreateCameraObjectInfoEthernetConnection successes...");
           for (int cand = 1; cand <= 32; ++cand) {
             SCRSDK::ICrCameraObjectInfo* pCamC = nullptr;
             CrInt8u macBufC[6] = {0};
-            auto errC = SCRSDK::CreateCameraObjectInfoEthernetConnection(&pCamC, (SCRSDK::CrCameraDeviceModelList)cand, ipAddr, macBufC, 1);
+            auto errC = CCU_TRACE_SDK(CreateCameraObjectInfoEthernetConnection, ccu::trace::kNone, &pCamC, (SCRSDK::CrCameraDeviceModelList)cand, ipAddr, macBufC, 1);
             if (!CR_FAILED(errC) && pCamC) {
-              std::printf("[SonyBackend] Candidate model %d succeeded to create camera object (err=0x%08X).\n", cand, (unsigned)errC);
+              CCU_LOG_INFO("[SonyBackend] Candidate model %d succeeded to create camera object (err=0x%08X).", cand, (unsigned)errC);
 
               // Try fingerprint + connect immediately for this candidate
               char fingerprintC[4096] = {0};
               CrInt32u fpSizeC = (CrInt32u)sizeof(fingerprintC);
-              SCRSDK::CrError fpStC = SCRSDK::GetFingerprint(pCamC, fingerprintC, &fpSizeC);
+              SCRSDK::CrError fpStC = CCU_TRACE_SDK(GetFingerprint, ccu::trace::kNone, pCamC, fingerprintC, &fpSizeC);
               if (CR_FAILED(fpStC) || fpSizeC == 0) {
-                std::printf("[SonyBackend] Candidate model %d GetFingerprint failed (0x%08X)\n", cand, (unsigned)fpStC);
+                CCU_LOG_WARN("[SonyBackend] Candidate model %d GetFingerprint failed (0x%08X)", cand, (unsigned)fpStC);
                 fpSizeC = 0;
               } else {
                 if (fpSizeC < sizeof(fingerprintC)) fingerprintC[fpSizeC] = '\0';
                 fingerprintC[sizeof(fingerprintC)-1] = '\0';
-                std::printf("[SonyBackend] Candidate model %d fingerprint size=%u\n", cand, (unsigned)fpSizeC);
+                CCU_LOG_INFO("[SonyBackend] Candidate model %d fingerprint size=%u", cand, (unsigned)fpSizeC);
               }
 
               const char* userC = std::getenv("SONY_USER");
               const char* passC = std::getenv("SONY_PASS");
               if (!passC || !passC[0]) {
-                std::printf("[SonyBackend] Missing SONY_PASS env var\n");
+                CCU_LOG_WARN("[SonyBackend] Missing SONY_PASS env var");
                 pCamC->Release();
                 return false;
               }
               if (!userC || !userC[0]) userC = nullptr;
 
-              if (!m_callback_impl) m_callback_impl = static_cast<void*>(new DeviceCallbackImpl());
+              if (!m_callback_impl) m_callback_impl = static_cast<void*>(new DeviceCallbackImpl(m_slot, &m_connected));
               auto* cb = static_cast<SCRSDK::IDeviceCallback*>(m_callback_impl);
               const char* userC_env = std::getenv("SONY_USER");
               if (!userC_env || !userC_env[0]) userC_env = nullptr;
@@ -582,96 +705,94 @@ bool SonyBackend::connect_first_camera() {
               if (accept_fpC && accept_fpC[0] == '1') {
                 fp_ptrC = select_fingerprint(env_fp, env_fp_len, fingerprintC, fpSizeC, &fp_lenC);
                 if (env_fp && env_fp[0]) {
-                  std::printf("[SonyBackend] Using fingerprint from SONY_FINGERPRINT (len=%u)\n", (unsigned)fp_lenC);
+                  CCU_LOG_INFO("[SonyBackend] Using fingerprint from SONY_FINGERPRINT (len=%u)", (unsigned)fp_lenC);
                 } else if (fp_ptrC && fp_lenC > 0) {
-                  std::printf("[SonyBackend] Using fingerprint from GetFingerprint (len=%u)\n", (unsigned)fp_lenC);
+                  CCU_LOG_INFO("[SonyBackend] Using fingerprint from GetFingerprint (len=%u)", (unsigned)fp_lenC);
                 }
               }
 
               SCRSDK::CrDeviceHandle h = 0;
               if (connect_camera(pCamC, cb, userC_env, passC, fp_ptrC, fp_lenC, &h)) {
-                m_device_handle = h;
-                std::printf("[SonyBackend] Candidate model %d Connect succeeded via direct CRSDK Connect!\n", cand);
-                m_connected = true;
+                adopt_session(h);
+                CCU_LOG_INFO("[SonyBackend] Candidate model %d Connect succeeded via direct CRSDK Connect!", cand);
                 pCamC->Release();
                 return true;
               }
-              std::printf("[SonyBackend] Candidate model %d Connect failed via direct CRSDK Connect\n", cand);
+              CCU_LOG_WARN("[SonyBackend] Candidate model %d Connect failed via direct CRSDK Connect", cand);
 
               pCamC->Release();
             } else {
               /* creation failed */
-              //std::printf("[SonyBackend] Candidate model %d failed to create (0x%08X)\n", cand, (unsigned)errC);
+              //CCU_LOG_WARN("[SonyBackend] Candidate model %d failed to create (0x%08X)", cand, (unsigned)errC);
             }
           }
-          std::printf("[SonyBackend] Model scan complete, no candidate succeeded.\n");
+          CCU_LOG_WARN("[SonyBackend] Model scan complete, no candidate succeeded.");
 
           // Diagnostic: try a non-SSH direct connect (sshSupport=0) to see if non-SSH connects
           {
-            std::printf("[SonyBackend] Attempting non-SSH direct connect (sshSupport=0) as diagnostic...\n");
+            CCU_LOG_INFO("[SonyBackend] Attempting non-SSH direct connect (sshSupport=0) as diagnostic...");
             SCRSDK::ICrCameraObjectInfo* pCam_no_ssh = nullptr;
             CrInt8u macBufNoSsh[6] = {0};
-            auto err_no_ssh = SCRSDK::CreateCameraObjectInfoEthernetConnection(&pCam_no_ssh, (SCRSDK::CrCameraDeviceModelList)0, ipAddr, macBufNoSsh, 0);
+            auto err_no_ssh = CCU_TRACE_SDK(CreateCameraObjectInfoEthernetConnection, ccu::trace::kNone, &pCam_no_ssh, (SCRSDK::CrCameraDeviceModelList)0, ipAddr, macBufNoSsh, 0);
             if (!CR_FAILED(err_no_ssh) && pCam_no_ssh) {
-              std::printf("[SonyBackend] Created non-SSH camera object (model=0) for IP %s\n", cam_ip_env);
+              CCU_LOG_INFO("[SonyBackend] Created non-SSH camera object (model=0) for IP %s", cam_ip_env);
 
               // Use a lightweight callback for diagnostic if not present
-              if (!m_callback_impl) m_callback_impl = static_cast<void*>(new DeviceCallbackImpl());
+              if (!m_callback_impl) m_callback_impl = static_cast<void*>(new DeviceCallbackImpl(m_slot, &m_connected));
 
               // Attempt Connect without fingerprint/password
               SCRSDK::CrDeviceHandle h = 0;
-              SCRSDK::CrError st_no_ssh = SCRSDK::Connect(pCam_no_ssh, static_cast<SCRSDK::IDeviceCallback*>(m_callback_impl), &h, SCRSDK::CrSdkControlMode_Remote, SCRSDK::CrReconnecting_ON, nullptr, nullptr, nullptr, 0);
+              SCRSDK::CrError st_no_ssh = CCU_TRACE_SDK(Connect, ccu::trace::kNone, pCam_no_ssh, static_cast<SCRSDK::IDeviceCallback*>(m_callback_impl), &h, SCRSDK::CrSdkControlMode_Remote, SCRSDK::CrReconnecting_ON, nullptr, nullptr, nullptr, 0);
               if (!CR_FAILED(st_no_ssh) && h != 0) {
-                std::printf("[SonyBackend] Non-SSH Connect succeeded!\n");
-                m_device_handle = h;
-                m_connected = true;
+                CCU_LOG_INFO("[SonyBackend] Non-SSH Connect succeeded!");
+                adopt_session(h);
                 pCam_no_ssh->Release();
                 return true;
               } else {
-                std::printf("[SonyBackend] Non-SSH Connect failed (0x%08X) category=%s\n", (unsigned)st_no_ssh, crerror_category(st_no_ssh));
+                CCU_LOG_WARN("[SonyBackend] Non-SSH Connect failed (0x%08X) category=%s", (unsigned)st_no_ssh, crerror_category(st_no_ssh));
               }
               pCam_no_ssh->Release();
             } else {
-              std::printf("[SonyBackend] CreateCameraObjectInfoEthernetConnection (non-SSH) failed (0x%08X) category=%s\n", (unsigned)err_no_ssh, crerror_category(err_no_ssh));
+              CCU_LOG_WARN("[SonyBackend] CreateCameraObjectInfoEthernetConnection (non-SSH) failed (0x%08X) category=%s", (unsigned)err_no_ssh, crerror_category(err_no_ssh));
             }
           }
         }
       }
     } else {
-      std::printf("[SonyBackend] SONY_CAMERA_IP invalid format: %s\n", cam_ip_env);
+      CCU_LOG_WARN("[SonyBackend] SONY_CAMERA_IP invalid format: %s", cam_ip_env);
     }
   }
 
   // 2) Enumerate with retry/backoff - match RemoteCli (no timeout)
   SCRSDK::ICrEnumCameraObjectInfo* enumInfo = nullptr;
-  std::printf("[SonyBackend] EnumCameraObjects...\n");
+  CCU_LOG_INFO("[SonyBackend] EnumCameraObjects...");
   const int max_attempts = 5;
   SCRSDK::CrError st = 0; /* initialize to OK */
   for (int attempt = 1; attempt <= max_attempts; ++attempt) {
     // Match RemoteCli exactly: no timeout parameter
-    st = SCRSDK::EnumCameraObjects(&enumInfo);
+    st = CCU_TRACE_SDK(EnumCameraObjects, ccu::trace::kNone, &enumInfo);
     if (!CR_FAILED(st) && enumInfo) break;
-    std::printf("[SonyBackend] EnumCameraObjects failed (0x%08X) attempt %d/%d\n", (unsigned)st, attempt, max_attempts);
+    CCU_LOG_WARN("[SonyBackend] EnumCameraObjects failed (0x%08X) attempt %d/%d", (unsigned)st, attempt, max_attempts);
     if (attempt < max_attempts) {
       // show local interfaces to aid debugging
       system("ip -brief addr 2>/dev/null || ip addr 2>/dev/null || echo 'ip command not available'");
-      std::this_thread::sleep_for(std::chrono::seconds(1 << (attempt-1)));
+      traced_sleep_ms(1000 << (attempt - 1));
     }
   }
   if (CR_FAILED(st) || !enumInfo) {
-    std::printf("[SonyBackend] EnumCameraObjects failed after %d attempts (0x%08X)\n", max_attempts, (unsigned)st);
+    CCU_LOG_WARN("[SonyBackend] EnumCameraObjects failed after %d attempts (0x%08X)", max_attempts, (unsigned)st);
 
     return false;
   }
 
   const CrInt32u n = enumInfo->GetCount();
   if (n == 0) {
-    std::printf("[SonyBackend] No cameras found\n");
+    CCU_LOG_WARN("[SonyBackend] No cameras found");
     enumInfo->Release();
     return false;
   }
 
-  std::printf("[SonyBackend] Enumerated %u camera(s):\n", (unsigned)n);
+  CCU_LOG_INFO("[SonyBackend] Enumerated %u camera(s):", (unsigned)n);
 
   // Selection: prefer SONY_CAMERA_INDEX (1-based) or SONY_CAMERA_MAC (MAC string), else default to first
   int selectedIndex = -1;
@@ -697,7 +818,7 @@ bool SonyBackend::connect_first_camera() {
     // GetMACAddressChar exists for IP-connected devices in sample
     mac = reinterpret_cast<const char*>(info->GetMACAddressChar());
 
-    std::printf("[%u] model=%s conn=%s id=%s mac=%s adaptor=%s\n",
+    CCU_LOG_INFO("[%u] model=%s conn=%s id=%s mac=%s adaptor=%s",
                 (unsigned)(i + 1), model ? model : "", conn ? conn : "", idstr.c_str(), mac ? mac : "", info->GetAdaptorName());
 
     if (selectedIndex == -1 && env_index && env_index[0]) {
@@ -717,21 +838,25 @@ bool SonyBackend::connect_first_camera() {
 
   if (selectedIndex == -1) {
     if (env_index || env_mac) {
-      std::printf("[SonyBackend] SONY_CAMERA_INDEX/MAC specified but no match found. Defaulting to first camera.\n");
+      CCU_LOG_INFO("[SonyBackend] SONY_CAMERA_INDEX/MAC specified but no match found. Defaulting to first camera.");
     }
     selectedIndex = 0; // default to first
   }
 
   const SCRSDK::ICrCameraObjectInfo* camInfoConst = enumInfo->GetCameraObjectInfo((CrInt32u)selectedIndex);
   if (!camInfoConst) {
-    std::printf("[SonyBackend] Failed to get camera info index %d\n", selectedIndex);
+    CCU_LOG_WARN("[SonyBackend] Failed to get camera info index %d", selectedIndex);
     enumInfo->Release();
     return false;
   }
 
   m_camera_model = camInfoConst->GetModel() ? camInfoConst->GetModel() : "";
   m_connection_type = camInfoConst->GetConnectionTypeName() ? camInfoConst->GetConnectionTypeName() : "";
-  std::printf("[SonyBackend] Selected camera model=%s conn=%s\n",
+  m_camera_id.clear();
+  if (const CrInt8u* id = camInfoConst->GetId()) {
+    m_camera_id.assign(reinterpret_cast<const char*>(id), strnlen(reinterpret_cast<const char*>(id), camInfoConst->GetIdSize()));
+  }
+  CCU_LOG_INFO("[SonyBackend] Selected camera model=%s conn=%s",
               m_camera_model.c_str(), m_connection_type.c_str());
 
   const bool is_usb = (m_connection_type == "USB");
@@ -748,21 +873,21 @@ bool SonyBackend::connect_first_camera() {
 
   if (!is_usb) {
     fpSize = (CrInt32u)sizeof(fingerprint);
-    SCRSDK::CrError fpSt = SCRSDK::GetFingerprint(camInfo, fingerprint, &fpSize);
+    SCRSDK::CrError fpSt = CCU_TRACE_SDK(GetFingerprint, ccu::trace::kNone, camInfo, fingerprint, &fpSize);
 
     std::string fp_norm;
     if (CR_FAILED(fpSt) || fpSize == 0) {
-      std::printf("[SonyBackend] GetFingerprint failed (0x%08X)\n", (unsigned)fpSt);
+      CCU_LOG_WARN("[SonyBackend] GetFingerprint failed (0x%08X)", (unsigned)fpSt);
       fpSize = 0; // still attempt connect
     } else {
       fp_norm = normalize_fingerprint(fingerprint, fpSize);
 
-      std::printf("[SonyBackend] Fingerprint OK (size=%u padded=%u)\n", (unsigned)fpSize, (unsigned)fp_norm.size());
-      std::printf("[SonyBackend] fingerprint (padded):\n%s\n", fp_norm.c_str());
+      CCU_LOG_INFO("[SonyBackend] Fingerprint OK (size=%u padded=%u)", (unsigned)fpSize, (unsigned)fp_norm.size());
+      CCU_LOG_INFO("[SonyBackend] fingerprint (padded):\n%s", fp_norm.c_str());
 
       const char* accept_fp = std::getenv("SONY_ACCEPT_FINGERPRINT");
       if (!(accept_fp && accept_fp[0] && accept_fp[0] == '1')) {
-        std::printf("[SonyBackend] Fingerprint requires acceptance. Set SONY_ACCEPT_FINGERPRINT=1 to auto-accept and connect.\n");
+        CCU_LOG_WARN("[SonyBackend] Fingerprint requires acceptance. Set SONY_ACCEPT_FINGERPRINT=1 to auto-accept and connect.");
         enumInfo->Release();
         return false;
       }
@@ -773,19 +898,19 @@ bool SonyBackend::connect_first_camera() {
     pass = std::getenv("SONY_PASS");
 
     if (!pass || !pass[0]) {
-      std::printf("[SonyBackend] Missing SONY_PASS env var\n");
+      CCU_LOG_WARN("[SonyBackend] Missing SONY_PASS env var");
       enumInfo->Release();
       return false;
     }
     if (!user || !user[0]) user = nullptr;
   } else {
-    std::printf("[SonyBackend] USB connection: skipping fingerprint and password\n");
+    CCU_LOG_INFO("[SonyBackend] USB connection: skipping fingerprint and password");
   }
 
   // 5) Connect (Remote Control Mode) with retries + backoff using direct CRSDK Connect
-  std::printf("[SonyBackend] Connect (Remote Control Mode) via direct CRSDK Connect...\n");
+  CCU_LOG_INFO("[SonyBackend] Connect (Remote Control Mode) via direct CRSDK Connect...");
 
-  if (!m_callback_impl) m_callback_impl = static_cast<void*>(new DeviceCallbackImpl());
+  if (!m_callback_impl) m_callback_impl = static_cast<void*>(new DeviceCallbackImpl(m_slot, &m_connected));
   auto* cb = static_cast<SCRSDK::IDeviceCallback*>(m_callback_impl);
   const char* accept_fp = std::getenv("SONY_ACCEPT_FINGERPRINT");
   const char* env_fp = std::getenv("SONY_FINGERPRINT");
@@ -795,9 +920,9 @@ bool SonyBackend::connect_first_camera() {
   if (!is_usb && accept_fp && accept_fp[0] == '1') {
     fp_ptr = select_fingerprint(env_fp, env_fp_len, fingerprint, fpSize, &fp_len);
     if (env_fp && env_fp[0]) {
-      std::printf("[SonyBackend] Using fingerprint from SONY_FINGERPRINT (len=%u)\n", (unsigned)fp_len);
+      CCU_LOG_INFO("[SonyBackend] Using fingerprint from SONY_FINGERPRINT (len=%u)", (unsigned)fp_len);
     } else if (fp_ptr && fp_len > 0) {
-      std::printf("[SonyBackend] Using fingerprint from GetFingerprint (len=%u)\n", (unsigned)fp_len);
+      CCU_LOG_INFO("[SonyBackend] Using fingerprint from GetFingerprint (len=%u)", (unsigned)fp_len);
     }
   }
 
@@ -806,30 +931,40 @@ bool SonyBackend::connect_first_camera() {
   for (int attempt = 1; attempt <= max_connect_attempts; ++attempt) {
     SCRSDK::CrDeviceHandle h = 0;
     if (connect_camera(camInfo, cb, user, pass, fp_ptr, fp_len, &h)) {
-      m_device_handle = h;
-      m_connected = true;
-      std::printf("[SonyBackend] Connect succeeded on attempt %d\n", attempt);
+      adopt_session(h);
+      CCU_LOG_INFO("[SonyBackend] Connect succeeded on attempt %d", attempt);
       cd_connected = true;
       break;
     }
-    std::printf("[SonyBackend] Connect attempt %d/%d failed\n", attempt, max_connect_attempts);
-    if (attempt < max_connect_attempts) std::this_thread::sleep_for(std::chrono::seconds(1 << (attempt - 1)));
+    CCU_LOG_WARN("[SonyBackend] Connect attempt %d/%d failed", attempt, max_connect_attempts);
+    if (attempt < max_connect_attempts) traced_sleep_ms(1000 << (attempt - 1));
   }
 
   enumInfo->Release();
 
   if (!cd_connected) {
-    std::printf("[SonyBackend] Connect failed after %d attempts\n", max_connect_attempts);
+    CCU_LOG_WARN("[SonyBackend] Connect failed after %d attempts", max_connect_attempts);
     return false;
   }
 
-  std::printf("[SonyBackend] Connected!\n");
+  CCU_LOG_INFO("[SonyBackend] Connected!");
   return true;
 }
 
-bool SonyBackend::set_runstop(bool run) {
+bool SonyBackend::set_runstop(bool run, uint64_t fire_at_ns, uint64_t* issued_ns) {
+  if (issued_ns) *issued_ns = 0;
+  // Everything before this is pre-arm work; it runs right before the first record command.
+  auto fire_point = [&]() {
+    if (fire_at_ns) wait_until_ns(fire_at_ns);
+  };
+  // issued_ns is when the first record command the camera accepted returned
+  // from the SDK, so it includes the call's own round trip.
+  auto stamp_issued = [&](SCRSDK::CrError st) {
+    if (issued_ns && *issued_ns == 0 && CR_SUCCEEDED(st)) *issued_ns = monotonic_ns();
+  };
+
   if (!is_connected()) {
-    std::printf("[SonyBackend] set_runstop(%d): not connected\n", run ? 1 : 0);
+    CCU_LOG_WARN("[SonyBackend] set_runstop(%d): not connected", run ? 1 : 0);
     return false;
   }
 
@@ -842,19 +977,21 @@ bool SonyBackend::set_runstop(bool run) {
     uint32_t rec_main = 0xFFFFFFFFu;
     bool is_recording = false;
     if (read_recording_flags(m_device_handle, rec_state, rec_main, is_recording) && is_recording == run) {
-      std::printf("[SonyBackend] set_runstop(%d): already target state (rec_state=0x%08X rec_main=0x%08X)\n",
+      CCU_LOG_INFO("[SonyBackend] set_runstop(%d): already target state (rec_state=0x%08X rec_main=0x%08X)",
                   run ? 1 : 0, (unsigned)rec_state, (unsigned)rec_main);
       return true;
     }
 
     try_prepare_recording_mode(m_device_handle);
     // A74 expects direct button semantics: Down=start, Up=stop.
-    std::this_thread::sleep_for(std::chrono::milliseconds(120));
-    auto st = SCRSDK::SendCommand(
+    traced_sleep_ms(120);
+    fire_point();
+    auto st = CCU_TRACE_SDK(SendCommand, SCRSDK::CrCommandId::CrCommandId_MovieRecord,
         m_device_handle,
         SCRSDK::CrCommandId::CrCommandId_MovieRecord,
         movie_param);
-    std::printf("[SonyBackend] set_runstop(%d): A74 MovieRecord param=%s st=0x%08X\n",
+    stamp_issued(st);
+    CCU_LOG_INFO("[SonyBackend] set_runstop(%d): A74 MovieRecord param=%s st=0x%08X",
                 run ? 1 : 0,
                 run ? "Down(start)" : "Up(stop)",
                 (unsigned)st);
@@ -865,17 +1002,19 @@ bool SonyBackend::set_runstop(bool run) {
       enable_prop.SetCode(SCRSDK::CrDevicePropertyCode::CrDeviceProperty_MovieRecButtonToggleEnableStatus);
       enable_prop.SetValueType(SCRSDK::CrDataType_UInt8);
       enable_prop.SetCurrentValue(SCRSDK::CrMovieRecButtonToggle_Enable);
-      auto st_enable = SCRSDK::SetDeviceProperty(m_device_handle, &enable_prop);
-      std::printf("[SonyBackend] set_runstop(%d): enable toggle st=0x%08X\n",
+      auto st_enable = CCU_TRACE_SDK(SetDeviceProperty, enable_prop.GetCode(), m_device_handle, &enable_prop);
+      CCU_LOG_INFO("[SonyBackend] set_runstop(%d): enable toggle st=0x%08X",
                   run ? 1 : 0, (unsigned)st_enable);
 
       auto send_toggle = [&](SCRSDK::CrCommandId cmd_id, const char* label) {
-        auto st_down = SCRSDK::SendCommand(
+        auto st_down = CCU_TRACE_SDK(SendCommand, cmd_id,
             m_device_handle, cmd_id, SCRSDK::CrCommandParam::CrCommandParam_Down);
-        std::this_thread::sleep_for(std::chrono::milliseconds(120));
-        auto st_up = SCRSDK::SendCommand(
+        stamp_issued(st_down);
+        traced_sleep_ms(120);
+        auto st_up = CCU_TRACE_SDK(SendCommand, cmd_id,
             m_device_handle, cmd_id, SCRSDK::CrCommandParam::CrCommandParam_Up);
-        std::printf("[SonyBackend] set_runstop(%d): %s down=0x%08X up=0x%08X\n",
+        stamp_issued(st_up);
+        CCU_LOG_INFO("[SonyBackend] set_runstop(%d): %s down=0x%08X up=0x%08X",
                     run ? 1 : 0, label, (unsigned)st_down, (unsigned)st_up);
         return (!CR_FAILED(st_down) || !CR_FAILED(st_up));
       };
@@ -888,7 +1027,7 @@ bool SonyBackend::set_runstop(bool run) {
       if (!any_ok) {
         const char* allow_invalid = std::getenv("SONY_ALLOW_INVALID_CALLED");
         if (allow_invalid && allow_invalid[0] == '1' && st == kA74InvalidCalled) {
-          std::printf("[SonyBackend] set_runstop(%d): treating MovieRecord 0x8402 as success (SONY_ALLOW_INVALID_CALLED=1)\n",
+          CCU_LOG_INFO("[SonyBackend] set_runstop(%d): treating MovieRecord 0x8402 as success (SONY_ALLOW_INVALID_CALLED=1)",
                       run ? 1 : 0);
           any_ok = true;
         }
@@ -896,12 +1035,12 @@ bool SonyBackend::set_runstop(bool run) {
       if (!any_ok) return false;
     }
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    traced_sleep_ms(250);
     if (read_recording_flags(m_device_handle, rec_state, rec_main, is_recording)) {
-      std::printf("[SonyBackend] set_runstop(%d): post-cmd rec_state=0x%08X rec_main=0x%08X is_recording=%d\n",
+      CCU_LOG_INFO("[SonyBackend] set_runstop(%d): post-cmd rec_state=0x%08X rec_main=0x%08X is_recording=%d",
                   run ? 1 : 0, (unsigned)rec_state, (unsigned)rec_main, is_recording ? 1 : 0);
     } else {
-      std::printf("[SonyBackend] set_runstop(%d): post-cmd recording flags unavailable\n", run ? 1 : 0);
+      CCU_LOG_INFO("[SonyBackend] set_runstop(%d): post-cmd recording flags unavailable", run ? 1 : 0);
     }
     return true;
   }
@@ -911,10 +1050,12 @@ bool SonyBackend::set_runstop(bool run) {
   const SCRSDK::CrCommandParam movie_param = run ? start_param : stop_param;
 
   auto send_toggle = [&](SCRSDK::CrCommandId cmd_id) {
-    auto st_down = SCRSDK::SendCommand(m_device_handle, cmd_id, SCRSDK::CrCommandParam::CrCommandParam_Down);
-    std::this_thread::sleep_for(std::chrono::milliseconds(150));
-    auto st_up = SCRSDK::SendCommand(m_device_handle, cmd_id, SCRSDK::CrCommandParam::CrCommandParam_Up);
-    std::printf("[SonyBackend] set_runstop(%d): %s down=0x%08X up=0x%08X\n",
+    auto st_down = CCU_TRACE_SDK(SendCommand, cmd_id, m_device_handle, cmd_id, SCRSDK::CrCommandParam::CrCommandParam_Down);
+    stamp_issued(st_down);
+    traced_sleep_ms(150);
+    auto st_up = CCU_TRACE_SDK(SendCommand, cmd_id, m_device_handle, cmd_id, SCRSDK::CrCommandParam::CrCommandParam_Up);
+    stamp_issued(st_up);
+    CCU_LOG_INFO("[SonyBackend] set_runstop(%d): %s down=0x%08X up=0x%08X",
                 run ? 1 : 0,
                 (cmd_id == SCRSDK::CrCommandId::CrCommandId_MovieRecButtonToggle) ? "Toggle" : "Toggle2",
                 (unsigned)st_down,
@@ -922,30 +1063,32 @@ bool SonyBackend::set_runstop(bool run) {
     return std::pair<SCRSDK::CrError, SCRSDK::CrError>(st_down, st_up);
   };
 
+  fire_point();
   auto toggle_result = send_toggle(SCRSDK::CrCommandId::CrCommandId_MovieRecButtonToggle);
   if (CR_SUCCEEDED(toggle_result.first) || CR_SUCCEEDED(toggle_result.second)) {
-    std::printf("[SonyBackend] set_runstop(%d): OK (toggle)\n", run ? 1 : 0);
+    CCU_LOG_INFO("[SonyBackend] set_runstop(%d): OK (toggle)", run ? 1 : 0);
     return true;
   }
 
-  auto st = SCRSDK::SendCommand(
+  auto st = CCU_TRACE_SDK(SendCommand, SCRSDK::CrCommandId::CrCommandId_MovieRecord,
       m_device_handle,
       SCRSDK::CrCommandId::CrCommandId_MovieRecord,
       movie_param);
+  stamp_issued(st);
   if (CR_SUCCEEDED(st)) {
-    std::printf("[SonyBackend] set_runstop(%d): OK (movie)\n", run ? 1 : 0);
+    CCU_LOG_INFO("[SonyBackend] set_runstop(%d): OK (movie)", run ? 1 : 0);
     return true;
   }
 
   const char* allow_invalid = std::getenv("SONY_ALLOW_INVALID_CALLED");
   if (allow_invalid && allow_invalid[0] == '1' &&
       toggle_result.first == 0x8402 && toggle_result.second == 0x8402) {
-    std::printf("[SonyBackend] set_runstop(%d): treating 0x8402 as success (SONY_ALLOW_INVALID_CALLED=1)\n",
+    CCU_LOG_INFO("[SonyBackend] set_runstop(%d): treating 0x8402 as success (SONY_ALLOW_INVALID_CALLED=1)",
                 run ? 1 : 0);
     return true;
   }
 
-  std::printf("[SonyBackend] set_runstop(%d): SendCommand FAILED (toggle=0x%08X/0x%08X movie=0x%08X)\n",
+  CCU_LOG_WARN("[SonyBackend] set_runstop(%d): SendCommand FAILED (toggle=0x%08X/0x%08X movie=0x%08X)",
               run ? 1 : 0,
               (unsigned)toggle_result.first,
               (unsigned)toggle_result.second,
@@ -955,17 +1098,17 @@ bool SonyBackend::set_runstop(bool run) {
 
 bool SonyBackend::get_property_options(CrInt32u property_code, PropertyOptions& out) {
   if (!is_connected()) {
-    std::printf("[SonyBackend] get_property_options: not connected\n");
+    CCU_LOG_WARN("[SonyBackend] get_property_options: not connected");
     return false;
   }
 
   SCRSDK::CrDeviceProperty* props = nullptr;
   CrInt32 num_props = 0;
   CrInt32u code = property_code;
-  auto err = SCRSDK::GetSelectDeviceProperties(m_device_handle, 1, &code, &props, &num_props);
+  auto err = CCU_TRACE_SDK(GetSelectDeviceProperties, code, m_device_handle, 1, &code, &props, &num_props);
   if (CR_FAILED(err) || !props || num_props <= 0) {
-    std::printf("[SonyBackend] get_property_options: GetSelectDeviceProperties failed 0x%08X\n", (unsigned)err);
-    if (props) SCRSDK::ReleaseDeviceProperties(m_device_handle, props);
+    CCU_LOG_WARN("[SonyBackend] get_property_options: GetSelectDeviceProperties failed 0x%08X", (unsigned)err);
+    if (props) CCU_TRACE_SDK(ReleaseDeviceProperties, ccu::trace::kNone, m_device_handle, props);
     return false;
   }
 
@@ -993,41 +1136,41 @@ bool SonyBackend::get_property_options(CrInt32u property_code, PropertyOptions&
     }
   }
 
-  SCRSDK::ReleaseDeviceProperties(m_device_handle, props);
+  CCU_TRACE_SDK(ReleaseDeviceProperties, ccu::trace::kNone, m_device_handle, props);
   return true;
 }
 
 bool SonyBackend::set_property_value(CrInt32u property_code, uint32_t value) {
   if (!is_connected()) {
-    std::printf("[SonyBackend] set_property_value: not connected\n");
+    CCU_LOG_WARN("[SonyBackend] set_property_value: not connected");
     return false;
   }
 
   SCRSDK::CrDeviceProperty* props = nullptr;
   CrInt32 num_props = 0;
   CrInt32u code = property_code;
-  auto err = SCRSDK::GetSelectDeviceProperties(m_device_handle, 1, &code, &props, &num_props);
+  auto err = CCU_TRACE_SDK(GetSelectDeviceProperties, code, m_device_handle, 1, &code, &props, &num_props);
   if (CR_FAILED(err) || !props || num_props <= 0) {
-    std::printf("[SonyBackend] set_property_value: GetSelectDeviceProperties failed 0x%08X\n", (unsigned)err);
-    if (props) SCRSDK::ReleaseDeviceProperties(m_device_handle, props);
+    CCU_LOG_WARN("[SonyBackend] set_property_value: GetSelectDeviceProperties failed 0x%08X", (unsigned)err);
+    if (props) CCU_TRACE_SDK(ReleaseDeviceProperties, ccu::trace::kNone, m_device_handle, props);
     return false;
   }
 
   bool ok = false;
   SCRSDK::CrDeviceProperty& prop = props[0];
   if (!prop.IsSetEnableCurrentValue()) {
-    std::printf("[SonyBackend] set_property_value: property 0x%08X not settable\n", (unsigned)property_code);
+    CCU_LOG_WARN("[SonyBackend] set_property_value: property 0x%08X not settable", (unsigned)property_code);
   } else {
     prop.SetCurrentValue((CrInt64u)value);
-    auto st = SCRSDK::SetDeviceProperty(m_device_handle, &prop);
+    auto st = CCU_TRACE_SDK(SetDeviceProperty, prop.GetCode(), m_device_handle, &prop);
     if (!CR_FAILED(st)) {
       ok = true;
     } else {
-      std::printf("[SonyBackend] set_property_value: SetDeviceProperty failed 0x%08X\n", (unsigned)st);
+      CCU_LOG_WARN("[SonyBackend] set_property_value: SetDeviceProperty failed 0x%08X", (unsigned)st);
     }
   }
 
-  SCRSDK::ReleaseDeviceProperties(m_device_handle, props);
+  CCU_TRACE_SDK(ReleaseDeviceProperties, ccu::trace::kNone, m_device_handle, props);
   return ok;
 }
 
@@ -1060,17 +1203,17 @@ bool SonyBackend::step_property_value(CrInt32u property_code, int8_t step) {
 
 bool SonyBackend::get_status(Status& out) {
   if (!is_connected()) {
-    std::printf("[SonyBackend] get_status: not connected\n");
+    CCU_LOG_WARN("[SonyBackend] get_status: not connected");
     return false;
   }
 
   SCRSDK::CrDeviceProperty* props = nullptr;
   CrInt32 num_props = 0;
-  auto err = SCRSDK::GetDeviceProperties(m_device_handle, &props, &num_props);
+  auto err = CCU_TRACE_SDK(GetDeviceProperties, ccu::trace::kNone, m_device_handle, &props, &num_props);
   if (CR_FAILED(err) || !props || num_props <= 0) {
-    std::printf("[SonyBackend] get_status: GetDeviceProperties failed 0x%08X num_props=%d\n",
+    CCU_LOG_WARN("[SonyBackend] get_status: GetDeviceProperties failed 0x%08X num_props=%d",
                 (unsigned)err, (int)num_props);
-    if (props) SCRSDK::ReleaseDeviceProperties(m_device_handle, props);
+    if (props) CCU_TRACE_SDK(ReleaseDeviceProperties, ccu::trace::kNone, m_device_handle, props);
     return false;
   }
 
@@ -1105,13 +1248,13 @@ bool SonyBackend::get_status(Status& out) {
     out.recording_state = recorder_main_status;
   }
 
-  SCRSDK::ReleaseDeviceProperties(m_device_handle, props);
+  CCU_TRACE_SDK(ReleaseDeviceProperties, ccu::trace::kNone, m_device_handle, props);
   return true;
 }
 
 bool SonyBackend::capture_still(bool with_af) {
   if (!is_connected()) {
-    std::printf("[SonyBackend] capture_still: not connected\n");
+    CCU_LOG_WARN("[SonyBackend] capture_still: not connected");
     return false;
   }
 
@@ -1119,14 +1262,162 @@ bool SonyBackend::capture_still(bool with_af) {
     ? SCRSDK::CrCommandId::CrCommandId_S1andRelease
     : SCRSDK::CrCommandId::CrCommandId_Release;
 
-  auto st_down = SCRSDK::SendCommand(m_device_handle, cmd_id, SCRSDK::CrCommandParam::CrCommandParam_Down);
-  std::this_thread::sleep_for(std::chrono::milliseconds(120));
-  auto st_up = SCRSDK::SendCommand(m_device_handle, cmd_id, SCRSDK::CrCommandParam::CrCommandParam_Up);
+  auto st_down = CCU_TRACE_SDK(SendCommand, cmd_id, m_device_handle, cmd_id, SCRSDK::CrCommandParam::CrCommandParam_Down);
+  traced_sleep_ms(120);
+  auto st_up = CCU_TRACE_SDK(SendCommand, cmd_id, m_device_handle, cmd_id, SCRSDK::CrCommandParam::CrCommandParam_Up);
 
-  std::printf("[SonyBackend] capture_still(%d): cmd=%d down=0x%08X up=0x%08X\n",
+  CCU_LOG_INFO("[SonyBackend] capture_still(%d): cmd=%d down=0x%08X up=0x%08X",
               with_af ? 1 : 0, (int)cmd_id, (unsigned)st_down, (unsigned)st_up);
 
   return CR_SUCCEEDED(st_down) || CR_SUCCEEDED(st_up);
 }
 
+static SCRSDK::CrError set_s1(SCRSDK::CrDeviceHandle device_handle, bool locked) {
+  SCRSDK::CrDeviceProperty prop;
+  prop.SetCode(SCRSDK::CrDevicePropertyCode::CrDeviceProperty_S1);
+  prop.SetCurrentValue(locked ? SCRSDK::CrLockIndicator::CrLockIndicator_Locked
+                              : SCRSDK::CrLockIndicator::CrLockIndicator_Unlocked);
+  prop.SetValueType(SCRSDK::CrDataType::CrDataType_UInt16);
+  return CCU_TRACE_SDK(SetDeviceProperty, prop.GetCode(), device_handle, &prop);
+}
+
+bool SonyBackend::still_arm(bool af, uint32_t af_timeout_ms, bool* focused) {
+  if (focused) *focused = false;
+  if (!is_connected()) {
+    CCU_LOG_WARN("[SonyBackend] still_arm: not connected");
+    return false;
+  }
+
+  const auto st = set_s1(m_device_handle, true);
+  if (CR_FAILED(st)) {
+    CCU_LOG_WARN("[SonyBackend] still_arm: S1 lock failed 0x%08X", (unsigned)st);
+    return false;
+  }
+  if (!af) return true;
+
+  // AF-S reports Focused or NotFocused once it settles; AF-C keeps
+  // tracking, so its first Focused report is as good as it gets.
+  ccu::trace::Span span("backend", "still_arm_af");
+  const uint64_t deadline = monotonic_ns() + (uint64_t)af_timeout_ms * 1000000ull;
+  uint32_t fi = 0;
+  while (true) {
+    if (read_current_value(m_device_handle, SCRSDK::CrDeviceProperty_FocusIndication, fi)) {
+      if (fi == SCRSDK::CrFocusIndicator_Focused_AF_S || fi == SCRSDK::CrFocusIndicator_Focused_AF_C ||
+          fi == SCRSDK::CrFocusIndicator_TrackingSubject_AF_C) {
+        if (focused) *focused = true;
+        break;
+      }
+      if (fi == SCRSDK::CrFocusIndicator_NotFocused_AF_S) break;
+    }
+    if (monotonic_ns() >= deadline) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  CCU_LOG_INFO("[SonyBackend] still_arm: focus=0x%08X%s", (unsigned)fi,
+              (focused && *focused) ? " (locked)" : "");
+  return true;
+}
+
+bool SonyBackend::still_release(uint64_t fire_at_ns, uint64_t* issued_ns) {
+  if (issued_ns) *issued_ns = 0;
+  if (!is_connected()) {
+    CCU_LOG_WARN("[SonyBackend] still_release: not connected");
+    return false;
+  }
+
+  if (fire_at_ns) wait_until_ns(fire_at_ns);
+  // issued_ns is when the first press the camera accepted returned from the SDK.
+  const SCRSDK::CrCommandId cmd_id = SCRSDK::CrCommandId::CrCommandId_Release;
+  auto st_down = CCU_TRACE_SDK(SendCommand, cmd_id, m_device_handle, cmd_id, SCRSDK::CrCommandParam::CrCommandParam_Down);
+  if (issued_ns && CR_SUCCEEDED(st_down)) *issued_ns = monotonic_ns();
+  traced_sleep_ms(120);
+  auto st_up = CCU_TRACE_SDK(SendCommand, cmd_id, m_device_handle, cmd_id, SCRSDK::CrCommandParam::CrCommandParam_Up);
+  if (issued_ns && *issued_ns == 0 && CR_SUCCEEDED(st_up)) *issued_ns = monotonic_ns();
+  // Let go of the half-press from still_arm (harmless if it never took).
+  auto st_s1 = set_s1(m_device_handle, false);
+
+  CCU_LOG_INFO("[SonyBackend] still_release: down=0x%08X up=0x%08X s1_off=0x%08X",
+              (unsigned)st_down, (unsigned)st_up, (unsigned)st_s1);
+
+  return CR_SUCCEEDED(st_down) || CR_SUCCEEDED(st_up);
+}
+
+bool SonyBackend::still_cancel() {
+  if (!is_connected()) return false;
+  const auto st = set_s1(m_device_handle, false);
+  CCU_LOG_INFO("[SonyBackend] still_cancel: s1_off=0x%08X", (unsigned)st);
+  return CR_SUCCEEDED(st);
+}
+
+bool SonyBackend::live_view_info(uint32_t& buffer_size) {
+  buffer_size = 0;
+  std::shared_lock<std::shared_mutex> session(m_session_mutex);
+  if (!is_connected()) return false;
+  SCRSDK::CrImageInfo info;
+  const auto st = CCU_TRACE_SDK(GetLiveViewImageInfo, ccu::trace::kNone, m_device_handle, &info);
+  if (CR_FAILED(st)) return false;
+  buffer_size = info.GetBufferSize();
+  return buffer_size > 0;
+}
+
+SCRSDK::CrError SonyBackend::fetch_live_view(uint8_t* buf, uint32_t cap, uint32_t& jpeg_off, uint32_t& jpeg_size,
+                                             uint32_t& frame_no) {
+  jpeg_off = jpeg_size = frame_no = 0;
+  std::shared_lock<std::shared_mutex> session(m_session_mutex);
+  if (!is_connected()) return SCRSDK::CrError_Connect_Disconnected;
+  SCRSDK::CrImageDataBlock block;
+  block.SetSize(cap);
+  block.SetData(buf);
+  // Not traced: at live-view rate it would flush everything else out of the
+  // trace rings and the flight recorder.
+  const SCRSDK::CrError st = SCRSDK::GetLiveViewImage(m_device_handle, &block);
+  if (CR_FAILED(st)) return st;
+  const uint8_t* img = block.GetImageData();
+  if (!img || img < buf || block.GetImageSize() > cap - (uint32_t)(img - buf)) return SCRSDK::CrError_Memory_Insufficient;
+  jpeg_off = (uint32_t)(img - buf);
+  jpeg_size = block.GetImageSize();
+  frame_no = block.GetFrameNo();
+  return SCRSDK::CrError_None;
+}
+
+bool SonyBackend::live_view_focus_area(FocusArea& out) {
+  out = FocusArea{};
+  std::shared_lock<std::shared_mutex> session(m_session_mutex);
+  if (!is_connected()) return false;
+  CrInt32u code = SCRSDK::CrLiveViewProperty_AF_Area_Position;
+  SCRSDK::CrLiveViewProperty* props = nullptr;
+  CrInt32 num = 0;
+  // Not traced, like fetch_live_view: it runs a few times a second per camera.
+  const auto st = SCRSDK::GetSelectLiveViewProperties(m_device_handle, 1, &code, &props, &num);
+  if (CR_FAILED(st) || !props) return false;
+
+  // Several frames (e.g. wide-area AF): take the highest priority one, 1
+  // being the main frame; 0 means the camera gave no priority.
+  auto frac = [](uint64_t n, uint64_t den) { return (uint16_t)std::min<uint64_t>(n * 65536 / den, 0xFFFF); };
+  bool found = false;
+  uint32_t best_pri = 0x100;
+  for (CrInt32 i = 0; i < num; ++i) {
+    const SCRSDK::CrLiveViewProperty& p = props[i];
+    if (p.GetCode() != SCRSDK::CrLiveViewProperty_AF_Area_Position ||
+        p.GetFrameInfoType() != SCRSDK::CrFrameInfoType_FocusFrameInfo || !p.GetValue())
+      continue;
+    const auto* frames = reinterpret_cast<const SCRSDK::CrFocusFrameInfo*>(p.GetValue());
+    const size_t count = p.GetValueSize() / sizeof(SCRSDK::CrFocusFrameInfo);
+    for (size_t j = 0; j < count; ++j) {
+      const SCRSDK::CrFocusFrameInfo& fi = frames[j];
+      if (fi.xDenominator == 0 || fi.yDenominator == 0 || fi.width == 0 || fi.height == 0) continue;
+      const uint32_t pri = fi.priority ? fi.priority : 0xFF;
+      if (pri >= best_pri) continue;
+      best_pri = pri;
+      out.x = frac(fi.xNumerator, fi.xDenominator);
+      out.y = frac(fi.yNumerator, fi.yDenominator);
+      out.w = frac(fi.width, fi.xDenominator);
+      out.h = frac(fi.height, fi.yDenominator);
+      out.focused = fi.state == SCRSDK::CrFocusFrameState_Focused;
+      found = true;
+    }
+  }
+  SCRSDK::ReleaseLiveViewProperties(m_device_handle, props);
+  return found;
+}
+
 } // namespace ccu
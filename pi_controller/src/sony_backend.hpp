@@ -1,6 +1,8 @@
 #pragma once
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <shared_mutex>
 #include <string>
 #include <vector>
 
@@ -10,6 +12,12 @@
 #include "shared/ccu-interface/ccu_link_protocol_v1.h"
 namespace ccu {
 
+struct FocusArea;
+
+// SCRSDK::Init, once per process. Serialized so discovery and the connect
+// workers cannot race it; a failed Init is retried by the next caller.
+bool ensure_sdk_init();
+
 class SonyBackend {
 public:
   SonyBackend() = default;
@@ -19,7 +27,13 @@ public:
   bool connect_first_camera();
 
   // run=true -> record start, run=false -> record stop
-  bool set_runstop(bool run);
+  //
+  // With fire_at_ns (CLOCK_MONOTONIC) the camera is pre-armed first (state
+  // check, mode prep, settle delay) and the first record command is issued
+  // from a timerfd at that instant; issued_ns receives when the first record
+  // command the camera accepted returned from the SDK (0 if none was, or the
+  // camera was already in the requested state).
+  bool set_runstop(bool run, uint64_t fire_at_ns = 0, uint64_t* issued_ns = nullptr);
 
   struct PropertyOptions {
     SCRSDK::CrDataType value_type = SCRSDK::CrDataType_Undefined;
@@ -52,18 +66,58 @@ public:
   // Stills capture
   bool capture_still(bool with_af);
 
+  // Synchronized stills, split in two calls so every camera can be armed
+  // before any fires. still_arm half-presses the shutter (S1 lock) and, with
+  // af, waits up to af_timeout_ms for focus; focused says whether it locked.
+  // still_release fully presses the shutter at fire_at_ns (CLOCK_MONOTONIC;
+  // issued_ns receives when the camera accepted it) and then releases S1.
+  // still_cancel releases S1 for an armed camera that will not fire.
+  bool still_arm(bool af, uint32_t af_timeout_ms, bool* focused);
+  bool still_release(uint64_t fire_at_ns, uint64_t* issued_ns);
+  bool still_cancel();
+
+  // Live view (LiveViewEngine). live_view_info reports the buffer size the
+  // camera asks for; fetch_live_view fills buf and returns the CrError
+  // (CrWarning_Frame_NotUpdated when there is no new frame), with the JPEG
+  // at buf + jpeg_off. These run on the slot's live-view executor lane,
+  // concurrently with commands, and hold the session lock for the SDK call.
+  bool live_view_info(uint32_t& buffer_size);
+  SCRSDK::CrError fetch_live_view(uint8_t* buf, uint32_t cap, uint32_t& jpeg_off, uint32_t& jpeg_size,
+                                  uint32_t& frame_no);
+  // The main focus frame from the AF_Area_Position live-view property.
+  // False if the camera reports none.
+  bool live_view_focus_area(FocusArea& out);
+
   const std::string& camera_model() const { return m_camera_model; }
   const std::string& connection_type() const { return m_connection_type; }
+  // GetId() of the selected camera (the USB serial number for USB cameras).
+  const std::string& camera_id() const { return m_camera_id; }
 
-  bool is_connected() const { return m_connected && (m_device_handle != 0); }
+  // Cleared by the SDK's OnDisconnected callback (any thread).
+  bool is_connected() const { return m_connected.load(std::memory_order_acquire) && (m_device_handle != 0); }
+  // The camera is known to be gone (USB unplug) before the SDK noticed; the
+  // next connect releases the session. Safe from any thread.
+  void mark_disconnected() { m_connected.store(false, std::memory_order_release); }
+
+  // Daemon slot this backend serves; tags its SDK callbacks in traces and
+  // the flight recorder. Set before the first connect.
+  void set_slot(int slot) { m_slot = slot; }
 
 private:
-  bool     m_inited = false;
-  bool     m_connected = false;
-  SCRSDK::CrDeviceHandle m_device_handle = 0;
+  void adopt_session(SCRSDK::CrDeviceHandle h);
+  void release_session();
+
+  std::atomic<bool> m_connected{false};
+  int      m_slot = -1;
+  // Live-view calls hold m_session_mutex shared across each SDK call;
+  // installing or freeing the handle takes it exclusively, so a reconnect
+  // cannot release the device under a live-view fetch.
+  mutable std::shared_mutex m_session_mutex;
+  std::atomic<SCRSDK::CrDeviceHandle> m_device_handle{0};
 
   std::string m_camera_model;
   std::string m_connection_type;
+  std::string m_camera_id;
 
   // Opaque pointer to concrete callback implementation (managed in .cpp)
   void* m_callback_impl = nullptr;
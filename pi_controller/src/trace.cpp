@@ -0,0 +1,242 @@
+#include "trace.hpp"
+#include "clock.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace ccu {
+namespace trace {
+
+namespace {
+
+// Single-writer ring of finished spans; the dumper copies the events without
+// locking and discards entries the writer may have overwritten during the
+// copy. tid, name and live change only under Registry::mutex; gen counts
+// reuses, so a copy that raced with one is dropped.
+struct Ring {
+  static constexpr size_t kCap = 16384;
+  static constexpr size_t kMask = kCap - 1;
+
+  std::atomic<uint64_t> head{0};
+  std::atomic<uint32_t> gen{0};
+  uint32_t tid = 0;
+  char name[32] = "thread";
+  bool live = true;
+  Event events[kCap];
+};
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<Ring>> rings;
+};
+
+// Leaked on purpose: detached threads may still trace during exit.
+Registry& registry() {
+  static Registry* r = new Registry();
+  return *r;
+}
+
+// Rings of exited threads are handed to the next new thread (losing the old
+// thread's spans), so short-lived workers do not grow the registry.
+struct RingHolder {
+  std::shared_ptr<Ring> ring;
+  ~RingHolder() {
+    if (!ring) return;
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    ring->live = false;
+  }
+};
+
+Ring& thread_ring() {
+  thread_local RingHolder holder;
+  if (!holder.ring) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto& r : reg.rings) {
+      if (r->live) continue;
+      r->live = true;
+      r->gen.fetch_add(1, std::memory_order_acq_rel);
+      r->head.store(0, std::memory_order_release);
+      std::snprintf(r->name, sizeof(r->name), "%s", "thread");
+      holder.ring = r;
+      break;
+    }
+    if (!holder.ring) {
+      holder.ring = std::make_shared<Ring>();
+      reg.rings.push_back(holder.ring);
+    }
+    holder.ring->tid = (uint32_t)::syscall(SYS_gettid);
+  }
+  return *holder.ring;
+}
+
+thread_local int t_slot = -1;
+thread_local uint32_t t_sdk_error = 0;
+
+void json_escape(std::string& out, const char* s) {
+  for (; *s; ++s) {
+    const char c = *s;
+    if (c == '"' || c == '\\') { out += '\\'; out += c; }
+    else if ((unsigned char)c < 0x20) out += ' ';
+    else out += c;
+  }
+}
+
+} // namespace
+
+Span::Span(const char* cat, const char* name, int slot, int64_t code)
+    : m_prev_slot(t_slot), m_sets_slot(slot != kInheritSlot) {
+  if (m_sets_slot) t_slot = slot;
+  m_ev.cat = cat;
+  m_ev.name = name;
+  m_ev.code = code;
+  m_ev.result = kNone;
+  m_ev.slot = t_slot;
+  m_ev.dur_ns = 0;
+  m_ev.ts_ns = monotonic_ns();
+}
+
+Span::~Span() {
+  m_ev.dur_ns = monotonic_ns() - m_ev.ts_ns;
+  Ring& r = thread_ring();
+  const uint64_t h = r.head.load(std::memory_order_relaxed);
+  r.events[h & Ring::kMask] = m_ev;
+  r.head.store(h + 1, std::memory_order_release);
+  if (m_sets_slot) t_slot = m_prev_slot;
+}
+
+void set_thread_name(const char* name) {
+  Ring& r = thread_ring();
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  std::snprintf(r.name, sizeof(r.name), "%s", name);
+}
+
+int current_slot() {
+  return t_slot;
+}
+
+void note_sdk_result(uint32_t result) {
+  if (result != 0 && t_sdk_error == 0) t_sdk_error = result;
+}
+
+uint32_t take_sdk_error() {
+  const uint32_t e = t_sdk_error;
+  t_sdk_error = 0;
+  return e;
+}
+
+std::vector<ThreadEvents> snapshot(uint32_t window_ms) {
+  struct Held {
+    std::shared_ptr<Ring> ring;
+    uint32_t gen;
+    uint64_t head;
+    uint32_t tid;
+    std::string name;
+  };
+  std::vector<Held> rings;
+  {
+    // Identity and head are read together, so they belong to the same thread.
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    rings.reserve(reg.rings.size());
+    for (const auto& r : reg.rings) {
+      rings.push_back(Held{r, r->gen.load(std::memory_order_acquire), r->head.load(std::memory_order_acquire),
+                           r->tid, r->name});
+    }
+  }
+
+  const uint64_t now = monotonic_ns();
+  const uint64_t window_ns = (uint64_t)window_ms * 1000000ull;
+  const uint64_t cutoff = now > window_ns ? now - window_ns : 0;
+
+  std::vector<ThreadEvents> out;
+  for (const auto& held : rings) {
+    const Ring* r = held.ring.get();
+    const uint64_t h1 = held.head;
+    const uint64_t first = h1 > Ring::kCap ? h1 - Ring::kCap : 0;
+    std::vector<Event> copy;
+    copy.reserve((size_t)(h1 - first));
+    for (uint64_t i = first; i < h1; ++i) copy.push_back(r->events[i & Ring::kMask]);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // Slots the writer reached while we copied are unreliable: drop them.
+    const uint64_t h2 = r->head.load(std::memory_order_relaxed);
+    // Reused by a new thread meanwhile: none of the copy is this thread's.
+    if (r->gen.load(std::memory_order_relaxed) != held.gen || h2 < h1) continue;
+    const uint64_t valid_from = h2 >= Ring::kCap ? h2 - Ring::kCap + 1 : 0;
+
+    ThreadEvents te;
+    te.tid = held.tid;
+    te.name = held.name;
+    for (uint64_t i = first; i < h1; ++i) {
+      if (i < valid_from) continue;
+      const Event& e = copy[(size_t)(i - first)];
+      if (e.ts_ns + e.dur_ns < cutoff) continue;
+      te.events.push_back(e);
+    }
+    if (!te.events.empty()) out.push_back(std::move(te));
+  }
+  return out;
+}
+
+size_t event_count(const std::vector<ThreadEvents>& snap) {
+  size_t n = 0;
+  for (const auto& t : snap) n += t.events.size();
+  return n;
+}
+
+bool write_chrome_json(const std::string& path, const std::vector<ThreadEvents>& snap) {
+  std::string s;
+  s.reserve(256 + event_count(snap) * 160);
+  s += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  s += "{\"ph\":\"M\",\"pid\":1,\"tid\":0,\"name\":\"process_name\",\"args\":{\"name\":\"ccu_daemon\"}}";
+  char buf[256];
+  for (const auto& t : snap) {
+    s += ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":";
+    s += std::to_string(t.tid);
+    s += ",\"name\":\"thread_name\",\"args\":{\"name\":\"";
+    json_escape(s, t.name.c_str());
+    s += "\"}}";
+    for (const Event& e : t.events) {
+      s += ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":";
+      s += std::to_string(t.tid);
+      s += ",\"cat\":\"";
+      json_escape(s, e.cat);
+      s += "\",\"name\":\"";
+      json_escape(s, e.name);
+      std::snprintf(buf, sizeof(buf), "\",\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"slot\":%d",
+                    (double)e.ts_ns / 1000.0, (double)e.dur_ns / 1000.0, (int)e.slot);
+      s += buf;
+      if (e.code != kNone) {
+        const bool is_request = e.cat[0] == 'r';
+        std::snprintf(buf, sizeof(buf), is_request ? ",\"seq\":%llu" : ",\"code\":\"0x%llX\"",
+                      (unsigned long long)e.code);
+        s += buf;
+      }
+      if (e.result != kNone) {
+        std::snprintf(buf, sizeof(buf), ",\"result\":\"0x%llX\"", (unsigned long long)e.result);
+        s += buf;
+      }
+      s += "}}";
+    }
+  }
+  s += "\n]}\n";
+
+  const std::string tmp = path + ".tmp";
+  FILE* f = std::fopen(tmp.c_str(), "w");
+  if (!f) return false;
+  const bool ok = std::fwrite(s.data(), 1, s.size(), f) == s.size();
+  if (std::fclose(f) != 0 || !ok) {
+    std::remove(tmp.c_str());
+    return false;
+  }
+  return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+} // namespace trace
+} // namespace ccu
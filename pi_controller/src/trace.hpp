@@ -0,0 +1,88 @@
+#pragma once
+// Lightweight span tracing for the daemon's request and SDK paths.
+//
+// Spans are recorded into a per-thread ring that overwrites the oldest
+// entries, so the last few seconds are always available for a dump in
+// Chrome trace / Perfetto JSON. Recording is two clock reads and a store;
+// names and categories must be string literals.
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "flight_recorder.hpp"
+
+namespace ccu {
+namespace trace {
+
+static constexpr int kInheritSlot = -2;   // use the enclosing span's slot
+static constexpr int64_t kNone = -1;
+
+struct Event {
+  uint64_t ts_ns;       // CLOCK_MONOTONIC start
+  uint64_t dur_ns;
+  const char* cat;
+  const char* name;
+  int64_t code;         // property/command code (request spans: seq), kNone if unset
+  int64_t result;       // SDK return / resp code, kNone if unset
+  int32_t slot;         // -1 = no slot
+};
+
+// RAII span. A span given an explicit slot also becomes the slot context
+// for nested spans on the same thread (e.g. SDK calls inside a backend op).
+class Span {
+public:
+  Span(const char* cat, const char* name, int slot = kInheritSlot, int64_t code = kNone);
+  ~Span();
+  Span(const Span&) = delete;
+  Span& operator=(const Span&) = delete;
+
+  void set_name(const char* name) { m_ev.name = name; }
+  void set_code(int64_t code) { m_ev.code = code; }
+  void set_result(int64_t result) { m_ev.result = result; }
+  uint64_t start_ns() const { return m_ev.ts_ns; }
+
+private:
+  Event m_ev;
+  int m_prev_slot;
+  bool m_sets_slot;
+};
+
+// Names the calling thread in dumps (default "thread").
+void set_thread_name(const char* name);
+
+// Slot set by the innermost enclosing span on this thread, or -1.
+int current_slot();
+
+// First failing SDK return code on this thread since the last take (0 = none);
+// fed by CCU_TRACE_SDK, read per request for the ACK timing extension.
+void note_sdk_result(uint32_t result);
+uint32_t take_sdk_error();
+
+struct ThreadEvents {
+  uint32_t tid;
+  std::string name;
+  std::vector<Event> events;
+};
+
+// Copies every thread's spans that ended within the last window_ms.
+std::vector<ThreadEvents> snapshot(uint32_t window_ms);
+size_t event_count(const std::vector<ThreadEvents>& snap);
+
+// Chrome trace event format (chrome://tracing, ui.perfetto.dev).
+bool write_chrome_json(const std::string& path, const std::vector<ThreadEvents>& snap);
+
+} // namespace trace
+} // namespace ccu
+
+// Wraps one SCRSDK call: CCU_TRACE_SDK(SendCommand, cmd_id, handle, cmd_id, param)
+// records a "sdk" span named after the function with its code and return value,
+// and logs the result to the flight recorder.
+#define CCU_TRACE_SDK(fn, code, ...) \
+  ([&]() { \
+    ::ccu::trace::Span ccu_sdk_span_("sdk", #fn, ::ccu::trace::kInheritSlot, (int64_t)(code)); \
+    auto ccu_sdk_ret_ = SCRSDK::fn(__VA_ARGS__); \
+    ccu_sdk_span_.set_result((int64_t)ccu_sdk_ret_); \
+    ::ccu::flight::record_sdk_call(#fn, (uint32_t)(code), (uint32_t)ccu_sdk_ret_, ccu_sdk_span_.start_ns()); \
+    ::ccu::trace::note_sdk_result((uint32_t)ccu_sdk_ret_); \
+    return ccu_sdk_ret_; \
+  }())
@@ -1,9 +1,11 @@
 #include "uart_transport.hpp"
+#include "clock.hpp"
 #include "protocol.hpp"
 #include <unistd.h>
 #include <fcntl.h>
 #include <termios.h>
 #include <cstring>
+#include <ctime>
 #include <algorithm>
 
 namespace ccu {
@@ -52,6 +54,8 @@ bool UartTransport::open(const std::string& device, uint32_t baud) {
 
   m_buf.clear();
   m_rd = 0;
+  m_base = 0;
+  m_marks.clear();
   return true;
 }
 
@@ -60,6 +64,8 @@ void UartTransport::close() {
   m_fd = -1;
   m_buf.clear();
   m_rd = 0;
+  m_base = 0;
+  m_marks.clear();
 }
 
 void UartTransport::poll_rx() {
@@ -69,18 +75,27 @@ void UartTransport::poll_rx() {
     const int n = (int)::read(m_fd, tmp, sizeof(tmp));
     if (n <= 0) break;
     m_buf.insert(m_buf.end(), tmp, tmp + n);
+    if (m_marks.size() >= 64) m_marks.pop_front();
+    m_marks.push_back(ReadMark{m_base + m_buf.size(), monotonic_ns()});
   }
 }
 
+void UartTransport::stamp_frame(uint64_t frame_end) {
+  while (!m_marks.empty() && m_marks.front().end < frame_end) m_marks.pop_front();
+  m_frame_rx_ns = m_marks.empty() ? monotonic_ns() : m_marks.front().ns;
+}
+
 void UartTransport::compact() {
   if (m_rd == 0) return;
   if (m_rd >= m_buf.size()) {
+    m_base += m_buf.size();
     m_buf.clear();
     m_rd = 0;
     return;
   }
   if (m_rd > 1024 || m_rd > (m_buf.size() / 2)) {
     m_buf.erase(m_buf.begin(), m_buf.begin() + (long)m_rd);
+    m_base += m_rd;
     m_rd = 0;
   }
 }
@@ -125,8 +140,9 @@ int UartTransport::recv_frame(uint8_t* out, size_t out_max) {
     const uint16_t payload_len = (uint16_t)hdr[6] | ((uint16_t)hdr[7] << 8);
     const size_t frame_len = sizeof(Header) + (size_t)payload_len + 4;
 
-    if (frame_len > out_max || frame_len > 2048) {
+    if (frame_len > out_max || frame_len > MAX_FRAME_LEN) {
       // Bad length; skip one byte and resync.
+      ++m_resyncs;
       m_rd = pos + 1;
       continue;
     }
@@ -141,11 +157,14 @@ int UartTransport::recv_frame(uint8_t* out, size_t out_max) {
     const uint32_t got_crc = rd32_le(frame + sizeof(Header) + payload_len);
     const uint32_t calc_crc = crc32_ieee(frame, sizeof(Header) + payload_len);
     if (got_crc != calc_crc) {
+      ++m_resyncs;
+      ++m_bad_crc;
       m_rd = pos + 1;
       continue;
     }
 
     std::memcpy(out, frame, frame_len);
+    stamp_frame(m_base + pos + frame_len);
     m_rd = pos + frame_len;
     compact();
     return (int)frame_len;
@@ -1,6 +1,7 @@
 #pragma once
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <string>
 #include <vector>
 
@@ -13,14 +14,30 @@ public:
 
   // Non-blocking; returns full CCU1 frame length, or 0 if none.
   int recv_frame(uint8_t* out, size_t out_max);
+  // CLOCK_MONOTONIC ns of the read() that delivered the last frame's final byte.
+  uint64_t last_frame_rx_ns() const { return m_frame_rx_ns; }
   bool send_frame(const uint8_t* buf, size_t len);
 
+  // Link health: resyncs counts skipped sync positions (bad length or CRC),
+  // bad_crc the subset rejected by the CRC check.
+  uint64_t resyncs() const { return m_resyncs; }
+  uint64_t bad_crc() const { return m_bad_crc; }
+
 private:
   int m_fd = -1;
   std::vector<uint8_t> m_buf;
   size_t m_rd = 0;
+  uint64_t m_resyncs = 0;
+  uint64_t m_bad_crc = 0;
+
+  // Stream offset of m_buf[0], and the stream end offset + time of recent reads.
+  struct ReadMark { uint64_t end; uint64_t ns; };
+  uint64_t m_base = 0;
+  std::deque<ReadMark> m_marks;
+  uint64_t m_frame_rx_ns = 0;
 
   void poll_rx();
+  void stamp_frame(uint64_t frame_end);
   void compact();
 };
 
@@ -1,8 +1,10 @@
 #include "udp_server.hpp"
+#include "clock.hpp"
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/socket.h>
 #include <cstring>
+#include <ctime>
 
 namespace ccu {
 
@@ -15,6 +17,8 @@ bool UdpServer::open(uint16_t port) {
 
   int yes = 1;
   ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  // Arrival stamps for the ACK timing extension (queue wait).
+  ::setsockopt(m_fd, SOL_SOCKET, SO_TIMESTAMPNS, &yes, sizeof(yes));
 
   sockaddr_in addr{};
   addr.sin_family = AF_INET;
@@ -34,10 +38,33 @@ void UdpServer::close() {
   m_fd = -1;
 }
 
-int UdpServer::recv(uint8_t* buf, size_t max_len, sockaddr_in& from) {
-  socklen_t sl = sizeof(from);
-  const int n = (int)::recvfrom(m_fd, buf, max_len, 0, (sockaddr*)&from, &sl);
+int UdpServer::recv(uint8_t* buf, size_t max_len, sockaddr_in& from, uint64_t* rx_mono_ns) {
+  iovec iov{buf, max_len};
+  alignas(cmsghdr) uint8_t ctrl[CMSG_SPACE(sizeof(timespec))];
+  msghdr msg{};
+  msg.msg_name = &from;
+  msg.msg_namelen = sizeof(from);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctrl;
+  msg.msg_controllen = sizeof(ctrl);
+  const int n = (int)::recvmsg(m_fd, &msg, 0);
   if (n < 0) return 0;
+
+  if (rx_mono_ns) {
+    *rx_mono_ns = 0;
+    for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+      if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_TIMESTAMPNS) continue;
+      timespec ts{};
+      std::memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+      // The stamp is CLOCK_REALTIME; carry its age over to CLOCK_MONOTONIC.
+      const uint64_t stamp = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+      const uint64_t real_now = clock_ns(CLOCK_REALTIME);
+      const uint64_t mono_now = clock_ns(CLOCK_MONOTONIC);
+      const uint64_t age = real_now > stamp ? real_now - stamp : 0;
+      *rx_mono_ns = mono_now > age ? mono_now - age : 0;
+    }
+  }
   return n;
 }
 
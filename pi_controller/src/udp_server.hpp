@@ -10,8 +10,9 @@ public:
   bool open(uint16_t port);
   void close();
 
-  // Non-blocking recv; returns bytes, 0 if none.
-  int recv(uint8_t* buf, size_t max_len, sockaddr_in& from);
+  // Non-blocking recv; returns bytes, 0 if none. rx_mono_ns (optional) gets
+  // the kernel's arrival time mapped to CLOCK_MONOTONIC (0 if unavailable).
+  int recv(uint8_t* buf, size_t max_len, sockaddr_in& from, uint64_t* rx_mono_ns = nullptr);
   bool sendto(const uint8_t* buf, size_t len, const sockaddr_in& to);
 
 private:
@@ -0,0 +1,200 @@
+// Proxy AVI layout: a file assembled the way ProxyRecorder does (header
+// placeholder, 00dc chunks with empty repeats and odd-size padding, idx1,
+// header rewritten with the counts) walked back as RIFF: list sizes, the
+// one-block header, idx1 offsets and sizes against the chunks they name,
+// and the JPEG size probe the header takes its dimensions from.
+#include "../src/avi_layout.hpp"
+#include "check.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace ccu;
+
+namespace {
+
+uint32_t get32(const uint8_t* p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+uint16_t get16(const uint8_t* p) { return (uint16_t)(p[0] | p[1] << 8); }
+
+bool is(const uint8_t* p, const char* cc) { return std::memcmp(p, cc, 4) == 0; }
+
+// SOI, APP0, a fill byte, DHT (not a SOF despite 0xC4), SOF0 w x h, SOS.
+std::vector<uint8_t> jpeg(uint16_t w, uint16_t h, bool with_sof = true) {
+  std::vector<uint8_t> j = {0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x06, 'J', 'F', 'I', 'F', 0xFF,
+                            0xFF, 0xC4, 0x00, 0x03, 0x00};
+  if (with_sof) {
+    const uint8_t sof[] = {0xFF, 0xC0, 0x00, 0x11, 0x08, (uint8_t)(h >> 8), (uint8_t)h, (uint8_t)(w >> 8), (uint8_t)w, 0x03};
+    j.insert(j.end(), sof, sof + sizeof(sof));
+    j.resize(j.size() + 9, 0x11);
+  }
+  const uint8_t sos[] = {0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x3F, 0x00, 0x12, 0x34, 0xFF, 0xD9};
+  j.insert(j.end(), sos, sos + sizeof(sos));
+  return j;
+}
+
+struct Built {
+  std::vector<uint8_t> file;
+  std::vector<uint32_t> sizes;   // per chunk, 0 for repeats
+};
+
+// The same sequence of writes as ProxyRecorder::open_file / append_chunk /
+// finish_file, into memory.
+Built build(const std::vector<std::vector<uint8_t>>& frames, uint32_t fps) {
+  Built b;
+  std::vector<uint8_t>& f = b.file;
+  f.assign(kAviHeaderBytes, 0);
+  std::vector<uint8_t> idx1;
+  uint32_t max_chunk = 0;
+  for (const auto& fr : frames) {
+    const uint32_t size = (uint32_t)fr.size();
+    uint8_t idx[kAviIndexEntry];
+    avi_index_entry(idx, f.size(), size);
+    idx1.insert(idx1.end(), idx, idx + sizeof(idx));
+    uint8_t head[8];
+    avi_chunk_header(head, size);
+    f.insert(f.end(), head, head + 8);
+    f.insert(f.end(), fr.begin(), fr.end());
+    if (size & 1) f.push_back(0);
+    max_chunk = std::max(max_chunk, size + (size & 1));
+    b.sizes.push_back(size);
+  }
+  const uint64_t movi_end = f.size();
+  uint8_t idx_head[8];
+  avi_index_header(idx_head, (uint32_t)idx1.size());
+  f.insert(f.end(), idx_head, idx_head + 8);
+  f.insert(f.end(), idx1.begin(), idx1.end());
+
+  AviInfo info;
+  info.fps = fps;
+  info.frames = (uint32_t)frames.size();
+  info.max_chunk = max_chunk;
+  CCU_CHECK(jpeg_dimensions(frames[0].data(), frames[0].size(), info.width, info.height));
+  info.indexed = true;
+  info.movi_end = movi_end;
+  info.file_bytes = f.size();
+  info.take_start = 1700000000;
+  avi_header(f.data(), info);
+  return b;
+}
+
+void test_jpeg_dimensions() {
+  uint16_t w = 0, h = 0;
+  const std::vector<uint8_t> j = jpeg(640, 360);
+  CCU_CHECK(jpeg_dimensions(j.data(), j.size(), w, h));
+  CCU_CHECK_EQ(w, 640);
+  CCU_CHECK_EQ(h, 360);
+
+  const std::vector<uint8_t> none = jpeg(640, 360, false);
+  CCU_CHECK(!jpeg_dimensions(none.data(), none.size(), w, h));  // scan before any SOF
+  CCU_CHECK(!jpeg_dimensions(j.data(), 20, w, h));               // cut inside SOF0
+  const std::vector<uint8_t> zero = jpeg(0, 360);
+  CCU_CHECK(!jpeg_dimensions(zero.data(), zero.size(), w, h));
+  const uint8_t png[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+  CCU_CHECK(!jpeg_dimensions(png, sizeof(png), w, h));
+}
+
+void test_header_block() {
+  CCU_CHECK_EQ(kAviJunkOffset, 12 + 8 + kAviHdrlBytes);
+  CCU_CHECK_EQ(kAviMoviFourcc, kAviHeaderBytes - 4);
+
+  // Two real frames (one odd-sized) with two repeats between them.
+  std::vector<uint8_t> a = jpeg(1024, 576), c = jpeg(1024, 576);
+  a.resize(a.size() + 2, 0xAA);
+  c.resize(c.size() + 1, 0xCC);
+  CCU_CHECK((a.size() & 1) == 1 && c.size() == a.size() - 1);
+  const Built b = build({a, {}, {}, c}, 30);
+  const uint8_t* f = b.file.data();
+  const size_t n = b.file.size();
+
+  CCU_CHECK(is(f, "RIFF") && is(f + 8, "AVI "));
+  CCU_CHECK_EQ(get32(f + 4), n - 8);
+  CCU_CHECK(is(f + 12, "LIST") && is(f + 20, "hdrl"));
+  CCU_CHECK_EQ(get32(f + 16), kAviHdrlBytes);
+
+  // hdrl: avih, strl (strh, strf), IDIT, each chunk where the last ended.
+  const uint8_t* avih = f + 24;
+  CCU_CHECK(is(avih, "avih"));
+  CCU_CHECK_EQ(get32(avih + 4), 56);
+  CCU_CHECK_EQ(get32(avih + 8), 1000000 / 30);
+  CCU_CHECK_EQ(get32(avih + 20), 0x10);   // AVIF_HASINDEX
+  CCU_CHECK_EQ(get32(avih + 24), 4);      // frames, repeats included
+  CCU_CHECK_EQ(get32(avih + 32), 1);
+  CCU_CHECK_EQ(get32(avih + 36), a.size() + 1);  // largest chunk, padded
+  CCU_CHECK_EQ(get32(avih + 40), 1024);
+  CCU_CHECK_EQ(get32(avih + 44), 576);
+  const uint8_t* strl = avih + 8 + 56;
+  CCU_CHECK(is(strl, "LIST") && is(strl + 8, "strl"));
+  const uint8_t* strh = strl + 12;
+  CCU_CHECK(is(strh, "strh") && is(strh + 8, "vids") && is(strh + 12, "MJPG"));
+  CCU_CHECK_EQ(get32(strh + 28), 1);
+  CCU_CHECK_EQ(get32(strh + 32), 30);
+  CCU_CHECK_EQ(get32(strh + 40), 4);
+  CCU_CHECK_EQ(get16(strh + 60), 1024);
+  CCU_CHECK_EQ(get16(strh + 62), 576);
+  const uint8_t* strf = strh + 8 + get32(strh + 4);
+  CCU_CHECK(is(strf, "strf") && is(strf + 24, "MJPG"));
+  CCU_CHECK_EQ(strf + 8 + get32(strf + 4) - (strl + 8), get32(strl + 4));
+  const uint8_t* idit = strf + 8 + get32(strf + 4);
+  CCU_CHECK(is(idit, "IDIT"));
+  CCU_CHECK_EQ(get32(idit + 4), 26);
+  CCU_CHECK(idit[8 + 24] == '\n' && idit[8 + 25] == 0);
+  const uint8_t* junk = idit + 8 + 26;
+  CCU_CHECK_EQ(junk - f, kAviJunkOffset);
+  CCU_CHECK(is(junk, "JUNK"));
+  CCU_CHECK_EQ(junk + 8 + get32(junk + 4) - f, kAviMoviOffset);
+
+  // movi spans exactly the chunks; idx1 follows it and ends the file.
+  const uint8_t* movi = f + kAviMoviOffset;
+  CCU_CHECK(is(movi, "LIST") && is(movi + 8, "movi"));
+  const uint8_t* idx1 = movi + 8 + get32(movi + 4);
+  CCU_CHECK(is(idx1, "idx1"));
+  CCU_CHECK_EQ(get32(idx1 + 4), 4 * kAviIndexEntry);
+  CCU_CHECK_EQ(idx1 + 8 + get32(idx1 + 4) - f, n);
+}
+
+void test_index_entries() {
+  std::vector<std::vector<uint8_t>> frames;
+  for (int i = 0; i < 7; ++i) {
+    std::vector<uint8_t> j = jpeg(320, 180);
+    if (i % 3 == 1) j.clear();         // repeat
+    else j.resize(j.size() + i, (uint8_t)i);  // mixed odd and even sizes
+    frames.push_back(j);
+  }
+  const Built b = build(frames, 25);
+  const uint8_t* f = b.file.data();
+  const uint8_t* movi = f + kAviMoviOffset;
+  const uint8_t* idx1 = movi + 8 + get32(movi + 4);
+  if (!is(idx1, "idx1")) {
+    CCU_CHECK(false);
+    return;
+  }
+
+  // Walking movi chunk by chunk must meet each idx1 entry in turn.
+  const uint8_t* chunk = movi + 12;
+  for (size_t i = 0; i < frames.size(); ++i) {
+    const uint8_t* e = idx1 + 8 + i * kAviIndexEntry;
+    CCU_CHECK(is(e, "00dc"));
+    CCU_CHECK_EQ(get32(e + 4), 0x10);   // AVIIF_KEYFRAME
+    CCU_CHECK_EQ(get32(e + 8), chunk - (f + kAviMoviFourcc));
+    CCU_CHECK_EQ(get32(e + 12), b.sizes[i]);
+    CCU_CHECK(is(chunk, "00dc"));
+    CCU_CHECK_EQ(get32(chunk + 4), b.sizes[i]);
+    if (b.sizes[i]) CCU_CHECK(std::memcmp(chunk + 8, frames[i].data(), b.sizes[i]) == 0);
+    chunk += 8 + b.sizes[i] + (b.sizes[i] & 1);
+  }
+  CCU_CHECK(chunk == idx1);
+}
+
+} // namespace
+
+int main() {
+  test_jpeg_dimensions();
+  test_header_block();
+  test_index_entries();
+  return ccu_test::result();
+}
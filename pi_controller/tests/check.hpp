@@ -0,0 +1,38 @@
+#pragma once
+// Minimal checks for the unit tests. A failed CCU_CHECK reports itself and
+// the test carries on, so one run lists every broken expectation; main
+// returns ccu_test::result().
+#include <cstdio>
+
+namespace ccu_test {
+
+inline int& failures() {
+  static int n = 0;
+  return n;
+}
+
+inline int result() {
+  if (failures() == 0) return 0;
+  std::fprintf(stderr, "%d check(s) failed\n", failures());
+  return 1;
+}
+
+} // namespace ccu_test
+
+#define CCU_CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      ++ccu_test::failures(); \
+    } \
+  } while (0)
+
+#define CCU_CHECK_EQ(a, b) \
+  do { \
+    const long long ccu_a_ = (long long)(a), ccu_b_ = (long long)(b); \
+    if (ccu_a_ != ccu_b_) { \
+      std::fprintf(stderr, "%s:%d: check failed: %s == %s (%lld vs %lld)\n", __FILE__, __LINE__, #a, #b, \
+                   ccu_a_, ccu_b_); \
+      ++ccu_test::failures(); \
+    } \
+  } while (0)
@@ -0,0 +1,85 @@
+// ClockSync: NTP offset and delay from the four timestamps, best-sample
+// selection, rejection of impossible reports and sample ageing.
+#include "../src/clock_sync.hpp"
+#include "check.hpp"
+#include <cstdint>
+
+using namespace ccu;
+
+namespace {
+
+// One exchange where the daemon clock reads ccu + offset, each direction
+// takes the given one-way time and the daemon holds the request hold_us.
+void exchange(ClockSync& cs, uint64_t t1, int64_t offset, uint64_t up_us, uint64_t down_us, uint64_t hold_us) {
+  const uint64_t t2 = (uint64_t)((int64_t)t1 + offset) + up_us;
+  const uint64_t t3 = t2 + hold_us;
+  const uint64_t t4 = (uint64_t)((int64_t)t3 - offset) + down_us;
+  cs.note_exchange(t1, t2, t3);
+  CCU_CHECK(cs.complete(t1, t4));
+}
+
+void test_symmetric_offset() {
+  ClockSync cs;
+  CCU_CHECK(!cs.estimate(1000000).valid);
+  exchange(cs, 1000000, 5000, 300, 300, 100);
+  const ClockSync::Estimate e = cs.estimate(1010000);
+  CCU_CHECK(e.valid);
+  CCU_CHECK_EQ(e.offset_us, 5000);
+  CCU_CHECK_EQ(e.uncertainty_us, 300);
+  CCU_CHECK_EQ(e.samples, 1);
+}
+
+void test_ccu_ahead() {
+  ClockSync cs;
+  exchange(cs, 90000000, -70000000, 250, 250, 40);
+  const ClockSync::Estimate e = cs.estimate(20100000);
+  CCU_CHECK(e.valid);
+  CCU_CHECK_EQ(e.offset_us, -70000000);
+  CCU_CHECK_EQ(e.uncertainty_us, 250);
+}
+
+void test_best_sample_wins() {
+  ClockSync cs;
+  // A congested, lopsided exchange is off by half its asymmetry...
+  exchange(cs, 1000000, 5000, 4000, 200, 100);
+  ClockSync::Estimate e = cs.estimate(1100000);
+  CCU_CHECK_EQ(e.offset_us, 5000 + (4000 - 200) / 2);
+  CCU_CHECK_EQ(e.uncertainty_us, 2100);
+  // ...and is superseded by a later quick one.
+  exchange(cs, 1200000, 5000, 150, 150, 100);
+  exchange(cs, 1400000, 5000, 900, 700, 100);
+  e = cs.estimate(1500000);
+  CCU_CHECK_EQ(e.samples, 3);
+  CCU_CHECK_EQ(e.offset_us, 5000);
+  CCU_CHECK_EQ(e.uncertainty_us, 150);
+}
+
+void test_rejects_bad_reports() {
+  ClockSync cs;
+  CCU_CHECK(!cs.complete(1234, 5678));  // never seen
+  cs.note_exchange(1000000, 1005300, 1005400);
+  CCU_CHECK(!cs.complete(1000000, 999999));   // t4 before t1
+  CCU_CHECK(!cs.complete(1000000, 1000050));  // round trip shorter than the daemon's hold
+  CCU_CHECK(cs.complete(1000000, 1000700));
+  CCU_CHECK(!cs.complete(1000000, 1000700));  // already completed
+  CCU_CHECK_EQ(cs.estimate(1006000).samples, 1);
+}
+
+void test_samples_age_out() {
+  ClockSync cs;
+  exchange(cs, 1000000, 5000, 300, 300, 100);
+  const uint64_t t2 = 1000000 + 5000 + 300;
+  CCU_CHECK(cs.estimate(t2 + ClockSync::kMaxAgeUs).valid);
+  CCU_CHECK(!cs.estimate(t2 + ClockSync::kMaxAgeUs + 1).valid);
+}
+
+} // namespace
+
+int main() {
+  test_symmetric_offset();
+  test_ccu_ahead();
+  test_best_sample_wins();
+  test_rejects_bad_reports();
+  test_samples_age_out();
+  return ccu_test::result();
+}
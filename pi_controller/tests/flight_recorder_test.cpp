@@ -0,0 +1,93 @@
+// Flight recorder ring: records come back oldest first with their payloads
+// intact, and a record the ring has partly lapped is dropped rather than
+// decoded from another lap's slots.
+#include "../src/flight_recorder.hpp"
+#include "check.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace ccu;
+
+namespace {
+
+std::string temp_path(const char* name) {
+  const char* dir = std::getenv("TMPDIR");
+  return std::string(dir && *dir ? dir : "/tmp") + "/" + name + "." + std::to_string(::getpid());
+}
+
+void test_lapped_ring(const std::string& path) {
+  // 64 slots; every record below is a header plus two payload slots.
+  const size_t slots = 64;
+  CCU_CHECK(flight::open(path, flight::kHeaderBytes + slots * flight::kSlotBytes));
+  CCU_CHECK(flight::enabled());
+
+  const uint32_t records = 50;
+  for (uint32_t k = 0; k < records; ++k) {
+    uint8_t payload[40];
+    std::memset(payload, (int)k, sizeof(payload));
+    flight::record(flight::KIND_FRAME_RX, flight::SRC_UDP, k, k * 2, payload, sizeof(payload), k + 7);
+  }
+
+  flight::FileHeader hdr{};
+  std::vector<flight::Record> out;
+  std::string err;
+  CCU_CHECK(flight::read_file(path, hdr, out, err));
+  CCU_CHECK_EQ(hdr.slot_count, slots);
+  CCU_CHECK_EQ(hdr.head, records * 3);
+
+  // head = 150 leaves slots [86, 150) live. The record at 84 lost its header
+  // slot's neighbours to the wrap, so the first intact one starts at 87.
+  const uint32_t first = 87 / 3;
+  CCU_CHECK_EQ(out.size(), records - first);
+  for (size_t i = 0; i < out.size(); ++i) {
+    const flight::Record& r = out[i];
+    const uint32_t k = first + (uint32_t)i;
+    CCU_CHECK_EQ(r.h.index, (uint64_t)k * 3 + 1);
+    CCU_CHECK_EQ(r.h.code, k);
+    CCU_CHECK_EQ(r.h.result, k * 2);
+    CCU_CHECK_EQ(r.h.aux, k + 7);
+    CCU_CHECK_EQ(r.h.kind, flight::KIND_FRAME_RX);
+    CCU_CHECK_EQ(r.data.size(), 40);
+    bool intact = true;
+    for (uint8_t b : r.data) intact = intact && b == (uint8_t)k;
+    CCU_CHECK(intact);
+    if (i > 0) CCU_CHECK(r.h.ts_ns >= out[i - 1].h.ts_ns);
+  }
+
+  // An empty payload takes just the header slot.
+  flight::record(flight::KIND_START, flight::SRC_UDP, 0, 0, nullptr, 0);
+  CCU_CHECK(flight::read_file(path, hdr, out, err));
+  CCU_CHECK_EQ(hdr.head, records * 3 + 1);
+  CCU_CHECK(!out.empty() && out.back().h.kind == flight::KIND_START && out.back().data.empty());
+}
+
+void test_rejects_foreign_file(const std::string& path) {
+  FILE* f = std::fopen(path.c_str(), "wb");
+  CCU_CHECK(f != nullptr);
+  if (!f) return;
+  std::vector<uint8_t> junk(flight::kHeaderBytes * 2, 0x5A);
+  std::fwrite(junk.data(), 1, junk.size(), f);
+  std::fclose(f);
+
+  flight::FileHeader hdr{};
+  std::vector<flight::Record> out;
+  std::string err;
+  CCU_CHECK(!flight::read_file(path, hdr, out, err));
+  CCU_CHECK(!err.empty());
+}
+
+} // namespace
+
+int main() {
+  const std::string ring = temp_path("ccu_flight_test");
+  const std::string junk = temp_path("ccu_flight_junk");
+  test_lapped_ring(ring);
+  test_rejects_foreign_file(junk);
+  ::unlink(ring.c_str());
+  ::unlink(junk.c_str());
+  return ccu_test::result();
+}
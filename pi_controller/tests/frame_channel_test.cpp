@@ -0,0 +1,190 @@
+// FramePool reference counts (free / kWriting / published + handles),
+// FrameChannel latest-wins publication across pool growth, FrameReader skip
+// counts, and a writer racing readers that must never see a torn frame.
+#include "../src/frame_channel.hpp"
+#include "check.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace ccu;
+
+namespace {
+
+// Exposes the writer side the live-view engine uses.
+class TestChannel : public FrameChannel {
+public:
+  using FrameChannel::add_pool;
+  using FrameChannel::pool;
+
+  // Fills a free buffer with fill and publishes it; false if none is free.
+  bool write(uint8_t fill, size_t size) {
+    FramePool& p = *pool();
+    const int idx = p.acquire_for_write();
+    if (idx < 0) return false;
+    std::memset(p.data(idx), fill, size);
+    LiveFrame& f = p.frame(idx);
+    f.jpeg = p.data(idx);
+    f.size = size;
+    f.frame_no = fill;
+    publish(idx);
+    return true;
+  }
+};
+
+void test_pool_states() {
+  FramePool p(2, 100);
+  CCU_CHECK_EQ(p.frames(), 2);
+  CCU_CHECK_EQ(p.buffer_bytes(), 100);
+  CCU_CHECK_EQ((uintptr_t)p.data(1) % 64, 0);
+
+  const int a = p.acquire_for_write();
+  CCU_CHECK_EQ(a, 0);
+  CCU_CHECK(!p.try_ref(a));  // being written
+  p.abandon_write(a);
+  CCU_CHECK(!p.try_ref(a));  // free
+  CCU_CHECK_EQ(p.acquire_for_write(), a);
+  p.finish_write(a);
+  CCU_CHECK(p.try_ref(a));   // published + one handle
+  const int b = p.acquire_for_write();
+  CCU_CHECK_EQ(b, 1);
+  CCU_CHECK_EQ(p.acquire_for_write(), -1);
+  p.unref(a);
+  CCU_CHECK_EQ(p.acquire_for_write(), -1);  // still published
+  p.unref(a);
+  CCU_CHECK_EQ(p.acquire_for_write(), a);
+}
+
+void test_latest_wins() {
+  TestChannel ch;
+  CCU_CHECK(!ch.latest());
+  CCU_CHECK_EQ(ch.latest_seq(), 0);
+  CCU_CHECK(ch.add_pool(3, 1000));
+  FrameReader reader(ch);
+  CCU_CHECK(!reader.next());
+
+  CCU_CHECK(ch.write(1, 10));
+  FrameRef first = reader.next();
+  CCU_CHECK(first && first->seq == 1 && first->frame_no == 1);
+  CCU_CHECK(!reader.next());  // nothing newer
+
+  // The held frame keeps its buffer: frames 2 and 3 take the other two,
+  // and first stays intact.
+  CCU_CHECK(ch.write(2, 10));
+  CCU_CHECK(ch.write(3, 10));
+  uint32_t skipped = 99;
+  FrameRef third = reader.next(&skipped);
+  CCU_CHECK(third && third->seq == 3);
+  CCU_CHECK_EQ(skipped, 1);
+  CCU_CHECK_EQ(reader.skipped_total(), 1);
+  CCU_CHECK(first->jpeg[0] == 1 && first->seq == 1);
+
+  // With first and third held, frame 4 takes frame 2's released buffer and
+  // then none is left.
+  FrameRef copy = third;
+  CCU_CHECK(ch.write(4, 10));
+  FrameRef fourth = ch.latest();
+  CCU_CHECK(fourth && fourth->seq == 4);
+  CCU_CHECK(!ch.write(5, 10));  // every buffer referenced
+  CCU_CHECK_EQ(ch.latest_seq(), 4);
+
+  first = FrameRef();
+  CCU_CHECK(ch.write(5, 10));
+  CCU_CHECK_EQ(ch.latest()->seq, 5);
+}
+
+void test_pool_growth() {
+  TestChannel ch;
+  CCU_CHECK(ch.add_pool(2, 1000));
+  CCU_CHECK(ch.write(7, 1000));
+  FrameRef old = ch.latest();
+
+  // A smaller request still at least doubles the buffers.
+  CCU_CHECK(ch.add_pool(2, 10));
+  CCU_CHECK_EQ(ch.pool()->buffer_bytes(), 2000);
+  CCU_CHECK(ch.write(8, 2000));
+  FrameRef grown = ch.latest();
+  CCU_CHECK(grown && grown->seq == 2 && grown->size == 2000);
+  CCU_CHECK(old && old->seq == 1 && old->jpeg[999] == 7);
+
+  CCU_CHECK(ch.add_pool(2, FrameChannel::kMaxBufferBytes * 4));
+  CCU_CHECK_EQ(ch.pool()->buffer_bytes(), FrameChannel::kMaxBufferBytes);
+  CCU_CHECK(!ch.add_pool(2, FrameChannel::kMaxBufferBytes));
+}
+
+void test_wait_newer() {
+  TestChannel ch;
+  CCU_CHECK(ch.add_pool(2, 64));
+  CCU_CHECK(!ch.wait_newer(0, std::chrono::milliseconds(5)));
+  std::thread writer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ch.write(1, 64);
+  });
+  CCU_CHECK(ch.wait_newer(0, std::chrono::seconds(5)));
+  writer.join();
+  CCU_CHECK(!ch.wait_newer(1, std::chrono::milliseconds(5)));
+}
+
+// Readers hold each frame for a moment and check every byte still carries
+// its seq; a buffer recycled under a reference would show up as a mismatch.
+void test_concurrent_readers() {
+  static constexpr size_t kSize = 4096;
+  static constexpr uint64_t kFrames = 20000;
+  TestChannel ch;
+  CCU_CHECK(ch.add_pool(4, kSize));
+  std::atomic<bool> done{false};
+  std::atomic<int> torn{0}, backwards{0};
+  std::atomic<uint64_t> seen{0};
+
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 3; ++r) {
+    readers.emplace_back([&, r] {
+      FrameReader reader(ch);
+      uint64_t last = 0;
+      while (!done.load(std::memory_order_acquire)) {
+        FrameRef f = r == 0 ? ch.latest() : reader.next();
+        if (!f) continue;
+        if (f->seq < last) backwards.fetch_add(1);
+        last = f->seq;
+        const uint8_t want = (uint8_t)f->seq;
+        for (size_t i = 0; i < f->size; i += 64) {
+          if (f->jpeg[i] != want) {
+            torn.fetch_add(1);
+            break;
+          }
+        }
+        seen.fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+  }
+
+  uint64_t published = 0;
+  while (published < kFrames) {
+    if (ch.write((uint8_t)(published + 1), kSize)) ++published;
+    else std::this_thread::yield();
+  }
+  done.store(true, std::memory_order_release);
+  for (std::thread& t : readers) t.join();
+
+  CCU_CHECK_EQ(torn.load(), 0);
+  CCU_CHECK_EQ(backwards.load(), 0);
+  CCU_CHECK(seen.load() > 0);
+  CCU_CHECK_EQ(ch.latest_seq(), kFrames);
+  // With every handle gone only the published frame is referenced.
+  int free_buffers = 0;
+  while (ch.pool()->acquire_for_write() >= 0) ++free_buffers;
+  CCU_CHECK_EQ(free_buffers, 3);
+}
+
+} // namespace
+
+int main() {
+  test_pool_states();
+  test_latest_wins();
+  test_pool_growth();
+  test_wait_newer();
+  test_concurrent_readers();
+  return ccu_test::result();
+}
@@ -0,0 +1,207 @@
+// Lut3d: tetrahedral interpolation (exact on lattice points and for affine
+// LUTs, the right tetrahedron for each fraction order), .cube parsing with
+// DOMAIN_MIN/MAX, resampling of large lattices and load errors.
+#include "../src/lut3d.hpp"
+#include "check.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace ccu;
+
+namespace {
+
+using Fn = std::function<void(float r, float g, float b, float* out)>;
+
+std::vector<float> lattice(uint32_t n, const Fn& fn) {
+  std::vector<float> v((size_t)n * n * n * 3);
+  for (uint32_t b = 0; b < n; ++b)
+    for (uint32_t g = 0; g < n; ++g)
+      for (uint32_t r = 0; r < n; ++r)
+        fn((float)r / (float)(n - 1), (float)g / (float)(n - 1), (float)b / (float)(n - 1),
+           &v[(((size_t)b * n + g) * n + r) * 3]);
+  return v;
+}
+
+void identity(float r, float g, float b, float* out) {
+  out[0] = r;
+  out[1] = g;
+  out[2] = b;
+}
+
+// Largest per-channel distance between lut(in) and want(in) over a grid of
+// input codes.
+int max_error(const Lut3d& lut, const std::function<void(const uint8_t*, int*)>& want) {
+  int worst = 0;
+  for (int r = 0; r < 256; r += 5) {
+    for (int g = 0; g < 256; g += 5) {
+      for (int b = 0; b < 256; b += 5) {
+        const uint8_t in[3] = {(uint8_t)r, (uint8_t)g, (uint8_t)b};
+        uint8_t out[3];
+        lut.apply(in, out, 1);
+        int exp[3];
+        want(in, exp);
+        for (int c = 0; c < 3; ++c) worst = std::max(worst, std::abs((int)out[c] - exp[c]));
+      }
+    }
+  }
+  return worst;
+}
+
+std::string temp_path(const char* name) {
+  const char* dir = std::getenv("TMPDIR");
+  return std::string(dir && *dir ? dir : "/tmp") + "/" + name + "." + std::to_string(::getpid()) + ".cube";
+}
+
+bool write_file(const std::string& path, const std::string& body) {
+  FILE* f = std::fopen(path.c_str(), "w");
+  if (!f) return false;
+  std::fputs(body.c_str(), f);
+  std::fclose(f);
+  return true;
+}
+
+std::string cube_body(uint32_t n, const std::vector<float>& v) {
+  std::string s = "LUT_3D_SIZE " + std::to_string(n) + "\n";
+  char line[64];
+  for (size_t i = 0; i < v.size(); i += 3) {
+    std::snprintf(line, sizeof(line), "%.6f %.6f %.6f\n", v[i], v[i + 1], v[i + 2]);
+    s += line;
+  }
+  return s;
+}
+
+void test_affine_exact() {
+  Lut3d lut;
+  CCU_CHECK(lut.empty());
+  CCU_CHECK(lut.load_values(2, lattice(2, identity), nullptr));
+  CCU_CHECK_EQ(lut.size(), 2);
+  CCU_CHECK(max_error(lut, [](const uint8_t* in, int* e) { for (int c = 0; c < 3; ++c) e[c] = in[c]; }) <= 1);
+
+  // Tetrahedral interpolation reproduces any affine map, here an inversion
+  // with cross-talk, at every lattice size.
+  const Fn mix = [](float r, float g, float b, float* out) {
+    out[0] = 1.0f - r;
+    out[1] = 0.5f * g + 0.5f * b;
+    out[2] = 0.25f + 0.5f * r;
+  };
+  CCU_CHECK(lut.load_values(33, lattice(33, mix), nullptr));
+  const int err = max_error(lut, [](const uint8_t* in, int* e) {
+    e[0] = 255 - in[0];
+    e[1] = (int)std::lround((in[1] + in[2]) / 2.0);
+    e[2] = (int)std::lround(63.75 + in[0] / 2.0);
+  });
+  CCU_CHECK(err <= 1);
+}
+
+void test_lattice_points() {
+  // 255 / 17 = 15: every 15th code lands on a lattice point, where even a
+  // curved LUT must come back unchanged.
+  const uint32_t n = 18;
+  Lut3d lut;
+  CCU_CHECK(lut.load_values(n, lattice(n, [](float r, float g, float b, float* out) {
+    out[0] = r * r;
+    out[1] = std::sqrt(g);
+    out[2] = r * g * b;
+  }), nullptr));
+  int worst = 0;
+  for (int r = 0; r < 256; r += 15) {
+    for (int g = 0; g < 256; g += 15) {
+      for (int b = 0; b < 256; b += 15) {
+        const uint8_t in[3] = {(uint8_t)r, (uint8_t)g, (uint8_t)b};
+        uint8_t out[3];
+        lut.apply(in, out, 1);
+        const float fr = r / 255.0f, fg = g / 255.0f, fb = b / 255.0f;
+        const float want[3] = {fr * fr, std::sqrt(fg), fr * fg * fb};
+        for (int c = 0; c < 3; ++c) worst = std::max(worst, std::abs((int)out[c] - (int)std::lround(want[c] * 255.0f)));
+      }
+    }
+  }
+  CCU_CHECK(worst <= 1);
+}
+
+void test_tetrahedron_choice() {
+  // On a 2^3 lattice that is 1 only at (1,1,1), tetrahedral interpolation
+  // gives min(r, g, b) (trilinear would give r * g * b); 0 only at (0,0,0)
+  // gives max(r, g, b). Every order of the fractions picks a different one
+  // of the six tetrahedra.
+  Lut3d lut;
+  CCU_CHECK(lut.load_values(2, lattice(2, [](float r, float g, float b, float* out) {
+    out[0] = (r > 0 && g > 0 && b > 0) ? 1.0f : 0.0f;
+    out[1] = (r > 0 || g > 0 || b > 0) ? 1.0f : 0.0f;
+    out[2] = b;
+  }), nullptr));
+  const uint8_t v[3] = {200, 120, 40};
+  const int order[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+  for (const auto& o : order) {
+    const uint8_t in[3] = {v[o[0]], v[o[1]], v[o[2]]};
+    uint8_t out[3];
+    lut.apply(in, out, 1);
+    CCU_CHECK(std::abs((int)out[0] - 40) <= 1);
+    CCU_CHECK(std::abs((int)out[1] - 200) <= 1);
+    CCU_CHECK(std::abs((int)out[2] - (int)in[2]) <= 1);
+  }
+
+  // In place, several pixels at once.
+  uint8_t px[6] = {255, 255, 255, 10, 0, 0};
+  lut.apply(px, px, 2);
+  CCU_CHECK(px[0] == 255 && px[1] == 255 && px[2] == 255);
+  CCU_CHECK(px[3] == 0 && px[4] == 10 && px[5] == 0);
+}
+
+void test_cube_file() {
+  const std::string path = temp_path("ccu_lut_test");
+  std::string err;
+  Lut3d lut;
+
+  // Title, comments and a domain covering only the lower half of the codes.
+  std::string body = "# monitoring LUT\nTITLE \"Half range\"\nDOMAIN_MIN 0 0 0\nDOMAIN_MAX 0.5 0.5 0.5\n";
+  body += cube_body(2, lattice(2, identity));
+  CCU_CHECK(write_file(path, body));
+  CCU_CHECK(lut.load_cube(path, &err));
+  CCU_CHECK(lut.title() == "Half range");
+  uint8_t px[9] = {64, 64, 64, 128, 128, 128, 255, 0, 255};
+  lut.apply(px, px, 3);
+  CCU_CHECK(std::abs((int)px[0] - 128) <= 1);
+  CCU_CHECK(px[3] >= 254 && px[6] == 255 && px[7] == 0);
+
+  // Larger lattices are resampled to kMaxSize and stay accurate.
+  CCU_CHECK(write_file(path, cube_body(40, lattice(40, identity))));
+  CCU_CHECK(lut.load_cube(path, &err));
+  CCU_CHECK_EQ(lut.size(), Lut3d::kMaxSize);
+  CCU_CHECK(lut.title().empty());
+  CCU_CHECK(max_error(lut, [](const uint8_t* in, int* e) { for (int c = 0; c < 3; ++c) e[c] = in[c]; }) <= 1);
+
+  const char* bad[] = {
+    "0 0 0\n1 1 1\n",                                  // no LUT_3D_SIZE
+    "LUT_3D_SIZE 2\n0 0 0\n1 1 1\n",                   // too few entries
+    "LUT_1D_SIZE 2\n0 0 0\n1 1 1\n",                   // 1D
+    "LUT_3D_SIZE 1\n0 0 0\n",                          // size out of range
+    "LUT_3D_SIZE 2\n0 0 x\n",                          // bad data line
+  };
+  for (const char* b : bad) {
+    err.clear();
+    CCU_CHECK(write_file(path, b));
+    CCU_CHECK(!lut.load_cube(path, &err));
+    CCU_CHECK(!err.empty());
+  }
+  CCU_CHECK(!lut.load_cube(path + ".missing", &err));
+  CCU_CHECK(!lut.load_values(Lut3d::kMaxSize + 1, {}, &err));
+  ::unlink(path.c_str());
+}
+
+} // namespace
+
+int main() {
+  test_affine_exact();
+  test_lattice_points();
+  test_tetrahedron_choice();
+  test_cube_file();
+  return ccu_test::result();
+}
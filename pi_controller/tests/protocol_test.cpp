@@ -0,0 +1,124 @@
+// CCU1 framing and the ACK timing extension: wire layout of Header and
+// TimingExt, CRC, a FLAG_TIMING ACK round trip as ccu_cli decodes it, and
+// parse_packet's rejections.
+#include "../src/protocol.hpp"
+#include "check.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+using namespace ccu;
+
+namespace {
+
+void test_layout() {
+  CCU_CHECK_EQ(offsetof(Header, payload_len), 6);
+  CCU_CHECK_EQ(offsetof(Header, seq), 8);
+  CCU_CHECK_EQ(offsetof(Header, target_mask), 12);
+  CCU_CHECK_EQ(offsetof(Header, flags), 14);
+
+  CCU_CHECK_EQ(offsetof(TimingExt, rx_mono_us), 0);
+  CCU_CHECK_EQ(offsetof(TimingExt, queue_us), 8);
+  CCU_CHECK_EQ(offsetof(TimingExt, handler_us), 12);
+  CCU_CHECK_EQ(offsetof(TimingExt, sdk_us), 16);
+  CCU_CHECK_EQ(offsetof(TimingExt, sdk_result), 48);
+  CCU_CHECK_EQ(offsetof(TimingExt, version), 80);
+  CCU_CHECK_EQ(offsetof(TimingExt, ext_len), 81);
+}
+
+void test_crc() {
+  const char* check = "123456789";
+  CCU_CHECK_EQ(crc32_ieee(reinterpret_cast<const uint8_t*>(check), 9), 0xCBF43926u);
+  CCU_CHECK_EQ(crc32_ieee(nullptr, 0), 0);
+}
+
+void test_timing_ack_round_trip() {
+  const uint8_t body[5] = {0x03, 0x00, 0x00, 0x01, 0x03};
+  TimingExt ext{};
+  ext.rx_mono_us = 0x0123456789ABCDEFull;
+  ext.queue_us = 41;
+  ext.handler_us = 382180;
+  for (int i = 0; i < 8; ++i) ext.sdk_us[i] = 1000u * (uint32_t)(i + 1);
+  ext.sdk_result[1] = TIMING_TIMED_OUT;
+  ext.sdk_result[7] = TIMING_FAILED_NO_SDK;
+  ext.version = TIMING_EXT_VER;
+  ext.ext_len = (uint8_t)sizeof(TimingExt);
+
+  uint8_t payload[sizeof(body) + sizeof(TimingExt)];
+  std::memcpy(payload, body, sizeof(body));
+  std::memcpy(payload + sizeof(body), &ext, sizeof(ext));
+
+  uint8_t frame[256];
+  const size_t n = build_resp_ack(frame, sizeof(frame), 0xA1B2C3D4u, 0x03, RESP_OK, payload, sizeof(payload),
+                                  FLAG_TIMING);
+  CCU_CHECK_EQ(n, sizeof(Header) + sizeof(payload) + 4);
+  const uint8_t magic[4] = {'1', 'U', 'C', 'C'};
+  CCU_CHECK(std::memcmp(frame, magic, 4) == 0);
+  CCU_CHECK_EQ(frame[5], MSG_RESP_ACK);
+  CCU_CHECK_EQ(frame[8], 0xD4);  // seq little-endian
+  CCU_CHECK_EQ(frame[14], FLAG_TIMING);
+
+  Header h{};
+  const uint8_t* pl = nullptr;
+  size_t pl_len = 0;
+  uint8_t err = 0xFF;
+  CCU_CHECK(parse_packet(frame, n, h, pl, pl_len, err));
+  CCU_CHECK_EQ(err, RESP_OK);
+  CCU_CHECK_EQ(h.seq, 0xA1B2C3D4u);
+  CCU_CHECK_EQ(h.target_mask, 0x03);
+  CCU_CHECK_EQ(h.cmd_or_code, RESP_OK);
+  CCU_CHECK((h.flags & FLAG_TIMING) != 0);
+  CCU_CHECK_EQ(pl_len, sizeof(payload));
+  if (pl_len != sizeof(payload)) return;
+
+  // The extension is found from the end of the payload, as ccu_cli does.
+  CCU_CHECK_EQ(pl[pl_len - 1], sizeof(TimingExt));
+  TimingExt got{};
+  std::memcpy(&got, pl + pl_len - sizeof(TimingExt), sizeof(got));
+  CCU_CHECK(std::memcmp(&got, &ext, sizeof(ext)) == 0);
+  CCU_CHECK(std::memcmp(pl, body, sizeof(body)) == 0);
+}
+
+void test_rejections() {
+  const uint8_t body[3] = {1, 2, 3};
+  uint8_t frame[64];
+  const size_t n = build_req_cmd(frame, sizeof(frame), 7, 0xFF, CMD_RUNSTOP, body, sizeof(body));
+  CCU_CHECK_EQ(n, sizeof(Header) + sizeof(body) + 4);
+  CCU_CHECK_EQ(build_req_cmd(frame, n - 1, 7, 0xFF, CMD_RUNSTOP, body, sizeof(body)), 0);
+
+  Header h{};
+  const uint8_t* pl = nullptr;
+  size_t pl_len = 0;
+  uint8_t err = 0;
+
+  CCU_CHECK(!parse_packet(frame, n - 1, h, pl, pl_len, err));
+  CCU_CHECK_EQ(err, RESP_BAD_FORMAT);
+  CCU_CHECK(!parse_packet(frame, sizeof(Header), h, pl, pl_len, err));
+  CCU_CHECK_EQ(err, RESP_BAD_FORMAT);
+
+  uint8_t bad[64];
+  std::memcpy(bad, frame, n);
+  bad[sizeof(Header) + 1] ^= 0x40;
+  CCU_CHECK(!parse_packet(bad, n, h, pl, pl_len, err));
+  CCU_CHECK_EQ(err, RESP_BAD_CRC);
+
+  std::memcpy(bad, frame, n);
+  bad[4] = VER + 1;
+  CCU_CHECK(!parse_packet(bad, n, h, pl, pl_len, err));
+  CCU_CHECK_EQ(err, RESP_BAD_FORMAT);
+
+  CCU_CHECK(parse_packet(frame, n, h, pl, pl_len, err));
+  CCU_CHECK_EQ(h.msg_type, MSG_REQ_CMD);
+  CCU_CHECK_EQ(h.cmd_or_code, CMD_RUNSTOP);
+  CCU_CHECK_EQ(h.flags, 0);
+}
+
+} // namespace
+
+int main() {
+  test_layout();
+  test_crc();
+  test_timing_ack_round_trip();
+  test_rejections();
+  return ccu_test::result();
+}
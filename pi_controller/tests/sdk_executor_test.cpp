@@ -0,0 +1,100 @@
+// SdkExecutor: run_each across slots under one deadline (parallel, not one
+// after another), a hung slot timed out while the others complete, its late
+// completion reported, and the slot's next call on a fresh worker.
+#include "../src/sdk_executor.hpp"
+#include "check.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace ccu;
+
+namespace {
+
+uint64_t now_us() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// A hung SDK call: blocks until released.
+struct Gate {
+  std::mutex mu;
+  std::condition_variable cv;
+  bool open = false;
+
+  void wait() {
+    std::unique_lock<std::mutex> lk(mu);
+    cv.wait(lk, [&] { return open; });
+  }
+  void release() {
+    {
+      std::lock_guard<std::mutex> lk(mu);
+      open = true;
+    }
+    cv.notify_all();
+  }
+};
+
+void test_parallel() {
+  SdkExecutor ex;
+  std::atomic<int> ran{0};
+  const uint64_t t0 = now_us();
+  const auto st = ex.run_each(0x0F, [&](int) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ran.fetch_add(1);
+  }, now_us() + 5000000);
+  const uint64_t took = now_us() - t0;
+  for (int i = 0; i < 8; ++i) CCU_CHECK_EQ(st[(size_t)i], SdkExecutor::DONE);
+  CCU_CHECK_EQ(ran.load(), 4);
+  CCU_CHECK(took < 300000);  // one sleep, not four
+}
+
+void test_hung_slot() {
+  SdkExecutor ex;
+  auto gate = std::make_shared<Gate>();
+  std::atomic<int> done{0}, late{0};
+  std::atomic<int> late_slot{-1};
+  const auto st = ex.run_each(0x06, [gate, &done](int slot) {
+    if (slot == 2) gate->wait();
+    done.fetch_add(1);
+  }, now_us() + 100000, [&](int slot) {
+    late_slot.store(slot);
+    late.fetch_add(1);
+  });
+  CCU_CHECK_EQ(st[1], SdkExecutor::DONE);
+  CCU_CHECK_EQ(st[2], SdkExecutor::TIMED_OUT);
+  CCU_CHECK_EQ(done.load(), 1);
+  CCU_CHECK_EQ(late.load(), 0);
+
+  // Slot 2's next call does not queue behind the hung one.
+  bool fresh = false;
+  CCU_CHECK_EQ(ex.run(2, [&] { fresh = true; }, now_us() + 1000000), SdkExecutor::DONE);
+  CCU_CHECK(fresh);
+
+  gate->release();
+  for (int i = 0; i < 200 && late.load() == 0; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  CCU_CHECK_EQ(late.load(), 1);
+  CCU_CHECK_EQ(late_slot.load(), 2);
+}
+
+void test_single_run() {
+  SdkExecutor ex;
+  auto gate = std::make_shared<Gate>();
+  std::atomic<bool> late{false};
+  CCU_CHECK_EQ(ex.run(5, [gate] { gate->wait(); }, now_us() + 50000, [&] { late = true; }), SdkExecutor::TIMED_OUT);
+  gate->release();
+  for (int i = 0; i < 200 && !late.load(); ++i) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  CCU_CHECK(late.load());
+  CCU_CHECK_EQ(ex.run_each(0, [](int) {}, now_us())[5], SdkExecutor::DONE);
+}
+
+} // namespace
+
+int main() {
+  test_parallel();
+  test_hung_slot();
+  test_single_run();
+  return ccu_test::result();
+}
@@ -0,0 +1,228 @@
+// Shared-memory live-view ring: the daemon's writer (shm_write_frame) and
+// the reader tools use (tools/ccu_shm_client.hpp) over a real memfd handed
+// out on a unix socket. Covers the subscribe handshake, skip counts, a
+// frame lapped while in use, and a writer racing the reader: every frame
+// the reader accepts must be whole.
+#include "../src/shm_layout.hpp"
+#include "../tools/ccu_shm_client.hpp"
+#include "check.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace ccu;
+
+namespace {
+
+constexpr uint32_t kFrames = 4;
+
+struct Ring {
+  int memfd = -1;
+  int event_fd = -1;
+  uint8_t* base = nullptr;
+  size_t total = 0;
+  uint64_t frame_bytes = 0;
+};
+
+bool make_ring(Ring& r) {
+  const size_t page = (size_t)::sysconf(_SC_PAGESIZE);
+  const uint32_t header_bytes = (uint32_t)page;
+  r.frame_bytes = page;
+  r.total = header_bytes + kFrames * r.frame_bytes;
+  r.memfd = ::memfd_create("ccu-shm-test", MFD_CLOEXEC);
+  r.event_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (r.memfd < 0 || r.event_fd < 0 || ::ftruncate(r.memfd, (off_t)r.total) < 0) return false;
+  void* p = ::mmap(nullptr, r.total, PROT_READ | PROT_WRITE, MAP_SHARED, r.memfd, 0);
+  if (p == MAP_FAILED) return false;
+  r.base = (uint8_t*)p;
+  shm_init_ring(r.base, 0, kFrames, header_bytes, r.frame_bytes, r.total);
+  return true;
+}
+
+// Frame seq: its size and every byte derive from seq, so a reader can tell
+// a whole frame from a mix of two.
+uint32_t frame_size(uint64_t seq) { return 100 + (uint32_t)(seq * 37 % 3000); }
+
+void write_frame(Ring& r, uint64_t seq) {
+  std::vector<uint8_t> jpeg(frame_size(seq), (uint8_t)seq);
+  shm_write_frame(r.base, seq, jpeg.data(), (uint32_t)jpeg.size(), seq * 1000, (uint32_t)seq + 7);
+  const uint64_t one = 1;
+  (void)!::write(r.event_fd, &one, sizeof(one));
+}
+
+// The daemon's side of the subscribe handshake (shm_export.cpp), for
+// `connections` clients: slot 0 gets the ring, anything else kShmNoSlot.
+void serve(int listen_fd, const Ring& r, int connections) {
+  for (int i = 0; i < connections; ++i) {
+    const int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) return;
+    uint8_t slot = 0xFF;
+    (void)!::recv(fd, &slot, 1, 0);
+    ShmReply reply{};
+    reply.status = slot == 0 ? kShmOk : kShmNoSlot;
+    reply.version = (uint8_t)kShmVersion;
+    reply.frames = kFrames;
+    iovec iov{&reply, sizeof(reply)};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+    if (reply.status == kShmOk) {
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+      cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+      cm->cmsg_level = SOL_SOCKET;
+      cm->cmsg_type = SCM_RIGHTS;
+      cm->cmsg_len = CMSG_LEN(2 * sizeof(int));
+      const int fds[2] = {r.memfd, r.event_fd};
+      std::memcpy(CMSG_DATA(cm), fds, sizeof(fds));
+    }
+    (void)!::sendmsg(fd, &msg, MSG_NOSIGNAL);
+    if (reply.status != kShmOk) ::close(fd);
+    // The subscriber's socket stays open: closing it would read as the
+    // daemon going away.
+  }
+}
+
+bool frame_whole(const ShmClient::Frame& f) {
+  if (f.size != frame_size(f.seq) || f.captured_ns != f.seq * 1000 || f.frame_no != (uint32_t)f.seq + 7) return false;
+  for (size_t i = 0; i < f.size; ++i) {
+    if (f.jpeg[i] != (uint8_t)f.seq) return false;
+  }
+  return true;
+}
+
+void test_layout(const Ring& r) {
+  const auto* h = reinterpret_cast<const ShmRingHeader*>(r.base);
+  CCU_CHECK_EQ(h->magic, kShmMagic);
+  CCU_CHECK_EQ(h->version, kShmVersion);
+  CCU_CHECK_EQ(h->frames, kFrames);
+  CCU_CHECK_EQ(h->total_bytes, r.total);
+  CCU_CHECK_EQ(h->write_seq.load(), 0);
+  CCU_CHECK_EQ(offsetof(ShmRingHeader, write_seq), 32);
+  CCU_CHECK_EQ(offsetof(ShmEntry, size), 16);
+  CCU_CHECK_EQ((uint8_t*)shm_entries(r.base) - r.base, 64);
+}
+
+void test_sequential(ShmClient& lv, Ring& r) {
+  ShmClient::Frame f;
+  CCU_CHECK(!lv.next(f));
+  CCU_CHECK(!lv.wait(10));
+
+  write_frame(r, 1);
+  CCU_CHECK(lv.wait(1000));
+  CCU_CHECK(lv.next(f));
+  CCU_CHECK_EQ(f.seq, 1);
+  CCU_CHECK_EQ(f.skipped, 0);
+  CCU_CHECK(frame_whole(f));
+  CCU_CHECK(lv.still_valid(f));
+  CCU_CHECK(!lv.next(f));
+
+  // Frame 5 reuses frame 1's entry while the reader still holds it.
+  ShmClient::Frame held = f;
+  for (uint64_t s = 2; s <= 6; ++s) write_frame(r, s);
+  CCU_CHECK(!lv.still_valid(held));
+  CCU_CHECK(lv.next(f));
+  CCU_CHECK_EQ(f.seq, 6);
+  CCU_CHECK_EQ(f.skipped, 4);
+  CCU_CHECK(frame_whole(f));
+}
+
+void test_racing_writer(ShmClient& lv, Ring& r, uint64_t first) {
+  // The writer publishes in bursts of eight, twice the ring, so entries are
+  // regularly rewritten while the reader is on them; it stops once the
+  // reader has checked enough frames (or after a few seconds on a slow box).
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> last{0};
+  std::thread writer([&] {
+    uint64_t s = first;
+    for (; !stop.load(std::memory_order_acquire); ++s) {
+      write_frame(r, s);
+      if (s % 8 == 0) std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    last.store(s - 1, std::memory_order_release);
+  });
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+  uint64_t accepted = 0, discarded = 0, torn = 0, prev = 0;
+  std::vector<uint8_t> copy;
+  ShmClient::Frame f;
+  while (true) {
+    if (!stop.load(std::memory_order_relaxed) &&
+        (accepted >= 2000 || std::chrono::steady_clock::now() > deadline))
+      stop.store(true, std::memory_order_release);
+    if (!lv.next(f)) {
+      if (stop.load(std::memory_order_relaxed) && last.load(std::memory_order_acquire) != 0 && !lv.wait(0)) break;
+      continue;
+    }
+    CCU_CHECK(f.seq > prev);
+    prev = f.seq;
+    copy.assign(f.jpeg, f.jpeg + std::min<size_t>(f.size, r.frame_bytes));
+    ShmClient::Frame mine = f;
+    mine.jpeg = copy.data();
+    if (!lv.still_valid(f)) {
+      ++discarded;
+      continue;
+    }
+    ++accepted;
+    if (!frame_whole(mine)) ++torn;
+  }
+  writer.join();
+  CCU_CHECK_EQ(torn, 0);
+  CCU_CHECK(accepted > 0);
+  CCU_CHECK_EQ(prev, last.load());
+  std::printf("racing writer: %llu frames written, %llu accepted, %llu discarded as lapped\n",
+              (unsigned long long)(last.load() - first + 1), (unsigned long long)accepted,
+              (unsigned long long)discarded);
+}
+
+} // namespace
+
+int main() {
+  Ring r;
+  CCU_CHECK(make_ring(r));
+  if (!r.base) return ccu_test::result();
+  test_layout(r);
+
+  const char* dir = std::getenv("TMPDIR");
+  const std::string path = std::string(dir && *dir ? dir : "/tmp") + "/ccu_shm_test." + std::to_string(::getpid());
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  const int listen_fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  ::unlink(path.c_str());
+  CCU_CHECK(listen_fd >= 0 && ::bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) == 0 && ::listen(listen_fd, 4) == 0);
+  std::thread server(serve, listen_fd, std::cref(r), 2);
+
+  std::string err;
+  {
+    ShmClient none;
+    CCU_CHECK(!none.open(path, 3, &err));
+    CCU_CHECK(err == "slot has no live view");
+  }
+  ShmClient lv;
+  CCU_CHECK(lv.open(path, 0, &err));
+  server.join();
+  if (lv.connected()) {
+    CCU_CHECK_EQ(lv.ring_frames(), kFrames);
+    test_sequential(lv, r);
+    test_racing_writer(lv, r, 7);
+  }
+
+  lv.close();
+  ::close(listen_fd);
+  ::unlink(path.c_str());
+  return ccu_test::result();
+}
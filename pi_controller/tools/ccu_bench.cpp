@@ -0,0 +1,410 @@
+// ccu_bench: CCU1 request/ACK load generator.
+//
+// Drives a weighted mix of commands at a fixed rate (open loop) or with a
+// fixed number in flight (closed loop), over UDP or a UART/pty, and reports
+// per-command RTT percentiles, timeouts and framing errors. Gates such as
+// --max-p99-ms turn it into a pass/fail regression check (exit code 1).
+#include "../src/protocol.hpp"
+#include "ccu_link.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+
+using namespace ccu;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+enum Kind : int {
+  K_RUNSTOP = 0,
+  K_STATUS,
+  K_OPTIONS,
+  K_SET,
+  K_STEP,
+  K_COUNT
+};
+
+const char* const kKindNames[K_COUNT] = { "runstop", "status", "options", "set", "step" };
+const uint8_t kKindCmd[K_COUNT] = { CMD_RUNSTOP, CMD_GET_STATUS, CMD_GET_OPTIONS, CMD_SET_VALUE, CMD_PARAM_STEP };
+
+struct Options {
+  std::string udp = "127.0.0.1:5555";
+  std::string uart;                  // "/dev/ttyX[@baud]"; empty = UDP
+  std::vector<int> mix;              // expanded weighted schedule of kinds
+  uint8_t target = 0x01;
+  double rate = 0.0;                 // req/s; 0 = closed loop
+  size_t window = 0;                 // max in flight; 0 = default for mode
+  double duration_s = 10.0;
+  uint64_t count = 0;                // overrides duration when set
+  uint32_t timeout_ms = 2000;
+  uint8_t opt = OPT_ISO;
+  uint32_t value = 800;
+  bool csv = false;
+  double max_p99_ms = 0.0;
+  int64_t max_timeouts = -1;
+};
+
+struct Pending {
+  int kind;
+  Clock::time_point t0;
+};
+
+struct KindStats {
+  uint64_t sent = 0;
+  uint64_t ok = 0;
+  uint64_t nak = 0;                  // ACK with resp code != RESP_OK
+  uint64_t timeouts = 0;
+  std::vector<uint32_t> rtt_us;
+};
+
+struct Totals {
+  uint64_t bad_crc = 0;              // frames failing CRC on our side
+  uint64_t bad_crc_reported = 0;     // daemon reported RESP_BAD_CRC
+  uint64_t malformed = 0;
+  uint64_t unmatched = 0;            // late or unknown seq
+  uint64_t late_sends = 0;           // open loop: window full at schedule time
+};
+
+void usage() {
+  std::fprintf(stderr,
+    "Usage: ccu_bench [options]\n"
+    "  --udp <ip>:<port>       daemon address (default 127.0.0.1:5555)\n"
+    "  --uart <dev>[@baud]     talk over a UART or pty instead of UDP\n"
+    "  --mix <k[:w],...>       runstop,status,options,set,step (default status)\n"
+    "  --target <hex>          target mask (default 01)\n"
+    "  --rate <req/s>          open loop at a fixed rate (default: closed loop)\n"
+    "  --window <n>            max requests in flight (closed loop: 1, open loop: 64)\n"
+    "  --duration <s>          run time (default 10)\n"
+    "  --count <n>             stop after n requests instead of --duration\n"
+    "  --timeout <ms>          per-request timeout (default 2000)\n"
+    "  --opt <id> --value <v>  option/value for options, set and step (default ISO, 800)\n"
+    "  --max-p99-ms <ms>       fail (exit 1) if any command p99 exceeds this\n"
+    "  --max-timeouts <n>      fail (exit 1) if more than n requests time out\n"
+    "  --csv                   machine-readable summary\n");
+}
+
+bool parse_mix(const std::string& spec, std::vector<int>& out) {
+  out.clear();
+  size_t pos = 0;
+  while (pos <= spec.size()) {
+    const size_t comma = spec.find(',', pos);
+    const std::string item = spec.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+    pos = (comma == std::string::npos) ? spec.size() + 1 : comma + 1;
+    if (item.empty()) continue;
+
+    const size_t colon = item.find(':');
+    const std::string name = item.substr(0, colon);
+    const int weight = (colon == std::string::npos) ? 1 : std::atoi(item.c_str() + colon + 1);
+    int kind = -1;
+    for (int k = 0; k < K_COUNT; ++k) {
+      if (name == kKindNames[k]) kind = k;
+    }
+    if (kind < 0 || weight <= 0) {
+      std::fprintf(stderr, "Bad --mix entry '%s'\n", item.c_str());
+      return false;
+    }
+    for (int i = 0; i < weight; ++i) out.push_back(kind);
+  }
+  // Interleave so a 4:1 mix does not send four in a row of one kind.
+  std::vector<int> spread;
+  std::vector<int> left(K_COUNT, 0);
+  for (int k : out) left[(size_t)k]++;
+  const int total = (int)out.size();
+  std::vector<double> credit(K_COUNT, 0.0);
+  for (int i = 0; i < total; ++i) {
+    int best = -1;
+    for (int k = 0; k < K_COUNT; ++k) {
+      if (!left[(size_t)k]) continue;
+      credit[(size_t)k] += (double)left[(size_t)k];
+      if (best < 0 || credit[(size_t)k] > credit[(size_t)best]) best = k;
+    }
+    credit[(size_t)best] -= (double)total;
+    spread.push_back(best);
+  }
+  out.swap(spread);
+  return !out.empty();
+}
+
+bool parse_args(int argc, char** argv, Options& o) {
+  parse_mix("status", o.mix);
+  for (int i = 1; i < argc; ++i) {
+    const std::string a = argv[i];
+    auto next = [&](const char*& v) -> bool {
+      if (i + 1 >= argc) { std::fprintf(stderr, "%s needs a value\n", a.c_str()); return false; }
+      v = argv[++i];
+      return true;
+    };
+    const char* v = nullptr;
+    if (a == "--csv") { o.csv = true; continue; }
+    if (a == "-h" || a == "--help") return false;
+    if (!next(v)) return false;
+
+    if (a == "--udp") {
+      o.udp = v;
+    } else if (a == "--uart") {
+      o.uart = v;
+    } else if (a == "--mix") {
+      if (!parse_mix(v, o.mix)) return false;
+    } else if (a == "--target") {
+      o.target = (uint8_t)std::strtoul(v, nullptr, 16);
+    } else if (a == "--rate") {
+      o.rate = std::atof(v);
+    } else if (a == "--window") {
+      o.window = (size_t)std::strtoul(v, nullptr, 10);
+    } else if (a == "--duration") {
+      o.duration_s = std::atof(v);
+    } else if (a == "--count") {
+      o.count = std::strtoull(v, nullptr, 10);
+    } else if (a == "--timeout") {
+      o.timeout_ms = (uint32_t)std::strtoul(v, nullptr, 10);
+    } else if (a == "--opt") {
+      o.opt = (uint8_t)std::strtoul(v, nullptr, 0);
+    } else if (a == "--value") {
+      o.value = (uint32_t)std::strtoul(v, nullptr, 0);
+    } else if (a == "--max-p99-ms") {
+      o.max_p99_ms = std::atof(v);
+    } else if (a == "--max-timeouts") {
+      o.max_timeouts = std::atoll(v);
+    } else {
+      std::fprintf(stderr, "Unknown option %s\n", a.c_str());
+      return false;
+    }
+  }
+  if (o.window == 0) o.window = (o.rate > 0.0) ? 64 : 1;
+  return true;
+}
+
+size_t build_request(uint8_t* out, size_t out_max, const Options& o, int kind, uint32_t seq, uint64_t nth) {
+  uint8_t pl[8] = {0};
+  size_t pl_len = 0;
+  switch (kind) {
+    case K_RUNSTOP:
+      pl[0] = (uint8_t)((nth & 1u) ? 0 : 1);       // alternate run/stop so the camera ends stopped
+      pl_len = 1;
+      break;
+    case K_OPTIONS:
+      pl[0] = o.opt;
+      pl_len = 1;
+      break;
+    case K_SET:
+      pl[0] = o.opt;
+      pl[1] = (uint8_t)(o.value & 0xFF);
+      pl[2] = (uint8_t)((o.value >> 8) & 0xFF);
+      pl[3] = (uint8_t)((o.value >> 16) & 0xFF);
+      pl[4] = (uint8_t)((o.value >> 24) & 0xFF);
+      pl_len = 5;
+      break;
+    case K_STEP:
+      pl[0] = o.opt;
+      pl[1] = (uint8_t)(int8_t)((nth & 1u) ? -1 : 1);  // +1/-1 pairs leave the value unchanged
+      pl_len = 2;
+      break;
+    default:
+      break;
+  }
+  return build_req_cmd(out, out_max, seq, o.target, kKindCmd[kind], pl, pl_len);
+}
+
+double percentile_ms(std::vector<uint32_t>& v, double p) {
+  if (v.empty()) return 0.0;
+  const size_t idx = (size_t)std::max(0.0, std::ceil(p * (double)v.size()) - 1.0);
+  return (double)v[std::min(idx, v.size() - 1)] / 1000.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options o;
+  if (!parse_args(argc, argv, o)) {
+    usage();
+    return 2;
+  }
+
+  ClientLink link;
+  const bool opened = o.uart.empty() ? link.open_udp(o.udp) : link.open_uart(o.uart);
+  if (!opened) {
+    std::fprintf(stderr, "Failed to open %s\n", o.uart.empty() ? o.udp.c_str() : o.uart.c_str());
+    return 1;
+  }
+
+  KindStats stats[K_COUNT];
+  std::vector<uint64_t> kind_nth(K_COUNT, 0);
+  Totals totals;
+  std::unordered_map<uint32_t, Pending> pending;
+  pending.reserve(o.window * 2);
+
+  uint32_t seq = ((uint32_t)getpid() << 16) | 1u;
+  uint64_t sent = 0;
+  size_t mix_pos = 0;
+
+  const auto timeout = std::chrono::milliseconds(o.timeout_ms);
+  const auto t_start = Clock::now();
+  const auto t_end = t_start + std::chrono::microseconds((int64_t)(o.duration_s * 1e6));
+  const auto period = (o.rate > 0.0) ? std::chrono::nanoseconds((int64_t)(1e9 / o.rate)) : std::chrono::nanoseconds(0);
+  auto next_send = t_start;
+  auto late_mark = Clock::time_point{};
+
+  uint8_t tx[512];
+  uint8_t rx[2048];
+
+  while (true) {
+    auto now = Clock::now();
+    const bool done_sending = o.count ? (sent >= o.count) : (now >= t_end);
+    if (done_sending && pending.empty()) break;
+
+    // Send whatever the schedule allows.
+    while (!(o.count ? (sent >= o.count) : (now >= t_end))) {
+      if (o.rate > 0.0) {
+        if (now < next_send) break;
+        if (pending.size() >= o.window) {
+          if (late_mark != next_send) {
+            totals.late_sends++;
+            late_mark = next_send;
+          }
+          break;
+        }
+      } else if (pending.size() >= o.window) {
+        break;
+      }
+
+      const int kind = o.mix[mix_pos++ % o.mix.size()];
+      if (++seq == 0) seq = 1;
+      const size_t n = build_request(tx, sizeof(tx), o, kind, seq, kind_nth[(size_t)kind]++);
+      if (!n || !link.send(tx, n)) {
+        std::perror("send");
+        return 1;
+      }
+      // Open loop measures from the scheduled time so a stalled daemon cannot
+      // hide latency by delaying our sends (coordinated omission).
+      pending[seq] = Pending{kind, (o.rate > 0.0) ? next_send : now};
+      stats[kind].sent++;
+      sent++;
+      if (o.rate > 0.0) next_send += period;
+      now = Clock::now();
+    }
+
+    // Drain responses.
+    while (true) {
+      const int n = link.recv(rx, sizeof(rx));
+      if (n <= 0) break;
+      const auto t_rx = Clock::now();
+
+      Header h{};
+      const uint8_t* pl = nullptr;
+      size_t pl_len = 0;
+      uint8_t err = RESP_OK;
+      if (!parse_packet(rx, (size_t)n, h, pl, pl_len, err)) {
+        if (err == RESP_BAD_CRC) totals.bad_crc++;
+        else totals.malformed++;
+        continue;
+      }
+      if (h.msg_type != MSG_RESP_ACK) {
+        totals.malformed++;
+        continue;
+      }
+      if (h.cmd_or_code == RESP_BAD_CRC) totals.bad_crc_reported++;
+
+      auto it = pending.find(h.seq);
+      if (it == pending.end()) {
+        totals.unmatched++;
+        continue;
+      }
+      KindStats& ks = stats[it->second.kind];
+      const auto rtt = std::chrono::duration_cast<std::chrono::microseconds>(t_rx - it->second.t0).count();
+      ks.rtt_us.push_back((uint32_t)std::max<int64_t>(0, rtt));
+      if (h.cmd_or_code == RESP_OK) ks.ok++;
+      else ks.nak++;
+      pending.erase(it);
+    }
+
+    // Expire timeouts.
+    now = Clock::now();
+    for (auto it = pending.begin(); it != pending.end();) {
+      if (now - it->second.t0 >= timeout) {
+        stats[it->second.kind].timeouts++;
+        it = pending.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    int wait_ms = 1;
+    if (o.rate > 0.0 && next_send > now) {
+      wait_ms = (int)std::min<int64_t>(1, std::chrono::duration_cast<std::chrono::milliseconds>(next_send - now).count());
+    }
+    link.wait(wait_ms);
+  }
+
+  const double elapsed_s = std::chrono::duration<double>(Clock::now() - t_start).count();
+  link.close();
+
+  // ---- Report ----
+  uint64_t total_ok = 0, total_nak = 0, total_tmo = 0;
+  double worst_p99 = 0.0;
+  if (o.csv) {
+    std::printf("cmd,sent,ok,nak,timeouts,p50_ms,p90_ms,p99_ms,max_ms\n");
+  } else {
+    std::printf("%-8s %8s %8s %6s %6s %9s %9s %9s %9s\n",
+                "cmd", "sent", "ok", "nak", "tmo", "p50_ms", "p90_ms", "p99_ms", "max_ms");
+  }
+  for (int k = 0; k < K_COUNT; ++k) {
+    KindStats& ks = stats[k];
+    if (!ks.sent) continue;
+    std::sort(ks.rtt_us.begin(), ks.rtt_us.end());
+    const double p50 = percentile_ms(ks.rtt_us, 0.50);
+    const double p90 = percentile_ms(ks.rtt_us, 0.90);
+    const double p99 = percentile_ms(ks.rtt_us, 0.99);
+    const double mx = ks.rtt_us.empty() ? 0.0 : ks.rtt_us.back() / 1000.0;
+    worst_p99 = std::max(worst_p99, p99);
+    total_ok += ks.ok;
+    total_nak += ks.nak;
+    total_tmo += ks.timeouts;
+    if (o.csv) {
+      std::printf("%s,%llu,%llu,%llu,%llu,%.3f,%.3f,%.3f,%.3f\n", kKindNames[k],
+                  (unsigned long long)ks.sent, (unsigned long long)ks.ok, (unsigned long long)ks.nak,
+                  (unsigned long long)ks.timeouts, p50, p90, p99, mx);
+    } else {
+      std::printf("%-8s %8llu %8llu %6llu %6llu %9.3f %9.3f %9.3f %9.3f\n", kKindNames[k],
+                  (unsigned long long)ks.sent, (unsigned long long)ks.ok, (unsigned long long)ks.nak,
+                  (unsigned long long)ks.timeouts, p50, p90, p99, mx);
+    }
+  }
+
+  const double tput = elapsed_s > 0.0 ? (double)(total_ok + total_nak) / elapsed_s : 0.0;
+  if (o.csv) {
+    std::printf("# elapsed_s=%.3f acked_per_s=%.1f bad_crc=%llu bad_crc_reported=%llu malformed=%llu unmatched=%llu late_sends=%llu\n",
+                elapsed_s, tput, (unsigned long long)totals.bad_crc, (unsigned long long)totals.bad_crc_reported,
+                (unsigned long long)totals.malformed, (unsigned long long)totals.unmatched,
+                (unsigned long long)totals.late_sends);
+  } else {
+    std::printf("elapsed %.2fs  sent %llu  acked %llu (%.1f/s)  timeouts %llu\n",
+                elapsed_s, (unsigned long long)sent, (unsigned long long)(total_ok + total_nak), tput,
+                (unsigned long long)total_tmo);
+    std::printf("bad_crc %llu  bad_crc_reported %llu  malformed %llu  unmatched %llu  late_sends %llu\n",
+                (unsigned long long)totals.bad_crc, (unsigned long long)totals.bad_crc_reported,
+                (unsigned long long)totals.malformed, (unsigned long long)totals.unmatched,
+                (unsigned long long)totals.late_sends);
+  }
+
+  bool pass = true;
+  if (o.max_p99_ms > 0.0 && worst_p99 > o.max_p99_ms) {
+    std::fprintf(stderr, "FAIL: p99 %.3f ms > %.3f ms\n", worst_p99, o.max_p99_ms);
+    pass = false;
+  }
+  if (o.max_timeouts >= 0 && (int64_t)total_tmo > o.max_timeouts) {
+    std::fprintf(stderr, "FAIL: %llu timeouts > %lld\n", (unsigned long long)total_tmo, (long long)o.max_timeouts);
+    pass = false;
+  }
+  if (totals.bad_crc || totals.bad_crc_reported) {
+    std::fprintf(stderr, "FAIL: CRC errors on the link\n");
+    pass = false;
+  }
+  return pass ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+// ccu_blend_bench: OSD alpha-blend kernel benchmark.
+//
+// Times the live-view OSD blend (src/alpha_blend.cpp) against the loop
+// OpenCVWrapper::OverlayImage used before: cv::split of the overlay for its
+// alpha plane, then a float blend per channel with multiplied offsets. Both
+// are reproduced on plain buffers so this builds without OpenCV. Checks
+// that the SIMD kernel matches the scalar one bit for bit and stays within
+// 1 of the float loop (which truncated instead of rounding).
+#include "../src/alpha_blend.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Size {
+  int w, h;
+};
+
+// What OverlayImage did: split the BGRA overlay into planes (a fresh
+// allocation per call) and blend with a float per channel.
+void legacy_overlay(const uint8_t* src, const uint8_t* ovl, uint8_t* result, int rows, int cols) {
+  std::vector<std::vector<uint8_t>> planes(4, std::vector<uint8_t>((size_t)rows * cols));
+  for (size_t i = 0; i < (size_t)rows * cols; ++i)
+    for (int ch = 0; ch < 4; ++ch) planes[(size_t)ch][i] = ovl[i * 4 + (size_t)ch];
+  const uint8_t* alpha_plane = planes[3].data();
+
+  const size_t step_alpha = (size_t)cols, step_src = (size_t)cols * 3, step_ovl = (size_t)cols * 4;
+  for (int r = 0; r < rows; ++r) {
+    for (int c = 0; c < cols; ++c) {
+      const uint8_t alpha = alpha_plane[(size_t)r * step_alpha + (size_t)c];
+      const float alpha_norm = (float)alpha / 255.f;
+      for (int ch = 0; ch < 3; ++ch) {
+        const uint8_t spix = src[(size_t)r * step_src + (size_t)c * 3 + (size_t)ch];
+        const uint8_t opix = ovl[(size_t)r * step_ovl + (size_t)c * 4 + (size_t)ch];
+        const float dpixf = (float)spix * (1.0f - alpha_norm) + (float)opix * alpha_norm;
+        result[(size_t)r * step_src + (size_t)c * 3 + (size_t)ch] = (dpixf >= 255.0f) ? 255 : (uint8_t)dpixf;
+      }
+    }
+  }
+}
+
+void new_overlay(const uint8_t* src, const uint8_t* ovl, uint8_t* result, int rows, int cols) {
+  for (int r = 0; r < rows; ++r)
+    ccu::blend_bgra_over_bgr(src + (size_t)r * cols * 3, ovl + (size_t)r * cols * 4, result + (size_t)r * cols * 3,
+                             (size_t)cols);
+}
+
+template <typename Fn>
+double time_ms(Fn&& fn, int iters) {
+  fn();  // warm up
+  const auto t0 = Clock::now();
+  for (int i = 0; i < iters; ++i) fn();
+  return std::chrono::duration<double, std::milli>(Clock::now() - t0).count() / iters;
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "Usage: ccu_blend_bench [--size WxH]... [--iters n]\n"
+               "Default sizes: 640x480 (OSD), 1024x576, 1920x1080.\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::vector<Size> sizes;
+  int iters = 20;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      Size s{};
+      if (std::sscanf(argv[++i], "%dx%d", &s.w, &s.h) != 2 || s.w <= 0 || s.h <= 0) {
+        usage();
+        return 2;
+      }
+      sizes.push_back(s);
+    } else if (std::strcmp(argv[i], "--iters") == 0 && i + 1 < argc) {
+      iters = std::max(1, std::atoi(argv[++i]));
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  if (sizes.empty()) sizes = {{640, 480}, {1024, 576}, {1920, 1080}};
+
+  std::printf("kernel: %s, %d iterations\n", ccu::blend_kernel_name(), iters);
+  std::printf("%-10s %12s %12s %9s %8s\n", "size", "legacy_ms", "kernel_ms", "speedup", "maxdiff");
+  bool ok = true;
+  uint32_t rng = 12345;
+  for (const Size& sz : sizes) {
+    const size_t px = (size_t)sz.w * sz.h;
+    std::vector<uint8_t> src(px * 3), ovl(px * 4), a(px * 3), b(px * 3), ref(px * 3);
+    for (auto& v : src) v = (uint8_t)((rng = rng * 1103515245u + 12345u) >> 16);
+    for (size_t i = 0; i < px; ++i) {
+      for (int ch = 0; ch < 3; ++ch) ovl[i * 4 + (size_t)ch] = (uint8_t)((rng = rng * 1103515245u + 12345u) >> 16);
+      // Mostly transparent with opaque text and soft edges, like a real OSD.
+      const uint32_t r = (rng = rng * 1103515245u + 12345u) >> 16;
+      ovl[i * 4 + 3] = (r % 10 < 7) ? 0 : (r % 10 < 9 ? 255 : (uint8_t)r);
+    }
+
+    const double legacy = time_ms([&] { legacy_overlay(src.data(), ovl.data(), a.data(), sz.h, sz.w); }, iters);
+    const double kernel = time_ms([&] { new_overlay(src.data(), ovl.data(), b.data(), sz.h, sz.w); }, iters);
+    for (int r = 0; r < sz.h; ++r)
+      ccu::blend_bgra_over_bgr_scalar(src.data() + (size_t)r * sz.w * 3, ovl.data() + (size_t)r * sz.w * 4,
+                                      ref.data() + (size_t)r * sz.w * 3, (size_t)sz.w);
+
+    int maxdiff = 0;
+    for (size_t i = 0; i < px * 3; ++i) maxdiff = std::max(maxdiff, std::abs((int)a[i] - (int)b[i]));
+    const bool exact = std::memcmp(b.data(), ref.data(), b.size()) == 0;
+    if (!exact || maxdiff > 1) ok = false;
+
+    char label[24];
+    std::snprintf(label, sizeof(label), "%dx%d", sz.w, sz.h);
+    std::printf("%-10s %12.3f %12.3f %8.1fx %8d%s\n", label, legacy, kernel, legacy / kernel, maxdiff,
+                exact ? "" : "  SIMD != scalar");
+  }
+  return ok ? 0 : 1;
+}
@@ -1,95 +1,982 @@
+// ccu_cli: scripted CCU1 client covering every command in protocol.hpp.
+//
+//   ccu_cli [--udp ip:port | --uart dev[@baud]] [--json] [--timing] [--target hex] <command> [args]
+//   ccu_cli [options] -            batch: one command per stdin line, pipelined
+//   ccu_cli <ip> <port> <run|stop> [mask_hex]      (original form)
+//
+// Batch lines may start with "@<hex>" to override the target mask, and
+// "sleep <ms>" waits for all earlier commands before pausing. "sync" runs
+// CMD_TIME_SYNC exchanges one at a time (this host's CLOCK_MONOTONIC is the
+// CCU clock); run-at/stop-at get one automatically unless a sync precedes them.
 #include "../src/protocol.hpp"
+#include "ccu_link.hpp"
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <iostream>
+#include <sstream>
 #include <string>
-#include <arpa/inet.h>
-#include <sys/socket.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include <unistd.h>
 
 using namespace ccu;
+using Clock = std::chrono::steady_clock;
 
-static size_t build_req_runstop(uint8_t* out, size_t out_max, uint32_t seq, uint8_t target_mask, bool run) {
-  const uint8_t payload[1] = {(uint8_t)(run ? 1 : 0)};
-  const size_t payload_len = 1;
-  const size_t total = sizeof(Header) + payload_len + 4;
-  if (out_max < total) return 0;
+namespace {
 
+struct Options {
+  std::string udp = "127.0.0.1:5555";
+  std::string uart;
+  uint8_t target = 0x01;
+  bool json = false;
+  bool timing = false;               // request the ACK timing extension
+  uint32_t timeout_ms = 0;           // 0 = per-command default
+  size_t window = 8;
+};
+
+struct Request {
+  std::string text;                  // original command line, for output
+  std::string name;
+  uint8_t cmd = 0;
+  uint8_t target = 0;
+  std::vector<uint8_t> payload;
+  bool is_sleep = false;             // "sleep" directive; no frame is sent
+  uint32_t sleep_ms = 0;
+  bool is_sync = false;              // "sync" directive: serial CMD_TIME_SYNC rounds
+  uint32_t sync_rounds = 0;
+  int64_t at_ms = -1;                // run-at/stop-at: target = send time + at_ms
+};
+
+struct Result {
+  bool done = false;
+  bool timed_out = false;
   Header h{};
-  h.magic = MAGIC;
-  h.version = VER;
-  h.msg_type = MSG_REQ_CMD;
-  h.payload_len = (uint16_t)payload_len;
-  h.seq = seq;
-  h.target_mask = target_mask;
-  h.cmd_or_code = CMD_RUNSTOP;
-  h.flags = 0;
+  std::vector<uint8_t> payload;      // without the timing extension
+  double rtt_ms = 0.0;
+  bool has_timing = false;
+  TimingExt timing{};
+};
 
-  std::memcpy(out, &h, sizeof(h));
-  std::memcpy(out + sizeof(Header), payload, payload_len);
+void usage() {
+  std::fprintf(stderr,
+    "Usage: ccu_cli [--udp ip:port | --uart dev[@baud]] [--json] [--timing] [--target hex]\n"
+    "               [--timeout ms] [--window n] <command> [args]\n"
+    "       ccu_cli [options] -        (read commands from stdin, pipelined)\n"
+    "       ccu_cli <ip> <port> <run|stop> [mask_hex]\n"
+    "Commands:\n"
+    "  run | stop                      CMD_RUNSTOP\n"
+    "  run-at | stop-at <ms>           CMD_RUNSTOP_AT, all selected cameras at send time + ms\n"
+    "  sync [rounds]                   CMD_TIME_SYNC clock-offset exchanges (default 8)\n"
+    "  status                          CMD_GET_STATUS (first selected slot)\n"
+    "  options <opt>                   CMD_GET_OPTIONS\n"
+    "  set <opt> <value>               CMD_SET_VALUE\n"
+    "  step <opt> <delta>              CMD_PARAM_STEP (delta -128..127)\n"
+    "  still [af]                      CMD_CAPTURE_STILL (af: half-press first)\n"
+    "  still-sync [af] [ms]            CMD_CAPTURE_SYNC, all selected cameras armed, then released\n"
+    "                                  together (at send time + ms if given)\n"
+    "  discover                        CMD_DISCOVER (reconnect selected slots)\n"
+    "  list                            CMD_LIST_CAMERAS\n"
+    "  stats                           CMD_GET_STATS (link health, latency, per-slot SDK)\n"
+    "  trace [seconds]                 CMD_TRACE_DUMP (Chrome trace JSON on the Pi, default 10 s)\n"
+    "  scopes                          CMD_GET_SCOPES (live-view exposure, first selected slot)\n"
+    "  focus                           CMD_GET_FOCUS (focus-assist sharpness, all selected slots)\n"
+    "  slot <n> [enable=0|1] [accept_fp=0|1] [ip=] [mac=] [user=] [pass=] [fp=]\n"
+    "                                  CMD_SET_SLOT_CONFIG\n"
+    "  raw <cmd_hex> [payload_hex]     arbitrary request\n"
+    "  <opt> is iso, wb, shutter, fps, project_fps or a number.\n");
+}
 
-  const uint32_t crc = crc32_ieee(out, sizeof(Header) + payload_len);
-  std::memcpy(out + sizeof(Header) + payload_len, &crc, 4);
-  return total;
+bool parse_opt(const std::string& s, uint8_t& out) {
+  if (s == "iso") out = OPT_ISO;
+  else if (s == "wb" || s == "white_balance") out = OPT_WHITE_BALANCE;
+  else if (s == "shutter") out = OPT_SHUTTER;
+  else if (s == "fps") out = OPT_FPS;
+  else if (s == "project_fps") out = OPT_PROJECT_FPS;
+  else {
+    char* end = nullptr;
+    const unsigned long v = std::strtoul(s.c_str(), &end, 0);
+    if (!end || *end || v == 0 || v > 0xFF) return false;
+    out = (uint8_t)v;
+  }
+  return true;
 }
 
-int main(int argc, char** argv) {
-  if (argc < 4) {
-    std::fprintf(stderr, "Usage: ccu_cli <ip> <port> <run|stop> [mask_hex]\n");
-    return 2;
+void put32(std::vector<uint8_t>& v, uint32_t x) {
+  v.push_back((uint8_t)(x & 0xFF));
+  v.push_back((uint8_t)((x >> 8) & 0xFF));
+  v.push_back((uint8_t)((x >> 16) & 0xFF));
+  v.push_back((uint8_t)((x >> 24) & 0xFF));
+}
+
+void put_str(std::vector<uint8_t>& v, const std::string& s) {
+  const size_t n = std::min<size_t>(s.size(), 255);
+  v.push_back((uint8_t)n);
+  v.insert(v.end(), s.begin(), s.begin() + (long)n);
+}
+
+bool parse_hex_bytes(const std::string& s, std::vector<uint8_t>& out) {
+  if (s.size() % 2) return false;
+  for (size_t i = 0; i < s.size(); i += 2) {
+    char* end = nullptr;
+    const std::string byte = s.substr(i, 2);
+    const unsigned long v = std::strtoul(byte.c_str(), &end, 16);
+    if (!end || *end) return false;
+    out.push_back((uint8_t)v);
   }
-  const char* ip = argv[1];
-  const int port = std::atoi(argv[2]);
-  const bool run = (std::string(argv[3]) == "run");
-  const uint8_t mask = (argc >= 5) ? (uint8_t)std::strtoul(argv[4], nullptr, 16) : 0x01;
+  return true;
+}
 
-  int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
-  if (fd < 0) { std::perror("socket"); return 1; }
+// Parses one command (already tokenized). Returns an error string, empty on success.
+std::string parse_request(std::vector<std::string> tok, uint8_t default_target, Request& r) {
+  r.target = default_target;
+  if (!tok.empty() && tok[0].size() > 1 && tok[0][0] == '@') {
+    r.target = (uint8_t)std::strtoul(tok[0].c_str() + 1, nullptr, 16);
+    tok.erase(tok.begin());
+  }
+  if (tok.empty()) return "empty command";
+  r.name = tok[0];
+  const std::string& c = tok[0];
 
-  sockaddr_in to{};
-  to.sin_family = AF_INET;
-  to.sin_port = htons((uint16_t)port);
-  if (::inet_pton(AF_INET, ip, &to.sin_addr) != 1) {
-    std::fprintf(stderr, "Bad IP\n");
-    return 1;
+  if (c == "run" || c == "stop") {
+    r.cmd = CMD_RUNSTOP;
+    r.payload.push_back(c == "run" ? 1 : 0);
+  } else if (c == "run-at" || c == "stop-at") {
+    if (tok.size() < 2) return "usage: " + c + " <ms>";
+    const long ms = std::strtol(tok[1].c_str(), nullptr, 10);
+    if (ms < 0 || ms > 10000) return "lead time must be 0..10000 ms";
+    r.cmd = CMD_RUNSTOP_AT;
+    r.payload.assign(9, 0);
+    r.payload[0] = (c == "run-at") ? 1 : 0;
+    r.at_ms = ms;
+  } else if (c == "sync") {
+    r.is_sync = true;
+    r.sync_rounds = (tok.size() >= 2) ? (uint32_t)std::strtoul(tok[1].c_str(), nullptr, 10) : 8u;
+    if (r.sync_rounds == 0 || r.sync_rounds > 64) return "usage: sync [rounds 1..64]";
+  } else if (c == "status") {
+    r.cmd = CMD_GET_STATUS;
+  } else if (c == "options") {
+    uint8_t opt = 0;
+    if (tok.size() < 2 || !parse_opt(tok[1], opt)) return "usage: options <opt>";
+    r.cmd = CMD_GET_OPTIONS;
+    r.payload.push_back(opt);
+  } else if (c == "set") {
+    uint8_t opt = 0;
+    if (tok.size() < 3 || !parse_opt(tok[1], opt)) return "usage: set <opt> <value>";
+    r.cmd = CMD_SET_VALUE;
+    r.payload.push_back(opt);
+    put32(r.payload, (uint32_t)std::strtoul(tok[2].c_str(), nullptr, 0));
+  } else if (c == "step") {
+    uint8_t opt = 0;
+    if (tok.size() < 3 || !parse_opt(tok[1], opt)) return "usage: step <opt> <delta>";
+    const long d = std::strtol(tok[2].c_str(), nullptr, 10);
+    if (d < -128 || d > 127) return "step delta out of range";
+    r.cmd = CMD_PARAM_STEP;
+    r.payload.push_back(opt);
+    r.payload.push_back((uint8_t)(int8_t)d);
+  } else if (c == "still") {
+    r.cmd = CMD_CAPTURE_STILL;
+    r.payload.push_back((tok.size() >= 2 && (tok[1] == "af" || tok[1] == "1")) ? 1 : 0);
+  } else if (c == "still-sync") {
+    r.cmd = CMD_CAPTURE_SYNC;
+    size_t arg = 1;
+    const bool af = tok.size() > arg && tok[arg] == "af";
+    if (af) ++arg;
+    r.payload.push_back(af ? 1 : 0);
+    if (tok.size() > arg) {
+      const long ms = std::strtol(tok[arg].c_str(), nullptr, 10);
+      if (ms <= 0 || ms > 10000) return "release time must be 1..10000 ms";
+      r.payload.resize(9, 0);
+      r.at_ms = ms;
+    }
+  } else if (c == "discover") {
+    r.cmd = CMD_DISCOVER;
+  } else if (c == "list") {
+    r.cmd = CMD_LIST_CAMERAS;
+  } else if (c == "stats") {
+    r.cmd = CMD_GET_STATS;
+  } else if (c == "scopes") {
+    r.cmd = CMD_GET_SCOPES;
+  } else if (c == "focus") {
+    r.cmd = CMD_GET_FOCUS;
+  } else if (c == "trace") {
+    r.cmd = CMD_TRACE_DUMP;
+    if (tok.size() >= 2) {
+      const unsigned long secs = std::strtoul(tok[1].c_str(), nullptr, 10);
+      if (secs == 0 || secs > 600) return "usage: trace [seconds 1..600]";
+      r.payload.push_back((uint8_t)(secs & 0xFF));
+      r.payload.push_back((uint8_t)(secs >> 8));
+    }
+  } else if (c == "slot") {
+    if (tok.size() < 2) return "usage: slot <n> [key=value...]";
+    const unsigned long slot = std::strtoul(tok[1].c_str(), nullptr, 10);
+    if (slot >= 8) return "slot must be 0..7";
+    uint8_t flags = 0x01;
+    std::string ip, mac, user, pass, fp;
+    for (size_t i = 2; i < tok.size(); ++i) {
+      const size_t eq = tok[i].find('=');
+      if (eq == std::string::npos) return "bad slot token '" + tok[i] + "'";
+      const std::string k = tok[i].substr(0, eq);
+      const std::string v = tok[i].substr(eq + 1);
+      if (k == "enable") flags = (uint8_t)((flags & ~0x01) | (v == "1" ? 0x01 : 0));
+      else if (k == "accept_fp") flags = (uint8_t)((flags & ~0x02) | (v == "1" ? 0x02 : 0));
+      else if (k == "ip") ip = v;
+      else if (k == "mac") mac = v;
+      else if (k == "user") user = v;
+      else if (k == "pass") pass = v;
+      else if (k == "fp") fp = v;
+      else return "unknown slot key '" + k + "'";
+    }
+    r.cmd = CMD_SET_SLOT_CONFIG;
+    r.payload.push_back((uint8_t)slot);
+    r.payload.push_back(flags);
+    put_str(r.payload, ip);
+    put_str(r.payload, mac);
+    put_str(r.payload, user);
+    put_str(r.payload, pass);
+    put_str(r.payload, fp);
+  } else if (c == "raw") {
+    if (tok.size() < 2) return "usage: raw <cmd_hex> [payload_hex]";
+    r.cmd = (uint8_t)std::strtoul(tok[1].c_str(), nullptr, 16);
+    if (tok.size() >= 3 && !parse_hex_bytes(tok[2], r.payload)) return "bad payload hex";
+  } else if (c == "sleep") {
+    if (tok.size() < 2) return "usage: sleep <ms>";
+    r.is_sleep = true;
+    r.sleep_ms = (uint32_t)std::strtoul(tok[1].c_str(), nullptr, 10);
+  } else {
+    return "unknown command '" + c + "'";
   }
+  return std::string();
+}
 
-  uint8_t tx[256];
-  uint8_t rx[256];
+uint32_t default_timeout_ms(uint8_t cmd) {
+  // DISCOVER reconnects cameras and LIST enumerates the bus: both take seconds.
+  if (cmd == CMD_DISCOVER || cmd == CMD_LIST_CAMERAS) return 20000;
+  // RUNSTOP_AT is ACKed after the (up to 10 s away) start time.
+  if (cmd == CMD_RUNSTOP_AT || cmd == CMD_CAPTURE_SYNC) return 15000;
+  return 5000;
+}
 
-  const uint32_t seq = 1;
-  const size_t n = build_req_runstop(tx, sizeof(tx), seq, mask, run);
-  if (!n) return 1;
+uint32_t rd32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
 
-  if (::sendto(fd, tx, n, 0, (sockaddr*)&to, sizeof(to)) != (ssize_t)n) {
-    std::perror("sendto");
-    return 1;
+uint64_t rd64(const uint8_t* p) {
+  return (uint64_t)rd32(p) | ((uint64_t)rd32(p + 4) << 32);
+}
+
+void put64_at(uint8_t* p, uint64_t x) {
+  for (int i = 0; i < 8; ++i) p[i] = (uint8_t)((x >> (8 * i)) & 0xFF);
+}
+
+// The CCU clock as far as the daemon is concerned.
+uint64_t ccu_clock_us() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+}
+
+const char* code_name(uint8_t code) {
+  switch (code) {
+    case RESP_OK: return "OK";
+    case RESP_BAD_CRC: return "BAD_CRC";
+    case RESP_BAD_FORMAT: return "BAD_FORMAT";
+    case RESP_UNKNOWN: return "UNKNOWN";
+    case RESP_TIMEOUT: return "E_TIMEOUT";
+    default: return "?";
   }
+}
 
-  timeval tv{0, 200000};
-  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+const char* conn_name(uint8_t t) {
+  return t == 1 ? "USB" : (t == 2 ? "Ethernet" : "unknown");
+}
 
-  sockaddr_in from{};
-  socklen_t sl = sizeof(from);
-  const int rn = (int)::recvfrom(fd, rx, sizeof(rx), 0, (sockaddr*)&from, &sl);
-  if (rn <= 0) { std::fprintf(stderr, "No response\n"); return 1; }
+std::string json_str(const std::string& s) {
+  std::string o = "\"";
+  for (char ch : s) {
+    if (ch == '"' || ch == '\\') { o += '\\'; o += ch; }
+    else if ((unsigned char)ch < 0x20) {
+      char b[8];
+      std::snprintf(b, sizeof(b), "\\u%04x", (unsigned)(unsigned char)ch);
+      o += b;
+    } else {
+      o += ch;
+    }
+  }
+  return o + "\"";
+}
 
-  Header h{};
-  const uint8_t* pl = nullptr;
-  size_t pl_len = 0;
-  uint8_t err = 0;
+// Collects key/value pairs and renders them as text or one JSON object.
+class Out {
+public:
+  explicit Out(bool json) : m_json(json) {}
+  void num(const char* k, uint64_t v) { add(k, std::to_string(v), false); }
+  void hex(const char* k, uint32_t v) {
+    char b[16];
+    std::snprintf(b, sizeof(b), "0x%02X", (unsigned)v);
+    add(k, b, m_json);
+  }
+  void str(const char* k, const std::string& v) { add(k, v, true); }
+  void raw(const char* k, const std::string& v) { add(k, v, false); }
+  void print() const {
+    if (m_json) std::printf("{%s}\n", m_buf.c_str());
+    else std::printf("%s\n", m_buf.c_str());
+  }
 
-  if (!parse_packet(rx, (size_t)rn, h, pl, pl_len, err)) {
-    std::fprintf(stderr, "Bad ACK\n");
-    return 1;
+private:
+  void add(const char* k, const std::string& v, bool quote) {
+    if (!m_buf.empty()) m_buf += m_json ? "," : " ";
+    if (m_json) m_buf += json_str(k) + ":" + (quote ? json_str(v) : v);
+    else m_buf += std::string(k) + "=" + v;
+  }
+  bool m_json;
+  std::string m_buf;
+};
+
+void decode_masks(Out& o, const std::vector<uint8_t>& p) {
+  if (p.size() < 5) return;
+  o.hex("ok", p[0]);
+  o.hex("fail", p[1]);
+  o.hex("busy", p[2]);
+  o.hex("run", p[3]);
+  o.hex("known", p[4]);
+  if (p.size() >= 6) o.hex("timeout", p[5]);
+}
+
+void decode_status(Out& o, const std::vector<uint8_t>& p) {
+  static const char* const kFields[12] = {
+    "battery_level", "battery_remain", "battery_unit", "recording_media", "movie_recording_media",
+    "slot1_status", "slot1_remaining_number", "slot1_remaining_min",
+    "slot2_status", "slot2_remaining_number", "slot2_remaining_min", "recording_state",
+  };
+  if (p.size() < 48) return;
+  for (int i = 0; i < 12; ++i) o.num(kFields[i], rd32(p.data() + i * 4));
+  size_t off = 48;
+  if (off + 2 > p.size()) return;
+  o.str("conn", conn_name(p[off]));
+  const size_t mlen = p[off + 1];
+  off += 2;
+  if (off + mlen <= p.size()) o.str("model", std::string(reinterpret_cast<const char*>(p.data() + off), mlen));
+}
+
+void decode_options(Out& o, const std::vector<uint8_t>& p, bool json) {
+  if (p.size() < 9) return;
+  const uint16_t type = (uint16_t)(p[1] | (p[2] << 8));
+  const uint16_t count = (uint16_t)(p[3] | (p[4] << 8));
+  o.num("opt", p[0]);
+  o.hex("value_type", type);
+  o.num("current", rd32(p.data() + 5));
+  std::string vals = json ? "[" : "";
+  for (uint16_t i = 0; i < count && 9 + (size_t)i * 4 + 4 <= p.size(); ++i) {
+    if (i) vals += ",";
+    vals += std::to_string(rd32(p.data() + 9 + (size_t)i * 4));
+  }
+  if (json) vals += "]";
+  o.raw("values", vals);
+}
+
+// docs/ccu_camera_list.md
+void decode_list(Out& o, const std::vector<uint8_t>& p, bool json) {
+  if (p.empty()) return;
+  o.num("count", p[0]);
+  size_t off = 1;
+  // Records come first; the trailer (daemons with background discovery)
+  // follows them, so it is parsed before the records are formatted.
+  struct Rec { uint8_t idx, ct; std::string model, ip, mac; };
+  std::vector<Rec> recs;
+  std::string cams = json ? "[" : "";
+  auto rd_str = [&](std::string& s) -> bool {
+    if (off >= p.size()) return false;
+    const size_t n = p[off++];
+    if (off + n > p.size()) return false;
+    s.assign(reinterpret_cast<const char*>(p.data() + off), n);
+    off += n;
+    return true;
+  };
+  for (uint8_t i = 0; i < p[0]; ++i) {
+    if (off + 2 > p.size()) break;
+    Rec r;
+    r.idx = p[off++];
+    r.ct = p[off++];
+    if (!rd_str(r.model) || !rd_str(r.ip) || !rd_str(r.mac)) break;
+    recs.push_back(std::move(r));
+  }
+  const uint8_t* flags = nullptr;
+  if (recs.size() == p[0] && off + 10 <= p.size() && p[off] == 1 && off + 10 + p[off + 9] <= p.size()) {
+    o.num("list_version", rd32(p.data() + off + 1));
+    const uint32_t age = rd32(p.data() + off + 5);
+    if (age == 0xFFFFFFFFu) o.str("age_ms", "never");
+    else o.num("age_ms", age);
+    if (p[off + 9] == recs.size()) flags = p.data() + off + 10;
+  }
+  for (size_t i = 0; i < recs.size(); ++i) {
+    const Rec& r = recs[i];
+    const bool fp = flags && (flags[i] & 0x01);
+    if (json) {
+      if (i) cams += ",";
+      cams += "{\"index\":" + std::to_string(r.idx) + ",\"conn\":" + json_str(conn_name(r.ct)) +
+              ",\"model\":" + json_str(r.model) + ",\"ip\":" + json_str(r.ip) + ",\"mac\":" + json_str(r.mac);
+      if (flags) cams += std::string(",\"fingerprint\":") + (fp ? "true" : "false");
+      cams += "}";
+    } else {
+      if (i) cams += ";";
+      cams += std::to_string(r.idx) + ":" + r.model + "/" + conn_name(r.ct) + (r.ip.empty() ? "" : "/" + r.ip) + (fp ? "/fp" : "");
+    }
+  }
+  if (json) cams += "]";
+  o.raw("cameras", cams);
+}
+
+// docs/ccu_scopes.md
+void decode_scopes(Out& o, const std::vector<uint8_t>& p, bool json) {
+  static const char* const kZones[8] = {
+    "crushed", "deep_shadow", "shadow", "low_mid", "mid", "high_mid", "highlight", "clipped",
+  };
+  if (p.size() < 26 || p[0] != 1) return;
+  const uint8_t flags = p[2];
+  const size_t cols = p[3];
+  const size_t wave_off = 26 + 256;
+  if (p.size() < wave_off + cols * 4) return;
+  o.num("slot", p[1]);
+  o.str("state", !(flags & 0x01) ? "none" : ((flags & 0x02) ? "stale" : "live"));
+  if (!(flags & 0x01)) return;
+  o.num("frame_seq", rd32(p.data() + 4));
+  o.num("age_ms", (uint32_t)(p[8] | (p[9] << 8)));
+  char b[16];
+  std::snprintf(b, sizeof(b), "%.1f", (p[10] | (p[11] << 8)) / 10.0);
+  o.raw("clipped_pct", b);
+  std::snprintf(b, sizeof(b), "%.1f", (p[12] | (p[13] << 8)) / 10.0);
+  o.raw("under_pct", b);
+  o.num("mean", p[14]);
+  o.num("p1", p[15]);
+  o.num("p50", p[16]);
+  o.num("p99", p[17]);
+  for (int z = 0; z < 8; ++z) {
+    std::snprintf(b, sizeof(b), "%.1f", p[18 + z] / 2.0);
+    o.raw((std::string("zone_") + kZones[z] + "_pct").c_str(), b);
+  }
+
+  const uint8_t* hist = p.data() + 26;
+  const uint8_t* wave = p.data() + wave_off;
+  std::string hs, ws;
+  if (json) {
+    hs = "[";
+    for (int v = 0; v < 256; ++v) hs += (v ? "," : "") + std::to_string(hist[v]);
+    hs += "]";
+    ws = "[";
+    for (size_t c = 0; c < cols; ++c) {
+      ws += c ? ",[" : "[";
+      for (size_t band = 0; band < 8; ++band) {
+        ws += (band ? "," : "") + std::to_string((wave[c * 4 + band / 2] >> (4 * (band & 1))) & 0x0F);
+      }
+      ws += "]";
+    }
+    ws += "]";
+  } else {
+    // Histogram as a 64-step sparkline (peak of each 4 bins); waveform as
+    // one hex digit per band, dark to bright, per column.
+    static const char kRamp[] = " .:-=+*#%@";
+    for (int v = 0; v < 256; v += 4) {
+      const uint8_t m = std::max(std::max(hist[v], hist[v + 1]), std::max(hist[v + 2], hist[v + 3]));
+      hs += kRamp[(m * 9 + 254) / 255];
+    }
+    hs = "|" + hs + "|";
+    for (size_t c = 0; c < cols; ++c) {
+      if (c) ws += ".";
+      for (size_t band = 0; band < 8; ++band) {
+        ws += "0123456789abcdef"[(wave[c * 4 + band / 2] >> (4 * (band & 1))) & 0x0F];
+      }
+    }
+  }
+  if (json) o.raw("hist", hs);
+  else o.str("hist", hs);
+  o.raw("waveform", ws);
+}
+
+// docs/ccu_focus_assist.md
+void decode_focus(Out& o, const std::vector<uint8_t>& p, bool json) {
+  static constexpr size_t kRecord = 18;
+  if (p.size() < 2 || p[0] != 1) return;
+  std::string slots = json ? "[" : "";
+  size_t shown = 0;
+  for (size_t i = 0, off = 2; i < p[1] && off + kRecord <= p.size(); ++i, off += kRecord) {
+    const uint8_t* r = p.data() + off;
+    const uint8_t flags = r[1];
+    const char* state = !(flags & 0x01) ? "none" : ((flags & 0x02) ? "stale" : "live");
+    const unsigned age = (unsigned)(r[6] | (r[7] << 8));
+    const unsigned rel = (unsigned)(r[12] | (r[13] << 8));
+    char roi[48];
+    std::snprintf(roi, sizeof(roi), "%.0f,%.0f,%.0fx%.0f", r[14] * 100 / 256.0, r[15] * 100 / 256.0,
+                  r[16] * 100 / 256.0, r[17] * 100 / 256.0);
+    if (shown++) slots += json ? "," : ";";
+    if (json) {
+      slots += "{\"slot\":" + std::to_string(r[0]) + ",\"state\":" + json_str(state);
+      if (flags & 0x01) {
+        slots += ",\"frame_seq\":" + std::to_string(rd32(r + 2)) + ",\"age_ms\":" + std::to_string(age) +
+                 ",\"score\":" + std::to_string(rd32(r + 8)) + ",\"rel_permille\":" + std::to_string(rel) +
+                 ",\"af\":" + ((flags & 0x04) ? "true" : "false") +
+                 ",\"focused\":" + ((flags & 0x08) ? "true" : "false") + ",\"roi_pct\":" + json_str(roi);
+      }
+      slots += "}";
+    } else if (flags & 0x01) {
+      // slot:score/rel%/region(%)[/af][/focused][/stale]
+      char b[96];
+      std::snprintf(b, sizeof(b), "%u:%u/%.1f%%/%s", (unsigned)r[0], (unsigned)rd32(r + 8), rel / 10.0, roi);
+      slots += b;
+      if (flags & 0x04) slots += "/af";
+      if (flags & 0x08) slots += "/focused";
+      if (flags & 0x02) slots += "/stale";
+    } else {
+      slots += std::to_string(r[0]) + ":none";
+    }
+  }
+  if (json) slots += "]";
+  o.raw("slots", slots);
+}
+
+// docs/ccu_stats_payload.md
+void decode_stats(Out& o, const std::vector<uint8_t>& p, bool json) {
+  static const char* const kTransport[7] = {
+    "rx", "rx_ok", "bad_crc", "bad_format", "resyncs", "tx", "tx_errors",
+  };
+  if (p.size() < 34 || p[0] != 1) return;
+  o.num("uptime_s", rd32(p.data() + 1));
+  for (int i = 0; i < 7; ++i) o.num(kTransport[i], rd32(p.data() + 5 + i * 4));
+  size_t off = 33;
+
+  const uint8_t n_cmd = p[off++];
+  std::string cmds = json ? "[" : "";
+  for (uint8_t i = 0; i < n_cmd && off + 21 <= p.size(); ++i, off += 21) {
+    const uint8_t* c = p.data() + off;
+    char b[160];
+    if (json) {
+      std::snprintf(b, sizeof(b), "%s{\"cmd\":%u,\"count\":%u,\"nak\":%u,\"p50_us\":%u,\"p99_us\":%u,\"max_us\":%u}",
+                    i ? "," : "", (unsigned)c[0], rd32(c + 1), rd32(c + 5), rd32(c + 9), rd32(c + 13), rd32(c + 17));
+    } else {
+      std::snprintf(b, sizeof(b), "%s0x%02X:%u/%u/%u/%u/%u", i ? ";" : "",
+                    (unsigned)c[0], rd32(c + 1), rd32(c + 5), rd32(c + 9), rd32(c + 13), rd32(c + 17));
+    }
+    cmds += b;
+  }
+  if (json) cmds += "]";
+  o.raw("cmds", cmds);
+
+  if (off >= p.size()) return;
+  const uint8_t n_slot = p[off++];
+  std::string slots = json ? "[" : "";
+  bool first = true;
+  for (uint8_t i = 0; i < n_slot && off + 22 <= p.size(); ++i, off += 22) {
+    const uint8_t* s = p.data() + off;
+    const uint32_t calls = rd32(s), errs = rd32(s + 4), p99 = rd32(s + 8);
+    const unsigned conn = (unsigned)(s[12] | (s[13] << 8));
+    const unsigned reconn = (unsigned)(s[14] | (s[15] << 8));
+    const unsigned cfail = (unsigned)(s[16] | (s[17] << 8));
+    const uint32_t last_ms = rd32(s + 18);
+    if (calls == 0 && conn == 0 && cfail == 0) continue;
+    char b[192];
+    if (json) {
+      std::snprintf(b, sizeof(b), "%s{\"slot\":%u,\"sdk_calls\":%u,\"sdk_errors\":%u,\"sdk_p99_us\":%u,"
+                    "\"connects\":%u,\"reconnects\":%u,\"connect_failures\":%u,\"last_connect_ms\":%u}",
+                    first ? "" : ",", (unsigned)i, calls, errs, p99, conn, reconn, cfail, last_ms);
+    } else {
+      std::snprintf(b, sizeof(b), "%s%u:%u/%u/%u/%u/%u/%u/%u", first ? "" : ";",
+                    (unsigned)i, calls, errs, p99, conn, reconn, cfail, last_ms);
+    }
+    slots += b;
+    first = false;
+  }
+  if (json) slots += "]";
+  o.raw("slots", slots);
+}
+
+// After the masks: per-slot accept time - target (int32 us, INT32_MIN = not accepted), uncertainty u32.
+void decode_skews(Out& o, const std::vector<uint8_t>& p, bool json) {
+  if (p.size() < 44) return;
+  std::string skews = json ? "[" : "";
+  bool first = true;
+  for (int i = 0; i < 8; ++i) {
+    const int32_t us = (int32_t)rd32(p.data() + 8 + i * 4);
+    if (us == INT32_MIN) continue;
+    char b[48];
+    if (json) std::snprintf(b, sizeof(b), "%s{\"slot\":%d,\"skew_us\":%d}", first ? "" : ",", i, (int)us);
+    else std::snprintf(b, sizeof(b), "%s%d:%+d", first ? "" : ";", i, (int)us);
+    skews += b;
+    first = false;
+  }
+  if (json) skews += "]";
+  o.raw("skew_us", skews);
+  o.num("sync_uncertainty_us", rd32(p.data() + 40));
+}
+
+// masks[8], skews, uncertainty.
+void decode_runstop_at(Out& o, const std::vector<uint8_t>& p, bool json) {
+  decode_masks(o, p);
+  decode_skews(o, p, json);
+}
+
+// Bytes 3/4 are the AF-locked and armed masks; arm_us is how long phase one took.
+void decode_capture_sync(Out& o, const std::vector<uint8_t>& p, bool json) {
+  if (p.size() < 6) return;
+  o.hex("ok", p[0]);
+  o.hex("fail", p[1]);
+  o.hex("busy", p[2]);
+  o.hex("timeout", p[5]);
+  o.hex("armed", p[4]);
+  o.hex("af_locked", p[3]);
+  decode_skews(o, p, json);
+  if (p.size() >= 48) o.num("arm_us", rd32(p.data() + 44));
+}
+
+void decode_trace(Out& o, const std::vector<uint8_t>& p) {
+  if (p.size() < 5) return;
+  o.num("spans", rd32(p.data()));
+  const size_t n = p[4];
+  if (5 + n <= p.size()) o.str("file", std::string(reinterpret_cast<const char*>(p.data() + 5), n));
+}
+
+// Server-side breakdown from an ACK that carries FLAG_TIMING: rtt minus
+// handler_us is transport plus queueing outside the daemon.
+void decode_timing(Out& o, const TimingExt& t, bool json) {
+  o.num("queue_us", t.queue_us);
+  o.num("handler_us", t.handler_us);
+  std::string sdk = json ? "[" : "";
+  bool first = true;
+  for (int i = 0; i < 8; ++i) {
+    if (t.sdk_us[i] == 0 && t.sdk_result[i] == 0) continue;
+    char b[80];
+    if (json) {
+      std::snprintf(b, sizeof(b), "%s{\"slot\":%d,\"us\":%u,\"result\":\"0x%X\"}", first ? "" : ",", i,
+                    (unsigned)t.sdk_us[i], (unsigned)t.sdk_result[i]);
+    } else {
+      std::snprintf(b, sizeof(b), "%s%d:%uus", first ? "" : ";", i, (unsigned)t.sdk_us[i]);
+      if (t.sdk_result[i]) std::snprintf(b + std::strlen(b), sizeof(b) - std::strlen(b), "/0x%X", (unsigned)t.sdk_result[i]);
+    }
+    sdk += b;
+    first = false;
   }
+  if (json) sdk += "]";
+  o.raw("sdk", sdk);
+}
 
-  std::printf("ACK seq=%u code=%u target=0x%02X\n", h.seq, h.cmd_or_code, h.target_mask);
-  if (pl_len >= 5) {
-    std::printf(" ok=0x%02X fail=0x%02X busy=0x%02X run=0x%02X known=0x%02X\n",
-      pl[0], pl[1], pl[2], pl[3], pl[4]);
+bool print_result(const Options& opt, const Request& r, const Result& res) {
+  Out o(opt.json);
+  o.str("cmd", r.name);
+  o.hex("target", r.target);
+  if (res.timed_out) {
+    o.str("code", "TIMEOUT");
+    o.print();
+    return false;
   }
+  o.num("seq", res.h.seq);
+  o.str("code", code_name(res.h.cmd_or_code));
+  char rtt[32];
+  std::snprintf(rtt, sizeof(rtt), "%.3f", res.rtt_ms);
+  o.raw("rtt_ms", rtt);
+  if (res.has_timing) decode_timing(o, res.timing, opt.json);
 
-  ::close(fd);
-  return 0;
+  bool ok = (res.h.cmd_or_code == RESP_OK);
+  if (ok) {
+    switch (r.cmd) {
+      case CMD_GET_STATUS: decode_status(o, res.payload); break;
+      case CMD_GET_OPTIONS: decode_options(o, res.payload, opt.json); break;
+      case CMD_LIST_CAMERAS: decode_list(o, res.payload, opt.json); break;
+      case CMD_GET_STATS: decode_stats(o, res.payload, opt.json); break;
+      case CMD_GET_SCOPES: decode_scopes(o, res.payload, opt.json); break;
+      case CMD_GET_FOCUS: decode_focus(o, res.payload, opt.json); break;
+      case CMD_TRACE_DUMP: decode_trace(o, res.payload); break;
+      case CMD_RUNSTOP_AT:
+        decode_runstop_at(o, res.payload, opt.json);
+        if (res.payload.size() >= 2 && res.payload[1] != 0) ok = false;
+        break;
+      case CMD_CAPTURE_SYNC:
+        decode_capture_sync(o, res.payload, opt.json);
+        if (res.payload.size() >= 2 && res.payload[1] != 0) ok = false;
+        break;
+      case CMD_RUNSTOP:
+      case CMD_SET_VALUE:
+      case CMD_PARAM_STEP:
+      case CMD_CAPTURE_STILL:
+      case CMD_DISCOVER:
+      case CMD_SET_SLOT_CONFIG:
+        decode_masks(o, res.payload);
+        if (res.payload.size() >= 2 && res.payload[1] != 0) ok = false;
+        break;
+      default: {
+        std::string hx;
+        char b[4];
+        for (uint8_t v : res.payload) { std::snprintf(b, sizeof(b), "%02X", v); hx += b; }
+        o.str("payload", hx);
+        break;
+      }
+    }
+  }
+  o.print();
+  return ok;
+}
+
+// Sends reqs[begin,end) with up to opt.window in flight and prints results
+// in request order. Returns false if anything failed or timed out.
+bool run_batch(ClientLink& link, const Options& opt, const std::vector<Request>& reqs, size_t begin, size_t end,
+               uint32_t& seq) {
+  struct Inflight {
+    size_t idx;
+    Clock::time_point t0;
+    Clock::time_point deadline;
+  };
+  std::vector<Result> results(end - begin);
+  std::unordered_map<uint32_t, Inflight> inflight;
+  size_t next = begin;
+  size_t printed = begin;
+  bool all_ok = true;
+  uint8_t tx[600];
+  uint8_t rx[2048];
+
+  while (printed < end) {
+    while (next < end && inflight.size() < opt.window) {
+      const Request& r = reqs[next];
+      if (++seq == 0) seq = 1;
+      std::vector<uint8_t> payload = r.payload;
+      if (r.at_ms >= 0) put64_at(payload.data() + 1, ccu_clock_us() + (uint64_t)r.at_ms * 1000u);
+      const size_t n = build_req_cmd(tx, sizeof(tx), seq, r.target, r.cmd, payload.data(), payload.size(),
+                                     opt.timing ? FLAG_TIMING : 0);
+      if (!n || !link.send(tx, n)) {
+        std::fprintf(stderr, "send failed for '%s'\n", r.text.c_str());
+        return false;
+      }
+      const auto now = Clock::now();
+      const uint32_t tmo = opt.timeout_ms ? opt.timeout_ms : default_timeout_ms(r.cmd);
+      inflight[seq] = Inflight{next, now, now + std::chrono::milliseconds(tmo)};
+      next++;
+    }
+
+    link.wait(5);
+    while (true) {
+      const int n = link.recv(rx, sizeof(rx));
+      if (n <= 0) break;
+      Header h{};
+      const uint8_t* pl = nullptr;
+      size_t pl_len = 0;
+      uint8_t err = RESP_OK;
+      if (!parse_packet(rx, (size_t)n, h, pl, pl_len, err) || h.msg_type != MSG_RESP_ACK) continue;
+      auto it = inflight.find(h.seq);
+      if (it == inflight.end()) continue;
+      Result& res = results[it->second.idx - begin];
+      res.done = true;
+      res.h = h;
+      res.payload.assign(pl, pl + pl_len);
+      if ((h.flags & FLAG_TIMING) && pl_len >= sizeof(TimingExt) && pl[pl_len - 1] == sizeof(TimingExt)) {
+        std::memcpy(&res.timing, pl + pl_len - sizeof(TimingExt), sizeof(TimingExt));
+        res.payload.resize(pl_len - sizeof(TimingExt));
+        res.has_timing = true;
+      }
+      res.rtt_ms = std::chrono::duration<double, std::milli>(Clock::now() - it->second.t0).count();
+      inflight.erase(it);
+    }
+
+    const auto now = Clock::now();
+    for (auto it = inflight.begin(); it != inflight.end();) {
+      if (now >= it->second.deadline) {
+        Result& res = results[it->second.idx - begin];
+        res.done = true;
+        res.timed_out = true;
+        it = inflight.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    while (printed < end && results[printed - begin].done) {
+      if (!print_result(opt, reqs[printed], results[printed - begin])) all_ok = false;
+      printed++;
+    }
+    std::fflush(stdout);
+  }
+  return all_ok;
+}
+
+// Serial CMD_TIME_SYNC rounds. Each request reports the previous round's
+// t1/t4 so the daemon can complete its sample; one extra request delivers the
+// last round's.
+bool run_sync(ClientLink& link, const Options& opt, const Request& r, uint32_t& seq) {
+  uint64_t prev_t1 = 0, prev_t4 = 0;
+  uint32_t done = 0;
+  double best_rtt_ms = 0.0;
+  std::vector<uint8_t> last;
+  uint8_t tx[64];
+  uint8_t rx[2048];
+  for (uint32_t round = 0; round <= r.sync_rounds; ++round) {
+    uint8_t pl[24];
+    const uint64_t t1 = ccu_clock_us();
+    put64_at(pl, t1);
+    put64_at(pl + 8, prev_t1);
+    put64_at(pl + 16, prev_t4);
+    if (++seq == 0) seq = 1;
+    const size_t n = build_req_cmd(tx, sizeof(tx), seq, r.target, CMD_TIME_SYNC, pl, sizeof(pl));
+    if (!n || !link.send(tx, n)) {
+      std::fprintf(stderr, "send failed for '%s'\n", r.text.c_str());
+      return false;
+    }
+    const auto deadline = Clock::now() + std::chrono::milliseconds(opt.timeout_ms ? opt.timeout_ms : 1000);
+    bool got = false;
+    while (!got && Clock::now() < deadline) {
+      link.wait(5);
+      int len = 0;
+      while (!got && (len = link.recv(rx, sizeof(rx))) > 0) {
+        const uint64_t t4 = ccu_clock_us();
+        Header h{};
+        const uint8_t* ap = nullptr;
+        size_t ap_len = 0;
+        uint8_t err = RESP_OK;
+        if (!parse_packet(rx, (size_t)len, h, ap, ap_len, err) || h.msg_type != MSG_RESP_ACK || h.seq != seq) continue;
+        if (h.cmd_or_code != RESP_OK || ap_len < 37 || rd64(ap) != t1) break;
+        got = true;
+        prev_t1 = t1;
+        prev_t4 = t4;
+        last.assign(ap, ap + ap_len);
+        const double rtt_ms = (double)(t4 - t1) / 1000.0;
+        if (done == 0 || rtt_ms < best_rtt_ms) best_rtt_ms = rtt_ms;
+        done++;
+      }
+    }
+    if (!got) prev_t1 = prev_t4 = 0;  // lost round: nothing to complete
+  }
+
+  Out o(opt.json);
+  o.str("cmd", r.name);
+  o.hex("target", r.target);
+  if (last.empty()) {
+    o.str("code", "TIMEOUT");
+    o.print();
+    return false;
+  }
+  o.str("code", "OK");
+  o.num("rounds", done);
+  char b[32];
+  std::snprintf(b, sizeof(b), "%.3f", best_rtt_ms);
+  o.raw("best_rtt_ms", b);
+  const uint32_t unc = rd32(last.data() + 32);
+  // The ACK that carried the final estimate went out before the last sample
+  // was completed; it is at most one round behind.
+  o.raw("offset_us", std::to_string((long long)(int64_t)rd64(last.data() + 24)));
+  if (unc == 0xFFFFFFFFu) o.str("uncertainty_us", "none");
+  else o.num("uncertainty_us", unc);
+  o.num("samples", last[36]);
+  o.print();
+  std::fflush(stdout);
+  return unc != 0xFFFFFFFFu || done > 1;
+}
+
+std::vector<std::string> split_ws(const std::string& line) {
+  std::vector<std::string> out;
+  std::istringstream iss(line);
+  std::string t;
+  while (iss >> t) out.push_back(t);
+  return out;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  std::vector<std::string> cmd;
+
+  // Original positional form: <ip> <port> <run|stop> [mask_hex]
+  in_addr probe{};
+  if (argc >= 4 && ::inet_pton(AF_INET, argv[1], &probe) == 1) {
+    opt.udp = std::string(argv[1]) + ":" + argv[2];
+    cmd.push_back(argv[3]);
+    if (argc >= 5) opt.target = (uint8_t)std::strtoul(argv[4], nullptr, 16);
+  } else {
+    int i = 1;
+    for (; i < argc; ++i) {
+      const std::string a = argv[i];
+      if (a.size() < 2 || a[0] != '-' || a[1] != '-') break;
+      if (a == "--json") { opt.json = true; continue; }
+      if (a == "--timing") { opt.timing = true; continue; }
+      if (a == "--help") { usage(); return 0; }
+      if (i + 1 >= argc) { usage(); return 2; }
+      const char* v = argv[++i];
+      if (a == "--udp") opt.udp = v;
+      else if (a == "--uart") opt.uart = v;
+      else if (a == "--target") opt.target = (uint8_t)std::strtoul(v, nullptr, 16);
+      else if (a == "--timeout") opt.timeout_ms = (uint32_t)std::strtoul(v, nullptr, 10);
+      else if (a == "--window") opt.window = std::max<size_t>(1, std::strtoul(v, nullptr, 10));
+      else { usage(); return 2; }
+    }
+    for (; i < argc; ++i) cmd.push_back(argv[i]);
+  }
+
+  const bool batch = cmd.empty() ? !isatty(STDIN_FILENO) : (cmd.size() == 1 && cmd[0] == "-");
+  if (cmd.empty() && !batch) {
+    usage();
+    return 2;
+  }
+
+  std::vector<Request> reqs;
+  if (batch) {
+    std::string line;
+    size_t lineno = 0;
+    while (std::getline(std::cin, line)) {
+      lineno++;
+      const size_t hash = line.find('#');
+      if (hash != std::string::npos) line.resize(hash);
+      const auto tok = split_ws(line);
+      if (tok.empty()) continue;
+      Request r;
+      r.text = line;
+      const std::string err = parse_request(tok, opt.target, r);
+      if (!err.empty()) {
+        std::fprintf(stderr, "stdin:%zu: %s\n", lineno, err.c_str());
+        return 2;
+      }
+      reqs.push_back(r);
+    }
+  } else {
+    Request r;
+    for (const auto& t : cmd) r.text += (r.text.empty() ? "" : " ") + t;
+    const std::string err = parse_request(cmd, opt.target, r);
+    if (!err.empty()) {
+      std::fprintf(stderr, "%s\n", err.c_str());
+      usage();
+      return 2;
+    }
+    reqs.push_back(r);
+  }
+
+  // A scheduled start or release needs a fresh offset estimate on the daemon.
+  for (size_t i = 0; i < reqs.size(); ++i) {
+    if (reqs[i].at_ms < 0 || (i > 0 && reqs[i - 1].is_sync)) continue;
+    Request sync;
+    sync.text = sync.name = "sync";
+    sync.target = reqs[i].target;
+    sync.is_sync = true;
+    sync.sync_rounds = 8;
+    reqs.insert(reqs.begin() + (long)i, sync);
+    ++i;
+  }
+
+  ClientLink link;
+  const bool opened = opt.uart.empty() ? link.open_udp(opt.udp) : link.open_uart(opt.uart);
+  if (!opened) {
+    std::fprintf(stderr, "Failed to open %s\n", opt.uart.empty() ? opt.udp.c_str() : opt.uart.c_str());
+    return 1;
+  }
+
+  uint32_t seq = ((uint32_t)getpid() << 16) | 1u;
+  bool ok = true;
+  size_t begin = 0;
+  for (size_t i = 0; i <= reqs.size(); ++i) {
+    if (i < reqs.size() && !reqs[i].is_sleep && !reqs[i].is_sync) continue;
+    if (i > begin && !run_batch(link, opt, reqs, begin, i, seq)) ok = false;
+    if (i < reqs.size()) {
+      if (reqs[i].is_sync) {
+        if (!run_sync(link, opt, reqs[i], seq)) ok = false;
+      } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(reqs[i].sleep_ms));
+      }
+    }
+    begin = i + 1;
+  }
+  return ok ? 0 : 1;
 }
@@ -0,0 +1,83 @@
+#pragma once
+// Client-side CCU1 link shared by the host tools (ccu_cli, ccu_bench):
+// a connected UDP socket or a UART/pty behind one send/recv pair.
+#include "../src/uart_transport.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace ccu {
+
+class ClientLink {
+public:
+  ~ClientLink() { close(); }
+
+  // "ip:port" (port defaults to 5555).
+  bool open_udp(const std::string& spec) {
+    close();
+    std::string ip = spec;
+    uint16_t port = 5555;
+    const size_t colon = spec.rfind(':');
+    if (colon != std::string::npos) {
+      ip = spec.substr(0, colon);
+      port = (uint16_t)std::atoi(spec.c_str() + colon + 1);
+    }
+    m_fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (m_fd < 0) return false;
+    sockaddr_in to{};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(port);
+    if (::inet_pton(AF_INET, ip.c_str(), &to.sin_addr) != 1) return false;
+    // Connected socket so ICMP errors surface and stray senders are ignored.
+    return ::connect(m_fd, (sockaddr*)&to, sizeof(to)) == 0;
+  }
+
+  // "/dev/ttyX[@baud]" (baud defaults to 115200).
+  bool open_uart(const std::string& spec) {
+    close();
+    const size_t at = spec.find('@');
+    const uint32_t baud = (at != std::string::npos) ? (uint32_t)std::strtoul(spec.c_str() + at + 1, nullptr, 10) : 115200u;
+    m_use_uart = m_uart.open(spec.substr(0, at), baud);
+    return m_use_uart;
+  }
+
+  void close() {
+    if (m_use_uart) m_uart.close();
+    m_use_uart = false;
+    if (m_fd >= 0) ::close(m_fd);
+    m_fd = -1;
+  }
+
+  bool send(const uint8_t* buf, size_t len) {
+    if (m_use_uart) return m_uart.send_frame(buf, len);
+    return ::send(m_fd, buf, len, 0) == (ssize_t)len;
+  }
+
+  // Non-blocking; returns frame length or 0.
+  int recv(uint8_t* out, size_t out_max) {
+    if (m_use_uart) return m_uart.recv_frame(out, out_max);
+    const ssize_t n = ::recv(m_fd, out, out_max, MSG_DONTWAIT);
+    return n > 0 ? (int)n : 0;
+  }
+
+  // Waits up to timeout_ms for input (the UART transport is polled).
+  void wait(int timeout_ms) {
+    if (m_use_uart) {
+      usleep((useconds_t)std::min(timeout_ms, 1) * 200);
+      return;
+    }
+    pollfd p{m_fd, POLLIN, 0};
+    ::poll(&p, 1, timeout_ms);
+  }
+
+private:
+  bool m_use_uart = false;
+  int m_fd = -1;
+  UartTransport m_uart;
+};
+
+} // namespace ccu
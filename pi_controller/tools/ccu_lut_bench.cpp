@@ -0,0 +1,146 @@
+// ccu_lut_bench: monitoring LUT kernel benchmark.
+//
+// Times Lut3d::apply (src/lut3d.cpp) on random RGB and checks it against a
+// float tetrahedral interpolation of the same lattice. Prints the budget
+// the daemon needs: --cameras live views at --fps each, spread over
+// --cores, with every LUT frame also decoded and re-encoded.
+#include "../src/lut3d.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Size {
+  int w, h;
+};
+
+// A contrast curve with a little cross-talk: enough that every tetrahedron
+// case gives a different answer.
+std::vector<float> synthetic_lattice(uint32_t n) {
+  std::vector<float> v((size_t)n * n * n * 3);
+  for (uint32_t b = 0; b < n; ++b)
+    for (uint32_t g = 0; g < n; ++g)
+      for (uint32_t r = 0; r < n; ++r) {
+        const float in[3] = {(float)r / (float)(n - 1), (float)g / (float)(n - 1), (float)b / (float)(n - 1)};
+        float* out = &v[(((size_t)b * n + g) * n + r) * 3];
+        for (int c = 0; c < 3; ++c) {
+          const float x = 0.8f * in[c] + 0.1f * in[(c + 1) % 3] + 0.1f * in[(c + 2) % 3];
+          out[c] = x * x * (3.0f - 2.0f * x);
+        }
+      }
+  return v;
+}
+
+// Float tetrahedral interpolation of the lattice, for the accuracy check.
+void reference(const std::vector<float>& lat, uint32_t n, const uint8_t* in, uint8_t* out, size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i, in += 3, out += 3) {
+    float pos[3];
+    uint32_t idx[3];
+    float f[3];
+    for (int c = 0; c < 3; ++c) {
+      pos[c] = (float)in[c] / 255.0f * (float)(n - 1);
+      idx[c] = std::min((uint32_t)pos[c], n - 2);
+      f[c] = pos[c] - (float)idx[c];
+    }
+    auto at = [&](uint32_t dr, uint32_t dg, uint32_t db, int c) {
+      return lat[((((size_t)idx[2] + db) * n + idx[1] + dg) * n + idx[0] + dr) * 3 + (size_t)c];
+    };
+    // Axis order by descending fraction picks the tetrahedron.
+    int o[3] = {0, 1, 2};
+    std::sort(o, o + 3, [&](int a, int b) { return f[a] > f[b]; });
+    uint32_t d1[3] = {0, 0, 0}, d2[3] = {0, 0, 0};
+    d1[o[0]] = 1;
+    d2[o[0]] = 1;
+    d2[o[1]] = 1;
+    for (int c = 0; c < 3; ++c) {
+      const float c0 = at(0, 0, 0, c), c1 = at(d1[0], d1[1], d1[2], c), c2 = at(d2[0], d2[1], d2[2], c),
+                  c3 = at(1, 1, 1, c);
+      const float v = c0 + (c1 - c0) * f[o[0]] + (c2 - c1) * f[o[1]] + (c3 - c2) * f[o[2]];
+      out[c] = (uint8_t)std::lround(std::min(std::max(v, 0.0f), 1.0f) * 255.0f);
+    }
+  }
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "Usage: ccu_lut_bench [--size WxH]... [--lut 17|33] [--iters n] [--cameras n] [--fps n] [--cores n]\n"
+               "Default sizes: 640x360, 1024x576 (camera live view), 1920x1080.\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::vector<Size> sizes;
+  std::vector<uint32_t> luts;
+  int iters = 10, cameras = 8, fps = 30, cores = 4;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      Size s{};
+      if (std::sscanf(argv[++i], "%dx%d", &s.w, &s.h) != 2 || s.w <= 0 || s.h <= 0) {
+        usage();
+        return 2;
+      }
+      sizes.push_back(s);
+    } else if (std::strcmp(argv[i], "--lut") == 0 && i + 1 < argc) {
+      luts.push_back((uint32_t)std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--iters") == 0 && i + 1 < argc) {
+      iters = std::max(1, std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--cameras") == 0 && i + 1 < argc) {
+      cameras = std::max(1, std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+      fps = std::max(1, std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--cores") == 0 && i + 1 < argc) {
+      cores = std::max(1, std::atoi(argv[++i]));
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  if (sizes.empty()) sizes = {{640, 360}, {1024, 576}, {1920, 1080}};
+  if (luts.empty()) luts = {17, 33};
+
+  std::printf("%d iterations; budget: %d cameras x %d fps on %d cores\n", iters, cameras, fps, cores);
+  std::printf("%-5s %-10s %10s %10s %12s %8s\n", "lut", "size", "ms/frame", "Mpx/s", "need_Mpx/s", "maxdiff");
+  bool ok = true;
+  uint32_t rng = 12345;
+  for (uint32_t n : luts) {
+    const std::vector<float> values = synthetic_lattice(n);
+    ccu::Lut3d lut;
+    std::string err;
+    if (!lut.load_values(n, values, &err)) {
+      std::fprintf(stderr, "lut %u: %s\n", n, err.c_str());
+      return 2;
+    }
+    for (const Size& sz : sizes) {
+      const size_t px = (size_t)sz.w * sz.h;
+      std::vector<uint8_t> src(px * 3), out(px * 3), ref(px * 3);
+      for (auto& v : src) v = (uint8_t)((rng = rng * 1103515245u + 12345u) >> 16);
+
+      lut.apply(src.data(), out.data(), px);  // warm up
+      const auto t0 = Clock::now();
+      for (int i = 0; i < iters; ++i) lut.apply(src.data(), out.data(), px);
+      const double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count() / iters;
+
+      reference(values, n, src.data(), ref.data(), px);
+      int maxdiff = 0;
+      for (size_t i = 0; i < px * 3; ++i) maxdiff = std::max(maxdiff, std::abs((int)out[i] - (int)ref[i]));
+      if (maxdiff > 1) ok = false;
+
+      // Per core, assuming the LUT threads spread evenly.
+      const double need = (double)px * cameras * fps / cores / 1e6;
+      char label[24];
+      std::snprintf(label, sizeof(label), "%dx%d", sz.w, sz.h);
+      std::printf("%-5u %-10s %10.3f %10.1f %12.1f %8d\n", n, label, ms, (double)px / ms / 1e3, need, maxdiff);
+    }
+  }
+  return ok ? 0 : 1;
+}
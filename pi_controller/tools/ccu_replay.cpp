@@ -0,0 +1,467 @@
+// ccu_replay: offline tool for ccu_daemon flight recordings.
+//
+// Replays the CCU1 requests of a capture into a daemon (normally one built
+// against the stub Cr_Core) with the original inter-frame timing, and checks
+// each ACK against the one recorded in the field. It can also print the
+// capture, or turn the recorded disconnects and SDK failure rates into a
+// CRSTUB_CONFIG script so the simulated cameras misbehave the same way.
+#include "../src/flight_recorder.hpp"
+#include "../src/protocol.hpp"
+#include "ccu_link.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace ccu;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+  std::string capture;
+  std::string udp = "127.0.0.1:5555";
+  std::string uart;                  // "/dev/ttyX[@baud]"; empty = UDP
+  bool dump = false;
+  std::string stub_config;           // output path, "-" = stdout
+  double speed = 1.0;                // 0 = back to back, one in flight
+  double from_s = 0.0;
+  double to_s = 0.0;                 // 0 = end of capture
+  uint32_t timeout_ms = 2000;
+  bool quiet = false;
+};
+
+// One recorded request and the ACK the daemon sent for it in the field.
+struct Request {
+  uint64_t ts_ns = 0;
+  std::vector<uint8_t> frame;
+  bool parsed = false;
+  Header h{};
+  bool have_ack = false;
+  uint8_t ack_code = 0;
+  uint8_t ack_masks[2] = {0, 0};     // ok/fail masks for mask-style ACKs
+  uint64_t ack_latency_us = 0;
+};
+
+struct Outcome {
+  bool acked = false;
+  uint8_t code = 0;
+  uint8_t masks[2] = {0, 0};
+  uint64_t latency_us = 0;
+};
+
+void usage() {
+  std::fprintf(stderr,
+    "Usage: ccu_replay <capture> [options]\n"
+    "  --dump                  print the capture and exit\n"
+    "  --stub-config <file>    write a CRSTUB_CONFIG script from recorded\n"
+    "                          disconnects and SDK failures ('-' = stdout) and exit\n"
+    "  --udp <ip>:<port>       daemon address (default 127.0.0.1:5555)\n"
+    "  --uart <dev>[@baud]     replay over a UART or pty instead of UDP\n"
+    "  --speed <x>             time scale (default 1.0; 0 = back to back)\n"
+    "  --from <s> --to <s>     replay only this window (seconds from first request)\n"
+    "  --timeout <ms>          per-request ACK timeout (default 2000)\n"
+    "  --quiet                 summary only, no per-mismatch lines\n");
+}
+
+bool parse_args(int argc, char** argv, Options& o) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string a = argv[i];
+    auto next = [&](const char*& v) -> bool {
+      if (i + 1 >= argc) { std::fprintf(stderr, "%s needs a value\n", a.c_str()); return false; }
+      v = argv[++i];
+      return true;
+    };
+    const char* v = nullptr;
+    if (a == "-h" || a == "--help") return false;
+    if (a == "--dump") { o.dump = true; continue; }
+    if (a == "--quiet") { o.quiet = true; continue; }
+    if (a.empty() || a[0] != '-') {
+      if (!o.capture.empty()) { std::fprintf(stderr, "Only one capture file\n"); return false; }
+      o.capture = a;
+      continue;
+    }
+    if (!next(v)) return false;
+
+    if (a == "--stub-config") {
+      o.stub_config = v;
+    } else if (a == "--udp") {
+      o.udp = v;
+    } else if (a == "--uart") {
+      o.uart = v;
+    } else if (a == "--speed") {
+      o.speed = std::atof(v);
+    } else if (a == "--from") {
+      o.from_s = std::atof(v);
+    } else if (a == "--to") {
+      o.to_s = std::atof(v);
+    } else if (a == "--timeout") {
+      o.timeout_ms = (uint32_t)std::strtoul(v, nullptr, 10);
+    } else {
+      std::fprintf(stderr, "Unknown option %s\n", a.c_str());
+      return false;
+    }
+  }
+  return !o.capture.empty() && o.speed >= 0.0;
+}
+
+// Commands whose ACK payload starts with ok/fail slot masks.
+bool has_mask_ack(uint8_t cmd) {
+  switch (cmd) {
+    case CMD_RUNSTOP:
+    case CMD_SET_VALUE:
+    case CMD_PARAM_STEP:
+    case CMD_CAPTURE_STILL:
+    case CMD_DISCOVER:
+    case CMD_SET_SLOT_CONFIG:
+      return true;
+    default:
+      return false;
+  }
+}
+
+std::string record_text(const flight::Record& r) {
+  return std::string(r.data.begin(), r.data.end());
+}
+
+// Pairs every recorded request with the next ACK carrying its seq.
+std::vector<Request> collect_requests(const std::vector<flight::Record>& recs) {
+  std::vector<Request> out;
+  std::unordered_map<uint32_t, size_t> open;
+  for (const auto& r : recs) {
+    if (r.h.kind != flight::KIND_FRAME_RX && r.h.kind != flight::KIND_FRAME_TX) continue;
+    Header h{};
+    const uint8_t* pl = nullptr;
+    size_t pl_len = 0;
+    uint8_t err = RESP_OK;
+    const bool ok = parse_packet(r.data.data(), r.data.size(), h, pl, pl_len, err);
+
+    if (r.h.kind == flight::KIND_FRAME_RX) {
+      Request q;
+      q.ts_ns = r.h.ts_ns;
+      q.frame = r.data;
+      q.parsed = ok && h.msg_type == MSG_REQ_CMD;
+      q.h = h;
+      if (q.parsed) open[h.seq] = out.size();
+      out.push_back(std::move(q));
+      continue;
+    }
+
+    if (!ok || h.msg_type != MSG_RESP_ACK) continue;
+    auto it = open.find(h.seq);
+    if (it == open.end()) continue;
+    Request& q = out[it->second];
+    q.have_ack = true;
+    q.ack_code = h.cmd_or_code;
+    if (pl_len >= 2) { q.ack_masks[0] = pl[0]; q.ack_masks[1] = pl[1]; }
+    q.ack_latency_us = r.h.ts_ns > q.ts_ns ? (r.h.ts_ns - q.ts_ns) / 1000 : 0;
+    open.erase(it);
+  }
+  std::stable_sort(out.begin(), out.end(), [](const Request& a, const Request& b) { return a.ts_ns < b.ts_ns; });
+  return out;
+}
+
+void dump(const flight::FileHeader& fh, const std::vector<flight::Record>& recs) {
+  std::printf("# pid %u  %llu slots x %u B  head %llu  %zu records\n",
+              (unsigned)fh.pid, (unsigned long long)fh.slot_count, (unsigned)fh.slot_bytes,
+              (unsigned long long)fh.head, recs.size());
+  for (const auto& r : recs) {
+    // Wall-clock time of the record, from the daemon's start anchor.
+    const int64_t wall_ns = (int64_t)fh.start_wall_ns + ((int64_t)r.h.ts_ns - (int64_t)fh.start_mono_ns);
+    const time_t secs = (time_t)(wall_ns / 1000000000);
+    tm tmv{};
+    localtime_r(&secs, &tmv);
+    char ts[32];
+    std::snprintf(ts, sizeof(ts), "%02d:%02d:%02d.%06lld", tmv.tm_hour, tmv.tm_min, tmv.tm_sec,
+                  (long long)((wall_ns % 1000000000) / 1000));
+
+    const char* kind = flight::kind_name(r.h.kind);
+    if (r.h.kind == flight::KIND_FRAME_RX || r.h.kind == flight::KIND_FRAME_TX) {
+      Header h{};
+      const uint8_t* pl = nullptr;
+      size_t pl_len = 0;
+      uint8_t err = RESP_OK;
+      const char* src = r.h.source == flight::SRC_UART ? "uart" : "udp";
+      if (!parse_packet(r.data.data(), r.data.size(), h, pl, pl_len, err)) {
+        std::printf("%s %-8s %s len=%zu unparsable (err=%u)\n", ts, kind, src, r.data.size(), (unsigned)err);
+      } else if (h.msg_type == MSG_REQ_CMD) {
+        std::printf("%s %-8s %s %s seq=%u target=0x%02X len=%u\n", ts, kind, src,
+                    command_name(h.cmd_or_code), h.seq, h.target_mask, (unsigned)pl_len);
+      } else {
+        std::printf("%s %-8s %s ack seq=%u code=%u", ts, kind, src, h.seq, (unsigned)h.cmd_or_code);
+        if (pl_len >= 2) std::printf(" ok=0x%02X fail=0x%02X", pl[0], pl[1]);
+        std::printf(" len=%u%s\n", (unsigned)pl_len, r.h.code ? " SEND-FAILED" : "");
+      }
+    } else if (r.h.kind == flight::KIND_SDK_CALL) {
+      std::printf("%s %-8s slot=%d %s code=0x%X result=0x%X %.3fms\n", ts, kind,
+                  r.h.source == flight::kNoSlot ? -1 : (int)r.h.source, record_text(r).c_str(),
+                  (unsigned)r.h.code, (unsigned)r.h.result, r.h.aux / 1000.0);
+    } else if (r.h.kind == flight::KIND_SDK_CALLBACK) {
+      std::printf("%s %-8s slot=%d %s 0x%X\n", ts, kind,
+                  r.h.source == flight::kNoSlot ? -1 : (int)r.h.source, record_text(r).c_str(), (unsigned)r.h.code);
+    } else {
+      std::printf("%s %-8s %s\n", ts, kind, record_text(r).c_str());
+    }
+  }
+}
+
+// CRSTUB op for an SDK function, or nullptr if the stub has no knob for it.
+const char* stub_op(const std::string& fn) {
+  if (fn == "EnumCameraObjects") return "enum";
+  if (fn == "Connect") return "connect";
+  if (fn == "GetDeviceProperties" || fn == "GetSelectDeviceProperties") return "get_props";
+  if (fn == "SetDeviceProperty") return "set_prop";
+  if (fn == "SendCommand") return "send_command";
+  if (fn == "GetLiveViewImage") return "live_view";
+  return nullptr;
+}
+
+bool write_stub_config(const std::string& path, const flight::FileHeader& fh, const std::vector<flight::Record>& recs) {
+  struct OpStats {
+    uint64_t calls = 0;
+    uint64_t failures = 0;
+    std::map<uint32_t, uint64_t> errors;
+    std::vector<uint32_t> dur_us;
+  };
+  std::map<std::string, OpStats> ops;
+  std::vector<std::string> events;
+  int max_slot = -1;
+
+  // The stub's event clock starts at Init, which the daemon calls right after start.
+  uint64_t t0 = fh.start_mono_ns;
+  for (const auto& r : recs) {
+    if (r.h.kind == flight::KIND_START) { t0 = r.h.ts_ns; break; }
+  }
+
+  // Calls made while a slot was disconnected fail because of the disconnect,
+  // which the event line already reproduces; keep them out of fail_rate.
+  bool offline[256] = {};
+  for (size_t i = 0; i < recs.size(); ++i) {
+    const auto& r = recs[i];
+    if (r.h.source != flight::kNoSlot && r.h.kind >= flight::KIND_SDK_CALL) max_slot = std::max(max_slot, (int)r.h.source);
+    if (r.h.kind == flight::KIND_SDK_CALLBACK && record_text(r) == "OnConnected") offline[r.h.source] = false;
+    if (r.h.kind == flight::KIND_SDK_CALL) {
+      const char* op = stub_op(record_text(r));
+      if (!op || offline[r.h.source]) continue;
+      OpStats& s = ops[op];
+      s.calls++;
+      s.dur_us.push_back(r.h.aux);
+      if (r.h.result != 0) { s.failures++; s.errors[r.h.result]++; }
+      continue;
+    }
+    if (r.h.kind != flight::KIND_SDK_CALLBACK || record_text(r) != "OnDisconnected" || r.h.source == flight::kNoSlot) continue;
+    offline[r.h.source] = true;
+    // Offline until the same slot reports OnConnected again (0 = never came back).
+    uint64_t offline_ms = 0;
+    for (size_t j = i + 1; j < recs.size(); ++j) {
+      const auto& c = recs[j];
+      if (c.h.kind == flight::KIND_SDK_CALLBACK && c.h.source == r.h.source && record_text(c) == "OnConnected") {
+        offline_ms = std::max<uint64_t>(1, (c.h.ts_ns - r.h.ts_ns) / 1000000);
+        break;
+      }
+    }
+    const uint64_t at_ms = r.h.ts_ns > t0 ? (r.h.ts_ns - t0) / 1000000 : 0;
+    char line[160];
+    std::snprintf(line, sizeof(line), "event=disconnect camera=%u at_ms=%llu offline_ms=%llu   # error 0x%X",
+                  (unsigned)r.h.source, (unsigned long long)at_ms, (unsigned long long)offline_ms, (unsigned)r.h.code);
+    events.push_back(line);
+  }
+
+  FILE* f = (path == "-") ? stdout : std::fopen(path.c_str(), "w");
+  if (!f) return false;
+  std::fprintf(f, "# Generated by ccu_replay from a flight recording (pid %u).\n", (unsigned)fh.pid);
+  std::fprintf(f, "# Camera n stands in for daemon slot n; run with CRSTUB_CAMERAS=%d.\n", max_slot + 1);
+  for (auto& kv : ops) {
+    OpStats& s = kv.second;
+    std::sort(s.dur_us.begin(), s.dur_us.end());
+    // The stub draws latency_ms + U(0, jitter_ms): use p10 and the p10..p90 spread.
+    const uint32_t p10 = s.dur_us[s.dur_us.size() / 10] / 1000;
+    const uint32_t p90 = s.dur_us[(s.dur_us.size() * 9) / 10] / 1000;
+    std::fprintf(f, "op=%s latency_ms=%u jitter_ms=%u", kv.first.c_str(), (unsigned)p10, (unsigned)(p90 - p10));
+    if (s.failures) {
+      uint32_t top_err = 0;
+      uint64_t top_n = 0;
+      for (const auto& e : s.errors) {
+        if (e.second > top_n) { top_err = e.first; top_n = e.second; }
+      }
+      std::fprintf(f, " fail_rate=%.4f fail_err=%X", (double)s.failures / (double)s.calls, (unsigned)top_err);
+    }
+    std::fprintf(f, "   # %llu calls, %llu failed\n", (unsigned long long)s.calls, (unsigned long long)s.failures);
+  }
+  for (const auto& e : events) std::fprintf(f, "%s\n", e.c_str());
+  if (f != stdout) std::fclose(f);
+  return true;
+}
+
+uint64_t percentile_us(std::vector<uint64_t> v, double p) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  const size_t idx = (size_t)(p * (double)(v.size() - 1) + 0.5);
+  return v[std::min(idx, v.size() - 1)];
+}
+
+int replay(const Options& o, const std::vector<Request>& all) {
+  std::vector<const Request*> reqs;
+  const uint64_t first_ts = all.empty() ? 0 : all.front().ts_ns;
+  for (const auto& q : all) {
+    const double t = (double)(q.ts_ns - first_ts) / 1e9;
+    if (t < o.from_s) continue;
+    if (o.to_s > 0.0 && t > o.to_s) continue;
+    reqs.push_back(&q);
+  }
+  if (reqs.empty()) {
+    std::fprintf(stderr, "No requests in the selected window\n");
+    return 1;
+  }
+
+  ClientLink link;
+  const bool opened = o.uart.empty() ? link.open_udp(o.udp) : link.open_uart(o.uart);
+  if (!opened) {
+    std::fprintf(stderr, "Failed to open %s\n", o.uart.empty() ? o.udp.c_str() : o.uart.c_str());
+    return 1;
+  }
+
+  std::vector<Outcome> outcomes(reqs.size());
+  std::unordered_map<uint32_t, std::pair<size_t, Clock::time_point>> pending;
+  const auto timeout = std::chrono::milliseconds(o.timeout_ms);
+  const uint64_t base_ts = reqs.front()->ts_ns;
+  const auto t_start = Clock::now();
+  size_t next = 0;
+  uint64_t unmatched = 0;
+  uint8_t rx[2048];
+
+  while (next < reqs.size() || !pending.empty()) {
+    auto now = Clock::now();
+    // Send everything that is due; --speed 0 keeps exactly one in flight.
+    while (next < reqs.size()) {
+      const Request& q = *reqs[next];
+      if (o.speed > 0.0) {
+        const auto due = t_start + std::chrono::nanoseconds((int64_t)((double)(q.ts_ns - base_ts) / o.speed));
+        if (now < due) break;
+      } else if (!pending.empty()) {
+        break;
+      }
+      if (!link.send(q.frame.data(), q.frame.size())) {
+        std::perror("send");
+        return 1;
+      }
+      if (q.parsed) pending[q.h.seq] = {next, now};
+      next++;
+      now = Clock::now();
+    }
+
+    while (true) {
+      const int n = link.recv(rx, sizeof(rx));
+      if (n <= 0) break;
+      Header h{};
+      const uint8_t* pl = nullptr;
+      size_t pl_len = 0;
+      uint8_t err = RESP_OK;
+      if (!parse_packet(rx, (size_t)n, h, pl, pl_len, err) || h.msg_type != MSG_RESP_ACK) {
+        unmatched++;
+        continue;
+      }
+      auto it = pending.find(h.seq);
+      if (it == pending.end()) { unmatched++; continue; }
+      Outcome& out = outcomes[it->second.first];
+      out.acked = true;
+      out.code = h.cmd_or_code;
+      if (pl_len >= 2) { out.masks[0] = pl[0]; out.masks[1] = pl[1]; }
+      out.latency_us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - it->second.second).count();
+      pending.erase(it);
+    }
+
+    now = Clock::now();
+    for (auto it = pending.begin(); it != pending.end();) {
+      if (now - it->second.second >= timeout) it = pending.erase(it);
+      else ++it;
+    }
+
+    int wait_ms = 1;
+    if (o.speed > 0.0 && next < reqs.size() && pending.empty()) {
+      const auto due = t_start + std::chrono::nanoseconds((int64_t)((double)(reqs[next]->ts_ns - base_ts) / o.speed));
+      wait_ms = (int)std::max<int64_t>(0, std::min<int64_t>(50, std::chrono::duration_cast<std::chrono::milliseconds>(due - now).count()));
+    }
+    link.wait(wait_ms);
+  }
+  const double elapsed_s = std::chrono::duration<double>(Clock::now() - t_start).count();
+
+  // ---- Compare against the field ----
+  uint64_t sent = 0, acked = 0, timeouts = 0, code_diff = 0, mask_diff = 0, compared = 0;
+  std::vector<uint64_t> field_lat, replay_lat;
+  for (size_t i = 0; i < reqs.size(); ++i) {
+    const Request& q = *reqs[i];
+    const Outcome& out = outcomes[i];
+    sent++;
+    if (!q.parsed) continue;
+    const double t = (double)(q.ts_ns - first_ts) / 1e9;
+    if (!out.acked) {
+      timeouts++;
+      if (!o.quiet) std::printf("%9.3fs %-14s seq=%u  TIMEOUT\n", t, command_name(q.h.cmd_or_code), q.h.seq);
+      continue;
+    }
+    acked++;
+    replay_lat.push_back(out.latency_us);
+    if (!q.have_ack) continue;
+    compared++;
+    field_lat.push_back(q.ack_latency_us);
+    const bool code_ok = out.code == q.ack_code;
+    const bool mask_ok = !has_mask_ack(q.h.cmd_or_code) ||
+                         (out.masks[0] == q.ack_masks[0] && out.masks[1] == q.ack_masks[1]);
+    if (!code_ok) code_diff++;
+    else if (!mask_ok) mask_diff++;
+    if ((!code_ok || !mask_ok) && !o.quiet) {
+      std::printf("%9.3fs %-14s seq=%u  field code=%u ok=0x%02X fail=0x%02X  replay code=%u ok=0x%02X fail=0x%02X\n",
+                  t, command_name(q.h.cmd_or_code), q.h.seq,
+                  (unsigned)q.ack_code, q.ack_masks[0], q.ack_masks[1],
+                  (unsigned)out.code, out.masks[0], out.masks[1]);
+    }
+  }
+
+  std::printf("replayed %llu frames in %.2fs  acked %llu  timeouts %llu  unmatched %llu\n",
+              (unsigned long long)sent, elapsed_s, (unsigned long long)acked,
+              (unsigned long long)timeouts, (unsigned long long)unmatched);
+  std::printf("compared %llu ACKs  code mismatches %llu  mask mismatches %llu\n",
+              (unsigned long long)compared, (unsigned long long)code_diff, (unsigned long long)mask_diff);
+  std::printf("ack latency ms   field p50 %.3f p99 %.3f   replay p50 %.3f p99 %.3f\n",
+              percentile_us(field_lat, 0.50) / 1000.0, percentile_us(field_lat, 0.99) / 1000.0,
+              percentile_us(replay_lat, 0.50) / 1000.0, percentile_us(replay_lat, 0.99) / 1000.0);
+  return (timeouts || code_diff || mask_diff) ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options o;
+  if (!parse_args(argc, argv, o)) {
+    usage();
+    return 2;
+  }
+
+  flight::FileHeader fh{};
+  std::vector<flight::Record> recs;
+  std::string err;
+  if (!flight::read_file(o.capture, fh, recs, err)) {
+    std::fprintf(stderr, "%s: %s\n", o.capture.c_str(), err.c_str());
+    return 1;
+  }
+
+  if (o.dump) {
+    dump(fh, recs);
+    return 0;
+  }
+  if (!o.stub_config.empty()) {
+    if (!write_stub_config(o.stub_config, fh, recs)) {
+      std::fprintf(stderr, "Failed to write %s\n", o.stub_config.c_str());
+      return 1;
+    }
+    return 0;
+  }
+  return replay(o, collect_requests(recs));
+}
@@ -0,0 +1,96 @@
+// ccu_shm_cat: copies one slot's live view from ccu_daemon's shared-memory
+// ring (CCU_SHM_SOCKET) to stdout as concatenated JPEGs, e.g.
+//
+//   ccu_shm_cat 0 | ffmpeg -f mjpeg -i - ...
+//
+// Also an example reader for tools/ccu_shm_client.hpp. Each frame is copied
+// out and checked before it is written, so a frame the daemon overwrote
+// mid-copy never reaches the pipe.
+#include "../src/clock.hpp"
+#include "ccu_shm_client.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+bool write_all(const uint8_t* p, size_t n) {
+  while (n > 0) {
+    const ssize_t w = ::write(STDOUT_FILENO, p, n);
+    if (w < 0 && errno == EINTR) continue;
+    if (w <= 0) return false;
+    p += w;
+    n -= (size_t)w;
+  }
+  return true;
+}
+
+void usage() {
+  std::fprintf(stderr,
+               "Usage: ccu_shm_cat [--socket path] [--count n] [--stats] <slot>\n"
+               "Default socket: $CCU_SHM_SOCKET, else /run/ccu/liveview.sock.\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const char* env = std::getenv("CCU_SHM_SOCKET");
+  std::string socket_path = env && *env ? env : "/run/ccu/liveview.sock";
+  long count = 0;  // 0 = until the daemon goes away
+  bool stats = false;
+  int slot = -1;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+      socket_path = argv[++i];
+    } else if (std::strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+      count = std::atol(argv[++i]);
+    } else if (std::strcmp(argv[i], "--stats") == 0) {
+      stats = true;
+    } else if (argv[i][0] != '-' && slot < 0) {
+      slot = std::atoi(argv[i]);
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  if (slot < 0) {
+    usage();
+    return 2;
+  }
+
+  ccu::ShmClient lv;
+  std::string err;
+  if (!lv.open(socket_path, slot, &err)) {
+    std::fprintf(stderr, "ccu_shm_cat: %s\n", err.c_str());
+    return 1;
+  }
+
+  std::vector<uint8_t> copy;
+  uint64_t written = 0, skipped = 0, torn = 0, age_sum_us = 0;
+  ccu::ShmClient::Frame f;
+  while (count == 0 || (long)written < count) {
+    if (!lv.wait(1000) && !lv.connected()) break;
+    if (!lv.next(f)) continue;
+    copy.assign(f.jpeg, f.jpeg + f.size);
+    if (!lv.still_valid(f)) {
+      ++torn;
+      continue;
+    }
+    const uint64_t now = ccu::monotonic_ns();
+    age_sum_us += now > f.captured_ns ? (now - f.captured_ns) / 1000 : 0;
+    skipped += f.skipped;
+    if (!write_all(copy.data(), copy.size())) break;
+    ++written;
+  }
+  if (stats) {
+    std::fprintf(stderr, "ccu_shm_cat: %llu frames, %llu skipped, %llu overwritten, mean age %.2f ms\n",
+                 (unsigned long long)written, (unsigned long long)skipped, (unsigned long long)torn,
+                 written ? (double)age_sum_us / (double)written / 1000.0 : 0.0);
+  }
+  return written ? 0 : 1;
+}
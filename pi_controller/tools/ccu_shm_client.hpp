@@ -0,0 +1,195 @@
+#pragma once
+// Reader for ccu_daemon's shared-memory live view (CCU_SHM_SOCKET; layout
+// in src/shm_layout.hpp). Header-only, no SDK and no other dependency, so
+// local tools can copy it in. Frames are read in place from the mapped
+// ring:
+//
+//   ccu::ShmClient lv;
+//   if (!lv.open("/run/ccu/liveview.sock", 0, &err)) ...
+//   ccu::ShmClient::Frame f;
+//   while (lv.wait(1000) || lv.connected()) {
+//     if (!lv.next(f)) continue;
+//     ... use f.jpeg / f.size ...
+//     if (!lv.still_valid(f)) ...   // overwritten meanwhile: discard results
+//   }
+#include "../src/shm_layout.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ccu {
+
+class ShmClient {
+public:
+  struct Frame {
+    const uint8_t* jpeg = nullptr;
+    size_t size = 0;
+    uint64_t seq = 0;
+    uint64_t captured_ns = 0;  // CLOCK_MONOTONIC, comparable with this host's clock
+    uint32_t frame_no = 0;
+    uint64_t skipped = 0;      // frames published since the previous next()
+  };
+
+  ShmClient() = default;
+  ~ShmClient() { close(); }
+  ShmClient(const ShmClient&) = delete;
+  ShmClient& operator=(const ShmClient&) = delete;
+
+  // Subscribes to slot's ring and maps it. False with a reason in err.
+  bool open(const std::string& socket_path, int slot, std::string* err) {
+    close();
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) return fail(err, "socket path too long");
+    std::memcpy(addr.sun_path, socket_path.c_str(), socket_path.size());
+    m_sock = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (m_sock < 0 || ::connect(m_sock, (sockaddr*)&addr, sizeof(addr)) < 0)
+      return fail(err, "cannot connect to " + socket_path);
+    const uint8_t req = (uint8_t)slot;
+    if (slot < 0 || slot > 255 || ::send(m_sock, &req, 1, MSG_NOSIGNAL) != 1) return fail(err, "bad slot");
+
+    ShmReply reply{};
+    iovec iov{&reply, sizeof(reply)};
+    alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    const ssize_t got = ::recvmsg(m_sock, &msg, MSG_CMSG_CLOEXEC);
+    if (got < 0) return fail(err, "no reply");
+    // Take ownership of whatever arrived (the daemon may send fds even with
+    // an error status): the memfd is closed below, the eventfd by close().
+    int fds[2] = {-1, -1};
+    for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm && cm->cmsg_len >= CMSG_LEN(0); cm = CMSG_NXTHDR(&msg, cm)) {
+      if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS) continue;
+      const size_t n = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      for (size_t i = 0; i < n; ++i) {
+        int fd;
+        std::memcpy(&fd, CMSG_DATA(cm) + i * sizeof(int), sizeof(int));
+        if (i < 2 && fds[i] < 0) fds[i] = fd;
+        else ::close(fd);
+      }
+    }
+    m_event_fd = fds[1];
+    const int ring_fd = fds[0];
+    auto fail_ring = [&](const std::string& why) {
+      if (ring_fd >= 0) ::close(ring_fd);
+      return fail(err, why);
+    };
+    if (got != (ssize_t)sizeof(reply)) return fail_ring("no reply");
+    if (reply.status == kShmNoSlot) return fail_ring("slot has no live view");
+    if (reply.status == kShmBusy) return fail_ring("too many readers");
+    if (reply.status != kShmOk || ring_fd < 0 || m_event_fd < 0) return fail_ring("bad reply");
+    if (reply.version != kShmVersion) {
+      return fail_ring("ring version " + std::to_string(reply.version) + ", this reader knows " +
+                       std::to_string(kShmVersion));
+    }
+
+    struct stat st{};
+    if (::fstat(ring_fd, &st) < 0 || (size_t)st.st_size < sizeof(ShmRingHeader)) return fail_ring("bad ring");
+    void* p = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, ring_fd, 0);
+    ::close(ring_fd);  // the mapping keeps it alive
+    if (p == MAP_FAILED) return fail(err, "mmap failed");
+    m_base = (const uint8_t*)p;
+    m_map_bytes = (size_t)st.st_size;
+    m_header = reinterpret_cast<const ShmRingHeader*>(m_base);
+    if (m_header->magic != kShmMagic || m_header->total_bytes > m_map_bytes || m_header->frames == 0)
+      return fail(err, "bad ring header");
+    m_entries = reinterpret_cast<const ShmEntry*>(m_base + sizeof(ShmRingHeader));
+    m_connected = true;
+    return true;
+  }
+
+  void close() {
+    if (m_base) ::munmap(const_cast<uint8_t*>(m_base), m_map_bytes);
+    if (m_event_fd >= 0) ::close(m_event_fd);
+    if (m_sock >= 0) ::close(m_sock);
+    m_base = nullptr;
+    m_header = nullptr;
+    m_entries = nullptr;
+    m_event_fd = m_sock = -1;
+    m_connected = false;
+    m_last = 0;
+  }
+
+  // Waits up to timeout_ms for a frame newer than the last one next()
+  // returned. False on timeout or once the daemon has gone.
+  bool wait(int timeout_ms) {
+    if (!m_connected) return false;
+    if (newest() > m_last) return true;
+    pollfd pfd[2] = {{m_event_fd, POLLIN, 0}, {m_sock, POLLIN, 0}};
+    if (::poll(pfd, 2, timeout_ms) <= 0) return false;
+    if (pfd[1].revents) {
+      char c;
+      if (::recv(m_sock, &c, 1, MSG_DONTWAIT) == 0 || (pfd[1].revents & (POLLHUP | POLLERR))) m_connected = false;
+    }
+    if (pfd[0].revents & POLLIN) {
+      uint64_t n;
+      (void)!::read(m_event_fd, &n, sizeof(n));
+    }
+    return newest() > m_last;
+  }
+
+  // The newest frame, if newer than the last one returned. f points into
+  // the ring: check still_valid(f) once done with its bytes.
+  bool next(Frame& f) {
+    if (!m_header) return false;
+    for (int attempt = 0; attempt < 4; ++attempt) {
+      const uint64_t seq = newest();
+      if (seq == 0 || seq <= m_last) return false;
+      const uint64_t idx = (seq - 1) % m_header->frames;
+      const ShmEntry& e = m_entries[idx];
+      if (e.seq.load(std::memory_order_acquire) != seq) continue;  // lapped already
+      f.jpeg = m_base + m_header->header_bytes + idx * m_header->frame_bytes;
+      f.size = e.size;
+      f.seq = seq;
+      f.captured_ns = e.captured_ns;
+      f.frame_no = e.frame_no;
+      f.skipped = m_last ? seq - m_last - 1 : 0;
+      if (!still_valid(f) || f.size > m_header->frame_bytes) continue;
+      m_last = seq;
+      return true;
+    }
+    return false;
+  }
+
+  // False if the daemon reused f's entry while f was in use.
+  bool still_valid(const Frame& f) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return m_entries[(f.seq - 1) % m_header->frames].seq.load(std::memory_order_relaxed) == f.seq;
+  }
+
+  bool connected() const { return m_connected; }
+  // For callers with their own poll loop: readable when a frame was published.
+  int event_fd() const { return m_event_fd; }
+  uint32_t ring_frames() const { return m_header ? m_header->frames : 0; }
+
+private:
+  uint64_t newest() const { return m_header->write_seq.load(std::memory_order_acquire); }
+
+  bool fail(std::string* err, const std::string& why) {
+    close();
+    if (err) *err = why;
+    return false;
+  }
+
+  int m_sock = -1;
+  int m_event_fd = -1;
+  const uint8_t* m_base = nullptr;
+  size_t m_map_bytes = 0;
+  const ShmRingHeader* m_header = nullptr;
+  const ShmEntry* m_entries = nullptr;
+  uint64_t m_last = 0;
+  bool m_connected = false;
+};
+
+} // namespace ccu